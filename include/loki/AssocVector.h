@@ -30,6 +30,7 @@
 
 
 #include <algorithm>
+#include <cassert>
 #include <functional>
 #include <vector>
 #include <utility>
@@ -39,6 +40,17 @@
 
 namespace Loki
 {
+////////////////////////////////////////////////////////////////////////////////
+// assume_sorted
+// Passed to the constructor of AssocVector for elements which are already
+//     sorted and unique
+////////////////////////////////////////////////////////////////////////////////
+
+    struct assume_sorted_t
+    {};
+
+    const assume_sorted_t assume_sorted = assume_sorted_t();
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template AssocVectorCompare
 // Used by AssocVector
@@ -77,6 +89,163 @@ namespace Loki
         };
     }
 
+////////////////////////////////////////////////////////////////////////////////
+// AssocVector layout policies
+// Decide how AssocVector searches its elements.  The elements themselves
+//     always stay a sorted vector of std::pair<K, V>, so iterators and the
+//     interface are the same with every layout.
+// A layout keeps whatever index it needs, is told to Rebuild it after every
+//     change of the elements, and implements LowerBound on the elements.
+//     Should Rebuild throw, it must leave the old index as it was.
+// SortedPairsLayout (the default) has no index and binary searches the pairs.
+// SortedKeysLayout keeps a sorted copy of the keys apart from the values, so
+//     a search touches only keys; it pays off for big values.
+// BTreeKeysLayout puts a static B-tree on top of the sorted copy of the
+//     keys, whose nodes hold as many keys as fill a cache line, so a search
+//     reads about one cache line per level and compares its keys without
+//     branches; it suits big tables of small keys.
+// Both key layouts rebuild their index in O(N) after every change, so they
+//     are meant for tables which are built once and then read.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class K, class C>
+    class SortedPairsLayout
+    {
+    protected:
+        template <class Iterator>
+        void Rebuild(Iterator, Iterator)
+        {}
+
+        template <class Iterator, class Compare>
+        Iterator LowerBound(Iterator first, Iterator last, const K& k,
+            const Compare& comp) const
+        { return std::lower_bound(first, last, k, comp); }
+
+        void Swap(SortedPairsLayout&)
+        {}
+    };
+
+    template <class K, class C>
+    class SortedKeysLayout
+    {
+    protected:
+        template <class Iterator>
+        void Rebuild(Iterator first, Iterator last)
+        {
+            std::vector<K> keys;
+            keys.reserve(static_cast<std::size_t>(last - first));
+            for (; first != last; ++first)
+                keys.push_back(first->first);
+            keys_.swap(keys);
+        }
+
+        template <class Iterator, class Compare>
+        Iterator LowerBound(Iterator first, Iterator, const K& k,
+            const Compare& comp) const
+        {
+            return first + (std::lower_bound(keys_.begin(), keys_.end(), k, comp)
+                - keys_.begin());
+        }
+
+        void Swap(SortedKeysLayout& other)
+        { keys_.swap(other.keys_); }
+
+    private:
+        std::vector<K> keys_;
+    };
+
+    template <class K, class C>
+    class BTreeKeysLayout
+    {
+    protected:
+        template <class Iterator>
+        void Rebuild(Iterator first, Iterator last)
+        {
+            // Level 0 holds all the keys in order, and every other level the
+            // first key of every block of the level below.  Each level is
+            // padded to whole blocks with copies of its last key, and the
+            // levels are stored top down in one vector.
+            std::vector<std::vector<K> > levels;
+            std::vector<std::size_t> sizes;
+            if (first != last)
+            {
+                levels.push_back(std::vector<K>());
+                for (; first != last; ++first)
+                    levels.back().push_back(first->first);
+                sizes.push_back(levels.back().size());
+                while (levels.back().size() > BlockSize())
+                {
+                    std::vector<K> level;
+                    const std::vector<K>& below = levels.back();
+                    for (std::size_t i = 0; i < below.size(); i += BlockSize())
+                        level.push_back(below[i]);
+                    levels.push_back(std::vector<K>());
+                    levels.back().swap(level);
+                    sizes.push_back(levels.back().size());
+                }
+            }
+            std::vector<K> keys;
+            std::vector<Level> index(levels.size());
+            for (std::size_t i = levels.size(); i-- != 0; )
+            {
+                std::vector<K>& level = levels[i];
+                index[i].offset_ = keys.size();
+                index[i].size_ = sizes[i];
+                const K padding(level.back());
+                level.resize((level.size() + BlockSize() - 1) / BlockSize()
+                    * BlockSize(), padding);
+                keys.insert(keys.end(), level.begin(), level.end());
+            }
+            keys_.swap(keys);
+            levels_.swap(index);
+        }
+
+        template <class Iterator, class Compare>
+        Iterator LowerBound(Iterator first, Iterator, const K& k,
+            const Compare& comp) const
+        {
+            // Every key before the block is smaller than k, and the key after
+            // it is not, so the lower bound on a level is the start of the
+            // block plus the keys of the block which are smaller than k.
+            // That position, less one, is the block on the level below.
+            std::size_t position = 0;
+            for (std::size_t level = levels_.size(); level-- != 0; )
+            {
+                const std::size_t begin = position == 0 ? 0
+                    : (position - 1) * BlockSize();
+                const K* keys = &keys_[levels_[level].offset_ + begin];
+                position = begin;
+                for (std::size_t i = 0; i != BlockSize(); ++i)
+                    position += comp(keys[i], k) ? 1 : 0;
+                // the padding counts if the last key is smaller than k
+                position = std::min(position, levels_[level].size_);
+            }
+            return first + static_cast<std::ptrdiff_t>(position);
+        }
+
+        void Swap(BTreeKeysLayout& other)
+        {
+            keys_.swap(other.keys_);
+            levels_.swap(other.levels_);
+        }
+
+    private:
+        struct Level
+        {
+            Level() : offset_(0), size_(0)
+            {}
+            std::size_t offset_;
+            std::size_t size_;
+        };
+
+        // As many keys as fill a cache line, but at least four.
+        static std::size_t BlockSize()
+        { return sizeof(K) * 4 <= 64 ? 64 / sizeof(K) : 4; }
+
+        std::vector<K> keys_;
+        std::vector<Level> levels_;
+    };
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template AssocVector
 // An associative vector built as a syntactic drop-in replacement for std::map
@@ -84,8 +253,10 @@ namespace Loki
 //     being:
 // * iterators are invalidated by insert and erase operations
 // * the complexity of insert/erase is O(N) not O(log N)
+//     (insert a range at once, or construct from a range, to fill it faster)
 // * value_type is std::pair<K, V> not std::pair<const K, V>
 // * iterators are random
+// LayoutPolicy chooses how the elements are searched; see the layout policies
 ////////////////////////////////////////////////////////////////////////////////
 
 
@@ -94,14 +265,17 @@ namespace Loki
         class K,
         class V,
         class C = std::less<K>,
-        class A = std::allocator< std::pair<K, V> >
+        class A = std::allocator< std::pair<K, V> >,
+        template <class, class> class LayoutPolicy = SortedPairsLayout
     >
     class AssocVector
         : private std::vector< std::pair<K, V>, A >
         , private Private::AssocVectorCompare<V, C>
+        , private LayoutPolicy<K, C>
     {
         typedef std::vector<std::pair<K, V>, A> Base;
         typedef Private::AssocVectorCompare<V, C> MyCompare;
+        typedef LayoutPolicy<K, C> Layout;
 
     public:
         typedef K key_type;
@@ -147,19 +321,24 @@ namespace Loki
         AssocVector(InputIterator first, InputIterator last,
             const key_compare& comp = key_compare(),
             const A& alloc = A())
-        : Base( alloc ), MyCompare( comp )
+        : Base(first, last, alloc), MyCompare(comp)
+        {
+            // Like std::map, keep the first of any elements with equal keys.
+            MergeTail(0);
+            Reindex();
+        }
+
+        /// Takes the elements of [first, last) as they are, without sorting
+        /// or comparing them, which is the fastest way to fill a big
+        /// AssocVector.  The keys must be sorted by comp and unique.
+        template <class InputIterator>
+        AssocVector(assume_sorted_t, InputIterator first, InputIterator last,
+            const key_compare& comp = key_compare(),
+            const A& alloc = A())
+        : Base(first, last, alloc), MyCompare(comp)
         {
-            typedef ::std::vector< ::std::pair< K, V >, A > BaseType;
-            typedef ::std::map< K, V, C, A > TempMap;
-            typedef ::std::back_insert_iterator< Base > MyInserter;
-            MyCompare & me = *this;
-            const A tempAlloc;
-            // Make a temporary map similar to this type to prevent any duplicate elements.
-            TempMap temp( first, last, me, tempAlloc );
-            Base::reserve( temp.size() );
-            BaseType & target = static_cast< BaseType & >( *this );
-            MyInserter myInserter = ::std::back_inserter( target );
-            ::std::copy( temp.begin(), temp.end(), myInserter );
+            assert(IsSortedAndUnique());
+            Reindex();
         }
 
         AssocVector& operator=(const AssocVector& rhs)
@@ -183,6 +362,15 @@ namespace Loki
         bool empty() const { return Base::empty(); }
         size_type size() const { return Base::size(); }
         size_type max_size() { return Base::max_size(); }
+        size_type capacity() const { return Base::capacity(); }
+        void reserve(size_type n) { Base::reserve(n); }
+
+        /// Frees the capacity beyond size().
+        void shrink_to_fit()
+        {
+            Base tight(static_cast<const Base&>(*this));
+            Base::swap(tight);
+        }
 
         // 23.3.1.2 element access:
         mapped_type& operator[](const key_type& key)
@@ -198,6 +386,7 @@ namespace Loki
             {
                 i = Base::insert(i, val);
                 found = false;
+                ReindexAfterInsert(i);
             }
             return std::make_pair(i, !found);
         }
@@ -208,17 +397,31 @@ namespace Loki
             if( (pos == begin() || this->operator()(*(pos-1),val)) &&
                 (pos == end()    || this->operator()(val, *pos)) )
             {
-                return Base::insert(pos, val);
+                pos = Base::insert(pos, val);
+                ReindexAfterInsert(pos);
+                return pos;
             }
             return insert(val).first;
         }
 
+        /// Appends all the elements and then sorts and merges them with the
+        /// old ones in one go, which costs O(N log N) instead of the O(N*N)
+        /// of inserting them one by one.  As with std::map, an element whose
+        /// key is already in the AssocVector is not inserted.  Offers only
+        /// the basic exception guarantee.
         template <class InputIterator>
         void insert(InputIterator first, InputIterator last)
-        { for (; first != last; ++first) insert(*first); }
+        {
+            const size_type oldSize = size();
+            Base::insert(end(), first, last);
+            MergeTail(oldSize);
+            Reindex();
+        }
 
         void erase(iterator pos)
-        { Base::erase(pos); }
+        {
+            EraseAndReindex(pos, pos + 1);
+        }
 
         size_type erase(const key_type& k)
         {
@@ -229,7 +432,9 @@ namespace Loki
         }
 
         void erase(iterator first, iterator last)
-        { Base::erase(first, last); }
+        {
+            EraseAndReindex(first, last);
+        }
 
         void swap(AssocVector& other)
         {
@@ -237,10 +442,14 @@ namespace Loki
             MyCompare& me = *this;
             MyCompare& rhs = other;
             std::swap(me, rhs);
+            Layout::Swap(other);
         }
 
         void clear()
-        { Base::clear(); }
+        {
+            Layout::Rebuild(end(), end());
+            Base::clear();
+        }
 
         // observers:
         key_compare key_comp() const
@@ -278,44 +487,138 @@ namespace Loki
 
         iterator lower_bound(const key_type& k)
         {
-            MyCompare& me = *this;
-            return std::lower_bound(begin(), end(), k, me);
+            const MyCompare& me = *this;
+            return Layout::LowerBound(begin(), end(), k, me);
         }
 
         const_iterator lower_bound(const key_type& k) const
         {
             const MyCompare& me = *this;
-            return std::lower_bound(begin(), end(), k, me);
+            return Layout::LowerBound(begin(), end(), k, me);
         }
 
+        // The keys are unique, so the upper bound is at most one past the
+        // lower bound.
         iterator upper_bound(const key_type& k)
         {
-            MyCompare& me = *this;
-            return std::upper_bound(begin(), end(), k, me);
+            iterator i(lower_bound(k));
+            if (i != end() && !this->operator()(k, i->first)) ++i;
+            return i;
         }
 
         const_iterator upper_bound(const key_type& k) const
         {
-            const MyCompare& me = *this;
-            return std::upper_bound(begin(), end(), k, me);
+            const_iterator i(lower_bound(k));
+            if (i != end() && !this->operator()(k, i->first)) ++i;
+            return i;
         }
 
         std::pair<iterator, iterator> equal_range(const key_type& k)
         {
-            MyCompare& me = *this;
-            return std::equal_range(begin(), end(), k, me);
+            iterator i(lower_bound(k));
+            iterator j(i);
+            if (j != end() && !this->operator()(k, j->first)) ++j;
+            return std::make_pair(i, j);
         }
 
         std::pair<const_iterator, const_iterator> equal_range(
             const key_type& k) const
+        {
+            const_iterator i(lower_bound(k));
+            const_iterator j(i);
+            if (j != end() && !this->operator()(k, j->first)) ++j;
+            return std::make_pair(i, j);
+        }
+
+    private:
+        // Tells the layout the elements have changed.  Should that fail, the
+        // AssocVector is emptied rather than left with a stale index, so this
+        // serves only where the basic guarantee is offered.
+        void Reindex()
+        {
+            try
+            {
+                Layout::Rebuild(begin(), end());
+            }
+            catch (...)
+            {
+                Base::clear();
+                Layout::Rebuild(begin(), end());
+                throw;
+            }
+        }
+
+        // Tells the layout about the element just inserted at pos, and takes
+        // the element out again should that fail.
+        void ReindexAfterInsert(iterator pos)
+        {
+            try
+            {
+                Layout::Rebuild(begin(), end());
+            }
+            catch (...)
+            {
+                Base::erase(pos);
+                throw;
+            }
+        }
+
+        // Moves [first, last) to the back and rebuilds the index without
+        // them before they are erased, so should Rebuild fail they are just
+        // rotated back into place.
+        void EraseAndReindex(iterator first, iterator last)
+        {
+            const iterator tail = end() - (last - first);
+            std::rotate(first, last, end());
+            try
+            {
+                Layout::Rebuild(begin(), tail);
+            }
+            catch (...)
+            {
+                std::rotate(first, tail, end());
+                throw;
+            }
+            Base::erase(tail, end());
+        }
+
+        // Sorts the elements from sortedSize on, merges them with the sorted
+        // ones before, and removes all but the first of equal keys.
+        void MergeTail(size_type sortedSize)
+        {
+            MyCompare& me = *this;
+            const iterator middle = begin() + static_cast<difference_type>(sortedSize);
+            if (middle == end()) return;
+            std::stable_sort(middle, end(), me);
+            std::inplace_merge(begin(), middle, end(), me);
+            Base::erase(std::unique(begin(), end(), NotLess(me)), end());
+        }
+
+        bool IsSortedAndUnique() const
         {
             const MyCompare& me = *this;
-            return std::equal_range(begin(), end(), k, me);
+            return std::adjacent_find(begin(), end(), NotLess(me)) == end();
         }
 
-        template <class K1, class V1, class C1, class A1>
-        friend bool operator==(const AssocVector<K1, V1, C1, A1>& lhs,
-                        const AssocVector<K1, V1, C1, A1>& rhs);
+        // Tells whether two neighbors of a sorted range have equal keys.
+        class NotLess
+        {
+        public:
+            explicit NotLess(const MyCompare& comp) : comp_(comp)
+            {}
+
+            bool operator()(const value_type& lhs, const value_type& rhs) const
+            { return !comp_(lhs, rhs); }
+
+        private:
+            const MyCompare& comp_;
+        };
+
+    public:
+        template <class K1, class V1, class C1, class A1,
+            template <class, class> class L1>
+        friend bool operator==(const AssocVector<K1, V1, C1, A1, L1>& lhs,
+                        const AssocVector<K1, V1, C1, A1, L1>& rhs);
 
         bool operator<(const AssocVector& rhs) const
         {
@@ -324,55 +627,65 @@ namespace Loki
             return me < yo;
         }
 
-        template <class K1, class V1, class C1, class A1>
-        friend bool operator!=(const AssocVector<K1, V1, C1, A1>& lhs,
-                               const AssocVector<K1, V1, C1, A1>& rhs);
-
-        template <class K1, class V1, class C1, class A1>
-        friend bool operator>(const AssocVector<K1, V1, C1, A1>& lhs,
-                              const AssocVector<K1, V1, C1, A1>& rhs);
-
-        template <class K1, class V1, class C1, class A1>
-        friend bool operator>=(const AssocVector<K1, V1, C1, A1>& lhs,
-                               const AssocVector<K1, V1, C1, A1>& rhs);
-
-        template <class K1, class V1, class C1, class A1>
-        friend bool operator<=(const AssocVector<K1, V1, C1, A1>& lhs,
-                               const AssocVector<K1, V1, C1, A1>& rhs);
+        template <class K1, class V1, class C1, class A1,
+            template <class, class> class L1>
+        friend bool operator!=(const AssocVector<K1, V1, C1, A1, L1>& lhs,
+                               const AssocVector<K1, V1, C1, A1, L1>& rhs);
+
+        template <class K1, class V1, class C1, class A1,
+            template <class, class> class L1>
+        friend bool operator>(const AssocVector<K1, V1, C1, A1, L1>& lhs,
+                              const AssocVector<K1, V1, C1, A1, L1>& rhs);
+
+        template <class K1, class V1, class C1, class A1,
+            template <class, class> class L1>
+        friend bool operator>=(const AssocVector<K1, V1, C1, A1, L1>& lhs,
+                               const AssocVector<K1, V1, C1, A1, L1>& rhs);
+
+        template <class K1, class V1, class C1, class A1,
+            template <class, class> class L1>
+        friend bool operator<=(const AssocVector<K1, V1, C1, A1, L1>& lhs,
+                               const AssocVector<K1, V1, C1, A1, L1>& rhs);
     };
 
-    template <class K, class V, class C, class A>
-    inline bool operator==(const AssocVector<K, V, C, A>& lhs,
-                           const AssocVector<K, V, C, A>& rhs)
+    template <class K, class V, class C, class A,
+        template <class, class> class L>
+    inline bool operator==(const AssocVector<K, V, C, A, L>& lhs,
+                           const AssocVector<K, V, C, A, L>& rhs)
     {
       const std::vector<std::pair<K, V>, A>& me = lhs;
       return me == rhs;
     }
 
-    template <class K, class V, class C, class A>
-    inline bool operator!=(const AssocVector<K, V, C, A>& lhs,
-                           const AssocVector<K, V, C, A>& rhs)
+    template <class K, class V, class C, class A,
+        template <class, class> class L>
+    inline bool operator!=(const AssocVector<K, V, C, A, L>& lhs,
+                           const AssocVector<K, V, C, A, L>& rhs)
     { return !(lhs == rhs); }
 
-    template <class K, class V, class C, class A>
-    inline bool operator>(const AssocVector<K, V, C, A>& lhs,
-                          const AssocVector<K, V, C, A>& rhs)
+    template <class K, class V, class C, class A,
+        template <class, class> class L>
+    inline bool operator>(const AssocVector<K, V, C, A, L>& lhs,
+                          const AssocVector<K, V, C, A, L>& rhs)
     { return rhs < lhs; }
 
-    template <class K, class V, class C, class A>
-    inline bool operator>=(const AssocVector<K, V, C, A>& lhs,
-                           const AssocVector<K, V, C, A>& rhs)
+    template <class K, class V, class C, class A,
+        template <class, class> class L>
+    inline bool operator>=(const AssocVector<K, V, C, A, L>& lhs,
+                           const AssocVector<K, V, C, A, L>& rhs)
     { return !(lhs < rhs); }
 
-    template <class K, class V, class C, class A>
-    inline bool operator<=(const AssocVector<K, V, C, A>& lhs,
-                           const AssocVector<K, V, C, A>& rhs)
+    template <class K, class V, class C, class A,
+        template <class, class> class L>
+    inline bool operator<=(const AssocVector<K, V, C, A, L>& lhs,
+                           const AssocVector<K, V, C, A, L>& rhs)
     { return !(rhs < lhs); }
 
 
     // specialized algorithms:
-    template <class K, class V, class C, class A>
-    void swap(AssocVector<K, V, C, A>& lhs, AssocVector<K, V, C, A>& rhs)
+    template <class K, class V, class C, class A,
+        template <class, class> class L>
+    void swap(AssocVector<K, V, C, A, L>& lhs, AssocVector<K, V, C, A, L>& rhs)
     { lhs.swap(rhs); }
 
 } // namespace Loki
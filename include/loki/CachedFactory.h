@@ -39,8 +39,10 @@
 #include <vector>
 #include <iterator>
 #include <map>
+#include <deque>
 #include <cassert>
 #include <loki/Key.h>
+#include <loki/Threads.h>
 
 #ifdef DO_EXTRA_LOKI_TESTS
 	#define D( x ) x
@@ -296,6 +298,339 @@ namespace Loki
             }
      };
 
+    namespace Private
+    {
+        /**
+         * \class	CacheKeyTable
+         * \ingroup	CachedFactoryGroup
+         * \brief	Open addressing hash table from Key to a value.
+         *
+         * Entries are never removed and keep their index, so callers may
+         * hold on to an index instead of a copy of the Key.  The table of
+         * slots only holds entry indexes, so growing it moves no values.
+         */
+        template <class K, class V>
+        class CacheKeyTable
+        {
+        private:
+            struct Entry
+            {
+                explicit Entry(const K& k, std::size_t h) : key(k), hash(h), value() {}
+                K           key;
+                std::size_t hash;
+                V           value;
+            };
+            typedef std::deque< Entry > EntryDeque;
+
+            EntryDeque                  entries;
+            std::vector< std::size_t >  slots; // entry index + 1, or 0 if empty
+            std::size_t                 mask;
+
+            void grow()
+            {
+                std::vector< std::size_t > bigger(slots.size() * 2, 0);
+                const std::size_t biggerMask = bigger.size() - 1;
+                for(std::size_t i = 0; i < entries.size(); ++i)
+                {
+                    std::size_t slot = entries[i].hash & biggerMask;
+                    while(bigger[slot] != 0)
+                        slot = (slot + 1) & biggerMask;
+                    bigger[slot] = i + 1;
+                }
+                slots.swap(bigger);
+                mask = biggerMask;
+            }
+
+        public:
+            CacheKeyTable() : entries(), slots(16, 0), mask(15)
+            {
+            }
+
+            /// Returns the index of the entry for key, adding one if needed.
+            std::size_t findOrInsert(const K& key)
+            {
+                const std::size_t hash = HashKey(key);
+                std::size_t slot = hash & mask;
+                while(slots[slot] != 0)
+                {
+                    const Entry &entry(entries[slots[slot] - 1]);
+                    if(entry.hash == hash && entry.key == key)
+                        return slots[slot] - 1;
+                    slot = (slot + 1) & mask;
+                }
+                entries.push_back(Entry(key, hash));
+                slots[slot] = entries.size();
+                if(entries.size() * 4 > slots.size() * 3)
+                    grow();
+                return entries.size() - 1;
+            }
+
+            V& getValue(std::size_t index)
+            {
+                assert(index < entries.size());
+                return entries[index].value;
+            }
+
+            std::size_t size() const
+            {
+                return entries.size();
+            }
+        };
+
+        /**
+         * \class	CacheProductTable
+         * \ingroup	CachedFactoryGroup
+         * \brief	Open addressing hash table from a product pointer to a value.
+         *
+         * Uses linear probing and shifts entries back on removal, so lookups
+         * never walk over deleted slots.  A NULL product marks an empty slot.
+         */
+        template <class P, class V>
+        class CacheProductTable
+        {
+        private:
+            struct Slot
+            {
+                Slot() : product(NULL), value() {}
+                P product;
+                V value;
+            };
+
+            std::vector< Slot > slots;
+            std::size_t         mask;
+            std::size_t         count;
+
+            std::size_t home(P product) const
+            {
+                return HashFinish(HashValue(product)) & mask;
+            }
+
+            std::size_t findSlot(P product) const
+            {
+                std::size_t slot = home(product);
+                while(slots[slot].product != NULL && slots[slot].product != product)
+                    slot = (slot + 1) & mask;
+                return slot;
+            }
+
+            void grow()
+            {
+                std::vector< Slot > old(slots.size() * 2);
+                old.swap(slots);
+                mask = slots.size() - 1;
+                for(std::size_t i = 0; i < old.size(); ++i)
+                    if(old[i].product != NULL)
+                        slots[findSlot(old[i].product)] = old[i];
+            }
+
+        public:
+            CacheProductTable() : slots(16), mask(15), count(0)
+            {
+            }
+
+            /// Returns the value for product, or NULL if it is not there.
+            V* find(P product)
+            {
+                Slot &slot(slots[findSlot(product)]);
+                return slot.product == NULL ? NULL : &slot.value;
+            }
+
+            /// Returns the value for product, adding a default one if needed.
+            V& insert(P product)
+            {
+                assert(product != NULL);
+                std::size_t slot = findSlot(product);
+                if(slots[slot].product == NULL)
+                {
+                    if((count + 1) * 4 > slots.size() * 3)
+                    {
+                        grow();
+                        slot = findSlot(product);
+                    }
+                    slots[slot].product = product;
+                    slots[slot].value = V();
+                    ++count;
+                }
+                return slots[slot].value;
+            }
+
+            /// Removes product, returns false if it was not there.
+            bool erase(P product)
+            {
+                std::size_t hole = findSlot(product);
+                if(slots[hole].product == NULL)
+                    return false;
+                // Moves back the following entries which may not be reached
+                // from their home slot once the hole is empty.
+                for(std::size_t next = (hole + 1) & mask; slots[next].product != NULL; next = (next + 1) & mask)
+                {
+                    const std::size_t wanted = home(slots[next].product);
+                    const bool between = (hole <= next)
+                        ? (hole < wanted && wanted <= next)
+                        : (hole < wanted || wanted <= next);
+                    if(!between)
+                    {
+                        slots[hole] = slots[next];
+                        hole = next;
+                    }
+                }
+                slots[hole] = Slot();
+                --count;
+                return true;
+            }
+
+            std::size_t size() const
+            {
+                return count;
+            }
+
+            /// Slots may be visited from 0 to capacity()-1, empty ones hold NULL.
+            std::size_t capacity() const
+            {
+                return slots.size();
+            }
+
+            P getProduct(std::size_t slot) const
+            {
+                return slots[slot].product;
+            }
+
+            V& getValue(std::size_t slot)
+            {
+                return slots[slot].value;
+            }
+        };
+        /**
+         * \class	CacheEvictionList
+         * \ingroup	CachedFactoryGroup
+         * \brief	Doubly linked list of cached objects for eviction policies.
+         *
+         * Holds one node per object the cache made, found through a
+         * CacheProductTable.  Nodes live in one vector and link by index,
+         * so linking, unlinking and finding a node take constant time.  Node
+         * 0 is the head of the list and holds no object.
+         */
+        template <class DT, class ST>
+        class CacheEvictionList
+        {
+        private:
+            struct Node
+            {
+                Node() : key(), prev(0), next(0), score(), linked(false) {}
+                DT          key;
+                std::size_t prev;
+                std::size_t next;
+                ST          score;
+                bool        linked;
+            };
+
+            std::vector< Node >                          nodes;
+            std::vector< std::size_t >                   freeNodes;
+            CacheProductTable< DT, std::size_t >         index;
+            std::size_t                                  linkedCount;
+
+        public:
+            CacheEvictionList() : nodes(1), freeNodes(), index(), linkedCount(0)
+            {
+            }
+
+            /// Returns the node of key, adding an unlinked one if needed.
+            std::size_t insert(const DT& key)
+            {
+                std::size_t &node(index.insert(key));
+                if(node == 0)
+                {
+                    if(freeNodes.empty())
+                    {
+                        nodes.push_back(Node());
+                        node = nodes.size() - 1;
+                    }
+                    else
+                    {
+                        node = freeNodes.back();
+                        freeNodes.pop_back();
+                        nodes[node] = Node();
+                    }
+                    nodes[node].key = key;
+                }
+                return node;
+            }
+
+            /// Returns the node of key, or 0 if the key has no node.
+            std::size_t find(const DT& key)
+            {
+                const std::size_t *pNode = index.find(key);
+                return pNode == NULL ? 0 : *pNode;
+            }
+
+            /// Unlinks and forgets the node of key.
+            void erase(const DT& key)
+            {
+                const std::size_t node = find(key);
+                if(node == 0)
+                    return;
+                unlink(node);
+                index.erase(key);
+                freeNodes.push_back(node);
+            }
+
+            /// Links node just before position, which may be the head.
+            void linkBefore(std::size_t node, std::size_t position)
+            {
+                assert(node != 0 && !nodes[node].linked);
+                Node &n(nodes[node]);
+                n.next = position;
+                n.prev = nodes[position].prev;
+                nodes[n.prev].next = node;
+                nodes[position].prev = node;
+                n.linked = true;
+                ++linkedCount;
+            }
+
+            void unlink(std::size_t node)
+            {
+                Node &n(nodes[node]);
+                if(!n.linked)
+                    return;
+                nodes[n.prev].next = n.next;
+                nodes[n.next].prev = n.prev;
+                n.linked = false;
+                --linkedCount;
+            }
+
+            bool empty() const
+            {
+                return linkedCount == 0;
+            }
+
+            /// The head of the list, node 0.
+            std::size_t head() const
+            {
+                return 0;
+            }
+
+            std::size_t next(std::size_t node) const
+            {
+                return nodes[node].next;
+            }
+
+            bool isLinked(std::size_t node) const
+            {
+                return nodes[node].linked;
+            }
+
+            const DT& getKey(std::size_t node) const
+            {
+                return nodes[node].key;
+            }
+
+            ST& getScore(std::size_t node)
+            {
+                return nodes[node].score;
+            }
+        };
+    } // namespace Private
+
 /**
  * \defgroup	EvictionPolicyCachedFactoryGroup		Eviction policies
  * \ingroup	CachedFactoryGroup
@@ -345,48 +680,52 @@ namespace Loki
 	/**
 	 * \class	EvictLRU
 	 * \ingroup	EvictionPolicyCachedFactoryGroup
-	 * \brief	Evicts least accessed objects first.
+	 * \brief	Evicts the least recently used object first.
 	 *
 	 * Implementation of the Least recent used algorithm as
 	 * described in http://en.wikipedia.org/wiki/Page_replacement_algorithms .
 	 *
-	 * WARNING : If an object is heavily fetched
-	 * (more than ULONG_MAX = UINT_MAX = 4294967295U)
-	 * it could unfortunately be removed from the cache.
+	 * Objects waiting in the cache are kept in a list, ordered by the time
+	 * they were released.  Fetch, release and eviction take constant time.
+	 * Objects which are out are not in the list and can't be evicted.
 	 */
     template
     <
     	typename DT, // Data Type (AbstractProduct*)
-    	typename ST = unsigned // default data type to use as Score Type
+    	typename ST = unsigned // Score Type not used by this policy
     >
-    class EvictLRU : public EvictionHelper< ST , DT >
+    class EvictLRU
     {
     private:
-    	typedef EvictionHelper< ST , DT >	EH;
+        Private::CacheEvictionList< DT, ST >	m_list;
+
     protected:
 
         virtual ~EvictLRU(){}
 
-    	// OnStore initialize the counter for the new key
-    	// If the key already exists, the counter is reseted
+    	// OnStore gives a node to the new key
     	void onCreate(const DT& key)
         {
-    		EH::m_mHitCount[key] = 0;
+    		m_list.insert(key);
     	}
 
-    	void onFetch(const DT&)
+    	// onFetch takes the object out of the list, it can't be evicted
+    	void onFetch(const DT& key)
         {
+            m_list.unlink(m_list.insert(key));
     	}
 
-    	// onRelease increments the hit counter associated with the object
+    	// onRelease makes the object the most recently used one
         void onRelease(const DT& key)
         {
-    		++(EH::m_mHitCount[key]);
+            const std::size_t node = m_list.insert(key);
+            m_list.unlink(node);
+            m_list.linkBefore(node, m_list.head());
         }
 
     	void onDestroy(const DT& key)
     	{
-            EH::m_mHitCount.erase(key);
+            m_list.erase(key);
     	}
 
     	// this function is implemented in Cache and redirected
@@ -396,7 +735,9 @@ namespace Loki
     	// LRU Eviction policy
     	void evict()
     	{
-    		remove(EH::getLowerBound());
+    		if(m_list.empty())
+    		    throw EvictionException();
+    		remove(m_list.getKey(m_list.next(m_list.head())));
     	}
         const char* name(){return "LRU";}
     };
@@ -404,78 +745,96 @@ namespace Loki
 	/**
 	 * \class	EvictAging
 	 * \ingroup	EvictionPolicyCachedFactoryGroup
-	 * \brief	LRU aware of the time span of use
+	 * \brief	LRU aware of how often objects are used
 	 *
-	 * Implementation of the Aging algorithm as
+	 * Implementation of the Clock algorithm with an age counter, as
 	 * described in http://en.wikipedia.org/wiki/Page_replacement_algorithms .
 	 *
-	 * This method is much more costly than evict LRU so
-	 * if you need extreme performance consider switching to EvictLRU
+	 * Objects waiting in the cache form a ring swept by a hand.  Each release
+	 * makes an object older, up to MaxAge.  To evict, the hand skips objects
+	 * with an age, making each one younger, and evicts the first object which
+	 * has none left.  Objects used often thus survive several sweeps.  Each
+	 * step of the hand undoes one release, so eviction takes constant time
+	 * on average.
 	 */
     template
     <
     	typename DT, // Data Type (AbstractProduct*)
     	typename ST = unsigned // default data type to use as Score Type
     >
-    class EvictAging : public EvictionHelper< ST, DT >
+    class EvictAging
     {
     private:
         EvictAging(const EvictAging&);
         EvictAging& operator=(const EvictAging&);
-    	typedef EvictionHelper< ST, DT >		       		EH;
-    	typedef typename EH::HitMap						HitMap;
-    	typedef typename EH::HitMapItr					HitMapItr;
-
-    	// update the counter
-		template<class T> struct updateCounter : public std::unary_function<T, void>
-		{
-			updateCounter(const DT& key): key_(key){}
-			void operator()(T x)
-			{
-				x.second = (x.first == key_ ? (x.second >> 1) | ( 1 << ((sizeof(ST)-1)*8) ) : x.second >> 1);
-    			D( std::cout <<  x.second << std::endl; )
-			}
-			const DT &key_;
-            updateCounter(const updateCounter& rhs) : key_(rhs.key_){}
-        private:
-            updateCounter& operator=(const updateCounter& rhs);
-		};
+
+        Private::CacheEvictionList< DT, ST >	m_list;
+        std::size_t								m_hand;
+
+        enum { MaxAge = 3 };
+
+        // takes node out of the ring, moving the hand past it
+        void unlink(std::size_t node)
+        {
+            if(m_hand == node)
+                m_hand = m_list.next(node);
+            m_list.unlink(node);
+        }
+
     protected:
-         EvictAging(){}
+         EvictAging() : m_list(), m_hand(0) {}
          virtual ~EvictAging(){}
 
-    	// OnStore initialize the counter for the new key
-    	// If the key already exists, the counter is reseted
+    	// OnStore gives a node to the new key, with no age
     	void onCreate(const DT& key){
-    		EH::m_mHitCount[key] = 0;
+    		m_list.getScore(m_list.insert(key)) = ST();
     	}
 
-    	void onFetch(const DT&){}
+    	// onFetch takes the object out of the ring, it can't be evicted
+    	void onFetch(const DT& key){
+            unlink(m_list.insert(key));
+        }
 
-    	// onRelease increments the hit counter associated with the object
-    	// Updating every counters by iterating over the map
-    	// If the key is the key of the fetched object :
-    	//  the counter is shifted to the right and it's MSB is set to 1
-    	// else
-    	//  the counter is shifted to the left
+    	// onRelease puts the object back in the ring just behind the hand,
+    	// where it will be looked at last, and makes it older
         void onRelease(const DT& key)
         {
-        	std::for_each(EH::m_mHitCount.begin(), EH::m_mHitCount.end(), updateCounter< typename HitMap::value_type >(key));
+            const std::size_t node = m_list.insert(key);
+            unlink(node);
+            m_list.linkBefore(node, m_hand);
+            ST &age(m_list.getScore(node));
+            if(age < static_cast< ST >(MaxAge))
+                ++age;
         }
 
         void onDestroy(const DT& key)
         {
-            EH::m_mHitCount.erase(key);
+            const std::size_t node = m_list.find(key);
+            if(node != 0)
+                unlink(node);
+            m_list.erase(key);
         }
 
     	// this function is implemented in Cache and redirected
     	// to the Storage Policy
     	virtual void remove(DT const key)=0;
 
-    	// LRU with Aging Eviction policy
+    	// Clock with aging Eviction policy
     	void evict()
     	{
-    		remove(EH::getLowerBound());
+    		if(m_list.empty())
+    		    throw EvictionException();
+    		for(;;)
+    		{
+    		    if(m_hand == m_list.head())
+    		        m_hand = m_list.next(m_hand);
+    		    ST &age(m_list.getScore(m_hand));
+    		    if(age == ST())
+    		        break;
+    		    --age;
+    		    m_hand = m_list.next(m_hand);
+    		}
+    		remove(m_list.getKey(m_hand));
     	}
         const char* name(){return "LRU with aging";}
     };
@@ -487,6 +846,9 @@ namespace Loki
 	 *
 	 * Implementation of the Random algorithm as
 	 * described in http://en.wikipedia.org/wiki/Page_replacement_algorithms .
+	 *
+	 * Only objects waiting in the cache are candidates.  Each fetch, release
+	 * and eviction takes constant time.
 	 */
     template
     <
@@ -497,8 +859,24 @@ namespace Loki
     {
     private:
     	std::vector< DT >	m_vKeys;
+    	Private::CacheProductTable< DT, std::size_t >	m_positions; // position in m_vKeys + 1
     	typedef typename std::vector< DT >::size_type	size_type;
-    	typedef typename std::vector< DT >::iterator		iterator;
+
+    	// removes key from m_vKeys by moving the last key in its place
+    	void take(const DT& key)
+    	{
+    		std::size_t *pPosition = m_positions.find(key);
+    		if(pPosition == NULL)
+    		    return;
+    		const std::size_t position = *pPosition - 1;
+    		m_positions.erase(key);
+    		if(position + 1 != m_vKeys.size())
+    		{
+    		    m_vKeys[position] = m_vKeys.back();
+    		    *m_positions.find(m_vKeys[position]) = position + 1;
+    		}
+    		m_vKeys.pop_back();
+    	}
 
     protected:
 
@@ -507,16 +885,21 @@ namespace Loki
     	void onCreate(const DT&){
     	}
 
-    	void onFetch(const DT& ){
+    	void onFetch(const DT& key){
+            take(key);
     	}
 
     	void onRelease(const DT& key){
-            m_vKeys.push_back(key);
+    		std::size_t &position(m_positions.insert(key));
+    		if(position == 0)
+    		{
+                m_vKeys.push_back(key);
+                position = m_vKeys.size();
+    		}
     	}
 
     	void onDestroy(const DT& key){
-    		using namespace std;
-            m_vKeys.erase(remove_if(m_vKeys.begin(), m_vKeys.end(), bind2nd(equal_to< DT >(), key)), m_vKeys.end());
+            take(key);
     	}
 
     	// Implemented in Cache and redirected to the Storage Policy
@@ -701,16 +1084,33 @@ namespace Loki
         typedef typename NP::ProductReturn ProductReturn;
      private:
         typedef Key< Impl, IdentifierType > MyKey;
-        typedef std::map< MyKey, ObjVector >  KeyToObjVectorMap;
-        typedef std::map< AbstractProduct*, MyKey >  FetchedObjToKeyMap;
+
+        // What the cache knows about each object it made and did not destroy.
+        struct ProductInfo
+        {
+            ProductInfo() : keyIndex(0), out(false) {}
+            std::size_t keyIndex; // index of the key in fromKeyToObjVector
+            bool        out;      // true while the object is provided
+        };
+
+        typedef Private::CacheKeyTable< MyKey, ObjVector >  KeyToObjVectorMap;
+        typedef Private::CacheProductTable< AbstractProduct*, ProductInfo >  ObjToInfoMap;
 
         MyFactory			factory;
         KeyToObjVectorMap   fromKeyToObjVector;
-        FetchedObjToKeyMap  providedObjects;
+        ObjToInfoMap        cachedObjects;
         unsigned            outObjects;
+        unsigned            evictionBatch;
 
-        ObjVector& getContainerFromKey(MyKey key){
-            return fromKeyToObjVector[key];
+        ObjVector& getContainerFromKeyIndex(std::size_t keyIndex){
+            return fromKeyToObjVector.getValue(keyIndex);
+        }
+
+        void setProvided(AbstractProduct * const pProduct, std::size_t keyIndex)
+        {
+            ProductInfo &info(cachedObjects.insert(pProduct));
+            info.keyIndex = keyIndex;
+            info.out = true;
         }
 
         AbstractProduct* getPointerToObjectInContainer(ObjVector &entry)
@@ -734,10 +1134,27 @@ namespace Loki
             if(pProduct!=NULL) // object already exists
                 return false;
             if(CP::canCreate()==false) // Are we allowed to Create ?
-                EP::evict(); // calling Eviction Policy to clean up
+                evictObjects(); // calling Eviction Policy to clean up
             return true;
         }
 
+        // Evicts up to evictionBatch objects, only throws if none could go.
+        void evictObjects()
+        {
+            EP::evict();
+            for(unsigned i = 1; i < evictionBatch; ++i)
+            {
+                try
+                {
+                    EP::evict();
+                }
+                catch(EvictionException &)
+                {
+                    break;
+                }
+            }
+        }
+
         void ReleaseObjectFromContainer(ObjVector &entry, AbstractProduct * const object)
         {
             entry.push_back(object);
@@ -771,55 +1188,26 @@ namespace Loki
             EP::onDestroy(pProduct);
         }
 
-		// delete the object
-		template<class T> struct deleteObject : public std::unary_function<T, void>
-		{
-			void operator()(T x){ delete x; }
-		};
-
-		// delete the objects in the vector
-		template<class T> struct deleteVectorObjects : public std::unary_function<T, void>
-		{
-			void operator()(T x){
-				ObjVector &vec(x.second);
-				std::for_each(vec.begin(), vec.end(), deleteObject< typename ObjVector::value_type>());
-			}
-		};
-
-		// delete the keys of the map
-		template<class T> struct deleteMapKeys : public std::unary_function<T, void>
-		{
-			void operator()(T x){ delete x.first; }
-		};
-
      protected:
         virtual void remove(AbstractProduct * const pProduct)
         {
-            typename FetchedObjToKeyMap::iterator fetchedItr = providedObjects.find(pProduct);
-            if(fetchedItr!=providedObjects.end()) // object is unreleased.
+            ProductInfo *pInfo = cachedObjects.find(pProduct);
+            if(pInfo==NULL) // the product is not in the cache ?!
                 throw CacheException();
-            bool productRemoved = false;
-            typename KeyToObjVectorMap::iterator objVectorItr;
-            typename ObjVector::iterator objItr;
-            for(objVectorItr=fromKeyToObjVector.begin();objVectorItr!=fromKeyToObjVector.end();++objVectorItr)
-            {
-                ObjVector &v((*objVectorItr).second);
-                objItr = remove_if(v.begin(), v.end(), std::bind2nd(std::equal_to<AbstractProduct*>(), pProduct));
-                if(objItr != v.end()) // we found the vector containing pProduct and removed it
-                {
-                    onDestroy(pProduct); // warning policies we are about to destroy an object
-                    v.erase(objItr, v.end()); // real removing
-                    productRemoved = true;
-                    break;
-                }
-            }
-            if(productRemoved==false)
+            if(pInfo->out) // object is unreleased.
+                throw CacheException();
+            ObjVector &v(getContainerFromKeyIndex(pInfo->keyIndex));
+            typename ObjVector::iterator objItr = remove_if(v.begin(), v.end(), std::bind2nd(std::equal_to<AbstractProduct*>(), pProduct));
+            if(objItr == v.end())
                 throw CacheException(); // the product is not in the cache ?!
+            onDestroy(pProduct); // warning policies we are about to destroy an object
+            v.erase(objItr, v.end()); // real removing
+            cachedObjects.erase(pProduct);
             delete pProduct; // deleting it
         }
 
      public:
-        CachedFactory() : factory(), fromKeyToObjVector(), providedObjects(), outObjects(0)
+        CachedFactory() : factory(), fromKeyToObjVector(), cachedObjects(), outObjects(0), evictionBatch(1)
         {
         }
 
@@ -829,21 +1217,14 @@ namespace Loki
             // debug information
             SP::onDebug();
             // cleaning the Cache
-            for_each(fromKeyToObjVector.begin(), fromKeyToObjVector.end(),
-            	deleteVectorObjects< typename KeyToObjVectorMap::value_type >()
-            );
-            if(!providedObjects.empty())
-            {
-				// The factory is responsible for the creation and destruction of objects.
-				// If objects are out during the destruction of the Factory : deleting anyway.
-				// This might not be a good idea. But throwing an exception in a destructor is
-				// considered as a bad pratice and asserting might be too much.
-				// What to do ? Leaking memory or corrupting in use pointers ? hmm...
-                D( cout << "====>>  Cache destructor : deleting "<< providedObjects.size()<<" in use objects  <<====" << endl << endl; )
-                for_each(providedObjects.begin(), providedObjects.end(),
-	                deleteMapKeys< typename FetchedObjToKeyMap::value_type >()
-                );
-            }
+			// The factory is responsible for the creation and destruction of objects.
+			// If objects are out during the destruction of the Factory : deleting anyway.
+			// This might not be a good idea. But throwing an exception in a destructor is
+			// considered as a bad pratice and asserting might be too much.
+			// What to do ? Leaking memory or corrupting in use pointers ? hmm...
+            D( if(outObjects!=0) cout << "====>>  Cache destructor : deleting "<< outObjects<<" in use objects  <<====" << endl << endl; )
+            for(std::size_t slot = 0; slot < cachedObjects.capacity(); ++slot)
+                delete cachedObjects.getProduct(slot);
         }
 
         ///////////////////////////////////
@@ -876,14 +1257,15 @@ namespace Loki
         ProductReturn CreateObject(const IdentifierType& id)
         {
             MyKey key(id);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -891,14 +1273,15 @@ namespace Loki
 				    Parm1 p1)
         {
             MyKey key(id,p1);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -906,14 +1289,15 @@ namespace Loki
 				    Parm1 p1, Parm2 p2)
         {
             MyKey key(id,p1,p2);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -921,14 +1305,15 @@ namespace Loki
 				    Parm1 p1, Parm2 p2, Parm3 p3)
         {
             MyKey key(id,p1,p2,p3);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3);
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -936,7 +1321,8 @@ namespace Loki
 				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
         {
             MyKey key(id,p1,p2,p3,p4);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -944,7 +1330,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -952,7 +1338,8 @@ namespace Loki
 				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
         {
             MyKey key(id,p1,p2,p3,p4,p5);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -960,7 +1347,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -969,7 +1356,8 @@ namespace Loki
 				    Parm6 p6)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -977,7 +1365,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -986,7 +1374,8 @@ namespace Loki
 				    Parm6 p6, Parm7 p7 )
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -994,7 +1383,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1003,7 +1392,8 @@ namespace Loki
 				    Parm6 p6, Parm7 p7, Parm8 p8)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1011,7 +1401,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1020,7 +1410,8 @@ namespace Loki
 				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1028,7 +1419,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1037,7 +1428,8 @@ namespace Loki
 				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9,Parm10 p10)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1045,7 +1437,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1055,7 +1447,8 @@ namespace Loki
 				    Parm11 p11)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1063,7 +1456,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1073,7 +1466,8 @@ namespace Loki
 				    Parm11 p11, Parm12 p12)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1081,7 +1475,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1091,7 +1485,8 @@ namespace Loki
 				    Parm11 p11, Parm12 p12, Parm13 p13)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1100,7 +1495,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1110,7 +1505,8 @@ namespace Loki
 				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1119,7 +1515,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1129,7 +1525,8 @@ namespace Loki
 				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
         {
             MyKey key(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15);
-            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKey(key)));
+            const std::size_t keyIndex(fromKeyToObjVector.findOrInsert(key));
+            AbstractProduct *pProduct(getPointerToObjectInContainer(getContainerFromKeyIndex(keyIndex)));
             if(shouldCreateObject(pProduct))
             {
                 pProduct = factory.CreateObject(key.id,key.p1,key.p2,key.p3
@@ -1138,7 +1535,7 @@ namespace Loki
                 onCreate(pProduct);
             }
             onFetch(pProduct);
-            providedObjects[pProduct] = key;
+            setProvided(pProduct, keyIndex);
             return NP::encapsulate(pProduct);
         }
 
@@ -1151,12 +1548,21 @@ namespace Loki
         void ReleaseObject(ProductReturn &object)
         {
             AbstractProduct* pProduct(NP::release(object));
-            typename FetchedObjToKeyMap::iterator itr = providedObjects.find(pProduct);
-            if(itr == providedObjects.end())
+            ProductInfo *pInfo = cachedObjects.find(pProduct);
+            if(pInfo == NULL || !pInfo->out)
                 throw CacheException();
             onRelease(pProduct);
-            ReleaseObjectFromContainer(getContainerFromKey((*itr).second), pProduct);
-            providedObjects.erase(itr);
+            pInfo->out = false;
+            ReleaseObjectFromContainer(getContainerFromKeyIndex(pInfo->keyIndex), pProduct);
+        }
+
+        /// Sets how many objects to evict each time the CreationPolicy
+        /// forbids a creation.  Evicting several at once makes room for the
+        /// next creations too.  Default is 1.
+        void setEvictionBatchSize(unsigned count)
+        {
+            assert(count>0);
+            evictionBatch = count;
         }
 
         /// display the cache configuration
@@ -1172,6 +1578,425 @@ namespace Loki
             cout << "############################" << endl;
         }
      };
+
+	/**
+	 * \class		ShardedCachedFactory
+	 * \ingroup		CachedFactoryGroup
+	 * \brief		Thread-safe CachedFactory split in shards
+	 *
+	 * Keeps ShardCount CachedFactory objects, each with its own lock, pools
+	 * and policies.  A product is created and cached by the shard picked by
+	 * the hash of its identifier and creator parameters (see HashKey), so
+	 * threads asking for different keys seldom wait for the same lock.  On
+	 * release the shard is found again through a table striped by the
+	 * product's address, so releases do not share one lock either.
+	 *
+	 * The CreationPolicy and EvictionPolicy of a shard only see the products
+	 * of that shard : an AmountLimitedCreation limit applies to each shard,
+	 * and eviction only makes room in the shard which asks for it.  Use
+	 * GetShard to set up the shards or to read their statistics.
+	 *
+	 * The factory is only thread-safe if ThreadingModel locks per object,
+	 * like ObjectLevelLockable does.  The default is LOKI_DEFAULT_THREADING.
+	 */
+	 template
+     <
+        class AbstractProduct,
+        typename IdentifierType,
+        typename CreatorParmTList = NullType,
+        template<class> class EncapsulationPolicy = SimplePointer,
+        class CreationPolicy = AlwaysCreate,
+        template <typename , typename> class EvictionPolicy = EvictRandom,
+        class StatisticPolicy = NoStatisticPolicy,
+        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError,
+        class ObjVector = std::vector<AbstractProduct*>,
+        unsigned int ShardCount = 16,
+        template <class, class> class ThreadingModel = LOKI_DEFAULT_THREADING,
+        class MutexPolicy = LOKI_DEFAULT_MUTEX
+     >
+	 class ShardedCachedFactory :
+            protected EncapsulationPolicy<AbstractProduct>
+	 {
+     public:
+        /// Type of each shard.
+        typedef CachedFactory< AbstractProduct, IdentifierType, CreatorParmTList,
+            SimplePointer, CreationPolicy, EvictionPolicy, StatisticPolicy,
+            FactoryErrorPolicy, ObjVector > ShardType;
+
+     private:
+        typedef FactoryImpl< AbstractProduct, IdentifierType, CreatorParmTList > Impl;
+        typedef Functor< AbstractProduct* , CreatorParmTList > ProductCreator;
+        typedef EncapsulationPolicy<AbstractProduct> NP;
+
+        typedef typename Impl::Parm1 Parm1;
+        typedef typename Impl::Parm2 Parm2;
+        typedef typename Impl::Parm3 Parm3;
+        typedef typename Impl::Parm4 Parm4;
+        typedef typename Impl::Parm5 Parm5;
+        typedef typename Impl::Parm6 Parm6;
+        typedef typename Impl::Parm7 Parm7;
+        typedef typename Impl::Parm8 Parm8;
+        typedef typename Impl::Parm9 Parm9;
+        typedef typename Impl::Parm10 Parm10;
+        typedef typename Impl::Parm11 Parm11;
+        typedef typename Impl::Parm12 Parm12;
+        typedef typename Impl::Parm13 Parm13;
+        typedef typename Impl::Parm14 Parm14;
+        typedef typename Impl::Parm15 Parm15;
+
+     public:
+        typedef typename NP::ProductReturn ProductReturn;
+     private:
+        typedef Key< Impl, IdentifierType > MyKey;
+
+        struct Shard : public ThreadingModel< Shard, MutexPolicy >
+        {
+            ShardType cache;
+        };
+
+        typedef Private::CacheProductTable< AbstractProduct*, Shard* > FetchedObjToShardMap;
+
+        struct Stripe : public ThreadingModel< Stripe, MutexPolicy >
+        {
+            FetchedObjToShardMap providedObjects;
+        };
+
+        Shard   shards[ShardCount];
+        Stripe  stripes[ShardCount];
+
+        ShardedCachedFactory(const ShardedCachedFactory&);
+        ShardedCachedFactory& operator=(const ShardedCachedFactory&);
+
+        Shard& getShard(const MyKey& key)
+        {
+            return shards[HashKey(key) % ShardCount];
+        }
+
+        Stripe& getStripe(AbstractProduct * const pProduct)
+        {
+            return stripes[HashFinish(HashValue(pProduct)) % ShardCount];
+        }
+
+        // Remembers which shard provided the object, then hands it out.
+        ProductReturn provide(Shard &shard, AbstractProduct *pProduct)
+        {
+            Stripe &stripe(getStripe(pProduct));
+            try
+            {
+                typename Stripe::Lock lock(stripe);
+                stripe.providedObjects.insert(pProduct) = &shard;
+            }
+            catch(...)
+            {
+                typename Shard::Lock lock(shard);
+                shard.cache.ReleaseObject(pProduct);
+                throw;
+            }
+            return NP::encapsulate(pProduct);
+        }
+
+     public:
+        ShardedCachedFactory()
+        {
+        }
+
+        ~ShardedCachedFactory()
+        {
+        }
+
+        /// Registers the creator with every shard.
+        bool Register(const IdentifierType& id, ProductCreator creator)
+        {
+            bool registered = true;
+            for(unsigned int i = 0; i < ShardCount; ++i)
+            {
+                typename Shard::Lock lock(shards[i]);
+                registered = shards[i].cache.Register(id, creator) && registered;
+            }
+            return registered;
+        }
+
+        template <class PtrObj, typename CreaFn>
+        bool Register(const IdentifierType& id, const PtrObj& p, CreaFn fn)
+        {
+            bool registered = true;
+            for(unsigned int i = 0; i < ShardCount; ++i)
+            {
+                typename Shard::Lock lock(shards[i]);
+                registered = shards[i].cache.Register(id, p, fn) && registered;
+            }
+            return registered;
+        }
+
+        bool Unregister(const IdentifierType& id)
+        {
+            bool unregistered = true;
+            for(unsigned int i = 0; i < ShardCount; ++i)
+            {
+                typename Shard::Lock lock(shards[i]);
+                unregistered = shards[i].cache.Unregister(id) && unregistered;
+            }
+            return unregistered;
+        }
+
+        /// Return the registered ID in this Factory
+        std::vector<IdentifierType>& RegisteredIds()
+        {
+            typename Shard::Lock lock(shards[0]);
+            return shards[0].cache.RegisteredIds();
+        }
+
+        /// Returns the number of shards.
+        unsigned int GetShardCount() const
+        {
+            return ShardCount;
+        }
+
+        /** Returns one shard, to set up its policies or read its statistics.
+         * The shard is not locked, so only use it while no other thread uses
+         * this factory.
+         */
+        ShardType& GetShard(unsigned int index)
+        {
+            assert(index < ShardCount);
+            return shards[index].cache;
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id)
+        {
+            Shard &shard(getShard(MyKey(id)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1)
+        {
+            Shard &shard(getShard(MyKey(id,p1)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12, Parm13 p13)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14);
+            }
+            return provide(shard, pProduct);
+        }
+
+        ProductReturn CreateObject(const IdentifierType& id,
+				    Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+				    Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+				    Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
+        {
+            Shard &shard(getShard(MyKey(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15)));
+            AbstractProduct *pProduct;
+            {
+                typename Shard::Lock lock(shard);
+                pProduct = shard.cache.CreateObject(id,p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15);
+            }
+            return provide(shard, pProduct);
+        }
+
+		/// Use this function to release the object
+		/**
+		 * Throws a CacheException if the object wasn't provided by this
+		 * factory, or was already released.
+		 */
+        void ReleaseObject(ProductReturn &object)
+        {
+            AbstractProduct* pProduct(NP::release(object));
+            Stripe &stripe(getStripe(pProduct));
+            Shard *pShard = NULL;
+            {
+                typename Stripe::Lock lock(stripe);
+                Shard **ppShard = stripe.providedObjects.find(pProduct);
+                if(ppShard == NULL)
+                    throw CacheException();
+                pShard = *ppShard;
+                stripe.providedObjects.erase(pProduct);
+            }
+            typename Shard::Lock lock(*pShard);
+            pShard->cache.ReleaseObject(pProduct);
+        }
+
+        /// display the cache configuration
+        void displayCacheType()
+        {
+            std::cout << "## " << ShardCount << " shards, each with :" << std::endl;
+            shards[0].cache.displayCacheType();
+        }
+     };
 } // namespace Loki
 
 #endif // end file guardian
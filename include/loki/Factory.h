@@ -38,6 +38,10 @@
 #include <loki/SmallObj.h>
 #include <loki/Sequence.h>
 
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE ) && !defined( LOKI_WINDOWS_H )
+#include <sched.h>
+#endif
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable: 4702)
@@ -757,13 +761,19 @@ template <typename AP, typename Id, typename P1 >
 ///  Alternatively you could suppress for Functor the inheritance
 ///  from SmallObject by defining the macro:
 /// \code LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT \endcode
+///
+///  IdToProductLayout is the layout policy of the AssocVector which maps
+///  identifiers to creators.  Factories which are filled at startup and
+///  then only create objects may look up faster with SortedKeysLayout or
+///  BTreeKeysLayout.
 ////////////////////////////////////////////////////////////////////////////////
     template
     <
         class AbstractProduct,
         typename IdentifierType,
         typename CreatorParmTList = NullType,
-        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError
+        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError,
+        template<class, class> class IdToProductLayout = SortedPairsLayout
     >
     class Factory : public FactoryErrorPolicy<IdentifierType, AbstractProduct>
     {
@@ -789,7 +799,10 @@ template <typename AP, typename Id, typename P1 >
         typedef Functor<AbstractProduct*, CreatorParmTList> ProductCreator;
 
     private:
-        typedef AssocVector<IdentifierType, ProductCreator> IdToProductMap;
+        typedef AssocVector<IdentifierType, ProductCreator,
+            std::less<IdentifierType>,
+            std::allocator<std::pair<IdentifierType, ProductCreator> >,
+            IdToProductLayout> IdToProductMap;
 
         IdToProductMap associations_;
 
@@ -999,6 +1012,559 @@ template <typename AP, typename Id, typename P1 >
 
     };
 
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class ConcurrentFactory
+///
+///  \ingroup FactoryGroup
+///  A Factory which many threads can use at once, even while others register
+///  and unregister creators, as plugins do when they are loaded at runtime.
+///
+///  CreateObject never locks.  It reads an immutable snapshot of the map
+///  from identifiers to creators through an atomic pointer.  Register and
+///  Unregister lock MutexPolicy, copy the snapshot, change the copy and
+///  publish it.  Then they wait until no thread can still read the old
+///  snapshot before they delete it, in the way of read-copy-update: readers
+///  count themselves in one of two counters picked by the parity of an
+///  epoch, and the writer flips the epoch twice, each time waiting for the
+///  counter new readers no longer use to drain.  The counters are striped
+///  over ReaderSlots cache lines so that readers on different cores seldom
+///  write the same line.  Each thread gets the next slot the first time it
+///  reads, through thread local storage, so up to ReaderSlots threads never
+///  share a line.  Without thread local storage, the slot is a hash of an
+///  address on the stack of the reader.
+///
+///  Registering is thus slow, as it copies the whole map, and a creator must
+///  not register or unregister with the factory which calls it, since the
+///  writer would wait for itself.  Since snapshots never change after they
+///  are published, SortedKeysLayout or BTreeKeysLayout are good choices
+///  for IdToProductLayout.
+///
+///  Without lock-free atomic functions, see LOKI_THREADS_ATOMIC_LOCKFREE,
+///  CreateObject locks MutexPolicy as well.
+////////////////////////////////////////////////////////////////////////////////
+    template
+    <
+        class AbstractProduct,
+        typename IdentifierType,
+        typename CreatorParmTList = NullType,
+        template<typename, class> class FactoryErrorPolicy = DefaultFactoryError,
+        template<class, class> class IdToProductLayout = SortedPairsLayout,
+        class MutexPolicy = LOKI_DEFAULT_MUTEX
+    >
+    class ConcurrentFactory : public FactoryErrorPolicy<IdentifierType, AbstractProduct>
+    {
+    protected:
+        typedef FactoryImpl< AbstractProduct, IdentifierType, CreatorParmTList > Impl;
+
+        typedef typename Impl::Parm1 Parm1;
+        typedef typename Impl::Parm2 Parm2;
+        typedef typename Impl::Parm3 Parm3;
+        typedef typename Impl::Parm4 Parm4;
+        typedef typename Impl::Parm5 Parm5;
+        typedef typename Impl::Parm6 Parm6;
+        typedef typename Impl::Parm7 Parm7;
+        typedef typename Impl::Parm8 Parm8;
+        typedef typename Impl::Parm9 Parm9;
+        typedef typename Impl::Parm10 Parm10;
+        typedef typename Impl::Parm11 Parm11;
+        typedef typename Impl::Parm12 Parm12;
+        typedef typename Impl::Parm13 Parm13;
+        typedef typename Impl::Parm14 Parm14;
+        typedef typename Impl::Parm15 Parm15;
+
+        typedef Functor<AbstractProduct*, CreatorParmTList> ProductCreator;
+
+    private:
+        typedef AssocVector<IdentifierType, ProductCreator,
+            std::less<IdentifierType>,
+            std::allocator<std::pair<IdentifierType, ProductCreator> >,
+            IdToProductLayout> IdToProductMap;
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+        typedef LOKI_THREADS_LONG CountType;
+
+        typedef ::Loki::AtomicOps< CountType > AtomicOps;
+
+        enum { ReaderSlots = 16, CacheLineSize = 64 };
+
+        /// Readers which entered while the epoch was even or odd.  Fills a
+        /// cache line, and readers_ starts each slot on a line boundary.
+        struct ReaderSlot
+        {
+            volatile CountType counts_[ 2 ];
+            char padding_[ CacheLineSize - 2 * sizeof( CountType ) ];
+        };
+
+        /// Returns the slot of the calling thread.
+        static std::size_t GetReaderSlot()
+        {
+#if defined( LOKI_THREAD_LOCAL )
+            if ( 0 == threadSlot_ )
+                threadSlot_ = static_cast< unsigned int >( AtomicOps::Add( nextThreadSlot_, 1 ) );
+            return ( threadSlot_ - 1 ) % ReaderSlots;
+#else
+            // Thread stacks are megabytes apart and aligned alike, so only a
+            // hash of the whole address spreads them over the slots.
+            const char here = 0;
+            const std::size_t address = reinterpret_cast< std::size_t >( &here ) >> 12;
+            return ( static_cast< unsigned long >( address ) * 2654435761UL >> 16 ) % ReaderSlots;
+#endif
+        }
+
+#if defined( LOKI_THREAD_LOCAL )
+        /// One more than the slot of this thread, or 0 until it reads once.
+        static LOKI_THREAD_LOCAL unsigned int threadSlot_;
+
+        /// # of threads which were given a slot.
+        static volatile CountType nextThreadSlot_;
+#endif
+
+#endif
+
+        /// Counts the calling thread as a reader for its lifetime, and gives
+        /// the snapshot it may read meanwhile.
+        class ReadSection
+        {
+        public:
+            explicit ReadSection( const ConcurrentFactory & factory )
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            {
+                const std::size_t slot = GetReaderSlot();
+                const CountType parity = AtomicOps::Load( factory.epoch_ ) & 1;
+                count_ = &factory.readers_[ slot ].counts_[ parity ];
+                AtomicOps::Add( *count_, 1 );
+                snapshot_ = LoadSnapshot( factory.snapshot_ );
+            }
+#else
+                : mutex_( &factory.mutex_ )
+            {
+                mutex_->Lock();
+                snapshot_ = factory.snapshot_;
+            }
+#endif
+
+            ~ReadSection()
+            {
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+                AtomicOps::Add( *count_, -1 );
+#else
+                mutex_->Unlock();
+#endif
+            }
+
+            const IdToProductMap * operator->() const
+            {
+                return snapshot_;
+            }
+
+        private:
+            ReadSection( const ReadSection & );
+            ReadSection & operator = ( const ReadSection & );
+
+            const IdToProductMap * snapshot_;
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            volatile CountType * count_;
+#else
+            MutexPolicy * mutex_;
+#endif
+        };
+
+        friend class ReadSection;
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+        static IdToProductMap * LoadSnapshot( IdToProductMap * volatile const & snapshot )
+        {
+#if defined( LOKI_WINDOWS_H )
+            return static_cast< IdToProductMap * >( ::InterlockedCompareExchangePointer(
+                reinterpret_cast< void * volatile * >(
+                    const_cast< IdToProductMap * volatile * >( &snapshot ) ), 0, 0 ) );
+#else
+            return __atomic_load_n( &snapshot, __ATOMIC_SEQ_CST );
+#endif
+        }
+
+        static IdToProductMap * ExchangeSnapshot( IdToProductMap * volatile & snapshot,
+            IdToProductMap * value )
+        {
+#if defined( LOKI_WINDOWS_H )
+            return static_cast< IdToProductMap * >( ::InterlockedExchangePointer(
+                reinterpret_cast< void * volatile * >( &snapshot ), value ) );
+#else
+            return __atomic_exchange_n( &snapshot, value, __ATOMIC_SEQ_CST );
+#endif
+        }
+
+        /// Returns once every reader which may have seen the snapshot before
+        /// the last Publish has left.
+        void WaitForReaders()
+        {
+            for ( unsigned int flip = 0; flip < 2; ++flip )
+            {
+                const CountType parity = ( AtomicOps::Add( epoch_, 1 ) - 1 ) & 1;
+                for ( unsigned int slot = 0; slot < ReaderSlots; ++slot )
+                {
+                    while ( AtomicOps::Load( readers_[ slot ].counts_[ parity ] ) != 0 )
+                    {
+#if defined( LOKI_WINDOWS_H )
+                        ::SwitchToThread();
+#else
+                        ::sched_yield();
+#endif
+                    }
+                }
+            }
+        }
+
+#endif
+
+        /// Makes map the snapshot for new readers and deletes the old one
+        /// once no reader can see it.  The caller must hold mutex_.
+        void Publish( IdToProductMap * map )
+        {
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            IdToProductMap * old = ExchangeSnapshot( snapshot_, map );
+            WaitForReaders();
+#else
+            IdToProductMap * old = snapshot_;
+            snapshot_ = map;
+#endif
+            delete old;
+        }
+
+        /// Copies the snapshot, so it can be changed.  The caller must hold
+        /// mutex_.
+        IdToProductMap * CopySnapshot() const
+        {
+            return new IdToProductMap( *snapshot_ );
+        }
+
+        /// Holds mutex_ for its lifetime, so a writer unlocks it even when
+        /// copying or changing the snapshot throws.
+        class WriteSection
+        {
+        public:
+            explicit WriteSection( MutexPolicy & mutex ) : mutex_( mutex )
+            {
+                mutex_.Lock();
+            }
+
+            ~WriteSection()
+            {
+                mutex_.Unlock();
+            }
+
+        private:
+            WriteSection( const WriteSection & );
+            WriteSection & operator = ( const WriteSection & );
+
+            MutexPolicy & mutex_;
+        };
+
+        /// Copy-constructor is not implemented.
+        ConcurrentFactory( const ConcurrentFactory & );
+        /// Copy-assignment operator is not implemented.
+        ConcurrentFactory & operator = ( const ConcurrentFactory & );
+
+        IdToProductMap * volatile snapshot_;
+
+        mutable MutexPolicy mutex_;
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+        volatile CountType epoch_;
+
+        /// Room for the slots plus one cache line, so readers_ can start on
+        /// a line boundary wherever the factory is.
+        char readerBuffer_[ ( ReaderSlots + 1 ) * CacheLineSize ];
+
+        ReaderSlot * readers_;
+#endif
+
+    public:
+
+        ConcurrentFactory()
+            : snapshot_( new IdToProductMap )
+            , mutex_()
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            , epoch_( 0 )
+            , readers_( reinterpret_cast< ReaderSlot * >( readerBuffer_ + CacheLineSize
+                - reinterpret_cast< std::size_t >( readerBuffer_ ) % CacheLineSize ) )
+#endif
+        {
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            for ( unsigned int slot = 0; slot < ReaderSlots; ++slot )
+            {
+                readers_[ slot ].counts_[ 0 ] = 0;
+                readers_[ slot ].counts_[ 1 ] = 0;
+            }
+#endif
+        }
+
+        /// No thread may use the factory while it is destroyed.
+        ~ConcurrentFactory()
+        {
+            delete snapshot_;
+        }
+
+        bool Register(const IdentifierType& id, ProductCreator creator)
+        {
+            WriteSection lock( mutex_ );
+            IdToProductMap * map = CopySnapshot();
+            bool inserted = false;
+            try
+            {
+                inserted = map->insert(
+                    typename IdToProductMap::value_type(id, creator)).second;
+            }
+            catch ( ... )
+            {
+                delete map;
+                throw;
+            }
+            if ( inserted )
+                Publish( map );
+            else
+                delete map;
+            return inserted;
+        }
+
+        template <class PtrObj, typename CreaFn>
+        bool Register(const IdentifierType& id, const PtrObj& p, CreaFn fn)
+        {
+            ProductCreator creator( p, fn );
+            return Register( id, creator );
+        }
+
+        bool Unregister(const IdentifierType& id)
+        {
+            WriteSection lock( mutex_ );
+            IdToProductMap * map = CopySnapshot();
+            bool erased = false;
+            try
+            {
+                erased = ( map->erase(id) != 0 );
+            }
+            catch ( ... )
+            {
+                delete map;
+                throw;
+            }
+            if ( erased )
+                Publish( map );
+            else
+                delete map;
+            return erased;
+        }
+
+        bool IsRegistered(const IdentifierType& id) const
+        {
+            ReadSection snapshot( *this );
+            return snapshot->find(id) != snapshot->end();
+        }
+
+        std::vector<IdentifierType> RegisteredIds() const
+        {
+            ReadSection snapshot( *this );
+            std::vector<IdentifierType> ids;
+            ids.reserve( snapshot->size() );
+            for(typename IdToProductMap::const_iterator it = snapshot->begin();
+                it != snapshot->end(); ++it)
+            {
+                ids.push_back(it->first);
+            }
+            return ids;
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12, Parm13 p13)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14 );
+            return this->OnUnknownType(id);
+        }
+
+        AbstractProduct* CreateObject(const IdentifierType& id,
+                                            Parm1 p1, Parm2 p2, Parm3 p3, Parm4 p4, Parm5 p5,
+                                            Parm6 p6, Parm7 p7, Parm8 p8, Parm9 p9, Parm10 p10,
+                                            Parm11 p11, Parm12 p12, Parm13 p13, Parm14 p14, Parm15 p15)
+        {
+            ReadSection snapshot( *this );
+            typename IdToProductMap::const_iterator i = snapshot->find(id);
+            if (i != snapshot->end())
+                return (i->second)( p1,p2,p3,p4,p5,p6,p7,p8,p9,p10,p11,p12,p13,p14,p15 );
+            return this->OnUnknownType(id);
+        }
+
+    };
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE ) && defined( LOKI_THREAD_LOCAL )
+
+    template < class AP, typename Id, typename CP, template < typename, class > class E,
+        template < class, class > class L, class M >
+    LOKI_THREAD_LOCAL unsigned int ConcurrentFactory< AP, Id, CP, E, L, M >::threadSlot_ = 0;
+
+    template < class AP, typename Id, typename CP, template < typename, class > class E,
+        template < class, class > class L, class M >
+    volatile typename ConcurrentFactory< AP, Id, CP, E, L, M >::CountType
+        ConcurrentFactory< AP, Id, CP, E, L, M >::nextThreadSlot_ = 0;
+
+#endif
+
 #else
 
     template
@@ -1049,6 +1615,9 @@ template <typename AP, typename Id, typename P1 >
  *   \class		CloneFactory
  *   \ingroup	CloneFactoryGroup
  *   \brief		Creates a copy from a polymorphic object.
+ *
+ *   IdToProductLayout is the layout policy of the map from TypeInfo to
+ *   creators, as for Factory.
  */
 
     template
@@ -1057,7 +1626,9 @@ template <typename AP, typename Id, typename P1 >
         class ProductCreator =
             AbstractProduct* (*)(const AbstractProduct*),
         template<typename, class>
-            class FactoryErrorPolicy = DefaultFactoryError
+            class FactoryErrorPolicy = DefaultFactoryError,
+        template<class, class>
+            class IdToProductLayout = SortedPairsLayout
     >
     class CloneFactory
         : public FactoryErrorPolicy<TypeInfo, AbstractProduct>
@@ -1092,7 +1663,9 @@ template <typename AP, typename Id, typename P1 >
         }
 
     private:
-        typedef AssocVector<TypeInfo, ProductCreator> IdToProductMap;
+        typedef AssocVector<TypeInfo, ProductCreator, std::less<TypeInfo>,
+            std::allocator<std::pair<TypeInfo, ProductCreator> >,
+            IdToProductLayout> IdToProductMap;
         IdToProductMap associations_;
     };
 
@@ -35,6 +35,11 @@
 #include <loki/Functor.h>
 #include <loki/Sequence.h>
 
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+#include <type_traits>
+#include <utility>
+#endif
+
 namespace Loki
 {
 
@@ -58,6 +63,36 @@ namespace Loki
     struct Function;
 
 
+////////////////////////////////////////////////////////////////////////////////
+// macro for the move members, which also have to declare the copy assignment
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+
+#define LOKI_FUNCTION_MOVE_BODY                             \
+                                                            \
+        Function(Function&& func)                           \
+            : FBase(static_cast<FBase&&>(func)) {}          \
+                                                            \
+        Function& operator=(const Function& func)           \
+        {                                                   \
+            FBase::operator=(func);                         \
+            return *this;                                   \
+        }                                                   \
+                                                            \
+        Function& operator=(Function&& func)                \
+        {                                                   \
+            FBase::operator=(std::move(func));              \
+            return *this;                                   \
+        }
+
+#else
+
+#define LOKI_FUNCTION_MOVE_BODY
+
+#endif
+
+
     template<class R>
     struct Function<R()> : public Functor<R>
     {
@@ -94,6 +129,7 @@ namespace Loki
         template<class Host, class Func>
         Function(const Host& host, const Func& func) : FBase(host,func) {}
 
+        LOKI_FUNCTION_MOVE_BODY
     };
 
 
@@ -124,7 +160,9 @@ namespace Loki
         Function(Func func) : FBase(func) {}        \
                                                     \
         template<class Host, class Func>            \
-        Function(const Host& host, const Func& func): FBase(host,func) {}
+        Function(const Host& host, const Func& func): FBase(host,func) {} \
+                                                    \
+        LOKI_FUNCTION_MOVE_BODY
 
 
 #define LOKI_FUNCTION_R2_CTOR_BODY          \
@@ -380,6 +418,102 @@ namespace Loki
         LOKI_FUNCTION_BODY
     };
 
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+
+    namespace Private
+    {
+        // Holds the callable of a UniqueFunction.  The Functor underneath
+        // only copies its callable to relocate it, and a UniqueFunction is
+        // never copied, so copying moves the callable, like std::auto_ptr.
+        template<class R, class Fun>
+        class UniqueFunctionTarget
+        {
+        public:
+            template<class F>
+            explicit UniqueFunctionTarget(F&& fun) : fun_(std::forward<F>(fun)) {}
+
+            UniqueFunctionTarget(const UniqueFunctionTarget& rhs)
+                : fun_(std::move(rhs.fun_)) {}
+
+            UniqueFunctionTarget(UniqueFunctionTarget&& rhs)
+                : fun_(std::move(rhs.fun_)) {}
+
+            template<class... P>
+            R operator()(P&&... p)
+            { return fun_(std::forward<P>(p)...); }
+
+        private:
+            UniqueFunctionTarget& operator=(const UniqueFunctionTarget&);
+
+            mutable Fun fun_;
+        };
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class UniqueFunction
+    ///
+    ///  \ingroup FunctorGroup
+    ///  A Function which can only be moved, for one-shot callbacks which hold
+    ///  move-only objects.  Since it is never copied, its callable does not
+    ///  need a copy constructor.  Needs LOKI_HAS_MOVE_SEMANTICS.
+    ///
+    ///  \par Usage
+    ///
+    ///      \code UniqueFunction<void()> f(std::bind(&consume, std::move(buffer)));
+    ///      queue.push_back(std::move(f)); \endcode
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template<class R = void()>
+    class UniqueFunction;
+
+    template<class R, class... P>
+    class UniqueFunction<R(P...)>
+        : private Functor<R, typename Seq<P...>::Type>
+    {
+        typedef Functor<R, typename Seq<P...>::Type> FBase;
+
+    public:
+        typedef typename FBase::ResultType ResultType;
+        typedef typename FBase::unspecified_bool_type unspecified_bool_type;
+
+        UniqueFunction() : FBase() {}
+
+        UniqueFunction(UniqueFunction&& func)
+            : FBase(static_cast<FBase&&>(func)) {}
+
+        template<class Func>
+        UniqueFunction(Func&& func,
+            typename std::enable_if<!std::is_same<typename std::decay<Func>::type,
+                UniqueFunction>::value, int>::type = 0)
+            : FBase(Private::UniqueFunctionTarget<R,
+                typename std::decay<Func>::type>(std::forward<Func>(func)))
+        {}
+
+        template<class Host, class Func>
+        UniqueFunction(const Host& host, const Func& func) : FBase(host, func) {}
+
+        UniqueFunction& operator=(UniqueFunction&& func)
+        {
+            FBase::operator=(std::move(func));
+            return *this;
+        }
+
+        operator unspecified_bool_type() const
+        {
+            return static_cast<const FBase&>(*this);
+        }
+
+        using FBase::empty;
+        using FBase::clear;
+        using FBase::operator();
+
+    private:
+        UniqueFunction(const UniqueFunction&);
+        UniqueFunction& operator=(const UniqueFunction&);
+    };
+
+#endif
+
 }// namespace Loki
 
 #endif // end file guardian
@@ -36,8 +36,11 @@
 #include <loki/EmptyType.h>
 #include <loki/SmallObj.h>
 #include <loki/TypeTraits.h>
+#include <loki/TypeManip.h>
 #include <typeinfo>
 #include <memory>
+#include <new>
+#include <cassert>
 
 ///  \defgroup FunctorGroup Function objects
 
@@ -49,6 +52,19 @@
 //#define LOKI_FUNCTORS_ARE_COMPARABLE
 #endif
 
+#ifndef LOKI_FUNCTOR_BUFFER_SIZE
+#define LOKI_FUNCTOR_BUFFER_SIZE (4 * sizeof(void*))
+#endif
+
+#if !defined(LOKI_HAS_MOVE_SEMANTICS) && (__cplusplus >= 201103L || \
+    defined(__GXX_EXPERIMENTAL_CXX0X__) || (defined(_MSC_VER) && _MSC_VER >= 1800))
+#define LOKI_HAS_MOVE_SEMANTICS
+#endif
+
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+#include <utility>
+#endif
+
 
 /// \namespace Loki
 /// All classes of Loki are in the Loki namespace
@@ -60,6 +76,35 @@ namespace Loki
 
     namespace Private
     {
+        // Storage inside a Functor for implementations small enough to live
+        // there, aligned for the members a functor implementation usually has.
+        union FunctorBuffer
+        {
+            void* pointer_;
+            void (*function_)();
+            long long_;
+            double double_;
+            char bytes_[LOKI_FUNCTOR_BUFFER_SIZE];
+        };
+
+        template <class T>
+        struct FunctorAlignmentProbe
+        {
+            char c_;
+            T t_;
+        };
+
+        template <class T>
+        struct FunctorFitsInBuffer
+        {
+            enum
+            {
+                value = sizeof(T) <= sizeof(FunctorBuffer) &&
+                    sizeof(FunctorAlignmentProbe<T>) - sizeof(T) <=
+                    sizeof(FunctorAlignmentProbe<FunctorBuffer>) - sizeof(FunctorBuffer)
+            };
+        };
+
         template <typename R, template <class, class> class ThreadingModel>
         struct FunctorImplBase
 #ifdef LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT
@@ -98,6 +143,16 @@ namespace Loki
 
             virtual FunctorImplBase* DoClone() const = 0;
 
+            // Copy constructs the implementation into place, which is a
+            // FunctorBuffer, and returns 0 if it does not fit there.
+            // Implementations which do not override it are cloned on the heap.
+            virtual FunctorImplBase* DoCloneInto(void*) const
+            { return 0; }
+
+            // Like DoCloneInto, but may leave the implementation moved from.
+            virtual FunctorImplBase* DoMoveInto(void* place)
+            { return DoCloneInto(place); }
+
             template <class U>
             static U* Clone(U* pObj)
             {
@@ -119,11 +174,29 @@ namespace Loki
 
 ////////////////////////////////////////////////////////////////////////////////
 // macro LOKI_DEFINE_CLONE_FUNCTORIMPL
-// Implements the DoClone function for a functor implementation
+// Implements the DoClone and DoCloneInto functions for a functor implementation
 ////////////////////////////////////////////////////////////////////////////////
 
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+
 #define LOKI_DEFINE_CLONE_FUNCTORIMPL(Cls) \
-    virtual Cls* DoClone() const { return new Cls(*this); }
+    virtual Cls* DoClone() const { return new Cls(*this); } \
+    virtual Cls* DoCloneInto(void* place) const \
+    { return ::Loki::Private::FunctorFitsInBuffer<Cls>::value ? \
+        new(place) Cls(*this) : 0; } \
+    virtual Cls* DoMoveInto(void* place) \
+    { return ::Loki::Private::FunctorFitsInBuffer<Cls>::value ? \
+        new(place) Cls(std::move(*this)) : 0; }
+
+#else
+
+#define LOKI_DEFINE_CLONE_FUNCTORIMPL(Cls) \
+    virtual Cls* DoClone() const { return new Cls(*this); } \
+    virtual Cls* DoCloneInto(void* place) const \
+    { return ::Loki::Private::FunctorFitsInBuffer<Cls>::value ? \
+        new(place) Cls(*this) : 0; }
+
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 // class template FunctorImpl
@@ -1226,6 +1299,20 @@ namespace Loki
 /// The macro is disabled by default, because it breaks compiling functor
 /// objects  which have no operator== implemented, keep in mind when you enable
 /// operator==.
+///
+/// \par Macro: LOKI_FUNCTOR_BUFFER_SIZE
+/// A Functor keeps implementations which fit in LOKI_FUNCTOR_BUFFER_SIZE bytes
+/// inside itself, so making, copying and calling it does not allocate.  This
+/// covers functors made from function pointers, member function pointers and
+/// small function objects.  Bigger implementations, like the ones made by
+/// BindFirst and Chain which hold whole Functors, are allocated on the heap.
+/// The default is the size of four pointers.
+///
+/// \par Macro: LOKI_HAS_MOVE_SEMANTICS
+/// Defined when the compiler has rvalue references and variadic templates.
+/// Functors can then be moved, which takes the implementation of a heap
+/// Functor without cloning it, and moves the callable of a Functor which
+/// keeps it inside itself.  Loki::UniqueFunction also needs it.
 ////////////////////////////////////////////////////////////////////////////////
     template <typename R = void, class TList = NullType,
         template<class, class> class ThreadingModel = LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL>
@@ -1257,49 +1344,104 @@ namespace Loki
         Functor() : spImpl_(0)
         {}
 
-        Functor(const Functor& rhs) : spImpl_(Impl::Clone(rhs.spImpl_.get()))
-        {}
+        Functor(const Functor& rhs) : spImpl_(0)
+        {
+            clone(rhs.spImpl_);
+        }
+
+#ifdef LOKI_HAS_MOVE_SEMANTICS
 
-        Functor(std::auto_ptr<Impl> spImpl) : spImpl_(spImpl)
+        Functor(Functor&& rhs) : spImpl_(0)
+        {
+            take(rhs);
+        }
+
+#endif
+
+        Functor(std::auto_ptr<Impl> spImpl) : spImpl_(spImpl.release())
         {}
 
         template <typename Fun>
-        Functor(Fun fun)
-        : spImpl_(new FunctorHandler<Functor, Fun>(fun))
-        {}
+        Functor(Fun fun) : spImpl_(0)
+        {
+            typedef FunctorHandler<Functor, Fun> Handler;
+            spImpl_ = make<Handler>(fun,
+                Int2Type<Private::FunctorFitsInBuffer<Handler>::value>());
+        }
 
         template <class PtrObj, typename MemFn>
-        Functor(const PtrObj& p, MemFn memFn)
-        : spImpl_(new MemFunHandler<Functor, PtrObj, MemFn>(p, memFn))
-        {}
+        Functor(const PtrObj& p, MemFn memFn) : spImpl_(0)
+        {
+            typedef MemFunHandler<Functor, PtrObj, MemFn> Handler;
+            spImpl_ = make<Handler>(p, memFn,
+                Int2Type<Private::FunctorFitsInBuffer<Handler>::value>());
+        }
+
+        ~Functor()
+        {
+            destroy();
+        }
 
-        typedef Impl * (std::auto_ptr<Impl>::*unspecified_bool_type)() const;
+        typedef Impl * Functor::*unspecified_bool_type;
 
         operator unspecified_bool_type() const
         {
-            return spImpl_.get() ? &std::auto_ptr<Impl>::get : 0;
+            return spImpl_ ? &Functor::spImpl_ : 0;
         }
 
         Functor& operator=(const Functor& rhs)
         {
-            Functor copy(rhs);
-            // swap auto_ptrs by hand
-            Impl* p = spImpl_.release();
-            spImpl_.reset(copy.spImpl_.release());
-            copy.spImpl_.reset(p);
+            // Copies rhs while the old implementation still lives, so a copy
+            // which throws leaves this unchanged, and rhs may be owned by the
+            // old implementation.  The copy goes into the buffer if the old
+            // implementation is not there, else onto the heap.
+            Impl* const pSource = rhs.spImpl_;
+            Impl* const pOld = spImpl_;
+            const bool oldInPlace = isInPlace();
+            spImpl_ = 0;
+            try
+            {
+                if (oldInPlace)
+                    spImpl_ = Impl::Clone(pSource);
+                else
+                    clone(pSource);
+            }
+            catch (...)
+            {
+                spImpl_ = pOld;
+                throw;
+            }
+            if (oldInPlace)
+                pOld->~Impl();
+            else
+                delete pOld;
             return *this;
         }
 
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+
+        Functor& operator=(Functor&& rhs)
+        {
+            if (this != &rhs)
+            {
+                destroy();
+                take(rhs);
+            }
+            return *this;
+        }
+
+#endif
+
 #ifdef LOKI_ENABLE_FUNCTION
 
         bool empty() const
         {
-            return spImpl_.get() == 0;
+            return spImpl_ == 0;
         }
 
         void clear()
         {
-            spImpl_.reset(0);
+            destroy();
         }
 #endif
 
@@ -1307,10 +1449,10 @@ namespace Loki
 
         bool operator==(const Functor& rhs) const
         {
-            if(spImpl_.get()==0 && rhs.spImpl_.get()==0)
+            if(spImpl_==0 && rhs.spImpl_==0)
                 return true;
-            if(spImpl_.get()!=0 && rhs.spImpl_.get()!=0)
-                return *spImpl_.get() == *rhs.spImpl_.get();
+            if(spImpl_!=0 && rhs.spImpl_!=0)
+                return *spImpl_ == *rhs.spImpl_;
             else
                 return false;
         }
@@ -1438,7 +1580,69 @@ namespace Loki
         }
 
     private:
-        std::auto_ptr<Impl> spImpl_;
+        template <class Handler, typename P1>
+        Impl* make(const P1& p1, Int2Type<true>)
+        { return new(&buffer_) Handler(p1); }
+
+        template <class Handler, typename P1>
+        Impl* make(const P1& p1, Int2Type<false>)
+        { return new Handler(p1); }
+
+        template <class Handler, typename P1, typename P2>
+        Impl* make(const P1& p1, const P2& p2, Int2Type<true>)
+        { return new(&buffer_) Handler(p1, p2); }
+
+        template <class Handler, typename P1, typename P2>
+        Impl* make(const P1& p1, const P2& p2, Int2Type<false>)
+        { return new Handler(p1, p2); }
+
+        bool isInPlace() const
+        {
+            const char* p = reinterpret_cast<const char*>(spImpl_);
+            return p >= buffer_.bytes_ && p < buffer_.bytes_ + sizeof(buffer_);
+        }
+
+        void destroy()
+        {
+            if (isInPlace())
+                spImpl_->~Impl();
+            else
+                delete spImpl_;
+            spImpl_ = 0;
+        }
+
+        // Copies pImpl into the buffer if it fits there, else onto the heap.
+        void clone(Impl* pImpl)
+        {
+            assert(spImpl_ == 0);
+            if (!pImpl) return;
+            spImpl_ = static_cast<Impl*>(pImpl->DoCloneInto(&buffer_));
+            if (spImpl_)
+                assert(typeid(*spImpl_) == typeid(*pImpl));
+            else
+                spImpl_ = Impl::Clone(pImpl);
+        }
+
+        // Takes the implementation of rhs, which only needs to be moved if
+        // it lives in the buffer of rhs.
+        void take(Functor& rhs)
+        {
+            assert(spImpl_ == 0);
+            if (rhs.isInPlace())
+            {
+                spImpl_ = static_cast<Impl*>(rhs.spImpl_->DoMoveInto(&buffer_));
+                assert(spImpl_ != 0);
+                rhs.destroy();
+            }
+            else
+            {
+                spImpl_ = rhs.spImpl_;
+                rhs.spImpl_ = 0;
+            }
+        }
+
+        Impl* spImpl_;
+        Private::FunctorBuffer buffer_;
     };
 
 
@@ -35,6 +35,10 @@
 
 #include <loki/Factory.h>
 
+#include <cstddef>
+#include <cstring>
+#include <string>
+
 namespace Loki
 {
 
@@ -766,7 +770,103 @@ namespace Loki
         }
     }
 
+    /**
+     * \defgroup   KeyHashGroup Key hashing
+     * \ingroup    FactoriesGroup
+     * \brief      Hash values for Key, used by the sharded CachedFactory.
+     *
+     * HashValue is overloaded for the built-in types, pointers and
+     * std::string.  If a creator parameter has another type, declare a
+     * HashValue overload for it in the namespace of that type, so it is found
+     * by argument dependent lookup.  Keys which compare equal must hash to the
+     * same value.
+     */
+    inline std::size_t HashValue(EmptyType) { return 0; }
+    inline std::size_t HashValue(bool v) { return v ? 1 : 0; }
+    inline std::size_t HashValue(char v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(signed char v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(unsigned char v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(wchar_t v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(short v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(unsigned short v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(int v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(unsigned int v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(long v) { return static_cast<std::size_t>(v); }
+    inline std::size_t HashValue(unsigned long v) { return static_cast<std::size_t>(v); }
+
+    inline std::size_t HashValue(double v)
+    {
+        if(v == 0.0) // +0.0 and -0.0 compare equal
+            return 0;
+        std::size_t h = 0;
+        std::memcpy(&h, &v, sizeof(h) < sizeof(v) ? sizeof(h) : sizeof(v));
+        return h;
+    }
+
+    inline std::size_t HashValue(float v) { return HashValue(static_cast<double>(v)); }
+
+    template<class T>
+    inline std::size_t HashValue(T* p)
+    {
+        return reinterpret_cast<std::size_t>(p);
+    }
+
+    inline std::size_t HashValue(const std::string& s)
+    {
+        // FNV-1a
+        std::size_t h = static_cast<std::size_t>(2166136261U);
+        for(std::string::size_type i = 0; i < s.size(); ++i)
+            h = (h ^ static_cast<unsigned char>(s[i])) * 16777619U;
+        return h;
+    }
 
+    /// Mixes the hash value of one more member into seed.
+    inline void HashCombine(std::size_t& seed, std::size_t h)
+    {
+        seed ^= h + static_cast<std::size_t>(0x9e3779b9U) + (seed << 6) + (seed >> 2);
+    }
+
+    /// Spreads the bits of h, so the low bits can pick a bucket or shard even
+    /// when the members hash to small consecutive numbers.
+    inline std::size_t HashFinish(std::size_t h)
+    {
+        h ^= h >> 16;
+        h *= static_cast<std::size_t>(0x85ebca6bU);
+        h ^= h >> 13;
+        h *= static_cast<std::size_t>(0xc2b2ae35U);
+        h ^= h >> 16;
+        return h;
+    }
+
+    /// Returns a hash of the identifier and the parameters held by key.
+    template<class F, typename I>
+    std::size_t HashKey(const Key<F, I> &key)
+    {
+        std::size_t h = static_cast<std::size_t>(key.count + 1);
+        // Each case falls through to hash the members before it.
+        switch(key.count){
+            case 15: HashCombine(h, HashValue(key.p15)); // fall through
+            case 14: HashCombine(h, HashValue(key.p14)); // fall through
+            case 13: HashCombine(h, HashValue(key.p13)); // fall through
+            case 12: HashCombine(h, HashValue(key.p12)); // fall through
+            case 11: HashCombine(h, HashValue(key.p11)); // fall through
+            case 10: HashCombine(h, HashValue(key.p10)); // fall through
+            case 9:  HashCombine(h, HashValue(key.p9)); // fall through
+            case 8:  HashCombine(h, HashValue(key.p8)); // fall through
+            case 7:  HashCombine(h, HashValue(key.p7)); // fall through
+            case 6:  HashCombine(h, HashValue(key.p6)); // fall through
+            case 5:  HashCombine(h, HashValue(key.p5)); // fall through
+            case 4:  HashCombine(h, HashValue(key.p4)); // fall through
+            case 3:  HashCombine(h, HashValue(key.p3)); // fall through
+            case 2:  HashCombine(h, HashValue(key.p2)); // fall through
+            case 1:  HashCombine(h, HashValue(key.p1)); // fall through
+            case 0:  HashCombine(h, HashValue(key.id));
+                break;
+            default:
+                break;
+        }
+        return HashFinish(h);
+    }
 
 } // namespace Loki
 
@@ -531,7 +531,9 @@ public:
 
 /** @class MutexSleepWaits
  Implements the WaitPolicy for LevelMutex.  Sleeps for a moment so thread won't
- consume idle CPU cycles.  Useful for high-level mutexes.
+ consume idle CPU cycles.  Useful for high-level mutexes.  The sleep can not be
+ shorter than 1 millisecond, so ParkingLevelMutex is a better choice when wait
+ times matter.
  */
 class MutexSleepWaits
 {
@@ -600,7 +602,10 @@ private:
 // ----------------------------------------------------------------------------
 
 /** @class SleepLevelMutex
- Implements a sleeping loop to wait for the mutex to unlock.
+ Implements a sleeping loop to wait for the mutex to unlock.  Since a thread
+ sleeps at least 1 millisecond between attempts, a contended lock adds at least
+ that much latency.  ParkingLevelMutex wakes waiting threads as soon as the
+ mutex is unlocked instead.
 
  @par Purpose
  Since this class puts the thread to sleep for short intervals, you can use this
@@ -672,6 +677,171 @@ private:
 
 // ----------------------------------------------------------------------------
 
+/** @class ParkingLevelMutex
+ Implements a mutex which spins for a short while, and then parks the thread
+ until another thread unlocks the mutex.
+
+ @par Purpose
+ This can be used wherever a SleepLevelMutex would be used.  Unlike that class,
+ a waiting thread does not poll the mutex at intervals.  It gets woken exactly
+ when the mutex is unlocked, so a contended lock does not add a millisecond of
+ latency, and sleeping threads do not wake up only to find the mutex is still
+ locked.  Since waiting threads are parked, the WaitPolicy of LevelMutex is not
+ used by this mutex.
+
+ @par Adaptive Spinning
+ Before it parks, Lock spins for up to twice the number of spins recent locks
+ needed, but never more than the spin limit.  A mutex protecting only short
+ operations usually gets locked without a system call, while a mutex held for
+ a long time soon stops spinning.  A spin limit of zero disables spinning.
+
+ @par Implementation
+ Under Linux, threads park on a futex, so an uncontended Lock or Unlock is just
+ one atomic operation.  Elsewhere, threads wait on a condition variable guarded
+ by an internal mutex.
+
+ @par Timed Locks
+ TimedLock waits until a deadline measured by GetSteadyClockTime, so calling
+ LevelMutex::Lock( milliSeconds ) waits for real time instead of CPU time.
+ */
+class ParkingLevelMutex
+{
+public:
+
+    /// Most spins a thread does before parking, unless told otherwise.
+    enum { DefaultSpinLimit = 100 };
+
+    /// Constructs a parking mutex with the default spin limit.
+    explicit ParkingLevelMutex( unsigned int level );
+
+    /// Constructs a parking mutex with a specific spin limit.
+    ParkingLevelMutex( unsigned int level, unsigned int spinLimit );
+
+    /// Destructs the mutex.
+    virtual ~ParkingLevelMutex( void );
+
+    /// Spins, then parks until the mutex is locked.
+    virtual MutexErrors::Type Lock( void ) volatile;
+
+    virtual MutexErrors::Type TryLock( void ) volatile;
+
+    /// Unlocks the mutex, and wakes one parked thread if there is one.
+    virtual MutexErrors::Type Unlock( void ) volatile;
+
+    /** Spins, then parks until the mutex is locked or milliSeconds pass.
+     @return Success if locked, or TimedOut if the deadline passed first.
+     */
+    virtual MutexErrors::Type TimedLock( unsigned int milliSeconds ) volatile;
+
+    inline unsigned int GetLevel( void ) const volatile { return m_level; }
+
+    inline unsigned int GetSpinLimit( void ) const volatile { return m_spinLimit; }
+
+    inline void SetSpinLimit( unsigned int spinLimit ) volatile { m_spinLimit = spinLimit; }
+
+private:
+
+    /// Default constructor is not implemented.
+    ParkingLevelMutex( void );
+    /// Copy constructor is not implemented.
+    ParkingLevelMutex( const ParkingLevelMutex & );
+    /// Copy-assignment operator is not implemented.
+    ParkingLevelMutex & operator = ( const ParkingLevelMutex & );
+
+    /** Spins and then parks until locked, or until GetSteadyClockTime reaches
+     deadline if timed is true.
+     */
+    MutexErrors::Type DoLock( bool timed, unsigned long long deadline ) volatile;
+
+    /// Tries to lock without waiting.  Returns true if locked.
+    bool DoTryLock( void ) volatile;
+
+    /** Parks the thread until woken, or until deadline if timed is true.
+     @return False if the deadline passed, else true.
+     */
+    bool Park( bool timed, unsigned long long deadline ) volatile;
+
+#if defined( __linux__ ) && defined( __GNUC__ )
+    /// 0 if unlocked, 1 if locked, 2 if locked and some thread may be parked.
+    int m_state;
+
+#elif defined( _MSC_VER )
+    /// Guards m_locked and m_parked.
+    CRITICAL_SECTION m_guard;
+    /// Threads wait here until the mutex is unlocked.
+    CONDITION_VARIABLE m_parked;
+    /// True if some thread locked the mutex.
+    bool m_locked;
+
+#else
+    /// Guards m_locked and m_parked.
+    pthread_mutex_t m_guard;
+    /// Threads wait here until the mutex is unlocked.
+    pthread_cond_t m_parked;
+    /// True if some thread locked the mutex.
+    bool m_locked;
+#endif
+
+    /// Recent average of how many spins Lock needed.
+    unsigned int m_spins;
+
+    /// Most spins a thread does before parking.
+    unsigned int m_spinLimit;
+
+    /// Keep a copy of the mutex level around for error reporting.
+    const unsigned int m_level;
+
+}; // end class ParkingLevelMutex
+
+// ----------------------------------------------------------------------------
+
+/** Returns milliseconds from a steady clock.  The clock does not jump when the
+ system time changes, and unlike clock() it measures real time rather than CPU
+ time, so LevelMutex uses it for deadlines.  Never throws exceptions.
+ */
+unsigned long long GetSteadyClockTime( void );
+
+// ----------------------------------------------------------------------------
+
+/** @class LevelMutexTimedLock
+ Helper for LevelMutex which locks a MutexPolicy within milliSeconds.  This
+ version calls TryLock until it succeeds or the deadline passes, and calls
+ WaitPolicy::Wait between attempts.  The specialization for ParkingLevelMutex
+ parks the thread until the mutex is unlocked or the deadline passes.
+ */
+template < class MutexPolicy, class WaitPolicy >
+class LevelMutexTimedLock
+{
+public:
+    static MutexErrors::Type Lock( volatile MutexPolicy & mutex,
+        unsigned int milliSeconds )
+    {
+        const unsigned long long deadline = GetSteadyClockTime() + milliSeconds;
+        for ( ; ; )
+        {
+            const MutexErrors::Type result = mutex.TryLock();
+            if ( MutexErrors::TryFailed != result )
+                return result;
+            if ( deadline <= GetSteadyClockTime() )
+                return MutexErrors::TimedOut;
+            WaitPolicy::Wait();
+        }
+    }
+};
+
+template < class WaitPolicy >
+class LevelMutexTimedLock< ParkingLevelMutex, WaitPolicy >
+{
+public:
+    static inline MutexErrors::Type Lock( volatile ParkingLevelMutex & mutex,
+        unsigned int milliSeconds )
+    {
+        return mutex.TimedLock( milliSeconds );
+    }
+};
+
+// ----------------------------------------------------------------------------
+
 /** @class LevelMutex
  Levelized mutex class prevents deadlocks by requiring programs to lock mutexes in
  the same order, and unlock them in reverse order.  This is accomplished by forcing
@@ -713,9 +883,10 @@ private:
  - WaitPolicy Whether a thread should wait, and how long in some internal loops.
 
  @par MutexPolicy
- A policy class that wraps a low-level mutex. Loki provides two policy classes
- for the actual mutex (SpinLevelMutex and SleepLevelMutex), both of which wrap
- either pthreads or the Windows CRITICAL_SECTION. If you want to use a mutex
+ A policy class that wraps a low-level mutex. Loki provides three policy classes
+ for the actual mutex (SpinLevelMutex, SleepLevelMutex, and ParkingLevelMutex).
+ The first two wrap either pthreads or the Windows CRITICAL_SECTION, and the
+ last parks waiting threads on a futex or condition variable. If you want to use a mutex
  mechanism besides one of those, then all you have to do is provide a class
  which wraps the mutex and implements these functions.
     explicit MutexPolicy( unsigned int level );
@@ -870,28 +1041,21 @@ public:
             return EP::CheckError( result, GetLevel() );
 
         assert( !LevelMutexInfo::IsLockedByCurrentThread() );
-        clock_t timeOut = clock() + milliSeconds;
-        while ( clock() < timeOut )
+        result = LevelMutexTimedLock< MutexPolicy, WP >::Lock( m_mutex, milliSeconds );
+        switch ( result )
         {
-            WP::Wait();
-            result = m_mutex.TryLock();
-            switch ( result )
+            case MutexErrors::Success:
             {
-                case MutexErrors::Success:
-                {
-                    PostLock();
-                    return MutexErrors::Success;
-                }
-                case MutexErrors::AlreadyLocked:
-                    return MutexErrors::AlreadyLocked;
-                case MutexErrors::TryFailed:
-                    break;
-                default:
-                    return EP::CheckError( result, GetLevel() );
+                PostLock();
+                return MutexErrors::Success;
             }
+            case MutexErrors::AlreadyLocked:
+                return MutexErrors::AlreadyLocked;
+            case MutexErrors::TimedOut:
+                return MutexErrors::TimedOut;
+            default:
+                return EP::CheckError( result, GetLevel() );
         }
-
-        return MutexErrors::TimedOut;
     }
 
     virtual MutexErrors::Type Unlock( void ) volatile
@@ -963,19 +1127,12 @@ private:
     {
         LOKI_MUTEX_DEBUG_CODE( CheckFor::NoChangeOnThrow checker( this, &IsValid ); (void)checker; )
 
-        clock_t timeOut = clock() + milliSeconds;
-        while ( clock() < timeOut )
-        {
-            WP::Wait();
-            const bool locked = ( MutexErrors::Success == m_mutex.TryLock() );
-            if ( locked )
-            {
-                PostLock();
-                return MutexErrors::Success;
-            }
-        }
-
-        return MutexErrors::TimedOut;
+        const MutexErrors::Type result =
+            LevelMutexTimedLock< MutexPolicy, WP >::Lock( m_mutex, milliSeconds );
+        if ( MutexErrors::Success != result )
+            return MutexErrors::TimedOut;
+        PostLock();
+        return MutexErrors::Success;
     }
 
     /** Called only by MultiUnlock to unlock each mutex within a container.
@@ -38,10 +38,73 @@
 
 #include <loki/ConstPolicy.h>
 #include <loki/Threads.h>
+#include <loki/TypeTraits.h>
+
+#include <cstring>
+#include <utility>
 
 
 namespace Loki
 {
+    /** @class SharedLocking
+     Tells LockingPtr how to lock a mutex for read-only access.  The default
+     takes the mutex exclusively, since most LockingPolicy classes can not be
+     shared.  Specialize it for a reader-writer mutex class so that any
+     number of readers can hold the mutex together, as is done for RWMutex.
+     */
+    template < class LockingPolicy >
+    struct SharedLocking
+    {
+        static void Lock( LockingPolicy & mutex )
+        {
+            mutex.Lock();
+        }
+
+        static void Unlock( LockingPolicy & mutex )
+        {
+            mutex.Unlock();
+        }
+    };
+
+    template <>
+    struct SharedLocking< RWMutex >
+    {
+        static void Lock( RWMutex & mutex )
+        {
+            mutex.LockShared();
+        }
+
+        static void Unlock( RWMutex & mutex )
+        {
+            mutex.UnlockShared();
+        }
+    };
+
+    namespace Private
+    {
+        /// Locks exclusively for read-write access.
+        template < class LockingPolicy, bool readOnly >
+        struct LockingPtrLocking
+        {
+            static void Lock( LockingPolicy & mutex )
+            {
+                mutex.Lock();
+            }
+
+            static void Unlock( LockingPolicy & mutex )
+            {
+                mutex.Unlock();
+            }
+        };
+
+        /// Locks shared, if the LockingPolicy can, for read-only access.
+        template < class LockingPolicy >
+        struct LockingPtrLocking< LockingPolicy, true >
+            : public SharedLocking< LockingPolicy >
+        {
+        };
+    }
+
     /** @class LockingPtr
      Locks a volatile object and casts away volatility so that the object
      can be safely used in a single-threaded region of code.
@@ -49,6 +112,11 @@ namespace Loki
      object, but not the mutex type.  This version allows users to specify a
      the mutex type as a LockingPolicy class.  The only requirements for a
      LockingPolicy class are to provide Lock and Unlock methods.
+     If the object is const, either because SharedObject is const or because
+     ConstPolicy is PropagateConst, LockingPtr only reads it and so locks the
+     mutex through SharedLocking.  With a RWMutex many threads can then read
+     the object at the same time, while a LockingPtr to the non-const object
+     still waits for all of them.
      */
     template < typename SharedObject, typename LockingPolicy = LOKI_DEFAULT_MUTEX,
                template<class> class ConstPolicy = LOKI_DEFAULT_CONSTNESS >
@@ -58,6 +126,13 @@ namespace Loki
 
         typedef typename ConstPolicy<SharedObject>::Type ConstOrNotType;
 
+    private:
+
+        typedef Private::LockingPtrLocking< LockingPolicy,
+            TypeTraits< ConstOrNotType >::isConst > Locking;
+
+    public:
+
         /** Constructor locks mutex associated with an object.
          @param object Reference to object.
          @param mutex Mutex used to control thread access to object.
@@ -66,7 +141,7 @@ namespace Loki
            : pObject_( const_cast< SharedObject * >( &object ) ),
             pMutex_( &mutex )
         {
-            mutex.Lock();
+            Locking::Lock( mutex );
         }
 
         typedef typename std::pair<volatile ConstOrNotType *, LockingPolicy *> Pair;
@@ -78,13 +153,13 @@ namespace Loki
            : pObject_( const_cast< SharedObject * >( lockpair.first ) ),
             pMutex_( lockpair.second )
         {
-            lockpair.second->Lock();
+            Locking::Lock( *lockpair.second );
         }
 
         /// Destructor unlocks the mutex.
         ~LockingPtr()
         {
-            pMutex_->Unlock();
+            Locking::Unlock( *pMutex_ );
         }
 
         /// Star-operator dereferences pointer.
@@ -118,6 +193,111 @@ namespace Loki
 
     }; // end class LockingPtr
 
+    /** @class SeqLocked
+     Holds a small object which many threads read and few threads write, such
+     as a configuration record or a pair of coordinates.  Read returns a copy
+     of the object without taking any lock, so readers never wait for each
+     other and never write to memory shared with other readers.  Write takes
+     the MutexPolicy lock to serialize writers and bumps a sequence number
+     before and after changing the object.  A reader which sees the sequence
+     number change while it copies the object throws the copy away and reads
+     again, so it never returns a half written object.
+     Since readers copy the object while it may be written, T must be a
+     trivially copyable type, with no pointers to memory which a writer may
+     free.  Reading is only lock-free on platforms with the gcc atomic
+     builtins; elsewhere Read takes the lock as Write does.
+     */
+    template < class T, class MutexPolicy = LOKI_DEFAULT_MUTEX >
+    class SeqLocked
+    {
+        typedef ::std::size_t Word;
+
+        enum { WordCount = ( sizeof( T ) + sizeof( Word ) - 1 ) / sizeof( Word ) };
+
+    public:
+
+        SeqLocked() : sequence_( 0 ), mutex_()
+        {
+            Store( T() );
+        }
+
+        explicit SeqLocked( const T & value ) : sequence_( 0 ), mutex_()
+        {
+            Store( value );
+        }
+
+        /// Returns a consistent copy of the object.
+        T Read() const
+        {
+            Word words[ WordCount ];
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE ) && !defined( LOKI_WINDOWS_H )
+            for ( ;; )
+            {
+                const Word before = __atomic_load_n( &sequence_, __ATOMIC_ACQUIRE );
+                if ( ( before & 1 ) != 0 )
+                    continue; // a writer is busy
+                for ( unsigned int ii = 0; ii < WordCount; ++ii )
+                    words[ ii ] = __atomic_load_n( &words_[ ii ], __ATOMIC_RELAXED );
+                __atomic_thread_fence( __ATOMIC_ACQUIRE );
+                if ( __atomic_load_n( &sequence_, __ATOMIC_RELAXED ) == before )
+                    break;
+            }
+#else
+            mutex_.Lock();
+            for ( unsigned int ii = 0; ii < WordCount; ++ii )
+                words[ ii ] = words_[ ii ];
+            mutex_.Unlock();
+#endif
+            T value;
+            ::std::memcpy( &value, words, sizeof( T ) );
+            return value;
+        }
+
+        /// Replaces the object.  Readers see either the old or the new one.
+        void Write( const T & value )
+        {
+            mutex_.Lock();
+            Store( value );
+            mutex_.Unlock();
+        }
+
+    private:
+
+        /// Writes the object; the caller must hold the lock.
+        void Store( const T & value )
+        {
+            Word words[ WordCount ] = { 0 };
+            ::std::memcpy( words, &value, sizeof( T ) );
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE ) && !defined( LOKI_WINDOWS_H )
+            const Word sequence = __atomic_load_n( &sequence_, __ATOMIC_RELAXED );
+            __atomic_store_n( &sequence_, sequence + 1, __ATOMIC_RELAXED );
+            __atomic_thread_fence( __ATOMIC_RELEASE );
+            for ( unsigned int ii = 0; ii < WordCount; ++ii )
+                __atomic_store_n( &words_[ ii ], words[ ii ], __ATOMIC_RELAXED );
+            __atomic_store_n( &sequence_, sequence + 2, __ATOMIC_RELEASE );
+#else
+            for ( unsigned int ii = 0; ii < WordCount; ++ii )
+                words_[ ii ] = words[ ii ];
+            sequence_ += 2;
+#endif
+        }
+
+        /// Copy-constructor is not implemented.
+        SeqLocked( const SeqLocked & );
+
+        /// Copy-assignment-operator is not implemented.
+        SeqLocked & operator = ( const SeqLocked & );
+
+        /// Odd while a writer changes the object.
+        Word sequence_;
+
+        /// The object, as words which can be read atomically.
+        Word words_[ WordCount ];
+
+        mutable MutexPolicy mutex_;
+
+    }; // end class SeqLocked
+
 } // namespace Loki
 
 #endif // end file guardian
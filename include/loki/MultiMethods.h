@@ -36,6 +36,10 @@
 #include <loki/Functor.h>
 #include <loki/AssocVector.h>
 
+#include <vector>
+#include <typeinfo>
+#include <stdexcept>
+
 ////////////////////////////////////////////////////////////////////////////////
 // IMPORTANT NOTE:
 // The double dispatchers implemented below differ from the excerpts shown in
@@ -131,9 +135,352 @@ namespace Loki
         { return DispatchLhs(lhs, rhs, exec, TypesLhs()); }
     };
 
+////////////////////////////////////////////////////////////////////////////////
+// Helpers of IndexedStaticDispatcher (internal)
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        // Returns the position of T in TList, or ~0u for a class not in TList
+        template <class TList, class T>
+        inline unsigned int StaticDispatchIndexOf(const T*)
+        {
+            return static_cast<unsigned int>(TL::IndexOf<TList, T>::value);
+        }
+
+        // The first class of TList which T is or derives from, which is the
+        // class the dynamic_casts of StaticDispatcher stop at, or NullType
+        template <class TList, class T> struct StaticDispatchMatch;
+
+        template <class T>
+        struct StaticDispatchMatch<NullType, T>
+        {
+            typedef NullType Result;
+        };
+
+        template <class Head, class Tail, class T>
+        struct StaticDispatchMatch<Typelist<Head, Tail>, T>
+        {
+            typedef typename Select<SuperSubclass<Head, T>::value, Head,
+                typename StaticDispatchMatch<Tail, T>::Result>::Result Result;
+        };
+
+        // Calls the Executor for one pair of classes; NullType stands for a
+        // class not in the typelists of the dispatcher
+        template <class Executor, class BaseLhs, class BaseRhs,
+            typename ResultType, class SomeLhs, class SomeRhs, bool swapArgs>
+        struct StaticDispatchThunk
+        {
+            static ResultType Fire(BaseLhs& lhs, BaseRhs& rhs, Executor& exec)
+            {
+                typedef InvocationTraits<SomeLhs, SomeRhs, Executor,
+                    ResultType> CallTraits;
+                return CallTraits::DoDispatch(static_cast<SomeLhs&>(lhs),
+                    static_cast<SomeRhs&>(rhs), exec, Int2Type<swapArgs>());
+            }
+        };
+
+        template <class Executor, class BaseLhs, class BaseRhs,
+            typename ResultType, class SomeLhs, bool swapArgs>
+        struct StaticDispatchThunk<Executor, BaseLhs, BaseRhs, ResultType,
+            SomeLhs, NullType, swapArgs>
+        {
+            static ResultType Fire(BaseLhs& lhs, BaseRhs& rhs, Executor& exec)
+            { return exec.OnError(static_cast<SomeLhs&>(lhs), rhs); }
+        };
+
+        template <class Executor, class BaseLhs, class BaseRhs,
+            typename ResultType, class SomeRhs, bool swapArgs>
+        struct StaticDispatchThunk<Executor, BaseLhs, BaseRhs, ResultType,
+            NullType, SomeRhs, swapArgs>
+        {
+            static ResultType Fire(BaseLhs& lhs, BaseRhs& rhs, Executor& exec)
+            { return exec.OnError(lhs, rhs); }
+        };
+
+        template <class Executor, class BaseLhs, class BaseRhs,
+            typename ResultType, bool swapArgs>
+        struct StaticDispatchThunk<Executor, BaseLhs, BaseRhs, ResultType,
+            NullType, NullType, swapArgs>
+        {
+            static ResultType Fire(BaseLhs& lhs, BaseRhs& rhs, Executor& exec)
+            { return exec.OnError(lhs, rhs); }
+        };
+
+        // Fills the row of the jump table for SomeLhs, one entry per class of
+        // RhsList
+        template <class Owner, class SomeLhs, class RhsList>
+        struct StaticDispatchRowFiller;
+
+        template <class Owner, class SomeLhs>
+        struct StaticDispatchRowFiller<Owner, SomeLhs, NullType>
+        {
+            template <class Thunk>
+            static void Fill(Thunk* row)
+            { *row = Owner::template GetThunk<SomeLhs, NullType>(); }
+        };
+
+        template <class Owner, class SomeLhs, class Head, class Tail>
+        struct StaticDispatchRowFiller<Owner, SomeLhs, Typelist<Head, Tail> >
+        {
+            template <class Thunk>
+            static void Fill(Thunk* row)
+            {
+                *row = Owner::template GetThunk<SomeLhs, Head>();
+                StaticDispatchRowFiller<Owner, SomeLhs, Tail>::Fill(row + 1);
+            }
+        };
+
+        // Fills one row of the jump table per class of LhsList, and a last
+        // row for classes not in LhsList
+        template <class Owner, class LhsList, class RhsList>
+        struct StaticDispatchTableFiller;
+
+        template <class Owner, class RhsList>
+        struct StaticDispatchTableFiller<Owner, NullType, RhsList>
+        {
+            template <class Thunk>
+            static void Fill(Thunk* table)
+            { StaticDispatchRowFiller<Owner, NullType, RhsList>::Fill(table); }
+        };
+
+        template <class Owner, class Head, class Tail, class RhsList>
+        struct StaticDispatchTableFiller<Owner, Typelist<Head, Tail>, RhsList>
+        {
+            template <class Thunk>
+            static void Fill(Thunk* table)
+            {
+                StaticDispatchRowFiller<Owner, Head, RhsList>::Fill(table);
+                StaticDispatchTableFiller<Owner, Tail, RhsList>::Fill(
+                    table + TL::Length<RhsList>::value + 1);
+            }
+        };
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+// macros LOKI_DEFINE_STATIC_DISPATCH_TYPES and LOKI_DEFINE_STATIC_DISPATCH_INDEX
+// Put LOKI_DEFINE_STATIC_DISPATCH_TYPES(TList) in the base class of a hierarchy
+//     dispatched by IndexedStaticDispatcher, with the typelist of all classes
+//     of the hierarchy, and LOKI_DEFINE_STATIC_DISPATCH_INDEX() in every class
+//     of TList. The classes may be declared after the base class.
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOKI_DEFINE_STATIC_DISPATCH_TYPES(TList) \
+    typedef TList StaticDispatchTypes; \
+    LOKI_DEFINE_STATIC_DISPATCH_INDEX()
+
+#define LOKI_DEFINE_STATIC_DISPATCH_INDEX() \
+    virtual unsigned int StaticDispatchIndex() const \
+    { return ::Loki::Private::StaticDispatchIndexOf<StaticDispatchTypes>(this); }
+
+////////////////////////////////////////////////////////////////////////////////
+// class template IndexedStaticDispatcher
+// Implements an automatic static double dispatcher based on two typelists,
+//     with the interface and the choice of Fire overloads of StaticDispatcher
+// Instead of trying a dynamic_cast to every class of TypesLhs and TypesRhs,
+//     Go asks both arguments for their position in the StaticDispatchTypes of
+//     their base class, and calls through a table of (N+1)*(M+1) entries. The
+//     entries are chosen at compile time from the typelists and filled in the
+//     first time Go is called.
+// Static casts replace the dynamic casts, so BaseLhs and BaseRhs must not be
+//     virtual base classes
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        class Executor,
+        class BaseLhs,
+        class TypesLhs,
+        bool symmetric = true,
+        class BaseRhs = BaseLhs,
+        class TypesRhs = TypesLhs,
+        typename ResultType = void
+    >
+    class IndexedStaticDispatcher
+    {
+        typedef typename BaseLhs::StaticDispatchTypes HierarchyLhs;
+        typedef typename BaseRhs::StaticDispatchTypes HierarchyRhs;
+        typedef ResultType (*Thunk)(BaseLhs&, BaseRhs&, Executor&);
+
+        enum
+        {
+            rows = TL::Length<HierarchyLhs>::value,
+            columns = TL::Length<HierarchyRhs>::value
+        };
+
+        template <class, class, class> friend struct Private::StaticDispatchRowFiller;
+
+        template <class SomeLhs, class SomeRhs>
+        static Thunk GetThunk()
+        {
+            typedef typename Private::StaticDispatchMatch<
+                TypesLhs, SomeLhs>::Result MatchLhs;
+            typedef typename Private::StaticDispatchMatch<
+                TypesRhs, SomeRhs>::Result MatchRhs;
+            enum
+            {
+                swapArgs = symmetric &&
+                    int(TL::IndexOf<TypesRhs, MatchRhs>::value) <
+                    int(TL::IndexOf<TypesLhs, MatchLhs>::value)
+            };
+            return &Private::StaticDispatchThunk<Executor, BaseLhs, BaseRhs,
+                ResultType, MatchLhs, MatchRhs, swapArgs != 0>::Fire;
+        }
+
+        struct Table
+        {
+            Table()
+            {
+                Private::StaticDispatchTableFiller<IndexedStaticDispatcher,
+                    HierarchyLhs, HierarchyRhs>::Fill(thunks_);
+            }
+            Thunk thunks_[(rows + 1) * (columns + 1)];
+        };
+
+    public:
+        static ResultType Go(BaseLhs& lhs, BaseRhs& rhs,
+            Executor & exec)
+        {
+            static const Table table;
+            unsigned int i = lhs.StaticDispatchIndex();
+            unsigned int j = rhs.StaticDispatchIndex();
+            if (i > rows) i = rows;
+            if (j > columns) j = columns;
+            return table.thunks_[i * (columns + 1) + j](lhs, rhs, exec);
+        }
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+// class DispatchTypeIndex (internal)
+// Gives the classes known to a BasicDispatcher dense indices, and finds the
+//     index of a class from its std::type_info through a hash table keyed by
+//     the address of the std::type_info
+// Insert records every std::type_info address it is given, so a class added
+//     from several modules is found fast under each of them, and Find never
+//     writes to the index
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        class DispatchTypeIndex
+        {
+        public:
+            DispatchTypeIndex() : used_(0)
+            {}
+
+            static unsigned int NotFound()
+            { return ~0u; }
+
+            unsigned int Size() const
+            { return static_cast<unsigned int>(types_.size()); }
+
+            unsigned int Find(const std::type_info& ti) const
+            {
+                if (!slots_.empty())
+                {
+                    const std::size_t mask = slots_.size() - 1;
+                    for (std::size_t s = Hash(&ti) & mask; slots_[s].type_ != 0;
+                        s = (s + 1) & mask)
+                    {
+                        if (slots_[s].type_ == &ti)
+                            return slots_[s].index_;
+                    }
+                }
+                // The class may be known under another std::type_info object,
+                // which happens with classes shared between modules.
+                for (std::size_t i = 0; i < types_.size(); ++i)
+                {
+                    if (types_[i] == TypeInfo(ti))
+                        return static_cast<unsigned int>(i);
+                }
+                return NotFound();
+            }
+
+            unsigned int Insert(const std::type_info& ti)
+            {
+                unsigned int index = Find(ti);
+                if (index == NotFound())
+                {
+                    index = Size();
+                    types_.push_back(TypeInfo(ti));
+                }
+                if ((used_ + 1) * 2 > slots_.size())
+                    Rehash(slots_.empty() ? 16 : slots_.size() * 2);
+                Place(&ti, index);
+                return index;
+            }
+
+        private:
+            struct Slot
+            {
+                Slot() : type_(0), index_(0) {}
+                const std::type_info* type_;
+                unsigned int index_;
+            };
+
+            static std::size_t Hash(const std::type_info* ti)
+            {
+                const std::size_t key = reinterpret_cast<std::size_t>(ti);
+                return (key >> 4) ^ (key >> 12);
+            }
+
+            void Place(const std::type_info* ti, unsigned int index)
+            {
+                const std::size_t mask = slots_.size() - 1;
+                std::size_t s = Hash(ti) & mask;
+                while (slots_[s].type_ != 0 && slots_[s].type_ != ti)
+                    s = (s + 1) & mask;
+                if (slots_[s].type_ == 0)
+                    ++used_;
+                slots_[s].type_ = ti;
+                slots_[s].index_ = index;
+            }
+
+            void Rehash(std::size_t slotCount)
+            {
+                std::vector<Slot> old(slotCount);
+                old.swap(slots_);
+                used_ = 0;
+                for (std::size_t s = 0; s < old.size(); ++s)
+                {
+                    if (old[s].type_ != 0)
+                        Place(old[s].type_, old[s].index_);
+                }
+            }
+
+            std::vector<TypeInfo> types_;
+            std::vector<Slot> slots_;
+            std::size_t used_;
+        };
+
+        template <class TList> struct DispatchTypeAdder;
+
+        template <>
+        struct DispatchTypeAdder<NullType>
+        {
+            static void Add(DispatchTypeIndex&)
+            {}
+        };
+
+        template <class Head, class Tail>
+        struct DispatchTypeAdder<Typelist<Head, Tail> >
+        {
+            static void Add(DispatchTypeIndex& index)
+            {
+                index.Insert(typeid(Head));
+                DispatchTypeAdder<Tail>::Add(index);
+            }
+        };
+    }
+
 ////////////////////////////////////////////////////////////////////////////////
 // class template BasicDispatcher
-// Implements a logarithmic double dispatcher for functors (or functions)
+// Implements a constant time double dispatcher for functors (or functions)
+// Every class added gets a dense index, and the callbacks are kept in a square
+//     table indexed by the classes of both arguments, so Go costs two lookups
+//     of std::type_info addresses and one table lookup
+// AddTypes<TList>() gives indices to many classes at once, which grows the
+//     table only once
 // Doesn't offer automated casts or symmetry
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -146,15 +493,24 @@ namespace Loki
     >
     class BasicDispatcher
     {
-        typedef std::pair<TypeInfo,TypeInfo> KeyType;
         typedef CallbackType MappedType;
-        typedef AssocVector<KeyType, MappedType> MapType;
-        MapType callbackMap_;
 
-        void DoAdd(TypeInfo lhs, TypeInfo rhs, CallbackType fun);
-        bool DoRemove(TypeInfo lhs, TypeInfo rhs);
+        Private::DispatchTypeIndex index_;
+        // callbacks_ index plus one, or zero if there is no callback
+        std::vector<unsigned int> table_;
+        unsigned int stride_;
+        std::vector<MappedType> callbacks_;
+        std::vector<unsigned int> freeCallbacks_;
+
+        void DoAdd(const std::type_info& lhs, const std::type_info& rhs,
+            CallbackType fun);
+        bool DoRemove(const std::type_info& lhs, const std::type_info& rhs);
+        void Grow();
 
     public:
+        BasicDispatcher() : stride_(0)
+        {}
+
         template <class SomeLhs, class SomeRhs>
         void Add(CallbackType fun)
         {
@@ -167,24 +523,80 @@ namespace Loki
             return DoRemove(typeid(SomeLhs), typeid(SomeRhs));
         }
 
+        template <class TList>
+        void AddTypes()
+        {
+            Private::DispatchTypeAdder<TList>::Add(index_);
+            Grow();
+        }
+
         ResultType Go(BaseLhs& lhs, BaseRhs& rhs);
     };
 
     // Non-inline to reduce compile time overhead...
+    template <class BaseLhs, class BaseRhs,
+        typename ResultType, typename CallbackType>
+    void BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>::Grow()
+    {
+        if (index_.Size() <= stride_)
+            return;
+        unsigned int stride = stride_ == 0 ? 8 : stride_;
+        while (stride < index_.Size())
+            stride *= 2;
+        std::vector<unsigned int> table(stride * stride, 0);
+        for (unsigned int i = 0; i < stride_; ++i)
+        {
+            for (unsigned int j = 0; j < stride_; ++j)
+                table[i * stride + j] = table_[i * stride_ + j];
+        }
+        table_.swap(table);
+        stride_ = stride;
+    }
+
     template <class BaseLhs, class BaseRhs,
         typename ResultType, typename CallbackType>
     void BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
-         ::DoAdd(TypeInfo lhs, TypeInfo rhs, CallbackType fun)
+         ::DoAdd(const std::type_info& lhs, const std::type_info& rhs,
+            CallbackType fun)
     {
-        callbackMap_[KeyType(lhs, rhs)] = fun;
+        const unsigned int i = index_.Insert(lhs);
+        const unsigned int j = index_.Insert(rhs);
+        Grow();
+        unsigned int& cell = table_[i * stride_ + j];
+        if (cell != 0)
+        {
+            callbacks_[cell - 1] = fun;
+        }
+        else if (!freeCallbacks_.empty())
+        {
+            callbacks_[freeCallbacks_.back()] = fun;
+            cell = freeCallbacks_.back() + 1;
+            freeCallbacks_.pop_back();
+        }
+        else
+        {
+            callbacks_.push_back(fun);
+            cell = static_cast<unsigned int>(callbacks_.size());
+        }
     }
 
     template <class BaseLhs, class BaseRhs,
         typename ResultType, typename CallbackType>
     bool BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
-         ::DoRemove(TypeInfo lhs, TypeInfo rhs)
+         ::DoRemove(const std::type_info& lhs, const std::type_info& rhs)
     {
-        return callbackMap_.erase(KeyType(lhs, rhs)) == 1;
+        const unsigned int i = index_.Find(lhs);
+        const unsigned int j = index_.Find(rhs);
+        if (i == Private::DispatchTypeIndex::NotFound() ||
+            j == Private::DispatchTypeIndex::NotFound())
+            return false;
+        unsigned int& cell = table_[i * stride_ + j];
+        if (cell == 0)
+            return false;
+        callbacks_[cell - 1] = MappedType();
+        freeCallbacks_.push_back(cell - 1);
+        cell = 0;
+        return true;
     }
 
     template <class BaseLhs, class BaseRhs,
@@ -192,13 +604,15 @@ namespace Loki
     ResultType BasicDispatcher<BaseLhs,BaseRhs,ResultType,CallbackType>
                ::Go(BaseLhs& lhs, BaseRhs& rhs)
     {
-        typename MapType::key_type k(typeid(lhs),typeid(rhs));
-        typename MapType::iterator i = callbackMap_.find(k);
-        if (i == callbackMap_.end())
+        const unsigned int i = index_.Find(typeid(lhs));
+        const unsigned int j = index_.Find(typeid(rhs));
+        if (i == Private::DispatchTypeIndex::NotFound() ||
+            j == Private::DispatchTypeIndex::NotFound() ||
+            table_[i * stride_ + j] == 0)
         {
                 throw std::runtime_error("Function not found");
         }
-        return (i->second)(lhs, rhs);
+        return callbacks_[table_[i * stride_ + j] - 1](lhs, rhs);
     }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -256,7 +670,7 @@ namespace Loki
 
 ////////////////////////////////////////////////////////////////////////////////
 // class template FnDispatcher
-// Implements an automatic logarithmic double dispatcher for functions
+// Implements an automatic constant time double dispatcher for functions
 // Features automated conversions
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -318,6 +732,12 @@ namespace Loki
             backEnd_.template Remove<SomeLhs, SomeRhs>();
         }
 
+        template <class TList>
+        void AddTypes()
+        {
+            backEnd_.template AddTypes<TList>();
+        }
+
         ResultType Go(BaseLhs& lhs, BaseRhs& rhs)
         {
             return backEnd_.Go(lhs, rhs);
@@ -359,7 +779,7 @@ namespace Loki
 
 ////////////////////////////////////////////////////////////////////////////////
 // class template FunctorDispatcher
-// Implements a logarithmic double dispatcher for functors
+// Implements a constant time double dispatcher for functors
 // Features automated casting
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -415,6 +835,12 @@ namespace Loki
             backEnd_.template Remove<SomeLhs, SomeRhs>();
         }
 
+        template <class TList>
+        void AddTypes()
+        {
+            backEnd_.template AddTypes<TList>();
+        }
+
         ResultType Go(BaseLhs& lhs, BaseRhs& rhs)
         {
             return backEnd_.Go(lhs, rhs);
@@ -37,7 +37,9 @@
 #include <climits>
 #include <cstring>
 #include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 #include <cassert>
 #include <locale>
 #include <iostream>
@@ -92,6 +94,46 @@ namespace Loki
         s.second -= to - from;
     }
 
+    namespace Private
+    {
+        /// Writes the decimal digits of n so that the last one lands on bufLast,
+        /// and returns a pointer to the first one.  Takes two digits per
+        /// division from a table of all the two-digit pairs.
+        inline char* RenderDecimal(LOKI_SAFEFORMAT_UNSIGNED_LONG n, char* bufLast) {
+            static const char pairs[] =
+                "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                "8081828384858687888990919293949596979899";
+            char* first = bufLast + 1;
+            while (n >= 100) {
+                const unsigned int pair = static_cast<unsigned int>(n % 100) * 2;
+                n /= 100;
+                *--first = pairs[pair + 1];
+                *--first = pairs[pair];
+            }
+            if (n >= 10) {
+                const unsigned int pair = static_cast<unsigned int>(n) * 2;
+                *--first = pairs[pair + 1];
+                *--first = pairs[pair];
+            } else {
+                *--first = static_cast<char>('0' + n);
+            }
+            return first;
+        }
+
+        /// Longest output of FormatShortest, "-1.2345678901234567e-308".
+        enum { ShortestSize = 24 };
+
+        /// Writes the shortest decimal form of value that reads back as value,
+        /// in the style of %g but with as many digits as it takes, and returns
+        /// the end of what it wrote.  Uses Florian Loitsch's Grisu2 algorithm:
+        /// no heap, no snprintf, and the shortest form for all but a tiny
+        /// fraction of values, which still round-trip but get one digit more.
+        LOKI_EXPORT
+        char* FormatShortest(double value, char* buffer);
+
+    } // namespace Private
+
     ////////////////////////////////////////////////////////////////////////////////
     // PrintfState class template
     // Holds the formatting state, and implements operator() to format stuff
@@ -445,6 +487,7 @@ namespace Loki
 
         Char* RenderWithoutSign(LOKI_SAFEFORMAT_UNSIGNED_LONG n, char* bufLast,
                 unsigned int base, bool uppercase) {
+            if (base == 10) return Private::RenderDecimal(n, bufLast);
             const Char hex1st = uppercase ? 'A' : 'a';
             for (;;) {
                 const LOKI_SAFEFORMAT_UNSIGNED_LONG next = n / base;
@@ -593,6 +636,534 @@ namespace Loki
         LOKI_SAFEFORMAT_SIGNED_LONG result_;
     };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // BufferedFile class
+    // A FILE* device that writes each Printf expression in one piece.  What an
+    //   expression prints is gathered in a buffer of the calling thread, and
+    //   reaches the file in a single fwrite when the expression ends.  Lines
+    //   printed by different threads never interleave, and stdio's lock is
+    //   taken once per expression instead of once per fragment.
+    // With the background flusher, a finished expression is only appended to a
+    //   shared buffer, and a thread of the BufferedFile writes it out, so the
+    //   printing thread makes no system call.  The flusher runs on pthreads, or
+    //   on Win32 threads under Windows.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class LOKI_EXPORT BufferedFile
+    {
+    public:
+
+        /// Does not take ownership of file.
+        explicit BufferedFile(std::FILE* file, bool backgroundFlusher = false);
+
+        /// Stops the flusher, and writes and flushes everything still pending.
+        ~BufferedFile();
+
+        /// Writes everything pending, and then calls fflush.
+        void Flush();
+
+        std::FILE* GetFile() const { return file_; }
+
+        /** The device of a PrintfState for a BufferedFile.  The text goes to
+         the file when the last copy goes away, which for a temporary is at the
+         end of the expression.  A PrintfState kept in a variable holds back
+         whatever the thread prints after it, until it goes away.  Not for
+         public use.
+         */
+        class LOKI_EXPORT Expression
+        {
+        public:
+            explicit Expression(BufferedFile& file);
+
+            /// Takes over the expression from other.
+            Expression(const Expression& other);
+
+            ~Expression();
+
+            void Append(const char* from, const char* to) {
+                buffer_->append(from, to);
+            }
+
+        private:
+            Expression& operator=(const Expression&);
+
+            BufferedFile* file_;
+            std::string* buffer_; // the calling thread's buffer
+            size_t mark_; // where this expression starts in buffer_
+            mutable bool owner_;
+        };
+
+    private:
+        BufferedFile(const BufferedFile&);
+        BufferedFile& operator=(const BufferedFile&);
+
+        /// Hands a finished expression to the file or to the flusher.
+        void Write(const char* from, const char* to);
+
+        struct Flusher;
+
+        std::FILE* file_;
+        Flusher* flusher_;
+    };
+
+    LOKI_EXPORT
+    void write(BufferedFile::Expression& e, const char* from, const char* to);
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // PrintfFormat class
+    // A format string parsed once into a list of directives, for formats that are
+    //   used over and over.  Printing through a PrintfFormat does not read the
+    //   format string again and does not allocate.  Besides the conversions of
+    //   printf it accepts %r, which prints a double with the fewest digits that
+    //   read back to the same value.
+    // Throws std::logic_error if the format string is malformed.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class LOKI_EXPORT PrintfFormat
+    {
+    public:
+
+        enum {
+            leftJustify = 1,
+            showSignAlways = 2,
+            blank = 4,
+            alternateForm = 8,
+            fillZeros = 16,
+            forceShort = 32,
+            widthFromArgument = 64,
+            precisionFromArgument = 128
+        };
+
+        /// A directive and the literal text in front of it.
+        struct Spec {
+            size_t literalBegin_; // offsets of the literal text in Text()
+            size_t literalEnd_;
+            size_t width_;
+            size_t prec_; // size_t(-1) if there is none
+            unsigned int flags_;
+            char type_; // conversion character, 0 for the text after the last directive
+        };
+
+        explicit PrintfFormat(const char* format);
+
+        explicit PrintfFormat(const std::string& format);
+
+        /// Number of arguments the format takes, '*' widths and precisions included.
+        size_t ArgumentCount() const { return argumentCount_; }
+
+        const Spec* Specs() const { return &specs_[0]; }
+
+        const char* Text() const { return text_.data(); }
+
+    private:
+        void Parse(const char* format);
+
+        /// Literal text with "%%" already turned into "%".
+        std::string text_;
+        std::vector<Spec> specs_;
+        size_t argumentCount_;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // PrintfFormatState class template
+    // Does for a PrintfFormat what PrintfState does for a format string.  All the
+    //   output goes straight to the device: integers are rendered two digits at a
+    //   time into a buffer on the stack, %r through Private::FormatShortest, and
+    //   only %e, %f and %g still go through snprintf.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template <class Device>
+    struct PrintfFormatState {
+
+        PrintfFormatState(Device dev, const PrintfFormat& format)
+                : device_(dev)
+                , spec_(format.Specs())
+                , text_(format.Text())
+                , width_(0)
+                , prec_(0)
+                , flags_(0)
+                , result_(0) {
+            Enter();
+        }
+
+        #define LOKI_PRINTF_FORMAT_STATE_FORWARD(type) \
+            PrintfFormatState& operator()(type par) {\
+                return (*this)(static_cast< LOKI_SAFEFORMAT_UNSIGNED_LONG >(par)); \
+            }
+
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(bool)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(char)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(signed char)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(unsigned char)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(signed short)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(unsigned short)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(signed int)
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(signed long)
+#if (defined(_WIN32) || defined(_WIN64))
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(unsigned long)
+#else
+        // on Windows already defined by uintptr_t
+        LOKI_PRINTF_FORMAT_STATE_FORWARD(unsigned int)
+#endif
+
+        #undef LOKI_PRINTF_FORMAT_STATE_FORWARD
+
+        // Print (or gobble in case of the "*" specifier) an int
+        PrintfFormatState& operator()(LOKI_SAFEFORMAT_UNSIGNED_LONG i) {
+            CheckArgumentCount();
+            if (result_ == -1) return *this; // don't even bother
+            if (ReadStar(i)) return *this;
+            const char c = spec_->type_;
+            if ((flags_ & PrintfFormat::forceShort) != 0 &&
+                    (c == 'x' || c == 'X' || c == 'u' || c == 'o')) {
+                i = static_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(static_cast<unsigned short>(i));
+            }
+            FormatInteger(i);
+            return *this;
+        }
+
+        PrintfFormatState& operator()(void* p) {
+            return (*this)(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(p));
+        }
+
+        PrintfFormatState& operator()(const void* const p) {
+            return (*this)(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(p));
+        }
+
+        PrintfFormatState& operator()(double n) {
+            CheckArgumentCount();
+            if (result_ == -1) return *this; // don't even bother
+            if (spec_->type_ == 'r' && !StarPending()) {
+                FormatRoundTrip(n);
+                return *this;
+            }
+            PrintUsing_snprintf(n, "");
+            return *this;
+        }
+
+        PrintfFormatState& operator()(long double n) {
+            CheckArgumentCount();
+            if (result_ == -1) return *this; // don't even bother
+            if (spec_->type_ == 'r' && !StarPending()) {
+                FormatRoundTrip(static_cast<double>(n));
+                return *this;
+            }
+            PrintUsing_snprintf(n, "L");
+            return *this;
+        }
+
+        // Store the number of characters printed so far
+        PrintfFormatState& operator()(int* pi) {
+            return StoreCountHelper(pi);
+        }
+
+        // Store the number of characters printed so far
+        PrintfFormatState& operator()(short* pi) {
+            return StoreCountHelper(pi);
+        }
+
+        // Store the number of characters printed so far
+        PrintfFormatState& operator()(long* pi) {
+            return StoreCountHelper(pi);
+        }
+
+        PrintfFormatState& operator()(const std::string& stdstr) {
+            return operator()(stdstr.c_str());
+        }
+
+        PrintfFormatState& operator()(const char* const s) {
+            CheckArgumentCount();
+            if (result_ == -1) return *this;
+            const char c = spec_->type_;
+            if (c == 'p') {
+                return (*this)(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(s));
+            }
+            if (c != 's' || StarPending()) {
+                result_ = -1;
+                return *this;
+            }
+            const size_t len = prec_ == size_t(-1) ? ::std::strlen(s) : StrnLength(s, prec_);
+            WritePadded(0, s, s + len, false);
+            return *this;
+        }
+
+        // read the result
+        operator int() const {
+            return static_cast<int>(result_);
+        }
+
+    private:
+        PrintfFormatState& operator=(const PrintfFormatState&);
+
+        static size_t StrnLength(const char* s, size_t n) {
+            const void* const end = ::std::memchr(s, 0, n);
+            return end == 0 ? n : static_cast<size_t>(static_cast<const char*>(end) - s);
+        }
+
+        void CheckArgumentCount() const {
+            if (spec_->type_ == 0) {
+                ::std::logic_error ex( "invalid number of parameters for Loki::SafeFormat!" );
+                throw ex;
+            }
+        }
+
+        bool StarPending() const {
+            return (flags_ & (PrintfFormat::widthFromArgument |
+                PrintfFormat::precisionFromArgument)) != 0;
+        }
+
+        // Take i as the width or precision if the directive wants one
+        bool ReadStar(LOKI_SAFEFORMAT_UNSIGNED_LONG i) {
+            const bool negative = static_cast<LOKI_SAFEFORMAT_SIGNED_LONG>(i) < 0;
+            if ((flags_ & PrintfFormat::widthFromArgument) != 0) {
+                flags_ &= ~PrintfFormat::widthFromArgument;
+                // a negative width means left justified, as in printf
+                if (negative) flags_ |= PrintfFormat::leftJustify;
+                width_ = static_cast<size_t>(negative ? 0 - i : i);
+                return true;
+            }
+            if ((flags_ & PrintfFormat::precisionFromArgument) != 0) {
+                flags_ &= ~PrintfFormat::precisionFromArgument;
+                // a negative precision counts as none
+                prec_ = negative ? size_t(-1) : static_cast<size_t>(i);
+                return true;
+            }
+            return false;
+        }
+
+        template <typename T>
+        PrintfFormatState& StoreCountHelper(T* const pi) {
+            CheckArgumentCount();
+            if (result_ == -1) return *this; // don't even bother
+            const char c = spec_->type_;
+            if (c == 'p') {
+                return (*this)(reinterpret_cast<LOKI_SAFEFORMAT_UNSIGNED_LONG>(pi));
+            }
+            if (c != 'n' || StarPending()) {
+                result_ = -1;
+                return *this;
+            }
+            assert(pi != 0);
+            *pi = static_cast<T>(result_);
+            Next();
+            return *this;
+        }
+
+        void FormatInteger(const LOKI_SAFEFORMAT_UNSIGNED_LONG i) {
+            char formatChar = spec_->type_;
+            bool isSigned = formatChar == 'd' || formatChar == 'i';
+            if (formatChar == 'p') {
+                formatChar = 'x'; // pointers go to hex
+                flags_ |= PrintfFormat::alternateForm; // printed with '0x' in front
+                isSigned = true; // that's what gcc does
+            }
+            if (!::std::strchr("cdiuoxX", formatChar)) {
+                result_ = -1;
+                return;
+            }
+            char buf[
+                sizeof(LOKI_SAFEFORMAT_UNSIGNED_LONG) * 3 // digits
+                + 1]; // spare
+            const char* const bufEnd = buf + sizeof(buf);
+            char* bufLast = buf + sizeof(buf) - 1;
+            char signChar = 0;
+            unsigned int base = 10;
+
+            if (formatChar == 'c') {
+                // The 'fill with zeros' flag is ignored
+                flags_ &= ~PrintfFormat::fillZeros;
+                *bufLast = static_cast<char>(i);
+            } else {
+                const bool negative = isSigned && static_cast<LOKI_SAFEFORMAT_SIGNED_LONG>(i) < 0;
+                if (formatChar == 'o') base = 8;
+                else if (formatChar == 'x' || formatChar == 'X') base = 16;
+                bufLast = Render(negative ? 0 - i : i, bufLast, base, formatChar == 'X');
+                if (isSigned) {
+                    signChar = negative ? '-'
+                        : (flags_ & PrintfFormat::showSignAlways) != 0 ? '+'
+                        : (flags_ & PrintfFormat::blank) != 0 ? ' '
+                        : 0;
+                }
+            }
+            // precision
+            size_t
+                countDigits = bufEnd - bufLast,
+                countZeros = prec_ != size_t(-1) && countDigits < prec_ &&
+                        formatChar != 'c'
+                    ? prec_ - countDigits
+                    : 0,
+                countBase = base != 10 && (flags_ & PrintfFormat::alternateForm) != 0 && i != 0
+                    ? (base == 16 ? 2 : countZeros > 0 ? 0 : 1)
+                    : 0,
+                countSign = (signChar != 0),
+                totalPrintable = countDigits + countZeros + countBase + countSign;
+            size_t countPadLeft = 0, countPadRight = 0;
+            if (width_ > totalPrintable) {
+                if ((flags_ & PrintfFormat::leftJustify) != 0) {
+                    countPadRight = width_ - totalPrintable;
+                } else {
+                    countPadLeft = width_ - totalPrintable;
+                }
+            }
+            if ((flags_ & PrintfFormat::fillZeros) != 0 && prec_ == size_t(-1)) {
+                // pad with zeros and no precision - transfer padding to precision
+                countZeros = countPadLeft;
+                countPadLeft = 0;
+            }
+            Fill(' ', countPadLeft);
+            if (signChar != 0) Write(&signChar, &signChar + 1);
+            if (countBase > 0) Fill('0', 1);
+            if (countBase == 2) Fill(formatChar, 1);
+            Fill('0', countZeros);
+            Write(bufLast, bufEnd);
+            Fill(' ', countPadRight);
+            Next();
+        }
+
+        static char* Render(LOKI_SAFEFORMAT_UNSIGNED_LONG n, char* bufLast,
+                unsigned int base, bool uppercase) {
+            if (base == 10) return Private::RenderDecimal(n, bufLast);
+            const char* const digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+            const unsigned int shift = base == 16 ? 4 : 3;
+            for (;;) {
+                *bufLast = digits[n & (base - 1)];
+                n >>= shift;
+                if (n == 0) break;
+                --bufLast;
+            }
+            return bufLast;
+        }
+
+        void FormatRoundTrip(double n) {
+            char buf[Private::ShortestSize];
+            const char* first = buf;
+            const char* const last = Private::FormatShortest(n, buf);
+            char signChar = 0;
+            if (*first == '-') {
+                signChar = '-';
+                ++first;
+            } else if ((flags_ & PrintfFormat::showSignAlways) != 0) {
+                signChar = '+';
+            } else if ((flags_ & PrintfFormat::blank) != 0) {
+                signChar = ' ';
+            }
+            // no zeros in front of "inf" and "nan"
+            WritePadded(signChar, first, last, *first >= '0' && *first <= '9');
+        }
+
+        // Write [b, e) after signChar, padded to the width
+        void WritePadded(char signChar, const char* b, const char* e, bool zeros) {
+            const size_t length = (e - b) + (signChar != 0);
+            const size_t pad = width_ > length ? width_ - length : 0;
+            if ((flags_ & PrintfFormat::leftJustify) != 0) {
+                if (signChar != 0) Write(&signChar, &signChar + 1);
+                Write(b, e);
+                Fill(' ', pad);
+            } else if (zeros && (flags_ & PrintfFormat::fillZeros) != 0) {
+                if (signChar != 0) Write(&signChar, &signChar + 1);
+                Fill('0', pad);
+                Write(b, e);
+            } else {
+                Fill(' ', pad);
+                if (signChar != 0) Write(&signChar, &signChar + 1);
+                Write(b, e);
+            }
+            Next();
+        }
+
+        template <class Value>
+        void PrintUsing_snprintf(Value n, const char* lengthModifier) {
+            if (!::std::strchr("eEfgG", spec_->type_) || StarPending()) {
+                result_ = -1;
+                return;
+            }
+            // rebuild the directive, with any '*' already replaced
+            char fmtBuf[64];
+            char* p = fmtBuf;
+            *p++ = '%';
+            if ((flags_ & PrintfFormat::leftJustify) != 0) *p++ = '-';
+            if ((flags_ & PrintfFormat::showSignAlways) != 0) *p++ = '+';
+            if ((flags_ & PrintfFormat::blank) != 0) *p++ = ' ';
+            if ((flags_ & PrintfFormat::alternateForm) != 0) *p++ = '#';
+            if ((flags_ & PrintfFormat::fillZeros) != 0) *p++ = '0';
+            if (width_ > 0) p = AppendDecimal(width_, p);
+            if (prec_ != size_t(-1)) {
+                *p++ = '.';
+                p = AppendDecimal(prec_, p);
+            }
+            while (*lengthModifier != 0) *p++ = *lengthModifier++;
+            *p++ = spec_->type_;
+            *p = 0;
+
+            char resultBuf[1024];
+            const int stored =
+#ifdef _MSC_VER
+#if _MSC_VER < 1400
+            _snprintf
+#else
+            _snprintf_s
+#endif
+#else
+            snprintf
+#endif
+                     (resultBuf, sizeof(resultBuf), fmtBuf, n);
+
+            if (stored < 0 || static_cast<size_t>(stored) >= sizeof(resultBuf)) {
+                result_ = -1;
+                return;
+            }
+            Write(resultBuf, resultBuf + stored);
+            Next();
+        }
+
+        static char* AppendDecimal(size_t n, char* p) {
+            char buf[sizeof(size_t) * 3];
+            char* const bufLast = buf + sizeof(buf) - 1;
+            const char* first = Private::RenderDecimal(n, bufLast);
+            while (first <= bufLast) *p++ = *first++;
+            return p;
+        }
+
+        void Write(const char* b, const char* e) {
+            if (result_ < 0) return;
+            const LOKI_SAFEFORMAT_SIGNED_LONG x = e - b;
+            write(device_, b, e);
+            result_ += x;
+        }
+
+        void Fill(const char c, size_t n) {
+            char buf[32];
+            ::std::memset(buf, c, n < sizeof(buf) ? n : sizeof(buf));
+            while (n > 0) {
+                const size_t chunk = n < sizeof(buf) ? n : sizeof(buf);
+                Write(buf, buf + chunk);
+                n -= chunk;
+            }
+        }
+
+        void Next() {
+            ++spec_;
+            Enter();
+        }
+
+        // Write the literal text in front of the current directive
+        void Enter() {
+            Write(text_ + spec_->literalBegin_, text_ + spec_->literalEnd_);
+            width_ = spec_->width_;
+            prec_ = spec_->prec_;
+            flags_ = spec_->flags_;
+        }
+
+        // state
+        Device device_;
+        const PrintfFormat::Spec* spec_;
+        const char* text_;
+        size_t width_;
+        size_t prec_;
+        unsigned int flags_;
+        LOKI_SAFEFORMAT_SIGNED_LONG result_;
+    };
+
     LOKI_EXPORT
     PrintfState<std::FILE*, char> Printf(const char* format);
 
@@ -605,6 +1176,12 @@ namespace Loki
     LOKI_EXPORT
     PrintfState<std::FILE*, char> FPrintf(std::FILE* f, const std::string& format);
 
+    LOKI_EXPORT
+    PrintfState<BufferedFile::Expression, char> FPrintf(BufferedFile& f, const char* format);
+
+    LOKI_EXPORT
+    PrintfState<BufferedFile::Expression, char> FPrintf(BufferedFile& f, const std::string& format);
+
 	/// Prints to cout.
     LOKI_EXPORT
     PrintfState<std::ostream&, char> FPrintf( const char * format );
@@ -635,6 +1212,26 @@ namespace Loki
         return PrintfState<T&, char>(device, format.c_str());
     }
 
+    LOKI_EXPORT
+    PrintfFormatState<std::FILE*> Printf(const PrintfFormat& format);
+
+    LOKI_EXPORT
+    PrintfFormatState<std::FILE*> FPrintf(std::FILE* f, const PrintfFormat& format);
+
+    LOKI_EXPORT
+    PrintfFormatState<BufferedFile::Expression> FPrintf(BufferedFile& f, const PrintfFormat& format);
+
+    LOKI_EXPORT
+    PrintfFormatState<std::ostream&> FPrintf(std::ostream& f, const PrintfFormat& format);
+
+    LOKI_EXPORT
+    PrintfFormatState<std::string&> SPrintf(std::string& s, const PrintfFormat& format);
+
+    template <class T>
+    PrintfFormatState<T&> XPrintf(T& device, const PrintfFormat& format) {
+        return PrintfFormatState<T&>(device, format);
+    }
+
     template <class Char, std::size_t N>
     PrintfState<std::pair<Char*, std::size_t>, Char>
     BufPrintf(Char (&buf)[N], const Char* format) {
@@ -642,6 +1239,15 @@ namespace Loki
         return PrintfState<std::pair<Char*, std::size_t>, Char>(temp, format);
     }
 
+    /// Prints into buf without touching the heap.  Nothing is appended after
+    /// the output; the result is the number of characters written.
+    template <std::size_t N>
+    PrintfFormatState<std::pair<char*, std::size_t> >
+    BufPrintf(char (&buf)[N], const PrintfFormat& format) {
+        std::pair<char*, std::size_t> temp(buf, N);
+        return PrintfFormatState<std::pair<char*, std::size_t> >(temp, format);
+    }
+
 }// namespace Loki
 
 
@@ -714,6 +714,53 @@ namespace Loki
 
 
 
+    namespace Private
+    {
+        ////////////////////////////////////////////////////////////////////////////////
+        // class template SingletonPointer
+        // Helper for SingletonHolder: reads and writes the instance pointer.
+        // Most threading models read it without any ordering, and rely on the
+        // class lock in MakeInstance.  DoubleCheckedLockable reads it with an
+        // acquire load and writes it with a release store, so a thread which
+        // sees the pointer also sees the fully constructed singleton.
+        ////////////////////////////////////////////////////////////////////////////////
+
+        template
+        <
+            class T,
+            template <class, class> class ThreadingModel,
+            class MutexPolicy
+        >
+        struct SingletonPointer
+        {
+            typedef typename ThreadingModel<T*,MutexPolicy>::VolatileType Type;
+
+            static inline T* Load(const Type& pointer)
+            { return pointer; }
+
+            static inline void Store(Type& pointer, T* value)
+            { pointer = value; }
+        };
+
+#if defined(LOKI_WINDOWS_H) || defined(LOKI_PTHREAD_H)
+
+        template <class T, class MutexPolicy>
+        struct SingletonPointer<T, DoubleCheckedLockable, MutexPolicy>
+        {
+            typedef T* volatile Type;
+            typedef DoubleCheckedLockable<T*,MutexPolicy> Model;
+
+            static inline T* Load(const Type& pointer)
+            { return Model::LoadAcquire(pointer); }
+
+            static inline void Store(Type& pointer, T* value)
+            { Model::StoreRelease(pointer, value); }
+        };
+
+#endif
+
+    } // namespace Private
+
     ////////////////////////////////////////////////////////////////////////////////
     ///  \class  SingletonHolder
     ///
@@ -727,6 +774,10 @@ namespace Loki
     ///  \param LifetimePolicy Lifetime policy, default: DefaultLifetime,
     ///  \param ThreadingModel Threading policy,
     ///                         default: LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL
+    ///                         Use DoubleCheckedLockable when Instance is
+    ///                         called from many threads: it never locks once
+    ///                         the singleton exists, and is safe on weakly
+    ///                         ordered processors.
     ////////////////////////////////////////////////////////////////////////////////
     template
     <
@@ -755,7 +806,8 @@ namespace Loki
         SingletonHolder();
 
         // Data
-        typedef typename ThreadingModel<T*,MutexPolicy>::VolatileType PtrInstanceType;
+        typedef Private::SingletonPointer<T, ThreadingModel, MutexPolicy> PtrAccess;
+        typedef typename PtrAccess::Type PtrInstanceType;
         static PtrInstanceType pInstance_;
         static bool destroyed_;
     };
@@ -800,11 +852,13 @@ namespace Loki
     inline T& SingletonHolder<T, CreationPolicy,
         LifetimePolicy, ThreadingModel, MutexPolicy>::Instance()
     {
-        if (!pInstance_)
+        T* instance = PtrAccess::Load(pInstance_);
+        if (!instance)
         {
             MakeInstance();
+            instance = pInstance_;
         }
-        return *pInstance_;
+        return *instance;
     }
 
     ////////////////////////////////////////////////////////////////////////////////
@@ -832,7 +886,7 @@ namespace Loki
                 destroyed_ = false;
                 LifetimePolicy<T>::OnDeadReference();
             }
-            pInstance_ = CreationPolicy<T>::Create();
+            PtrAccess::Store(pInstance_, CreationPolicy<T>::Create());
             LifetimePolicy<T>::ScheduleDestruction(pInstance_,
                 &DestroySingleton);
         }
@@ -851,7 +905,7 @@ namespace Loki
     {
         assert(!destroyed_);
         CreationPolicy<T>::Destroy(pInstance_);
-        pInstance_ = 0;
+        PtrAccess::Store(pInstance_, 0);
         destroyed_ = true;
     }
 
@@ -34,6 +34,10 @@
 #include <cstddef>
 #include <new> // needed for std::nothrow_t parameter.
 
+#if defined( LOKI_WINDOWS_H ) || defined( LOKI_PTHREAD_H )
+    #include <loki/ThreadLocal.h>
+#endif
+
 #ifndef LOKI_DEFAULT_CHUNK_SIZE
 #define LOKI_DEFAULT_CHUNK_SIZE 4096
 #endif
@@ -46,10 +50,22 @@
 #define LOKI_DEFAULT_OBJECT_ALIGNMENT 4
 #endif
 
+#ifndef LOKI_SMALL_OBJECT_CACHE_SIZE
+#define LOKI_SMALL_OBJECT_CACHE_SIZE 64
+#endif
+
 #ifndef LOKI_DEFAULT_SMALLOBJ_LIFETIME
 #define LOKI_DEFAULT_SMALLOBJ_LIFETIME ::Loki::LongevityLifetime::DieAsSmallObjectParent
 #endif
 
+#ifndef LOKI_DEFAULT_PAGE_SOURCE
+#define LOKI_DEFAULT_PAGE_SOURCE ::Loki::HeapPageSource
+#endif
+
+#ifndef LOKI_PAGE_REGION_SIZE
+#define LOKI_PAGE_REGION_SIZE ( 64 * 1024 * 1024 )
+#endif
+
 #if defined(LOKI_SMALL_OBJECT_USE_NEW_ARRAY) && defined(_MSC_VER)
 #pragma message("Don't define LOKI_SMALL_OBJECT_USE_NEW_ARRAY when using a Microsoft compiler to prevent memory leaks.")
 #pragma message("now calling '#undef LOKI_SMALL_OBJECT_USE_NEW_ARRAY'")
@@ -88,8 +104,170 @@ namespace Loki
     namespace Private
     {
         class FixedAllocator;
+        class ChunkMap;
+        class PageRegions;
     } // end namespace Private
 
+    /** @class PageSource
+        @ingroup SmallObjectGroup
+     Gives a SmallObjAllocator the memory for its Chunks.  Each Chunk takes a
+     whole number of pages of PageSize bytes, aligned on a PageSize boundary.
+     A page source belongs to one allocator, and the allocator only calls it
+     while it holds its lock, so a page source needs no lock of its own.  None
+     of the functions may throw.  AllocatorSingleton takes the class of its
+     page source as the PageSourcePolicy template parameter.
+     */
+    class LOKI_EXPORT PageSource
+    {
+    public:
+
+        enum { PageSize = 4096 };
+
+        virtual ~PageSource( void ) {}
+
+        /** Returns numBytes of memory aligned on a PageSize boundary, or a
+         nullptr if none is available.  numBytes is a multiple of PageSize.
+         */
+        virtual void * AllocatePages( ::std::size_t numBytes ) = 0;
+
+        /// Takes back memory returned by AllocatePages with the same size.
+        virtual void ReleasePages( void * place, ::std::size_t numBytes ) = 0;
+
+        /** Gives memory which ReleasePages kept for later back to the system.
+         SmallObjAllocator::TrimExcessMemory calls this after it released its
+         empty Chunks.
+         @return True if any memory was given back.
+         */
+        virtual bool Trim( void ) { return false; }
+    };
+
+    /** @class HeapPageSource
+        @ingroup SmallObjectGroup
+     Default page source which takes each Chunk from the heap with an aligned
+     malloc, and frees it as soon as the Chunk is released.
+     */
+    class LOKI_EXPORT HeapPageSource : public PageSource
+    {
+    public:
+        virtual void * AllocatePages( ::std::size_t numBytes );
+        virtual void ReleasePages( void * place, ::std::size_t numBytes );
+    };
+
+    /** @class MappedPageSource
+        @ingroup SmallObjectGroup
+     Page source which maps large regions of virtual memory directly from the
+     operating system, with mmap or VirtualAlloc, and carves the Chunks out of
+     them one after another.  Chunks thus sit next to each other instead of
+     being scattered over the heap, so the blocks of a program use fewer TLB
+     entries.  Where the system has transparent huge pages, the regions are
+     aligned to huge pages and advised to use them (MADV_HUGEPAGE).
+
+     Released Chunks stay mapped and are reused by the next Chunk of the same
+     size.  Trim gives their pages back to the system, with MADV_DONTNEED or
+     by decommitting them, but keeps the address range, so a later Chunk can
+     use them again.  Regions are only unmapped when the page source is
+     destroyed.  Pages are only backed by memory once they are touched,
+     except that a huge page is backed as a whole.
+     */
+    class LOKI_EXPORT MappedPageSource : public PageSource
+    {
+    public:
+
+        /** @param regionSize # of bytes mapped at once.  Rounded up to a whole
+         number of huge pages, if the system has them.
+         */
+        explicit MappedPageSource( ::std::size_t regionSize = LOKI_PAGE_REGION_SIZE );
+
+        virtual ~MappedPageSource( void );
+
+        virtual void * AllocatePages( ::std::size_t numBytes );
+
+        virtual void ReleasePages( void * place, ::std::size_t numBytes );
+
+        virtual bool Trim( void );
+
+        /// Returns # of bytes of address space mapped in all regions.
+        ::std::size_t GetMappedSize( void ) const;
+
+        /// Returns # of bytes released and not given back to the system yet.
+        ::std::size_t GetUntrimmedSize( void ) const;
+
+    private:
+        /// Copy-constructor is not implemented.
+        MappedPageSource( const MappedPageSource & );
+        /// Copy-assignment operator is not implemented.
+        MappedPageSource & operator = ( const MappedPageSource & );
+
+        /// The regions and the released Chunks within them.
+        ::Loki::Private::PageRegions * regions_;
+    };
+
+    /** @struct SmallObjStats
+        @ingroup SmallObjectGroup
+     Snapshot of the counters kept for a size class of SmallObjAllocator, or
+     the sum over all size classes.  The counters only ever grow, and the
+     gauges are derived from them, so a snapshot costs no lock and may be
+     taken from any thread while other threads allocate.  Each counter is
+     read atomically, but they are not read at the same instant, so the
+     gauges of a snapshot taken during allocations are approximate, and may
+     be off by a few blocks.  Deallocations are read before allocations, and
+     released Chunks before made ones, so a gauge is never negative, and
+     the gauge functions clamp at zero for snapshots summed or built by hand.
+
+     Blocks which sit in the magazines of a SmallObjThreadCache count as in
+     use, since the allocator handed them out.  The counters are compiled in
+     unless the library is built with LOKI_SMALL_OBJECT_NO_STATS defined, in
+     which case SmallObjAllocator::HasStats returns false and every counter
+     stays zero.
+     */
+    struct LOKI_EXPORT SmallObjStats
+    {
+        SmallObjStats( void );
+
+        /// # of bytes per block, or zero in a sum over size classes.
+        ::std::size_t blockSize_;
+        /// # of bytes of memory each Chunk takes from the page source, or zero
+        /// in a sum over size classes.
+        ::std::size_t chunkSize_;
+        /// # of blocks allocated.
+        ::std::size_t allocations_;
+        /// # of blocks deallocated.
+        ::std::size_t deallocations_;
+        /// # of allocations which found allocChunk_ full or missing, and had
+        /// to take the empty Chunk, search the Chunks, or make a new Chunk.
+        ::std::size_t allocSlowPaths_;
+        /// # of Chunks looked at while searching for one with a free block.
+        ::std::size_t chunksSearched_;
+        /// # of deallocations whose block was neither in the Chunk given by
+        /// the caller nor in deallocChunk_, and had to be found in the map.
+        ::std::size_t deallocSlowPaths_;
+        /// # of Chunks made.
+        ::std::size_t chunksMade_;
+        /// # of Chunks released.
+        ::std::size_t chunksReleased_;
+        /// # of bytes of all Chunks held now.
+        ::std::size_t bytesReserved_;
+        /// # of bytes in blocks which are allocated.
+        ::std::size_t bytesInUse_;
+
+        /// Returns # of Chunks held now.
+        inline ::std::size_t GetChunkCount( void ) const
+        { return ( chunksReleased_ < chunksMade_ ) ? chunksMade_ - chunksReleased_ : 0; }
+
+        /// Returns # of blocks allocated and not deallocated yet.
+        inline ::std::size_t GetBlocksInUse( void ) const
+        { return ( deallocations_ < allocations_ ) ? allocations_ - deallocations_ : 0; }
+
+        /** Returns fraction of reserved bytes not in use, from 0 when every
+         block of every Chunk is allocated, to 1 when all Chunks are empty.
+         Returns 0 if nothing is reserved.
+         */
+        double GetFragmentation( void ) const;
+
+        /// Adds the counters and byte counts of stats, but not the sizes.
+        SmallObjStats & operator += ( const SmallObjStats & stats );
+    };
+
     /** @class SmallObjAllocator
         @ingroup SmallObjectGroupInternal
      Manages pool of fixed-size allocators.
@@ -104,9 +282,11 @@ namespace Loki
          @param pageSize # of bytes in a page of memory.
          @param maxObjectSize Max # of bytes which this may allocate.
          @param objectAlignSize # of bytes between alignment boundaries.
+         @param pageSource Where Chunks get their memory.  It must outlive the
+          allocator.  If it is nullptr, a shared HeapPageSource is used.
          */
         SmallObjAllocator( ::std::size_t pageSize, ::std::size_t maxObjectSize,
-            ::std::size_t objectAlignSize );
+            ::std::size_t objectAlignSize, PageSource * pageSource = 0 );
 
         /** Destructor releases all blocks, all Chunks, and FixedAllocator's.
          Any outstanding blocks are unavailable, and should not be used after
@@ -148,20 +328,41 @@ namespace Loki
         void * Allocate( std::size_t size, bool doThrow );
 
         /** Deallocates a block of memory at a given place and of a specific
-        size.  Complexity is almost always constant-time, and is O(C) only if
-        it has to search for which Chunk deallocates.  This never throws.
+        size.  Complexity is constant-time since the Chunk which owns the block
+        is found through a map of pages to Chunks.  This never throws.
          */
         void Deallocate( void * p, std::size_t size );
 
         /** Deallocates a block of memory at a given place but of unknown size
-        size.  Complexity is O(F + C) where F is the count of FixedAllocator's
-        in the pool, and C is the number of Chunks in all FixedAllocator's.  This
+        size.  Complexity is constant-time since the same map of pages to
+        Chunks also knows which FixedAllocator owns each Chunk.  Blocks not
+        found in the map are given to the default deallocator.  This
         does not throw exceptions.  This overloaded version of Deallocate is
         called by the nothow delete operator - which is called when the nothrow
         new operator is used, but a constructor throws an exception.
          */
         void Deallocate( void * p );
 
+        /** Allocates up to count blocks of the same size and stores their
+         addresses in blocks.  This is used by SmallObjThreadCache to refill a
+         whole magazine while holding the allocator's lock only once.  If it
+         can not allocate any block, it calls TrimExcessMemory and tries once
+         more.  This never throws.
+         @param numBytes # of bytes in each block, at most GetMaxObjectSize.
+         @param blocks Array with room for at least count pointers.
+         @param count # of blocks wanted.
+         @return # of blocks actually allocated.
+         */
+        ::std::size_t AllocateBatch( ::std::size_t numBytes, void ** blocks,
+            ::std::size_t count );
+
+        /** Deallocates count blocks which all have the same size.  This is the
+         counterpart of AllocateBatch, and is used when a SmallObjThreadCache
+         flushes a magazine.  This never throws.
+         */
+        void DeallocateBatch( ::std::size_t numBytes, void ** blocks,
+            ::std::size_t count );
+
         /// Returns max # of bytes which this can allocate.
         inline ::std::size_t GetMaxObjectSize() const
         { return maxSmallObjectSize_; }
@@ -169,7 +370,8 @@ namespace Loki
         /// Returns # of bytes between allocation boundaries.
         inline std::size_t GetAlignment() const { return objectAlignSize_; }
 
-        /** Releases empty Chunks from memory.  Complexity is O(F + C) where F
+        /** Releases empty Chunks from memory, and lets the page source give
+        released pages back to the system.  Complexity is O(F + C) where F
         is the count of FixedAllocator's in the pool, and C is the number of
         Chunks in all FixedAllocator's.  This will never throw.  This is called
         by AllocatorSingleto::ClearExtraMemory, the new_handler function for
@@ -188,6 +390,25 @@ namespace Loki
          */
         bool IsCorrupt( void ) const;
 
+        /// Returns true if the library keeps counters for SmallObjStats.
+        static bool HasStats( void );
+
+        /// Returns # of size classes, one for each FixedAllocator in the pool.
+        inline ::std::size_t GetSizeClassCount( void ) const
+        { return ( maxSmallObjectSize_ + objectAlignSize_ - 1 ) / objectAlignSize_; }
+
+        /** Returns counters of the size class at index, which holds blocks of
+         ( index + 1 ) * GetAlignment() bytes.  This takes no lock, so it may
+         be called from any thread.  Complexity is constant.  This never throws.
+         */
+        SmallObjStats GetSizeClassStats( ::std::size_t index ) const;
+
+        /** Returns sum of the counters of all size classes.  Complexity is
+         O(F) where F is the count of FixedAllocator's in the pool.  This takes
+         no lock, and never throws.
+         */
+        SmallObjStats GetTotalStats( void ) const;
+
     private:
         /// Default-constructor is not implemented.
         SmallObjAllocator( void );
@@ -199,6 +420,12 @@ namespace Loki
         /// Pointer to array of fixed-size allocators.
         ::Loki::Private::FixedAllocator * pool_;
 
+        /// Pointer to map of memory pages to the Chunks which own them.
+        ::Loki::Private::ChunkMap * chunkMap_;
+
+        /// Where the Chunks get their memory.
+        PageSource * pageSource_;
+
         /// Largest object size supported by allocators.
         const ::std::size_t maxSmallObjectSize_;
 
@@ -206,6 +433,18 @@ namespace Loki
         const ::std::size_t objectAlignSize_;
     };
 
+    namespace Private
+    {
+        /** Holds the page source of an AllocatorSingleton in a base class, so
+         that it is made before the SmallObjAllocator base which uses it.
+         */
+        template < class PageSourcePolicy >
+        struct PageSourceHolder
+        {
+            PageSourcePolicy source_;
+        };
+    } // end namespace Private
+
     /** @class AllocatorSingleton
         @ingroup SmallObjectGroupInternal
      This template class is derived from
@@ -221,6 +460,10 @@ namespace Loki
      Thus, the only functions in the allocator which show up in SmallObject or
      SmallValueObject inheritance hierarchies are the new and delete
      operators.
+
+     PageSourcePolicy is the class of the PageSource which gives the allocator
+     its memory, such as HeapPageSource or MappedPageSource.  The allocator
+     owns one, made by its default constructor.
     */
     template
     <
@@ -229,15 +472,19 @@ namespace Loki
         std::size_t maxSmallObjectSize = LOKI_MAX_SMALL_OBJECT_SIZE,
         std::size_t objectAlignSize = LOKI_DEFAULT_OBJECT_ALIGNMENT,
         template <class> class LifetimePolicy = LOKI_DEFAULT_SMALLOBJ_LIFETIME,
-        class MutexPolicy = LOKI_DEFAULT_MUTEX
+        class MutexPolicy = LOKI_DEFAULT_MUTEX,
+        class PageSourcePolicy = LOKI_DEFAULT_PAGE_SOURCE
     >
-    class AllocatorSingleton : public SmallObjAllocator
+    class AllocatorSingleton
+        : private ::Loki::Private::PageSourceHolder< PageSourcePolicy >
+        , public SmallObjAllocator
     {
     public:
 
         /// Defines type of allocator.
         typedef AllocatorSingleton< ThreadingModel, chunkSize,
-            maxSmallObjectSize, objectAlignSize, LifetimePolicy > MyAllocator;
+            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy,
+            PageSourcePolicy > MyAllocator;
 
         /// Defines type for thread-safety locking mechanism.
         typedef ThreadingModel< MyAllocator, MutexPolicy > MyThreadingModel;
@@ -254,7 +501,8 @@ namespace Loki
 
         /// The default constructor is not meant to be called directly.
         inline AllocatorSingleton() :
-            SmallObjAllocator( chunkSize, maxSmallObjectSize, objectAlignSize )
+            SmallObjAllocator( chunkSize, maxSmallObjectSize, objectAlignSize,
+                &this->source_ )
             {}
 
         /// The destructor is not meant to be called directly.
@@ -280,6 +528,21 @@ namespace Loki
          */
         static bool IsCorrupted( void );
 
+        /** Returns counters of the size class at index.  Unlike IsCorrupted,
+         this takes no lock, so reading the counters never stalls threads
+         which allocate.
+         */
+        inline static SmallObjStats GetSizeClassStats( ::std::size_t index )
+        {
+            return Instance().SmallObjAllocator::GetSizeClassStats( index );
+        }
+
+        /// Returns sum of the counters of all size classes.  Takes no lock.
+        inline static SmallObjStats GetTotalStats( void )
+        {
+            return Instance().SmallObjAllocator::GetTotalStats();
+        }
+
     private:
         /// Copy-constructor is not implemented.
         AllocatorSingleton( const AllocatorSingleton & );
@@ -294,9 +557,10 @@ namespace Loki
         std::size_t M,
         std::size_t O,
         template <class> class L,
-        class X
+        class X,
+        class P
     >
-    void AllocatorSingleton< T, C, M, O, L, X >::ClearExtraMemory( void )
+    void AllocatorSingleton< T, C, M, O, L, X, P >::ClearExtraMemory( void )
     {
         typename MyThreadingModel::Lock lock;
         (void)lock; // get rid of warning
@@ -310,9 +574,10 @@ namespace Loki
         std::size_t M,
         std::size_t O,
         template <class> class L,
-        class X
+        class X,
+        class P
     >
-    bool AllocatorSingleton< T, C, M, O, L, X >::IsCorrupted( void )
+    bool AllocatorSingleton< T, C, M, O, L, X, P >::IsCorrupted( void )
     {
         typename MyThreadingModel::Lock lock;
         (void)lock; // get rid of warning
@@ -338,16 +603,337 @@ namespace Loki
         std::size_t M,
         std::size_t O,
         template <class> class L,
-        class X
+        class X,
+        class P
     >
     inline unsigned int GetLongevity(
-        AllocatorSingleton< T, C, M, O, L, X > * )
+        AllocatorSingleton< T, C, M, O, L, X, P > * )
     {
         // Returns highest possible value.
         return 0xFFFFFFFF;
     }
 
 
+    /** @class SmallObjThreadCache
+        @ingroup SmallObjectGroupInternal
+     Per-thread cache of free blocks in front of a SmallObjAllocator.  It holds
+     one magazine for each FixedAllocator size class.  A magazine is an array
+     of up to LOKI_SMALL_OBJECT_CACHE_SIZE free blocks.  Pop and Push are
+     inline and never touch the shared allocator, so they need no lock.  When
+     a magazine runs empty, Refill gets half a magazine from the allocator in
+     one batch.  When it runs full, Flush returns half a magazine in one batch.
+     The caller must hold the allocator's lock while calling Refill, Flush, or
+     FlushAll.
+
+     @par Cross-Thread Deallocation
+     A block freed by a thread other than the one which allocated it goes into
+     the freeing thread's magazine.  It gets back to the shared allocator when
+     that magazine is flushed, along with the other blocks in the same batch,
+     and from there the allocating thread's next Refill can pick it up.
+
+     @par Lifetime
+     When a thread exits, its caches are flushed and deleted.  When an
+     allocator is destroyed, the caches of the destroying thread are flushed,
+     since the main thread usually destroys it and never exits like other
+     threads do.  The caches of other threads are then marked as dead, so they
+     do not flush into the destroyed allocator when their threads exit.
+     */
+    class LOKI_EXPORT SmallObjThreadCache
+    {
+    public:
+
+        /** Function called when the thread which owns the cache exits.  It
+         should lock the allocator, call FlushAll, and forget the cache.  The
+         cache is deleted after this function returns.
+         */
+        typedef void ( * ExitFunction )( SmallObjThreadCache & cache );
+
+        /** Makes a cache for the calling thread.  If the platform supports it,
+         the cache is registered so that exitFunction gets called when the
+         thread exits, if the allocator still lives then.  (This uses a pthread
+         key destructor, or a fiber local storage callback on Windows, so the
+         caches of fibers which share a thread are not flushed by an exit.)
+         @return Pointer to new cache, or nullptr if none could be made.
+         */
+        static SmallObjThreadCache * Create( SmallObjAllocator & allocator,
+            ExitFunction exitFunction );
+
+        /// Returns a free block of numBytes size, or nullptr if magazine empty.
+        inline void * Pop( ::std::size_t numBytes )
+        {
+            Magazine & magazine = GetMagazine( numBytes );
+            if ( 0 == magazine.count_ )
+                return 0;
+            return magazine.blocks_[ --magazine.count_ ];
+        }
+
+        /// Puts block into magazine, or returns false if magazine is full.
+        inline bool Push( void * p, ::std::size_t numBytes )
+        {
+            Magazine & magazine = GetMagazine( numBytes );
+            if ( LOKI_SMALL_OBJECT_CACHE_SIZE == magazine.count_ )
+                return false;
+            magazine.blocks_[ magazine.count_++ ] = p;
+            return true;
+        }
+
+        /** Moves a batch of blocks from the allocator into the magazine for
+         numBytes.  Caller must hold the allocator's lock.
+         @return False if the allocator could not provide any block.
+         */
+        bool Refill( ::std::size_t numBytes );
+
+        /** Moves a batch of blocks from the magazine for numBytes back into
+         the allocator.  Caller must hold the allocator's lock.
+         */
+        void Flush( ::std::size_t numBytes );
+
+        /** Returns all blocks in all magazines to the allocator.  Caller must
+         hold the allocator's lock.
+         */
+        void FlushAll( void );
+
+        /// Returns the allocator which this caches.
+        inline SmallObjAllocator & GetAllocator( void ) const
+        { return *allocator_; }
+
+        /** Returns false if the allocator was destroyed.  A dead cache must
+         not be used again, but it stays owned by its thread until that exits.
+         */
+        inline bool IsAlive( void ) const
+        { return ( 0 != allocator_ ); }
+
+        /// Destructor does not flush magazines.  Call FlushAll first.
+        ~SmallObjThreadCache( void );
+
+        /** Calls the exit function for each cache in the list, and deletes
+         them.  This is called by the pthread library when a thread exits, and
+         is not meant to be called by clients.
+         */
+        static void OnThreadExit( void * caches );
+
+        /** Flushes the calling thread's caches for allocator, and marks all
+         caches for it as dead.  This is called by the destructor of
+         SmallObjAllocator, and is not meant to be called by clients.
+         */
+        static void ForgetAllocator( SmallObjAllocator & allocator );
+
+    private:
+
+        /// Holds free blocks of a single size class.
+        struct Magazine
+        {
+            ::std::size_t count_;
+            void * blocks_[ LOKI_SMALL_OBJECT_CACHE_SIZE ];
+        };
+
+        SmallObjThreadCache( SmallObjAllocator & allocator,
+            ExitFunction exitFunction );
+        /// Copy-constructor is not implemented.
+        SmallObjThreadCache( const SmallObjThreadCache & );
+        /// Copy-assignment operator is not implemented.
+        SmallObjThreadCache & operator = ( const SmallObjThreadCache & );
+
+        inline Magazine & GetMagazine( ::std::size_t numBytes )
+        {
+            if ( 0 == numBytes ) numBytes = 1;
+            return magazines_[ ( numBytes + alignment_ - 1 ) / alignment_ - 1 ];
+        }
+
+        /// Allocator which provides and receives blocks in batches, or nullptr
+        /// once the allocator is destroyed.
+        SmallObjAllocator * allocator_;
+        /// Copy of allocator's alignment so Pop and Push need not ask it.
+        const ::std::size_t alignment_;
+        /// Array of magazines, one per FixedAllocator.
+        Magazine * magazines_;
+        /// Called when owning thread exits.
+        ExitFunction exitFunction_;
+        /// Next cache owned by same thread, for a different allocator.
+        SmallObjThreadCache * next_;
+        /// Previous cache in list of all caches in the process.
+        SmallObjThreadCache * prevAll_;
+        /// Next cache in list of all caches in the process.
+        SmallObjThreadCache * nextAll_;
+    };
+
+#if defined( LOKI_WINDOWS_H ) || defined( LOKI_PTHREAD_H )
+
+    /** @class ThreadCachedLockable
+        @ingroup SmallObjectGroup
+     Threading policy for SmallObject and SmallValueObject which puts a
+     SmallObjThreadCache in front of the shared allocator.  Most allocations
+     and deallocations only touch the calling thread's cache and take no lock.
+     The class-level lock is only taken when a magazine needs a refill or a
+     flush, and then only once per batch.  In all other respects, and for any
+     other class, this behaves exactly like ClassLevelLockable.
+
+     @par Memory Use
+     Each thread can hold up to LOKI_SMALL_OBJECT_CACHE_SIZE free blocks per
+     size class, and those blocks can not be released by ClearExtraMemory.
+     The cached blocks go back to the allocator when the thread exits, or when
+     the allocator is destroyed by that thread.
+     */
+    template < class Host, class MutexPolicy = LOKI_DEFAULT_MUTEX >
+    class ThreadCachedLockable : public ClassLevelLockable< Host, MutexPolicy >
+    {
+    };
+
+#endif
+
+    namespace Private
+    {
+
+    /** @struct SmallObjectFront
+        @ingroup SmallObjectGroupInternal
+     Called by the new and delete operators of SmallObjectBase.  The general
+     version locks the allocator for every call.  Threading policies which
+     need a different way to reach the allocator specialize this template.
+     */
+    template
+    <
+        template <class, class> class ThreadingModel,
+        class AllocatorSingletonType,
+        class MutexPolicy
+    >
+    struct SmallObjectFront
+    {
+        typedef ThreadingModel< AllocatorSingletonType, MutexPolicy > MyThreadingModel;
+        typedef typename AllocatorSingletonType::MyAllocatorSingleton MyAllocatorSingleton;
+
+        static void * Allocate( ::std::size_t size, bool doThrow )
+        {
+            typename MyThreadingModel::Lock lock;
+            (void)lock; // get rid of warning
+            return MyAllocatorSingleton::Instance().Allocate( size, doThrow );
+        }
+
+        static void Deallocate( void * p, ::std::size_t size )
+        {
+            typename MyThreadingModel::Lock lock;
+            (void)lock; // get rid of warning
+            MyAllocatorSingleton::Instance().Deallocate( p, size );
+        }
+
+        static void Deallocate( void * p )
+        {
+            typename MyThreadingModel::Lock lock;
+            (void)lock; // get rid of warning
+            MyAllocatorSingleton::Instance().Deallocate( p );
+        }
+    };
+
+#if ( defined( LOKI_WINDOWS_H ) || defined( LOKI_PTHREAD_H ) ) && defined( LOKI_THREAD_LOCAL )
+
+    /** @struct SmallObjectFront
+        @ingroup SmallObjectGroupInternal
+     Specialization for ThreadCachedLockable which serves blocks from each
+     thread's own SmallObjThreadCache.  If no cache can be made for a thread,
+     it falls back to locking the allocator for every call.
+     */
+    template < class AllocatorSingletonType, class MutexPolicy >
+    struct SmallObjectFront< ThreadCachedLockable, AllocatorSingletonType, MutexPolicy >
+    {
+        typedef ThreadCachedLockable< AllocatorSingletonType, MutexPolicy > MyThreadingModel;
+        typedef typename AllocatorSingletonType::MyAllocatorSingleton MyAllocatorSingleton;
+
+        static void * Allocate( ::std::size_t size, bool doThrow )
+        {
+            SmallObjAllocator & allocator = MyAllocatorSingleton::Instance();
+            SmallObjThreadCache * cache = GetCache( allocator, size );
+            if ( 0 == cache )
+            {
+                typename MyThreadingModel::Lock lock;
+                (void)lock; // get rid of warning
+                return allocator.Allocate( size, doThrow );
+            }
+            void * place = cache->Pop( size );
+            if ( 0 != place )
+                return place;
+            {
+                typename MyThreadingModel::Lock lock;
+                (void)lock; // get rid of warning
+                cache->Refill( size );
+            }
+            place = cache->Pop( size );
+            if ( ( 0 == place ) && doThrow )
+                throw std::bad_alloc();
+            return place;
+        }
+
+        static void Deallocate( void * p, ::std::size_t size )
+        {
+            if ( 0 == p )
+                return;
+            SmallObjAllocator & allocator = MyAllocatorSingleton::Instance();
+            SmallObjThreadCache * cache = GetCache( allocator, size );
+            if ( 0 == cache )
+            {
+                typename MyThreadingModel::Lock lock;
+                (void)lock; // get rid of warning
+                allocator.Deallocate( p, size );
+                return;
+            }
+            if ( cache->Push( p, size ) )
+                return;
+            {
+                typename MyThreadingModel::Lock lock;
+                (void)lock; // get rid of warning
+                cache->Flush( size );
+            }
+            const bool pushed = cache->Push( p, size );
+            (void)pushed;
+            assert( pushed );
+        }
+
+        /// Size is unknown, so the block goes straight back to the allocator.
+        static void Deallocate( void * p )
+        {
+            typename MyThreadingModel::Lock lock;
+            (void)lock; // get rid of warning
+            MyAllocatorSingleton::Instance().Deallocate( p );
+        }
+
+    private:
+
+        /** Returns calling thread's cache, or nullptr if size is too big for
+         the cache or no cache could be made.
+         */
+        static SmallObjThreadCache * GetCache( SmallObjAllocator & allocator,
+            ::std::size_t size )
+        {
+            if ( size > allocator.GetMaxObjectSize() )
+                return 0;
+            // A cache outlived by its allocator is dead, as when a destroyed
+            // allocator singleton comes back as a phoenix.
+            if ( ( 0 == cache_ ) || !cache_->IsAlive() )
+                cache_ = SmallObjThreadCache::Create( allocator, &OnThreadExit );
+            return cache_;
+        }
+
+        /// Returns cached blocks to the allocator when thread exits.
+        static void OnThreadExit( SmallObjThreadCache & cache )
+        {
+            {
+                typename MyThreadingModel::Lock lock;
+                (void)lock; // get rid of warning
+                cache.FlushAll();
+            }
+            cache_ = 0;
+        }
+
+        /// Each thread's cache for this allocator.
+        static LOKI_THREAD_LOCAL SmallObjThreadCache * cache_;
+    };
+
+    template < class AllocatorSingletonType, class MutexPolicy >
+    LOKI_THREAD_LOCAL SmallObjThreadCache * SmallObjectFront< ThreadCachedLockable,
+        AllocatorSingletonType, MutexPolicy >::cache_ = 0;
+
+#endif
+
+    } // end namespace Private
+
     /** @class SmallObjectBase
         @ingroup SmallObjectGroup
      Base class for small object allocation classes.
@@ -443,7 +1029,8 @@ namespace Loki
         std::size_t maxSmallObjectSize,
         std::size_t objectAlignSize,
         template <class> class LifetimePolicy,
-        class MutexPolicy
+        class MutexPolicy,
+        class PageSourcePolicy = LOKI_DEFAULT_PAGE_SOURCE
     >
     class SmallObjectBase
     {
@@ -454,15 +1041,14 @@ namespace Loki
         /// Defines type of allocator singleton, must be public
         /// to handle singleton lifetime dependencies.
         typedef AllocatorSingleton< ThreadingModel, chunkSize,
-            maxSmallObjectSize, objectAlignSize, LifetimePolicy > ObjAllocatorSingleton;
+            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy,
+            PageSourcePolicy > ObjAllocatorSingleton;
 
     private:
 
-        /// Defines type for thread-safety locking mechanism.
-        typedef ThreadingModel< ObjAllocatorSingleton, MutexPolicy > MyThreadingModel;
-
-        /// Use singleton defined in AllocatorSingleton.
-        typedef typename ObjAllocatorSingleton::MyAllocatorSingleton MyAllocatorSingleton;
+        /// Defines how new and delete operators reach the allocator.
+        typedef ::Loki::Private::SmallObjectFront< ThreadingModel,
+            ObjAllocatorSingleton, MutexPolicy > MyFront;
 
     public:
 
@@ -474,17 +1060,13 @@ namespace Loki
         static void * operator new ( std::size_t size ) throw ( std::bad_alloc )
 #endif
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            return MyAllocatorSingleton::Instance().Allocate( size, true );
+            return MyFront::Allocate( size, true );
         }
 
         /// Non-throwing single-object new returns NULL if allocation fails.
         static void * operator new ( std::size_t size, const std::nothrow_t & ) throw ()
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            return MyAllocatorSingleton::Instance().Allocate( size, false );
+            return MyFront::Allocate( size, false );
         }
 
         /// Placement single-object new merely calls global placement new.
@@ -496,9 +1078,7 @@ namespace Loki
         /// Single-object delete.
         static void operator delete ( void * p, std::size_t size ) throw ()
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            MyAllocatorSingleton::Instance().Deallocate( p, size );
+            MyFront::Deallocate( p, size );
         }
 
         /** Non-throwing single-object delete is only called when nothrow
@@ -506,9 +1086,7 @@ namespace Loki
          */
         static void operator delete ( void * p, const std::nothrow_t & ) throw()
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            MyAllocatorSingleton::Instance().Deallocate( p );
+            MyFront::Deallocate( p );
         }
 
         /// Placement single-object delete merely calls global placement delete.
@@ -528,18 +1106,14 @@ namespace Loki
             throw ( std::bad_alloc )
 #endif
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            return MyAllocatorSingleton::Instance().Allocate( size, true );
+            return MyFront::Allocate( size, true );
         }
 
         /// Non-throwing array-object new returns NULL if allocation fails.
         static void * operator new [] ( std::size_t size,
             const std::nothrow_t & ) throw ()
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            return MyAllocatorSingleton::Instance().Allocate( size, false );
+            return MyFront::Allocate( size, false );
         }
 
         /// Placement array-object new merely calls global placement new.
@@ -551,9 +1125,7 @@ namespace Loki
         /// Array-object delete.
         static void operator delete [] ( void * p, std::size_t size ) throw ()
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            MyAllocatorSingleton::Instance().Deallocate( p, size );
+            MyFront::Deallocate( p, size );
         }
 
         /** Non-throwing array-object delete is only called when nothrow
@@ -562,9 +1134,7 @@ namespace Loki
         static void operator delete [] ( void * p,
             const std::nothrow_t & ) throw()
         {
-            typename MyThreadingModel::Lock lock;
-            (void)lock; // get rid of warning
-            MyAllocatorSingleton::Instance().Deallocate( p );
+            MyFront::Deallocate( p );
         }
 
         /// Placement array-object delete merely calls global placement delete.
@@ -601,10 +1171,12 @@ namespace Loki
         std::size_t maxSmallObjectSize = LOKI_MAX_SMALL_OBJECT_SIZE,
         std::size_t objectAlignSize = LOKI_DEFAULT_OBJECT_ALIGNMENT,
         template <class> class LifetimePolicy = LOKI_DEFAULT_SMALLOBJ_LIFETIME,
-        class MutexPolicy = LOKI_DEFAULT_MUTEX
+        class MutexPolicy = LOKI_DEFAULT_MUTEX,
+        class PageSourcePolicy = LOKI_DEFAULT_PAGE_SOURCE
     >
     class SmallObject : public SmallObjectBase< ThreadingModel, chunkSize,
-            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy >
+            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy,
+            PageSourcePolicy >
     {
 
     public:
@@ -637,10 +1209,12 @@ namespace Loki
         std::size_t maxSmallObjectSize = LOKI_MAX_SMALL_OBJECT_SIZE,
         std::size_t objectAlignSize = LOKI_DEFAULT_OBJECT_ALIGNMENT,
         template <class> class LifetimePolicy = LOKI_DEFAULT_SMALLOBJ_LIFETIME,
-        class MutexPolicy = LOKI_DEFAULT_MUTEX
+        class MutexPolicy = LOKI_DEFAULT_MUTEX,
+        class PageSourcePolicy = LOKI_DEFAULT_PAGE_SOURCE
     >
     class SmallValueObject : public SmallObjectBase< ThreadingModel, chunkSize,
-            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy >
+            maxSmallObjectSize, objectAlignSize, LifetimePolicy, MutexPolicy,
+            PageSourcePolicy >
     {
     protected:
         inline SmallValueObject( void ) {}
@@ -44,11 +44,13 @@
 #include <loki/LokiExport.h>
 #include <loki/SmallObj.h>
 #include <loki/TypeManip.h>
+#include <loki/TypeTraits.h>
 #include <loki/static_check.h>
 #include <loki/RefToValue.h>
 #include <loki/ConstPolicy.h>
 
 #include <functional>
+#include <new>
 #include <stdexcept>
 #include <cassert>
 #include <string>
@@ -367,6 +369,169 @@ namespace Loki
     inline typename LockedStorage<T>::StoredType& GetImplRef(LockedStorage<T>& sp)
     { return sp.pointee_; }
 
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class SharedLockedStorage
+///
+///  \ingroup  SmartPointerStorageGroup
+///  Implementation of the StoragePolicy used by SmartPtr.
+///
+///  Like LockedStorage, each call to operator-> locks the object for the
+///  duration of a call to a member function of T.  Calls through a const
+///  SmartPtr only get a const T, so they lock the object shared, and any
+///  number of threads can call const member functions at the same time.
+///  Calls through a non-const SmartPtr lock the object exclusively.
+///
+///  \par How It Works
+///  The non-const operator-> returns a Locker<T>, just as LockedStorage does.
+///  The const operator-> returns a SharedLocker<T>, which calls LockShared
+///  when it is constructed and UnlockShared when it is destructed.  SmartPtr
+///  asks Private::ConstArrow for the type of its const operator->, so that
+///  the SharedLocker stays alive for the whole call.
+///
+///  \note This storage policy requires class T to have member functions Lock,
+///  Unlock, LockShared and UnlockShared, such as those of a Loki::RWMutex.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class T>
+    class SharedLocker
+    {
+    public:
+        explicit SharedLocker( const T * p ) : pointee_( const_cast< T * >( p ) )
+        {
+            if ( pointee_ != 0 )
+                pointee_->LockShared();
+        }
+
+        /// Takes over the lock, so the returned temporary unlocks only once.
+        SharedLocker( const SharedLocker & that ) : pointee_( that.pointee_ )
+        {
+            that.pointee_ = 0;
+        }
+
+        ~SharedLocker( void )
+        {
+            if ( pointee_ != 0 )
+                pointee_->UnlockShared();
+        }
+
+        operator const T * ()
+        {
+            return pointee_;
+        }
+
+        const T * operator->()
+        {
+            return pointee_;
+        }
+
+    private:
+        SharedLocker( void );
+        SharedLocker & operator = ( const SharedLocker & );
+        mutable T * pointee_;
+    };
+
+    template <class T>
+    class SharedLockedStorage
+    {
+    public:
+
+        typedef T* StoredType;                     /// the type of the pointee_ object
+        typedef T* InitPointerType;                /// type used to declare OwnershipPolicy type.
+        typedef Locker< T > PointerType;           /// type returned by operator->
+        typedef SharedLocker< T > ConstPointerType; /// type returned by operator-> const
+        typedef T& ReferenceType;                  /// type returned by operator*
+
+    protected:
+
+        SharedLockedStorage() : pointee_( Default() ) {}
+
+        ~SharedLockedStorage( void ) {}
+
+        SharedLockedStorage( const SharedLockedStorage&) : pointee_( 0 ) {}
+
+        explicit SharedLockedStorage( const StoredType & p ) : pointee_( p ) {}
+
+        PointerType operator->()
+        {
+            return Locker< T >( pointee_ );
+        }
+
+        ConstPointerType operator->() const
+        {
+            return SharedLocker< T >( pointee_ );
+        }
+
+        void Swap(SharedLockedStorage& rhs)
+        {
+            std::swap( pointee_, rhs.pointee_ );
+        }
+
+        // Accessors
+        template <class F>
+        friend typename SharedLockedStorage<F>::InitPointerType GetImpl(const SharedLockedStorage<F>& sp);
+
+        template <class F>
+        friend const typename SharedLockedStorage<F>::StoredType& GetImplRef(const SharedLockedStorage<F>& sp);
+
+        template <class F>
+        friend typename SharedLockedStorage<F>::StoredType& GetImplRef(SharedLockedStorage<F>& sp);
+
+        // Destroys the data stored
+        // (Destruction might be taken over by the OwnershipPolicy)
+        void Destroy()
+        {
+            delete pointee_;
+        }
+
+        // Default value to initialize the pointer
+        static StoredType Default()
+        { return 0; }
+
+    private:
+        /// Dereference operator is not implemented.
+        ReferenceType operator*();
+
+        // Data
+        StoredType pointee_;
+    };
+
+    template <class T>
+    inline typename SharedLockedStorage<T>::InitPointerType GetImpl(const SharedLockedStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline const typename SharedLockedStorage<T>::StoredType& GetImplRef(const SharedLockedStorage<T>& sp)
+    { return sp.pointee_; }
+
+    template <class T>
+    inline typename SharedLockedStorage<T>::StoredType& GetImplRef(SharedLockedStorage<T>& sp)
+    { return sp.pointee_; }
+
+    namespace Private
+    {
+        ////////////////////////////////////////////////////////////////////////////////
+        ///  \struct ConstArrow
+        ///
+        ///  \ingroup  SmartPointerStorageGroup
+        ///  Gives the type returned by the const operator-> of SmartPtr.  That is
+        ///  the const pointer type chosen by the ConstnessPolicy, unless the
+        ///  StoragePolicy has to hold a lock for the duration of the call.
+        ////////////////////////////////////////////////////////////////////////////////
+
+        template < class SP, class ConstPointerType >
+        struct ConstArrow
+        {
+            typedef ConstPointerType Type;
+        };
+
+        template < class T, class ConstPointerType >
+        struct ConstArrow< SharedLockedStorage< T >, ConstPointerType >
+        {
+            typedef typename SharedLockedStorage< T >::ConstPointerType Type;
+        };
+    }
+
     namespace Private
     {
 
@@ -637,6 +802,301 @@ namespace Loki
         };
     };
 
+    namespace Private
+    {
+
+        ////////////////////////////////////////////////////////////////////////////////
+        ///  \class MadeBlock
+        ///
+        ///  \ingroup  SmartPointerOwnershipGroup
+        ///  Layout of a block made by MakeSmart or MakeStrong.  The block starts
+        ///   with a Header for the reference counts, and the pointee follows at
+        ///   the first offset aligned for any fundamental type.  Pointees which
+        ///   need stricter alignment than ::operator new gives can not be made.
+        ////////////////////////////////////////////////////////////////////////////////
+
+        template < class Header >
+        class MadeBlock
+        {
+            union MaxAlign
+            {
+                long double d_;
+                long l_;
+                void * p_;
+                void ( * f_ )( void );
+            };
+
+        public:
+
+            enum { ObjectOffset = ( ( sizeof(Header) + sizeof(MaxAlign) - 1 )
+                / sizeof(MaxAlign) ) * sizeof(MaxAlign) };
+
+            static Header * Allocate( size_t objectSize )
+            {
+                return static_cast< Header * >( ::operator new( ObjectOffset + objectSize ) );
+            }
+
+            static void Deallocate( Header * header )
+            {
+                ::operator delete( header );
+            }
+
+            static void * GetObject( Header * header )
+            {
+                return reinterpret_cast< char * >( header ) + ObjectOffset;
+            }
+        };
+
+        /// Destroys a pointee made by MakeStrong, but does not free it.
+        template < class T >
+        void DestroyMade( void * p )
+        {
+            static_cast< T * >( p )->~T();
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////
+        ///  \struct MadeRefCount
+        ///
+        ///  \ingroup  SmartPointerOwnershipGroup
+        ///  Header of a block made for the MadeRefCounted policies.
+        ////////////////////////////////////////////////////////////////////////////////
+
+        template < class CountType >
+        struct MadeRefCount
+        {
+            CountType count_;
+            /// Destroys the pointee and frees the whole block.  Since this is
+            /// called through a pointer, the free is not inlined where the
+            /// count drops, and callers never touch the block afterwards.
+            void ( * dispose_ )( void * );
+
+            /// Destroys the pointee and frees the whole block.
+            void Destroy( void )
+            {
+                dispose_( this );
+            }
+        };
+
+        /// Destroys the pointee of a block whose header is a MadeRefCount, and
+        /// frees the block.
+        template < class Header, class T >
+        void DisposeMade( void * header )
+        {
+            Header * const block = static_cast< Header * >( header );
+            static_cast< T * >( MadeBlock< Header >::GetObject( block ) )->~T();
+            MadeBlock< Header >::Deallocate( block );
+        }
+
+        ////////////////////////////////////////////////////////////////////////////////
+        ///  \class MadeBuilder
+        ///
+        ///  \ingroup  SmartPointerOwnershipGroup
+        ///  Helper for MakeSmart and MakeStrong.  It allocates one block for the
+        ///   counts and the pointee, frees the block if the pointee's constructor
+        ///   throws, and passes the block to the OwnershipPolicy of Ptr once the
+        ///   pointee exists.  That policy must declare MadePolicy and MadeHeader.
+        ////////////////////////////////////////////////////////////////////////////////
+
+        template < class Ptr >
+        class MadeBuilder
+        {
+        public:
+
+            typedef typename TypeTraits< typename Ptr::PointerType >::PointeeType Pointee;
+            typedef typename Ptr::MadePolicy Policy;
+            typedef typename Ptr::MadeHeader Header;
+
+            MadeBuilder( void )
+                : header_( MadeBlock< Header >::Allocate( sizeof(Pointee) ) )
+            {}
+
+            ~MadeBuilder( void )
+            {
+                if ( 0 != header_ )
+                    MadeBlock< Header >::Deallocate( header_ );
+            }
+
+            void * GetStorage( void )
+            {
+                return MadeBlock< Header >::GetObject( header_ );
+            }
+
+            Ptr Finish( Pointee * p )
+            {
+                Header * header = header_;
+                header_ = 0;
+                return Policy::template AdoptMade< Ptr >( header, p );
+            }
+
+        private:
+            /// Copy-constructor not implemented.
+            MadeBuilder( const MadeBuilder & );
+            /// Copy-assignment operator not implemented.
+            MadeBuilder & operator = ( const MadeBuilder & );
+
+            Header * header_;
+        };
+
+    } // namespace Private
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class MadeRefCounted
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Implementation of the OwnershipPolicy used by SmartPtr
+///  Like RefCounted, but for pointees made by MakeSmart.  The count lives in
+///   the same block as the pointee, so making a pointee needs one allocation
+///   instead of two, and copying a SmartPtr touches memory next to the pointee.
+///   The policy destroys the pointee itself, so the StoragePolicy must hold a
+///   plain pointer and is never asked to destroy it.  Only pass pointers from
+///   MakeSmart to SmartPtr's which use this policy.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class P>
+    class MadeRefCounted
+    {
+        template < class > friend class ::Loki::Private::MadeBuilder;
+
+    public:
+        typedef MadeRefCounted MadePolicy;
+        typedef Private::MadeRefCount< uintptr_t > MadeHeader;
+
+    protected:
+        MadeRefCounted() : pHeader_(0)
+        {}
+
+        MadeRefCounted(const MadeRefCounted& rhs)
+        : pHeader_(rhs.pHeader_)
+        {}
+
+        // MWCW lacks template friends, hence the following kludge
+        template <typename P1>
+        MadeRefCounted(const MadeRefCounted<P1>& rhs)
+        : pHeader_(reinterpret_cast<const MadeRefCounted&>(rhs).pHeader_)
+        {}
+
+        P Clone(const P& val)
+        {
+            assert(pHeader_ != 0 || val == 0);
+            if (pHeader_ != 0)
+                ++pHeader_->count_;
+            return val;
+        }
+
+        bool Release(const P&)
+        {
+            // Forget the header before the block may be freed.
+            MadeHeader* const header = pHeader_;
+            pHeader_ = 0;
+            if (header != 0 && !--header->count_)
+                header->Destroy();
+            return false;
+        }
+
+        void Swap(MadeRefCounted& rhs)
+        { std::swap(pHeader_, rhs.pHeader_); }
+
+        enum { destructiveCopy = false };
+
+    private:
+        template < class Ptr >
+        static Ptr AdoptMade(MadeHeader* header, P p)
+        {
+            header->count_ = 1;
+            header->dispose_ = &Private::DisposeMade< MadeHeader,
+                typename TypeTraits<P>::PointeeType >;
+            Ptr sp(p);
+            static_cast<MadeRefCounted&>(sp).pHeader_ = header;
+            return sp;
+        }
+
+        // Data
+        MadeHeader* pHeader_;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+///  \struct MadeRefCountedMTAdj
+///
+///  \ingroup  SmartPointerOwnershipGroup
+///  Implementation of the OwnershipPolicy used by SmartPtr
+///  Like RefCountedMT, but for pointees made by MakeSmart, and like
+///   MadeRefCounted the count lives in the same block as the pointee.
+///  Policy Usage: MadeRefCountedMTAdj<ThreadingModel>::RefCountedMT
+////////////////////////////////////////////////////////////////////////////////
+
+    template <template <class, class> class ThreadingModel,
+              class MX = LOKI_DEFAULT_MUTEX >
+    struct MadeRefCountedMTAdj
+    {
+        template <class P>
+        class RefCountedMT : public ThreadingModel< RefCountedMT<P>, MX >
+        {
+            template < class > friend class ::Loki::Private::MadeBuilder;
+
+        public:
+
+            typedef ThreadingModel< RefCountedMT<P>, MX > base_type;
+            typedef typename base_type::IntType       CountType;
+            typedef RefCountedMT                      MadePolicy;
+            typedef Private::MadeRefCount< CountType > MadeHeader;
+
+        protected:
+            RefCountedMT() : pHeader_(0)
+            {}
+
+            RefCountedMT(const RefCountedMT& rhs)
+            : pHeader_(rhs.pHeader_)
+            {}
+
+            //MWCW lacks template friends, hence the following kludge
+            template <typename P1>
+            RefCountedMT(const RefCountedMT<P1>& rhs)
+            : pHeader_(reinterpret_cast<const RefCountedMT<P>&>(rhs).pHeader_)
+            {}
+
+            P Clone(const P& val)
+            {
+                assert(pHeader_ != 0 || val == 0);
+                if (pHeader_ != 0)
+                    ThreadingModel<RefCountedMT, MX>::AtomicIncrement(pHeader_->count_);
+                return val;
+            }
+
+            bool Release(const P&)
+            {
+                if (pHeader_ != 0)
+                {
+                    bool isZero = false;
+                    ThreadingModel< RefCountedMT, MX >::AtomicDecrement( pHeader_->count_, 0, isZero );
+                    if ( isZero )
+                        pHeader_->Destroy();
+                    pHeader_ = 0;
+                }
+                return false;
+            }
+
+            void Swap(RefCountedMT& rhs)
+            { std::swap(pHeader_, rhs.pHeader_); }
+
+            enum { destructiveCopy = false };
+
+        private:
+            template < class Ptr >
+            static Ptr AdoptMade(MadeHeader* header, P p)
+            {
+                ThreadingModel<RefCountedMT, MX>::AtomicAssign(header->count_, 1);
+                header->dispose_ = &Private::DisposeMade< MadeHeader,
+                    typename TypeTraits<P>::PointeeType >;
+                Ptr sp(p);
+                static_cast<RefCountedMT&>(sp).pHeader_ = header;
+                return sp;
+            }
+
+            // Data
+            MadeHeader* pHeader_;
+        };
+    };
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class COMRefCounted
 ///
@@ -1551,7 +2011,7 @@ namespace Loki
             return SP::operator->();
         }
 
-        ConstPointerType operator->() const
+        typename Private::ConstArrow< SP, ConstPointerType >::Type operator->() const
         {
             KP::OnDereference(GetImplRef(*this));
             return SP::operator->();
@@ -1992,6 +2452,60 @@ namespace Loki
         const SmartPtr<T, OP, CP, KP, SP, CNP >& rhs)
     { return !(lhs < rhs); }
 
+////////////////////////////////////////////////////////////////////////////////
+///  MakeSmart makes a pointee and its reference count in a single allocation
+///   and returns a SmartPtr to it.  SmartPtrType must use MadeRefCounted or
+///   MadeRefCountedMTAdj<>::RefCountedMT for its OwnershipPolicy.  Usage:
+///   "ThingPtr p = MakeSmart< ThingPtr >( 3, name );"
+///  \ingroup SmartPointerGroup
+////////////////////////////////////////////////////////////////////////////////
+
+    template < class SmartPtrType >
+    inline SmartPtrType MakeSmart( void )
+    {
+        typedef Private::MadeBuilder< SmartPtrType > Builder;
+        Builder builder;
+        return builder.Finish( new ( builder.GetStorage() )
+            typename Builder::Pointee() );
+    }
+
+    template < class SmartPtrType, class P1 >
+    inline SmartPtrType MakeSmart( const P1 & p1 )
+    {
+        typedef Private::MadeBuilder< SmartPtrType > Builder;
+        Builder builder;
+        return builder.Finish( new ( builder.GetStorage() )
+            typename Builder::Pointee( p1 ) );
+    }
+
+    template < class SmartPtrType, class P1, class P2 >
+    inline SmartPtrType MakeSmart( const P1 & p1, const P2 & p2 )
+    {
+        typedef Private::MadeBuilder< SmartPtrType > Builder;
+        Builder builder;
+        return builder.Finish( new ( builder.GetStorage() )
+            typename Builder::Pointee( p1, p2 ) );
+    }
+
+    template < class SmartPtrType, class P1, class P2, class P3 >
+    inline SmartPtrType MakeSmart( const P1 & p1, const P2 & p2, const P3 & p3 )
+    {
+        typedef Private::MadeBuilder< SmartPtrType > Builder;
+        Builder builder;
+        return builder.Finish( new ( builder.GetStorage() )
+            typename Builder::Pointee( p1, p2, p3 ) );
+    }
+
+    template < class SmartPtrType, class P1, class P2, class P3, class P4 >
+    inline SmartPtrType MakeSmart( const P1 & p1, const P2 & p2, const P3 & p3,
+        const P4 & p4 )
+    {
+        typedef Private::MadeBuilder< SmartPtrType > Builder;
+        Builder builder;
+        return builder.Finish( new ( builder.GetStorage() )
+            typename Builder::Pointee( p1, p2, p3, p4 ) );
+    }
+
 } // namespace Loki
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -79,7 +79,8 @@
 ///   -# void * & GetPointerRef( void ) const
 ///   It is strongly recommended that all 12 of these functions be protected
 ///   instead of public.  These two functions are optional for single-threaded
-///   policies, but required for multi-threaded policies:
+///   policies, but required for multi-threaded policies which let StrongPtr
+///   lock the pointee.  LockFreeTwoRefCounts does not:
 ///   -# void Lock( void ) const
 ///   -# void Unlock( void ) const
 ///   This function is entirely optional:
@@ -876,6 +877,141 @@ private:
     mutable LOKI_DEFAULT_MUTEX m_Mutex;
 };
 
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class LockFreeTwoRefCountInfo
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   Implementation detail for LockFreeTwoRefCounts.  It keeps the strong
+///   count, the weak count and a flag in one word which is only changed by
+///   atomic operations, so it needs no mutex.  The strong count is in the
+///   upper half of the word.  The weak count is in the lower half above the
+///   flag, and it includes one count which all the strong pointers hold
+///   together, so the block outlives the last strong pointer until its
+///   pointee is zapped.  The flag marks blocks made by a weak pointer which
+///   no strong pointer has shared yet.  Such a block may still gain a strong
+///   pointer, while a block whose last strong pointer died never can.
+////////////////////////////////////////////////////////////////////////////////
+
+class LOKI_EXPORT LockFreeTwoRefCountInfo
+{
+public:
+
+#if defined( LOKI_WINDOWS_H )
+    typedef LONGLONG CountsType;
+#else
+    typedef unsigned long long CountsType;
+#endif
+
+    inline LockFreeTwoRefCountInfo( void * p, bool strong )
+        : m_pointer( p )
+        , m_counts( strong ? StrongOne + WeakOne : WeakOne + UnownedFlag )
+    {
+    }
+
+    inline bool HasStrongPointer( void ) const
+    {
+        return ( StrongOne <= Ops::Load( m_counts ) );
+    }
+
+    /// Adds a weak count.  Only call this while holding a count.
+    inline void IncWeakCount( void )
+    {
+        Ops::Add( m_counts, WeakOne );
+    }
+
+    /// Adds a strong count, unless the last strong pointer already died.
+    /// The first strong count also takes the weak count of the strong
+    /// pointers.  Returns false if no count was added.
+    inline bool TryIncStrongCount( void )
+    {
+        CountsType expected = Ops::Load( m_counts );
+        for ( ;; )
+        {
+            const bool owned = ( StrongOne <= expected );
+            if ( !owned && ( 0 == ( expected & UnownedFlag ) ) )
+                return false;
+            const CountsType desired = owned ? expected + StrongOne
+                : ( expected & ~UnownedFlag ) + StrongOne + WeakOne;
+            if ( Ops::CompareExchange( m_counts, expected, desired ) )
+                return true;
+        }
+    }
+
+    /// Returns true if this removed the last strong count.
+    inline bool DecStrongCount( void )
+    {
+        const CountsType counts = Ops::Add( m_counts, Negate( StrongOne ) );
+        return ( counts < StrongOne );
+    }
+
+    /// Removes a weak count, unless it is the very last count, which is left
+    /// for ZapPointer to remove.  Returns true if it is the last count.
+    inline bool DecWeakCount( void )
+    {
+        CountsType expected = Ops::Load( m_counts );
+        for ( ;; )
+        {
+            assert( WeakOne <= ( expected & WeakMask ) );
+            if ( WeakOne == ( expected & ~UnownedFlag ) )
+                return true;
+            if ( Ops::CompareExchange( m_counts, expected, expected - WeakOne ) )
+                return false;
+        }
+    }
+
+    /// Zaps the pointer and then removes a weak count.  Returns true if that
+    /// was the last count, so the caller must free this.
+    inline bool ZapPointer( void )
+    {
+        m_pointer = 0;
+        const CountsType counts = Ops::Add( m_counts, Negate( WeakOne ) );
+        return ( 0 == ( counts & ~UnownedFlag ) );
+    }
+
+    void SetPointer( void * p )
+    {
+        m_pointer = p;
+    }
+
+    inline void * GetPointer( void ) const
+    {
+        return m_pointer;
+    }
+
+    inline void * & GetPointerRef( void ) const
+    {
+        return const_cast< void * & >( m_pointer );
+    }
+
+private:
+    /// Default constructor is not available.
+    LockFreeTwoRefCountInfo( void );
+    /// Copy constructor is not available.
+    LockFreeTwoRefCountInfo( const LockFreeTwoRefCountInfo & );
+    /// Copy-assignment operator is not available.
+    LockFreeTwoRefCountInfo & operator = ( const LockFreeTwoRefCountInfo & );
+
+    typedef ::Loki::AtomicOps< CountsType, ::Loki::AtomicAcqRel > Ops;
+
+    static const CountsType UnownedFlag = 1;
+    static const CountsType WeakOne = 2;
+    static const CountsType StrongOne =
+        static_cast< CountsType >( 1 ) << ( 4 * sizeof( CountsType ) );
+    static const CountsType WeakMask = StrongOne - WeakOne;
+
+    static inline CountsType Negate( CountsType value )
+    {
+        return static_cast< CountsType >( 0 - value );
+    }
+
+    void * m_pointer;
+    volatile CountsType m_counts;
+};
+
+#endif // if LOKI_THREADS_ATOMIC_LOCKFREE
+
 #endif // if object-level-locking or class-level-locking
 
 } // end namespace Private
@@ -959,6 +1095,171 @@ private:
     Loki::Private::TwoRefCountInfo * m_counts;
 };
 
+namespace Private
+{
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class MadeTwoRefCountInfo
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   Implementation detail for MadeTwoRefCounts.  It sits at the front of a
+///   block made by MakeStrong, just before the pointee, and adds a function to
+///   destroy the pointee to the counts of TwoRefCountInfo.
+////////////////////////////////////////////////////////////////////////////////
+
+class LOKI_EXPORT MadeTwoRefCountInfo : public TwoRefCountInfo
+{
+public:
+
+    inline MadeTwoRefCountInfo( void * p, void ( * destroy )( void * ), bool strong )
+        : TwoRefCountInfo( p, strong )
+        , m_destroy( destroy )
+    {
+    }
+
+    /// Zaps the pointer before destroying the pointee, as StrongPtr does.
+    inline void DestroyPointee( void )
+    {
+        void * p = GetPointer();
+        ZapPointer();
+        if ( 0 != p )
+        {
+            m_destroy( p );
+        }
+    }
+
+private:
+    /// Default constructor not implemented.
+    MadeTwoRefCountInfo( void );
+    /// Copy-constructor not implemented.
+    MadeTwoRefCountInfo( const MadeTwoRefCountInfo & );
+    /// Copy-assignment operator not implemented.
+    MadeTwoRefCountInfo & operator = ( const MadeTwoRefCountInfo & );
+
+    void ( * m_destroy )( void * );
+};
+
+} // end namespace Private
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class MadeTwoRefCounts
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   This implementation of StrongPtr's OwnershipPolicy is like TwoRefCounts,
+///   but it is for pointees made by MakeStrong.  The counts and the pointee
+///   share a single allocation, and a null StrongPtr needs no allocation at
+///   all.  This policy destroys the pointee when the last strong copointer
+///   dies, and frees the block when the last copointer dies, so the
+///   DeletePolicy is never used.  It is not thread safe.
+///
+///  \note Use only pointers made by MakeStrong with this policy.  Constructing
+///   a StrongPtr from any other non-null pointer throws a logic_error.
+///
+///  \note Use NeverReset for the ResetPolicy, since a pointee made by
+///   MakeStrong can not be released to, or replaced by, a plain pointer.
+////////////////////////////////////////////////////////////////////////////////
+
+class LOKI_EXPORT MadeTwoRefCounts
+{
+    template < class > friend class ::Loki::Private::MadeBuilder;
+
+public:
+
+    typedef MadeTwoRefCounts MadePolicy;
+    typedef ::Loki::Private::MadeTwoRefCountInfo MadeHeader;
+
+protected:
+
+    explicit MadeTwoRefCounts( bool strong ) : m_info( NULL )
+    {
+        (void)strong;
+    }
+
+    MadeTwoRefCounts( const void * p, bool strong );
+
+    MadeTwoRefCounts( const MadeTwoRefCounts & rhs, bool strong ) :
+        m_info( rhs.m_info )
+    {
+        Increment( strong );
+    }
+
+    MadeTwoRefCounts( const MadeTwoRefCounts & rhs, bool isNull, bool strong ) :
+        m_info( ( isNull ) ? NULL : rhs.m_info )
+    {
+        Increment( strong );
+    }
+
+    /// Nothing to do here, since Release does all the cleanup.
+    inline ~MadeTwoRefCounts( void ) {}
+
+    /// Destroys the pointee or frees the block as needed.  Always returns
+    /// false, since StrongPtr has nothing left to delete.
+    bool Release( bool strong );
+
+    inline bool HasStrongPointer( void ) const
+    {
+        return ( NULL != m_info ) && m_info->HasStrongPointer();
+    }
+
+    inline void Swap( MadeTwoRefCounts & rhs )
+    {
+        ::std::swap( m_info, rhs.m_info );
+    }
+
+    void SetPointer( void * p );
+
+    /// Nothing to do here, since Release already zapped the pointer.
+    inline void ZapPointer( void ) {}
+
+    inline void * & GetPointerRef( void ) const
+    {
+        return ( NULL == m_info ) ? s_nullPointer : m_info->GetPointerRef();
+    }
+
+    inline void * GetPointer( void ) const
+    {
+        return ( NULL == m_info ) ? NULL : m_info->GetPointer();
+    }
+
+private:
+
+    /// Default constructor is not implemented.
+    MadeTwoRefCounts( void );
+    /// Copy constructor is not implemented.
+    MadeTwoRefCounts( const MadeTwoRefCounts & );
+    /// Copy-assignment operator is not implemented.
+    MadeTwoRefCounts & operator = ( const MadeTwoRefCounts & );
+
+    inline void Increment( bool strong )
+    {
+        if ( NULL == m_info )
+            return;
+        if ( strong )
+            m_info->IncStrongCount();
+        else
+            m_info->IncWeakCount();
+    }
+
+    /// Called by MakeStrong once the pointee exists in the block at header.
+    template < class Ptr, class T >
+    static Ptr AdoptMade( MadeHeader * header, T * p )
+    {
+        Ptr sp;
+        assert( sp.IsStrong() );
+        void * pointee = const_cast< void * >( static_cast< const void * >( p ) );
+        static_cast< MadeTwoRefCounts & >( sp ).m_info =
+            new ( header ) MadeHeader( pointee,
+                &::Loki::Private::DestroyMade< T >, sp.IsStrong() );
+        return sp;
+    }
+
+    /// Referred to by GetPointerRef when no block exists.
+    static void * s_nullPointer;
+
+    /// Pointer to the counts at the front of the made block.
+    ::Loki::Private::MadeTwoRefCountInfo * m_info;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 ///  \class SingleOwnerRefCount
 ///
@@ -1450,6 +1751,147 @@ private:
 
 };
 
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+////////////////////////////////////////////////////////////////////////////////
+///  \class LockFreeTwoRefCounts
+///
+///  \ingroup  StrongPointerOwnershipGroup
+///   This implementation of StrongPtr's OwnershipPolicy is a thread-safe
+///   alternative to LockableTwoRefCounts which has no mutex.  The counts are
+///   kept in one word and changed by atomic operations, so a count block is
+///   only two words, and copying or destroying copointers never blocks.  The
+///   blocks come from a SmallValueObject pool with a cache per thread.
+///
+///   Making a strong pointer from a weak one is safe even while another
+///   thread destroys the last strong pointer.  The strong count is only
+///   incremented if the pointee is still alive, else the new strong pointer
+///   is null, and does not share the counts of the weak pointer.  So the
+///   usual way to use a weak pointer from many threads is to copy it into a
+///   strong pointer and then check that for null.
+///
+///  \note This policy has no Lock and Unlock functions, so StrongPtr's Lock
+///   and Unlock can not be used with it.  Use a LockingPtr or a mutex in the
+///   pointee instead.
+///
+///  \note A pointee owned only by weak pointers is deleted by the last of
+///   them, instead of by the first as with LockableTwoRefCounts.
+////////////////////////////////////////////////////////////////////////////////
+
+class LOKI_EXPORT LockFreeTwoRefCounts
+{
+    typedef SmallValueObject< ::Loki::ThreadCachedLockable > ThreadSafePointerAllocator;
+    typedef ::Loki::Private::LockFreeTwoRefCountInfo CountsInfo;
+
+protected:
+
+    explicit LockFreeTwoRefCounts( bool strong )
+        : m_counts( MakeCounts( NULL, strong ) )
+    {
+    }
+
+    LockFreeTwoRefCounts( const void * p, bool strong )
+        : m_counts( MakeCounts( p, strong ) )
+    {
+    }
+
+    LockFreeTwoRefCounts( const LockFreeTwoRefCounts & rhs, bool strong ) :
+        m_counts( rhs.m_counts )
+    {
+        Increment( strong );
+    }
+
+    LockFreeTwoRefCounts( const LockFreeTwoRefCounts & rhs, bool isNull, bool strong ) :
+        m_counts( ( isNull ) ? MakeCounts( NULL, strong ) : rhs.m_counts )
+    {
+        if ( !isNull )
+        {
+            Increment( strong );
+        }
+    }
+
+    /** The destructor does not need to do anything since the call to
+     ZapPointer inside StrongPtr::~StrongPtr will do the cleanup which
+     this dtor would have done.
+     */
+    inline ~LockFreeTwoRefCounts( void ) {}
+
+    /// Returns true if the caller must delete the pointee and call ZapPointer.
+    inline bool Release( bool strong )
+    {
+        return ( strong ) ? m_counts->DecStrongCount() : m_counts->DecWeakCount();
+    }
+
+    inline bool HasStrongPointer( void ) const
+    {
+        return m_counts->HasStrongPointer();
+    }
+
+    inline void Swap( LockFreeTwoRefCounts & rhs )
+    {
+        ::std::swap( m_counts, rhs.m_counts );
+    }
+
+    void SetPointer( void * p )
+    {
+        m_counts->SetPointer( p );
+    }
+
+    void ZapPointer( void )
+    {
+        if ( m_counts->ZapPointer() )
+        {
+            m_counts->~CountsInfo();
+            ThreadSafePointerAllocator::operator delete ( m_counts,
+                sizeof(CountsInfo) );
+            m_counts = NULL;
+        }
+    }
+
+    inline void * GetPointer( void ) const
+    {
+        return m_counts->GetPointer();
+    }
+
+    inline void * & GetPointerRef( void ) const
+    {
+        return m_counts->GetPointerRef();
+    }
+
+private:
+    /// Default constructor is not implemented.
+    LockFreeTwoRefCounts( void );
+    /// Copy constructor is not implemented.
+    LockFreeTwoRefCounts( const LockFreeTwoRefCounts & );
+    /// Copy-assignment operator is not implemented.
+    LockFreeTwoRefCounts & operator = ( const LockFreeTwoRefCounts & );
+
+    static CountsInfo * MakeCounts( const void * p, bool strong )
+    {
+        void * temp = ThreadSafePointerAllocator::operator new( sizeof(CountsInfo) );
+        return new ( temp ) CountsInfo( const_cast< void * >( p ), strong );
+    }
+
+    /// A strong copy of a pointer whose pointee already died gets new counts
+    /// for a null pointer.
+    void Increment( bool strong )
+    {
+        if ( !strong )
+        {
+            m_counts->IncWeakCount();
+        }
+        else if ( !m_counts->TryIncStrongCount() )
+        {
+            m_counts = MakeCounts( NULL, true );
+        }
+    }
+
+    /// Pointer to all shared data.
+    CountsInfo * m_counts;
+};
+
+#endif // if LOKI_THREADS_ATOMIC_LOCKFREE
+
 #endif // if object-level-locking or class-level-locking
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -2563,6 +3005,62 @@ inline bool operator >= ( U * lhs,
     return !( rhs.GreaterThan( lhs ) );
 }
 
+////////////////////////////////////////////////////////////////////////////////
+///  MakeStrong makes a pointee and its reference counts in a single allocation
+///   and returns a strong pointer to it.  StrongPtrType must use
+///   MadeTwoRefCounts for its OwnershipPolicy.  Usage:
+///   "ThingPtr p = MakeStrong< ThingPtr >( 3, name );"
+///  \ingroup SmartPointerGroup
+////////////////////////////////////////////////////////////////////////////////
+
+template < class StrongPtrType >
+inline StrongPtrType MakeStrong( void )
+{
+    typedef ::Loki::Private::MadeBuilder< StrongPtrType > Builder;
+    Builder builder;
+    return builder.Finish( new ( builder.GetStorage() )
+        typename Builder::Pointee() );
+}
+
+template < class StrongPtrType, class P1 >
+inline StrongPtrType MakeStrong( const P1 & p1 )
+{
+    typedef ::Loki::Private::MadeBuilder< StrongPtrType > Builder;
+    Builder builder;
+    return builder.Finish( new ( builder.GetStorage() )
+        typename Builder::Pointee( p1 ) );
+}
+
+template < class StrongPtrType, class P1, class P2 >
+inline StrongPtrType MakeStrong( const P1 & p1, const P2 & p2 )
+{
+    typedef ::Loki::Private::MadeBuilder< StrongPtrType > Builder;
+    Builder builder;
+    return builder.Finish( new ( builder.GetStorage() )
+        typename Builder::Pointee( p1, p2 ) );
+}
+
+template < class StrongPtrType, class P1, class P2, class P3 >
+inline StrongPtrType MakeStrong( const P1 & p1, const P2 & p2, const P3 & p3 )
+{
+    typedef ::Loki::Private::MadeBuilder< StrongPtrType > Builder;
+    Builder builder;
+    return builder.Finish( new ( builder.GetStorage() )
+        typename Builder::Pointee( p1, p2, p3 ) );
+}
+
+template < class StrongPtrType, class P1, class P2, class P3, class P4 >
+inline StrongPtrType MakeStrong( const P1 & p1, const P2 & p2, const P3 & p3,
+    const P4 & p4 )
+{
+    typedef ::Loki::Private::MadeBuilder< StrongPtrType > Builder;
+    Builder builder;
+    return builder.Finish( new ( builder.GetStorage() )
+        typename Builder::Pointee( p1, p2, p3, p4 ) );
+}
+
+// ----------------------------------------------------------------------------
+
 } // namespace Loki
 
 namespace std
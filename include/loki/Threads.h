@@ -93,6 +93,26 @@
     #define LOKI_DEFAULT_MUTEX ::Loki::Mutex
 #endif
 
+///  The atomic functions of ObjectLevelLockable and ClassLevelLockable are
+///  lock-free when the platform provides atomic instructions (Interlocked
+///  functions on Windows, the __atomic builtins of gcc and clang elsewhere).
+///  Define LOKI_THREADS_ATOMIC_USE_MUTEX to get the old implementation which
+///  guards every atomic function with one mutex per threading model class.
+///  LOKI_THREADS_ATOMIC_ORDER selects the memory ordering used by the
+///  threading models, see Loki::AtomicOrder.  The default is sequential
+///  consistency.
+#if !defined( LOKI_THREADS_ATOMIC_USE_MUTEX )
+    #if defined( LOKI_WINDOWS_H )
+        #define LOKI_THREADS_ATOMIC_LOCKFREE
+    #elif defined( LOKI_PTHREAD_H ) && defined( __GNUC__ ) && defined( __ATOMIC_SEQ_CST )
+        #define LOKI_THREADS_ATOMIC_LOCKFREE
+    #endif
+#endif
+
+#if !defined( LOKI_THREADS_ATOMIC_ORDER )
+    #define LOKI_THREADS_ATOMIC_ORDER ::Loki::AtomicSeqCst
+#endif
+
 #if defined( LOKI_WINDOWS_H )
 
 #define LOKI_THREADS_MUTEX(x)           CRITICAL_SECTION (x);
@@ -103,6 +123,17 @@
 #define LOKI_THREADS_LONG               LONG
 #define LOKI_THREADS_MUTEX_CTOR(x)
 
+// slim reader-writer locks need Windows Vista or later
+#define LOKI_THREADS_RWMUTEX(x)                 SRWLOCK x;
+#define LOKI_THREADS_RWMUTEX_INIT(x)            ::InitializeSRWLock (x)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)
+#define LOKI_THREADS_RWMUTEX_LOCK(x)            ::AcquireSRWLockExclusive (x)
+#define LOKI_THREADS_RWMUTEX_UNLOCK(x)          ::ReleaseSRWLockExclusive (x)
+#define LOKI_THREADS_RWMUTEX_LOCK_SHARED(x)     ::AcquireSRWLockShared (x)
+#define LOKI_THREADS_RWMUTEX_UNLOCK_SHARED(x)   ::ReleaseSRWLockShared (x)
+
+#if !defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
 #define LOKI_THREADS_ATOMIC_FUNCTIONS                                   \
     private:                                                            \
         static CRITICAL_SECTION atomic_mutex_;                          \
@@ -205,6 +236,8 @@
             return lval;                                                \
         }
 
+#endif // #if !defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
 #elif defined(LOKI_PTHREAD_H)
 
 
@@ -226,6 +259,39 @@
 #define LOKI_THREADS_MUTEX_UNLOCK(x)    ::pthread_mutex_unlock (x)
 #define LOKI_THREADS_LONG               long
 
+#define LOKI_THREADS_RWMUTEX(x)                 pthread_rwlock_t x;
+#define LOKI_THREADS_RWMUTEX_INIT(x)            ::Loki::Private::InitRWMutex (x)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)          ::pthread_rwlock_destroy (x)
+#define LOKI_THREADS_RWMUTEX_LOCK(x)            ::pthread_rwlock_wrlock (x)
+#define LOKI_THREADS_RWMUTEX_UNLOCK(x)          ::pthread_rwlock_unlock (x)
+#define LOKI_THREADS_RWMUTEX_LOCK_SHARED(x)     ::pthread_rwlock_rdlock (x)
+#define LOKI_THREADS_RWMUTEX_UNLOCK_SHARED(x)   ::pthread_rwlock_unlock (x)
+
+namespace Loki
+{
+    namespace Private
+    {
+        /// Makes glibc prefer writers, as other platforms do, so that a steady
+        /// stream of readers can not starve them.
+        inline int InitRWMutex( pthread_rwlock_t * rwlock )
+        {
+#if defined( __GLIBC__ ) && defined( __USE_GNU )
+            pthread_rwlockattr_t attributes;
+            ::pthread_rwlockattr_init( &attributes );
+            ::pthread_rwlockattr_setkind_np( &attributes,
+                PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP );
+            const int result = ::pthread_rwlock_init( rwlock, &attributes );
+            ::pthread_rwlockattr_destroy( &attributes );
+            return result;
+#else
+            return ::pthread_rwlock_init( rwlock, 0 );
+#endif
+        }
+    }
+}
+
+#if !defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
 #define LOKI_THREADS_ATOMIC(x)                                           \
                 pthread_mutex_lock(&atomic_mutex_);                      \
                 x;                                                       \
@@ -318,6 +384,8 @@
             return lval;                                                \
         }
 
+#endif // #if !defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
 #else // single threaded
 
 #define LOKI_THREADS_MUTEX(x)
@@ -328,13 +396,258 @@
 #define LOKI_THREADS_LONG
 #define LOKI_THREADS_MUTEX_CTOR(x)
 
+#define LOKI_THREADS_RWMUTEX(x)
+#define LOKI_THREADS_RWMUTEX_INIT(x)
+#define LOKI_THREADS_RWMUTEX_DELETE(x)
+#define LOKI_THREADS_RWMUTEX_LOCK(x)
+#define LOKI_THREADS_RWMUTEX_UNLOCK(x)
+#define LOKI_THREADS_RWMUTEX_LOCK_SHARED(x)
+#define LOKI_THREADS_RWMUTEX_UNLOCK_SHARED(x)
+
 #endif
 
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+#define LOKI_THREADS_ATOMIC_FUNCTIONS                                   \
+    public:                                                             \
+        typedef ::Loki::AtomicOps< IntType, LOKI_THREADS_ATOMIC_ORDER > AtomicOpsType; \
+                                                                        \
+        static IntType AtomicAdd(volatile IntType& lval, const IntType val) \
+        { return AtomicOpsType::Add( lval, val ); }                     \
+                                                                        \
+        static IntType AtomicSubtract(volatile IntType& lval, const IntType val) \
+        { return AtomicOpsType::Add( lval, -val ); }                    \
+                                                                        \
+        static IntType AtomicMultiply(volatile IntType& lval, const IntType val) \
+        { return AtomicOpsType::Multiply( lval, val ); }                \
+                                                                        \
+        static IntType AtomicDivide(volatile IntType& lval, const IntType val) \
+        { return AtomicOpsType::Divide( lval, val ); }                  \
+                                                                        \
+        static IntType AtomicIncrement(volatile IntType& lval)          \
+        { return AtomicOpsType::Add( lval, 1 ); }                       \
+                                                                        \
+        static IntType AtomicDecrement(volatile IntType& lval)          \
+        { return AtomicOpsType::Add( lval, -1 ); }                      \
+                                                                        \
+        static IntType AtomicAssign(volatile IntType& lval, const IntType val) \
+        {                                                               \
+            AtomicOpsType::Store( lval, val );                          \
+            return val;                                                 \
+        }                                                               \
+                                                                        \
+        static IntType AtomicAssign(IntType& lval, volatile const IntType& val) \
+        {                                                               \
+            lval = AtomicOpsType::Load( val );                          \
+            return lval;                                                \
+        }                                                               \
+                                                                        \
+        static IntType AtomicAdd(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicOpsType::Add( lval, val );     \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicSubtract(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicOpsType::Add( lval, -val );    \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicMultiply(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicOpsType::Multiply( lval, val ); \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDivide(volatile IntType& lval, const IntType val, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicOpsType::Divide( lval, val );  \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicIncrement(volatile IntType& lval, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicOpsType::Add( lval, 1 );       \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }                                                               \
+                                                                        \
+        static IntType AtomicDecrement(volatile IntType& lval, const IntType compare, bool & matches ) \
+        {                                                               \
+            const IntType result = AtomicOpsType::Add( lval, -1 );      \
+            matches = ( result == compare );                            \
+            return result;                                              \
+        }
+
+#endif // #if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
 
 
 namespace Loki
 {
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \enum AtomicOrder
+    //
+    ///  \ingroup ThreadingGroup
+    ///  Memory orderings for the lock-free atomic functions.  They have the
+    ///  same meaning and values as the orderings of the C++11 memory model
+    ///  and of the gcc __atomic builtins.  Platforms without finer grained
+    ///  orderings treat all of them as AtomicSeqCst.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    enum AtomicOrder
+    {
+        AtomicRelaxed,
+        AtomicConsume,
+        AtomicAcquire,
+        AtomicRelease,
+        AtomicAcqRel,
+        AtomicSeqCst
+    };
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class AtomicOps
+    //
+    ///  \ingroup ThreadingGroup
+    ///  Lock-free atomic operations on an integer or pointer sized value.
+    ///  Read-modify-write functions use the given ordering.  Load drops the
+    ///  release part and Store drops the acquire part of the ordering, since
+    ///  those are meaningless for pure loads and stores.  All functions
+    ///  except CompareExchange return the new value.
+    ///  On Windows only LONG and LONGLONG sized values are supported and all
+    ///  orderings are sequentially consistent.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template < class IntType, AtomicOrder Order = AtomicSeqCst >
+    class AtomicOps
+    {
+    public:
+
+#if defined( LOKI_WINDOWS_H )
+
+        static IntType Load( volatile const IntType & lval )
+        {
+            return Interlocked::CompareExchange( const_cast< volatile IntType * >( &lval ), 0, 0 );
+        }
+
+        static void Store( volatile IntType & lval, const IntType val )
+        {
+            Interlocked::Exchange( &lval, val );
+        }
+
+        static IntType Exchange( volatile IntType & lval, const IntType val )
+        {
+            return Interlocked::Exchange( &lval, val );
+        }
+
+        /// Stores desired if lval equals expected and returns true.  Else
+        /// copies the current value of lval into expected and returns false.
+        static bool CompareExchange( volatile IntType & lval, IntType & expected, const IntType desired )
+        {
+            const IntType previous = Interlocked::CompareExchange( &lval, desired, expected );
+            const bool matches = ( previous == expected );
+            expected = previous;
+            return matches;
+        }
+
+        static IntType Add( volatile IntType & lval, const IntType val )
+        {
+            return Interlocked::ExchangeAdd( &lval, val ) + val;
+        }
+
+#else // gcc and clang builtins
+
+        static IntType Load( volatile const IntType & lval )
+        {
+            return __atomic_load_n( &lval, LoadOrder );
+        }
+
+        static void Store( volatile IntType & lval, const IntType val )
+        {
+            __atomic_store_n( &lval, val, StoreOrder );
+        }
+
+        static IntType Exchange( volatile IntType & lval, const IntType val )
+        {
+            return __atomic_exchange_n( &lval, val, Order );
+        }
+
+        /// Stores desired if lval equals expected and returns true.  Else
+        /// copies the current value of lval into expected and returns false.
+        static bool CompareExchange( volatile IntType & lval, IntType & expected, const IntType desired )
+        {
+            return __atomic_compare_exchange_n( &lval, &expected, desired, false,
+                Order, LoadOrder );
+        }
+
+        static IntType Add( volatile IntType & lval, const IntType val )
+        {
+            return __atomic_add_fetch( &lval, val, Order );
+        }
+
+#endif
+
+        static IntType Multiply( volatile IntType & lval, const IntType val )
+        {
+            IntType expected = Load( lval );
+            while ( !CompareExchange( lval, expected, expected * val ) ) {}
+            return expected * val;
+        }
+
+        static IntType Divide( volatile IntType & lval, const IntType val )
+        {
+            IntType expected = Load( lval );
+            while ( !CompareExchange( lval, expected, expected / val ) ) {}
+            return expected / val;
+        }
+
+    private:
+
+#if defined( LOKI_WINDOWS_H )
+
+        /// Picks the Interlocked function of the right width by overloading.
+        struct Interlocked
+        {
+            static LONG CompareExchange( volatile LONG * p, LONG desired, LONG expected )
+            { return ::InterlockedCompareExchange( p, desired, expected ); }
+
+            static LONGLONG CompareExchange( volatile LONGLONG * p, LONGLONG desired, LONGLONG expected )
+            { return ::InterlockedCompareExchange64( p, desired, expected ); }
+
+            static LONG Exchange( volatile LONG * p, LONG val )
+            { return ::InterlockedExchange( p, val ); }
+
+            static LONGLONG Exchange( volatile LONGLONG * p, LONGLONG val )
+            { return ::InterlockedExchange64( p, val ); }
+
+            static LONG ExchangeAdd( volatile LONG * p, LONG val )
+            { return ::InterlockedExchangeAdd( p, val ); }
+
+            static LONGLONG ExchangeAdd( volatile LONGLONG * p, LONGLONG val )
+            { return ::InterlockedExchangeAdd64( p, val ); }
+        };
+
+#endif
+
+        enum
+        {
+            LoadOrder = ( Order == AtomicRelease ) ? AtomicRelaxed :
+                ( Order == AtomicAcqRel ) ? AtomicAcquire : Order,
+            StoreOrder = ( Order == AtomicAcquire || Order == AtomicConsume ) ? AtomicRelaxed :
+                ( Order == AtomicAcqRel ) ? AtomicRelease : Order
+        };
+    };
+
+#endif // #if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
     ////////////////////////////////////////////////////////////////////////////////
     ///  \class Mutex
     //
@@ -369,6 +682,53 @@ namespace Loki
         LOKI_THREADS_MUTEX(mtx_)
     };
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class RWMutex
+    //
+    ///  \ingroup ThreadingGroup
+    ///  A portable reader-writer lock.  Lock and Unlock take it exclusively, so
+    ///  it can be used wherever a Mutex can.  LockShared and UnlockShared take
+    ///  it shared, so any number of readers may hold it together.  Like Mutex
+    ///  it is not recursive: a thread which holds it, in either way, must not
+    ///  take it again.  Writers are preferred, so a writer waiting for the
+    ///  lock keeps new readers out.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class RWMutex
+    {
+    public:
+        RWMutex()
+        {
+            LOKI_THREADS_RWMUTEX_INIT(&rwmtx_);
+        }
+        ~RWMutex()
+        {
+            LOKI_THREADS_RWMUTEX_DELETE(&rwmtx_);
+        }
+        void Lock()
+        {
+            LOKI_THREADS_RWMUTEX_LOCK(&rwmtx_);
+        }
+        void Unlock()
+        {
+            LOKI_THREADS_RWMUTEX_UNLOCK(&rwmtx_);
+        }
+        void LockShared()
+        {
+            LOKI_THREADS_RWMUTEX_LOCK_SHARED(&rwmtx_);
+        }
+        void UnlockShared()
+        {
+            LOKI_THREADS_RWMUTEX_UNLOCK_SHARED(&rwmtx_);
+        }
+    private:
+        /// Copy-constructor not implemented.
+        RWMutex(const RWMutex &);
+        /// Copy-assignement operator not implemented.
+        RWMutex & operator = (const RWMutex &);
+        LOKI_THREADS_RWMUTEX(rwmtx_)
+    };
+
 
      ////////////////////////////////////////////////////////////////////////////////
     ///  \class SingleThreaded
@@ -533,7 +893,7 @@ namespace Loki
 
     };
 
-#ifdef LOKI_PTHREAD_H
+#if defined( LOKI_PTHREAD_H ) && !defined( LOKI_THREADS_ATOMIC_LOCKFREE )
     template <class Host, class MutexPolicy>
     pthread_mutex_t ObjectLevelLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
 #endif
@@ -636,11 +996,64 @@ namespace Loki
 
     };
 
-#ifdef LOKI_PTHREAD_H
+#if defined( LOKI_PTHREAD_H ) && !defined( LOKI_THREADS_ATOMIC_LOCKFREE )
     template <class Host, class MutexPolicy>
     pthread_mutex_t ClassLevelLockable<Host, MutexPolicy>::atomic_mutex_ = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
+    ////////////////////////////////////////////////////////////////////////////////
+    ///  \class DoubleCheckedLockable
+    ///
+    ///  \ingroup ThreadingGroup
+    ///  Implementation of the ThreadingModel policy used by various classes
+    ///  Implements the same class-level locking scheme as ClassLevelLockable,
+    ///  and adds LoadAcquire and StoreRelease so that a pointer written while
+    ///  holding the lock can be read without it.  SingletonHolder uses these
+    ///  for double-checked locking: Instance only takes the lock until the
+    ///  singleton exists.  When atomic functions are not lock-free, both
+    ///  functions take the class lock instead, which is correct but slower.
+    ////////////////////////////////////////////////////////////////////////////////
+    template <class Host, class MutexPolicy = LOKI_DEFAULT_MUTEX >
+    class DoubleCheckedLockable : public ClassLevelLockable< Host, MutexPolicy >
+    {
+    public:
+
+        /// Reads pointer so that whatever was written before the matching
+        /// StoreRelease is visible to the caller.
+        template < class T >
+        static T * LoadAcquire( T * volatile const & pointer )
+        {
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE ) && defined( LOKI_WINDOWS_H )
+            return static_cast< T * >( ::InterlockedCompareExchangePointer(
+                reinterpret_cast< void * volatile * >(
+                    const_cast< T * volatile * >( &pointer ) ), 0, 0 ) );
+#elif defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            return __atomic_load_n( &pointer, __ATOMIC_ACQUIRE );
+#else
+            typename ClassLevelLockable< Host, MutexPolicy >::Lock guard;
+            (void)guard;
+            return pointer;
+#endif
+        }
+
+        /// Writes pointer after everything the caller wrote before it, such
+        /// as the members of the object it points to.
+        template < class T >
+        static void StoreRelease( T * volatile & pointer, T * value )
+        {
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE ) && defined( LOKI_WINDOWS_H )
+            ::InterlockedExchangePointer( reinterpret_cast< void * volatile * >(
+                &pointer ), value );
+#elif defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+            __atomic_store_n( &pointer, value, __ATOMIC_RELEASE );
+#else
+            typename ClassLevelLockable< Host, MutexPolicy >::Lock guard;
+            (void)guard;
+            pointer = value;
+#endif
+        }
+    };
+
 #endif // #if defined(LOKI_WINDOWS_H) || defined(LOKI_PTHREAD_H)
 
 } // namespace Loki
@@ -34,6 +34,9 @@
 
 #include <loki/Typelist.h>
 #include <loki/HierarchyGenerators.h>
+#include <loki/Threads.h>
+
+#include <vector>
 
 namespace Loki
 {
@@ -359,6 +362,274 @@ struct DefaultCatchAll
     virtual SomeVisitor::ReturnType Accept(SomeVisitor& guest) \
     { return guest.GenericVisit(*this); }
 
+////////////////////////////////////////////////////////////////////////////////
+// class template VisitedIndexRegistry (internal)
+// Hands out a dense index to every class visitable by IndexedBaseVisitor<R,
+//     ConstVisit> the first time the index is asked for.
+////////////////////////////////////////////////////////////////////////////////
+
+    namespace Private
+    {
+        template <typename R, bool ConstVisit>
+        class VisitedIndexRegistry
+        {
+            typedef LOKI_DEFAULT_THREADING_NO_OBJ_LEVEL<VisitedIndexRegistry,
+                LOKI_DEFAULT_MUTEX> ThreadingModel;
+            typedef typename ThreadingModel::IntType IntType;
+
+            static IntType count_;
+
+        public:
+            template <class T>
+            static unsigned int IndexOf()
+            {
+                static const unsigned int index =
+                    static_cast<unsigned int>(ThreadingModel::AtomicIncrement(count_) - 1);
+                return index;
+            }
+        };
+
+        template <typename R, bool ConstVisit>
+        typename VisitedIndexRegistry<R, ConstVisit>::IntType
+            VisitedIndexRegistry<R, ConstVisit>::count_ = 0;
+
+        // Adds the visit function of every class of List, which is a class or
+        // a typelist, to the table of an IndexedVisitor.
+        template <class Owner, class List>
+        struct VisitFunctionsFiller
+        {
+            template <class VisitFunctions>
+            static void Fill(VisitFunctions& functions)
+            {
+                Owner::template AddVisitFunction<List>(functions);
+            }
+        };
+
+        template <class Owner, class Head, class Tail>
+        struct VisitFunctionsFiller<Owner, Typelist<Head, Tail> >
+        {
+            template <class VisitFunctions>
+            static void Fill(VisitFunctions& functions)
+            {
+                Owner::template AddVisitFunction<Head>(functions);
+                VisitFunctionsFiller<Owner, Tail>::Fill(functions);
+            }
+        };
+
+        template <class Owner>
+        struct VisitFunctionsFiller<Owner, NullType>
+        {
+            template <class VisitFunctions>
+            static void Fill(VisitFunctions&)
+            {}
+        };
+    }
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class IndexedBaseVisitor
+///
+/// \ingroup VisitorGroup
+/// The base class of any Acyclic Visitor which visits classes derived from
+/// IndexedBaseVisitable.  It holds a table of visit functions for its
+/// concrete class, indexed by the dense index of the visited class, so that
+/// Accept needs no dynamic_cast.  Derive visitors from IndexedVisitor, which
+/// fills in the table.
+////////////////////////////////////////////////////////////////////////////////
+
+    template <typename R = void, bool ConstVisit = false>
+    class IndexedBaseVisitor : public BaseVisitor
+    {
+    public:
+        typedef R ReturnType;
+        typedef ReturnType (*VisitFunction)(IndexedBaseVisitor&, void*);
+
+        /// Returns the function visiting the class with that index, or 0 if
+        /// this visitor does not visit that class.
+        VisitFunction GetVisitFunction(unsigned int index) const
+        {
+            return index < count_ ? functions_[index] : 0;
+        }
+
+    protected:
+        IndexedBaseVisitor(const VisitFunction* functions, unsigned int count)
+            : functions_(functions), count_(count)
+        {}
+
+    private:
+        const VisitFunction* functions_;
+        unsigned int count_;
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class IndexedVisitor
+///
+/// \ingroup VisitorGroup
+/// The building block of Acyclic Visitors with constant time dispatch.  The
+/// first IndexedVisitor of a ConcreteVisitor builds its table of visit
+/// functions from TList; every other one shares it.
+///
+/// \par Usage
+///
+/// Defining the visitable class:
+///
+/// \code
+/// class RasterBitmap : public IndexedBaseVisitable<>
+/// {
+/// public:
+///     LOKI_DEFINE_INDEXED_VISITABLE()
+/// };
+/// \endcode
+///
+/// Defining the visitor:
+/// \code
+/// class SomeVisitor :
+///     public IndexedVisitor<SomeVisitor, LOKI_TYPELIST_2(RasterBitmap, Paragraph)>
+/// {
+/// public:
+///     void Visit(RasterBitmap&); // visit a RasterBitmap
+///     void Visit(Paragraph &);   // visit a Paragraph
+/// };
+/// \endcode
+///
+/// For const visit functions, pass true as ConstVisit here and as
+/// ConstVisitable to IndexedBaseVisitable, and use
+/// LOKI_DEFINE_CONST_INDEXED_VISITABLE().
+////////////////////////////////////////////////////////////////////////////////
+
+    template <class ConcreteVisitor, class TList, typename R = void,
+        bool ConstVisit = false>
+    class IndexedVisitor
+        : public IndexedBaseVisitor<R, ConstVisit>
+        , public Visitor<TList, R, ConstVisit>
+    {
+        typedef IndexedBaseVisitor<R, ConstVisit> BaseType;
+        typedef typename BaseType::VisitFunction VisitFunction;
+        typedef std::vector<VisitFunction> VisitFunctions;
+
+        template <class T>
+        static R VisitThunk(BaseType& guest, void* visited)
+        {
+            typedef typename Select<ConstVisit, const T, T>::Result ParamType;
+            Visitor<T, R, ConstVisit>& subObj =
+                static_cast<ConcreteVisitor&>(guest);
+            return subObj.Visit(*static_cast<ParamType*>(visited));
+        }
+
+        template <class, class> friend struct Private::VisitFunctionsFiller;
+
+        template <class T>
+        static void AddVisitFunction(VisitFunctions& functions)
+        {
+            const unsigned int index = Private::VisitedIndexRegistry<R,
+                ConstVisit>::template IndexOf<T>();
+            if (functions.size() <= index)
+                functions.resize(index + 1, 0);
+            functions[index] = &IndexedVisitor::template VisitThunk<T>;
+        }
+
+        static const VisitFunctions& GetVisitFunctions()
+        {
+            static const VisitFunctions functions(MakeVisitFunctions());
+            return functions;
+        }
+
+        static VisitFunctions MakeVisitFunctions()
+        {
+            VisitFunctions functions;
+            Private::VisitFunctionsFiller<IndexedVisitor, TList>::Fill(functions);
+            return functions;
+        }
+
+    protected:
+        IndexedVisitor()
+            : BaseType(GetVisitFunctions().empty() ? 0 : &GetVisitFunctions()[0],
+                static_cast<unsigned int>(GetVisitFunctions().size()))
+        {}
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+/// \class IndexedBaseVisitable
+///
+/// \ingroup VisitorGroup
+/// Base class of classes visited by IndexedVisitors.  Accept looks up the
+/// visit function in the table of the visitor instead of casting it.
+////////////////////////////////////////////////////////////////////////////////
+
+    template
+    <
+        typename R = void,
+        template <typename, class> class CatchAll = DefaultCatchAll,
+        bool ConstVisitable = false
+    >
+    class IndexedBaseVisitable;
+
+    template<typename R,template <typename, class> class CatchAll>
+    class IndexedBaseVisitable<R, CatchAll, false>
+    {
+    public:
+        typedef R ReturnType;
+        typedef IndexedBaseVisitor<R, false> GuestType;
+        virtual ~IndexedBaseVisitable() {}
+        virtual ReturnType Accept(GuestType&) = 0;
+
+    protected: // give access only to the hierarchy
+        template <class T>
+        static ReturnType AcceptImpl(T& visited, GuestType& guest)
+        {
+            if (typename GuestType::VisitFunction visit = guest.GetVisitFunction(
+                Private::VisitedIndexRegistry<R, false>::template IndexOf<T>()))
+            {
+                return visit(guest, &visited);
+            }
+            return CatchAll<R, T>::OnUnknownVisitor(visited, guest);
+        }
+    };
+
+    template<typename R,template <typename, class> class CatchAll>
+    class IndexedBaseVisitable<R, CatchAll, true>
+    {
+    public:
+        typedef R ReturnType;
+        typedef IndexedBaseVisitor<R, true> GuestType;
+        virtual ~IndexedBaseVisitable() {}
+        virtual ReturnType Accept(GuestType&) const = 0;
+
+    protected: // give access only to the hierarchy
+        template <class T>
+        static ReturnType AcceptImpl(const T& visited, GuestType& guest)
+        {
+            if (typename GuestType::VisitFunction visit = guest.GetVisitFunction(
+                Private::VisitedIndexRegistry<R, true>::template IndexOf<T>()))
+            {
+                return visit(guest, const_cast<T*>(&visited));
+            }
+            return CatchAll<R, T>::OnUnknownVisitor(const_cast<T&>(visited), guest);
+        }
+    };
+
+////////////////////////////////////////////////////////////////////////////////
+/// \def LOKI_DEFINE_INDEXED_VISITABLE()
+/// \ingroup VisitorGroup
+/// Put it in every class that you want to make visitable by IndexedVisitors
+/// (in addition to deriving it from IndexedBaseVisitable<R>)
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOKI_DEFINE_INDEXED_VISITABLE() \
+    virtual ReturnType Accept(GuestType& guest) \
+    { return AcceptImpl(*this, guest); }
+
+////////////////////////////////////////////////////////////////////////////////
+/// \def LOKI_DEFINE_CONST_INDEXED_VISITABLE()
+/// \ingroup VisitorGroup
+/// Put it in every class that you want to make visitable by const member
+/// functions of IndexedVisitors (in addition to deriving it from
+/// IndexedBaseVisitable<R, CatchAll, true>)
+////////////////////////////////////////////////////////////////////////////////
+
+#define LOKI_DEFINE_CONST_INDEXED_VISITABLE() \
+    virtual ReturnType Accept(GuestType& guest) const \
+    { return AcceptImpl(*this, guest); }
+
 } // namespace Loki
 
 
@@ -17,6 +17,7 @@
 
 
 #include <memory>
+#include <cstring>
 
 namespace flex_string_details
 {
@@ -0,0 +1,300 @@
+////////////////////////////////////////////////////////////////////////////////
+// flex_string
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef FLEX_STRING_SEARCH_INC_
+#define FLEX_STRING_SEARCH_INC_
+
+// $Id$
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Search loops behind flex_string's find, rfind and find_..._of functions.
+// The general searcher works for any traits type.  The one for
+//     std::char_traits<char> scans 16 characters at a time with SSE2, or 32
+//     with AVX2 when the processor has it, which is checked at run time.
+// Define LOKI_FLEX_STRING_NO_SIMD to use the general searcher for char too.
+////////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#if !defined(LOKI_FLEX_STRING_NO_SIMD)
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define LOKI_FLEX_STRING_SSE2
+#       include <emmintrin.h>
+#       if defined(_MSC_VER)
+#           include <intrin.h>
+#       endif
+#   endif
+    // AVX2 code is compiled with a target pragma, which only gcc has
+#   if defined(LOKI_FLEX_STRING_SSE2) && defined(__GNUC__) && !defined(__clang__) \
+        && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#       define LOKI_FLEX_STRING_AVX2
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace flex_string_details
+{
+    ////////////////////////////////////////////////////////////////////////////////
+    // class template searcher
+    // Each function looks in [b, e) and returns a pointer to what it found, or 0.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    template <class T>
+    struct searcher
+    {
+        typedef typename T::char_type E;
+
+        /// First [s, s + n).
+        static const E* find(const E* b, const E* e, const E* s, std::size_t n)
+        {
+            if (n == 0) return b;
+            for (; static_cast<std::size_t>(e - b) >= n; ++b)
+            {
+                // skip to the next place where the first character matches
+                b = T::find(b, (e - b) - n + 1, *s);
+                if (b == 0) return 0;
+                if (T::compare(b + 1, s + 1, n - 1) == 0) return b;
+            }
+            return 0;
+        }
+
+        /// Last [s, s + n), for n <= e - b.
+        static const E* rfind(const E* b, const E* e, const E* s, std::size_t n)
+        {
+            if (n == 0) return e;
+            for (const E* p = e - n + 1; p != b; )
+            {
+                --p;
+                if (T::eq(*p, *s) && T::compare(p, s, n) == 0) return p;
+            }
+            return 0;
+        }
+
+        /// First character which is in [s, s + n) if member is true, or which
+        /// is not if member is false.
+        static const E* find_of(const E* b, const E* e, const E* s, std::size_t n,
+            bool member)
+        {
+            for (; b != e; ++b)
+            {
+                if ((T::find(s, n, *b) != 0) == member) return b;
+            }
+            return 0;
+        }
+
+        /// Like find_of, but the last such character.
+        static const E* rfind_of(const E* b, const E* e, const E* s, std::size_t n,
+            bool member)
+        {
+            while (e != b)
+            {
+                --e;
+                if ((T::find(s, n, *e) != 0) == member) return e;
+            }
+            return 0;
+        }
+    };
+
+#if defined(LOKI_FLEX_STRING_SSE2)
+
+    namespace simd
+    {
+        /// Sets of up to this many characters are searched with SIMD compares,
+        /// larger ones with a lookup table.
+        const std::size_t MaxSetSize = 16;
+
+        inline unsigned int first_bit(unsigned int m)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, m);
+            return index;
+#else
+            return static_cast<unsigned int>(__builtin_ctz(m));
+#endif
+        }
+
+        inline unsigned int last_bit(unsigned int m)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanReverse(&index, m);
+            return index;
+#else
+            return 31 - static_cast<unsigned int>(__builtin_clz(m));
+#endif
+        }
+
+        namespace sse2
+        {
+            typedef __m128i block;
+            const std::ptrdiff_t Width = 16;
+            const unsigned int FullMask = 0xFFFF;
+
+            inline block load(const char* p)
+            { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+            inline block splat(char c)
+            { return _mm_set1_epi8(c); }
+
+            inline block equal(block a, block b)
+            { return _mm_cmpeq_epi8(a, b); }
+
+            inline block both(block a, block b)
+            { return _mm_and_si128(a, b); }
+
+            inline block either(block a, block b)
+            { return _mm_or_si128(a, b); }
+
+            inline unsigned int mask(block a)
+            { return static_cast<unsigned int>(_mm_movemask_epi8(a)); }
+
+#include "flex_string_simd.h"
+        }
+
+#if defined(LOKI_FLEX_STRING_AVX2)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+        namespace avx2
+        {
+            typedef __m256i block;
+            const std::ptrdiff_t Width = 32;
+            const unsigned int FullMask = 0xFFFFFFFF;
+
+            inline block load(const char* p)
+            { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+            inline block splat(char c)
+            { return _mm256_set1_epi8(c); }
+
+            inline block equal(block a, block b)
+            { return _mm256_cmpeq_epi8(a, b); }
+
+            inline block both(block a, block b)
+            { return _mm256_and_si256(a, b); }
+
+            inline block either(block a, block b)
+            { return _mm256_or_si256(a, b); }
+
+            inline unsigned int mask(block a)
+            { return static_cast<unsigned int>(_mm256_movemask_epi8(a)); }
+
+#include "flex_string_simd.h"
+        }
+#pragma GCC pop_options
+
+        inline bool has_avx2()
+        {
+            static const bool result = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") != 0);
+            return result;
+        }
+
+#   define LOKI_FLEX_STRING_DISPATCH(call) \
+        (simd::has_avx2() ? simd::avx2::call : simd::sse2::call)
+#else
+#   define LOKI_FLEX_STRING_DISPATCH(call) (simd::sse2::call)
+#endif
+
+        /// Table of the characters of [s, s + n), for sets too big for SIMD
+        struct char_set
+        {
+            char_set(const char* s, std::size_t n)
+            {
+                std::memset(in_, 0, sizeof(in_));
+                for (std::size_t i = 0; i < n; ++i)
+                {
+                    in_[static_cast<unsigned char>(s[i])] = true;
+                }
+            }
+
+            bool operator()(char c) const
+            { return in_[static_cast<unsigned char>(c)]; }
+
+        private:
+            bool in_[256];
+        };
+    }
+
+    template <>
+    struct searcher< std::char_traits<char> >
+    {
+        static const char* find(const char* b, const char* e, const char* s, std::size_t n)
+        {
+            if (n == 0) return b;
+            if (static_cast<std::size_t>(e - b) < n) return 0;
+            if (n == 1) return LOKI_FLEX_STRING_DISPATCH(find_char(b, e, *s));
+            return LOKI_FLEX_STRING_DISPATCH(find_substring(b, e, s, n));
+        }
+
+        static const char* rfind(const char* b, const char* e, const char* s, std::size_t n)
+        {
+            if (n == 0) return e;
+            if (n == 1) return LOKI_FLEX_STRING_DISPATCH(rfind_char(b, e, *s));
+            return LOKI_FLEX_STRING_DISPATCH(rfind_substring(b, e, s, n));
+        }
+
+        static const char* find_of(const char* b, const char* e, const char* s, std::size_t n,
+            bool member)
+        {
+            if (n == 0) return member || b == e ? 0 : b;
+            if (n == 1 && member) return LOKI_FLEX_STRING_DISPATCH(find_char(b, e, *s));
+            if (n <= simd::MaxSetSize)
+            {
+                return LOKI_FLEX_STRING_DISPATCH(find_of(b, e, s, n, member));
+            }
+            const simd::char_set set(s, n);
+            for (; b != e; ++b)
+            {
+                if (set(*b) == member) return b;
+            }
+            return 0;
+        }
+
+        static const char* rfind_of(const char* b, const char* e, const char* s, std::size_t n,
+            bool member)
+        {
+            if (n == 0) return member || b == e ? 0 : e - 1;
+            if (n == 1 && member) return LOKI_FLEX_STRING_DISPATCH(rfind_char(b, e, *s));
+            if (n <= simd::MaxSetSize)
+            {
+                return LOKI_FLEX_STRING_DISPATCH(rfind_of(b, e, s, n, member));
+            }
+            const simd::char_set set(s, n);
+            while (e != b)
+            {
+                --e;
+                if (set(*e) == member) return e;
+            }
+            return 0;
+        }
+    };
+
+#undef LOKI_FLEX_STRING_DISPATCH
+
+#endif // LOKI_FLEX_STRING_SSE2
+}
+
+#endif // FLEX_STRING_SEARCH_INC_
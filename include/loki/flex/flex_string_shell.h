@@ -28,7 +28,10 @@
 #include <limits>
 #include <stdexcept>
 #include "flex_string_details.h"
+#include "flex_string_search.h"
 #include <string>
+#include <istream>
+#include <ostream>
 
 // Forward declaration for default storage policy
 template <typename E, class A> class AllocatorStringStorage;
@@ -226,6 +229,12 @@ private:
     static void Procust(size_type& n, size_type nmax)
     { if (n > nmax) n = nmax; }
 
+    typedef flex_string_details::searcher<traits_type> searcher;
+
+    // Position of what a searcher found, or npos if it found nothing
+    size_type Offset(const value_type* found) const
+    { return found == 0 ? npos : static_cast<size_type>(found - data()); }
+
 public:
     // 21.3.1 construct/copy/destroy
     explicit flex_string(const A& a = A())
@@ -556,9 +565,9 @@ private:
             // The characters that are pushed back need to be moved because they're aliased.
             // The appended characters will all be overwritten by the move.
             append(n, value_type(0));
-            value_type * begin(&*begin());
-            flex_string_details::pod_move(begin + insertOffset, begin + originalSize, begin + insertOffset + n);
-            std::fill(begin + insertOffset, begin + insertOffset + n, c);
+            value_type * first(&*begin());
+            flex_string_details::pod_move(first + insertOffset, first + originalSize, first + insertOffset + n);
+            std::fill(first + insertOffset, first + insertOffset + n, c);
         }
         else
         {
@@ -566,9 +575,9 @@ private:
             // The characters that are pushed back can simply be copied since they aren't aliased.
             // The appended characters will partly be overwritten by the copy.
             append(n, c);
-            value_type * begin(&*begin());
-            flex_string_details::pod_copy(begin + insertOffset, begin + originalSize, begin + insertOffset + n);
-            std::fill(begin + insertOffset, begin + originalSize, c);
+            value_type * first(&*begin());
+            flex_string_details::pod_copy(first + insertOffset, first + originalSize, first + insertOffset + n);
+            std::fill(first + insertOffset, first + originalSize, c);
         }
         return *this;
     }
@@ -938,17 +947,10 @@ public:
 
     size_type find (const value_type* s, size_type pos, size_type n) const
     {
-        const size_type size(size());
-        if (n + pos > size)
+        const size_type sz(size());
+        if (pos > sz || n > sz - pos)
             return npos;
-        for (; pos + n <= size; ++pos)
-        {
-            if (traits_type::compare(data() + pos, s, n) == 0)
-            {
-                return pos;
-            }
-        }
-        return npos;
+        return Offset(searcher::find(data() + pos, data() + sz, s, n));
     }
 
     size_type find (const value_type* s, size_type pos = 0) const
@@ -964,19 +966,7 @@ public:
     {
         if (n > length()) return npos;
         pos = Min(pos, length() - n);
-        if (n == 0) return pos;
-
-        const_iterator i(begin() + pos);
-        for (; ; --i)
-        {
-            if (traits_type::eq(*i, *s)
-                && traits_type::compare(&*i, s, n) == 0)
-            {
-                return i - begin();
-            }
-            if (i == begin()) break;
-        }
-        return npos;
+        return Offset(searcher::rfind(data(), data() + pos + n, s, n));
     }
 
     size_type rfind(const value_type* s, size_type pos = npos) const
@@ -992,16 +982,7 @@ public:
         size_type pos, size_type n) const
     {
         if (pos > length() || n == 0) return npos;
-        const_iterator i(begin() + pos),
-            finish(end());
-        for (; i != finish; ++i)
-        {
-            if (traits_type::find(s, n, *i) != 0)
-            {
-                return i - begin();
-            }
-        }
-        return npos;
+        return Offset(searcher::find_of(data() + pos, data() + length(), s, n, true));
     }
 
     size_type find_first_of(const value_type* s, size_type pos = 0) const
@@ -1017,20 +998,9 @@ public:
     size_type find_last_of (const value_type* s, size_type pos,
         size_type n) const
     {
-        if (!empty() && n > 0)
-        {
-            pos = Min(pos, length() - 1);
-            const_iterator i(begin() + pos);
-            for (;; --i)
-            {
-                if (traits_type::find(s, n, *i) != 0)
-                {
-                    return i - begin();
-                }
-                if (i == begin()) break;
-            }
-        }
-        return npos;
+        if (empty() || n == 0) return npos;
+        pos = Min(pos, length() - 1);
+        return Offset(searcher::rfind_of(data(), data() + pos + 1, s, n, true));
     }
 
     size_type find_last_of (const value_type* s,
@@ -1047,20 +1017,8 @@ public:
     size_type find_first_not_of(const value_type* s, size_type pos,
         size_type n) const
     {
-        if (pos < length())
-        {
-            const_iterator
-                i(begin() + pos),
-                finish(end());
-            for (; i != finish; ++i)
-            {
-                if (traits_type::find(s, n, *i) == 0)
-                {
-                    return i - begin();
-                }
-            }
-        }
-        return npos;
+        if (pos >= length()) return npos;
+        return Offset(searcher::find_of(data() + pos, data() + length(), s, n, false));
     }
 
     size_type find_first_not_of(const value_type* s,
@@ -1077,20 +1035,9 @@ public:
     size_type find_last_not_of(const value_type* s, size_type pos,
         size_type n) const
     {
-        if (!this->empty())
-        {
-            pos = Min(pos, size() - 1);
-            const_iterator i(begin() + pos);
-            for (;; --i)
-            {
-                if (traits_type::find(s, n, *i) == 0)
-                {
-                    return i - begin();
-                }
-                if (i == begin()) break;
-            }
-        }
-        return npos;
+        if (this->empty()) return npos;
+        pos = Min(pos, size() - 1);
+        return Offset(searcher::rfind_of(data(), data() + pos + 1, s, n, false));
     }
 
     size_type find_last_not_of(const value_type* s,
@@ -1339,17 +1286,17 @@ getline(
     typename flex_string<E, T, A, S>::value_type delim)
 {
   size_t nread = 0;
-  typename basic_istream<typename flex_string<E, T, A, S>::value_type,
+  typename std::basic_istream<typename flex_string<E, T, A, S>::value_type,
     typename flex_string<E, T, A, S>::traits_type>::sentry sentry(is, true);
   if (sentry) {
-    basic_streambuf<typename flex_string<E, T, A, S>::value_type,
+    std::basic_streambuf<typename flex_string<E, T, A, S>::value_type,
       typename flex_string<E, T, A, S>::traits_type>* buf = is.rdbuf();
     str.clear();
 
     while (nread < str.max_size()) {
       int c1 = buf->sbumpc();
       if (flex_string<E, T, A, S>::traits_type::eq_int_type(c1, flex_string<E, T, A, S>::traits_type::eof())) {
-        is.setstate(ios_base::eofbit);
+        is.setstate(std::ios_base::eofbit);
         break;
       }
       else {
@@ -1363,7 +1310,7 @@ getline(
     }
   }
   if (nread == 0 || nread >= str.max_size())
-    is.setstate(ios_base::failbit);
+    is.setstate(std::ios_base::failbit);
 
   return is;
 }
@@ -0,0 +1,247 @@
+////////////////////////////////////////////////////////////////////////////////
+// flex_string
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Search kernels for char strings, written once for all instruction sets.
+// flex_string_search.h includes this file inside a namespace per instruction
+//     set, which defines block, Width, FullMask, load, splat, equal, both,
+//     either and mask.  So there is no include guard, and no #include either.
+// The long loops look at four blocks at a time and test them together, which
+//     keeps up with the loads much better than a test per block.
+////////////////////////////////////////////////////////////////////////////////
+
+/// Bits set for the positions of b where a has the same character.
+inline unsigned int equal_mask(block a, block b)
+{
+    return mask(equal(a, b));
+}
+
+/// Index of the first bit set in the masks of m0 to m3, one of which has one.
+inline std::ptrdiff_t first_of_four(block m0, block m1, block m2, block m3)
+{
+    unsigned int found = mask(m0);
+    if (found != 0) return first_bit(found);
+    found = mask(m1);
+    if (found != 0) return Width + first_bit(found);
+    found = mask(m2);
+    if (found != 0) return 2 * Width + first_bit(found);
+    return 3 * Width + first_bit(mask(m3));
+}
+
+/// Index of the last bit set in the masks of m0 to m3, one of which has one.
+inline std::ptrdiff_t last_of_four(block m0, block m1, block m2, block m3)
+{
+    unsigned int found = mask(m3);
+    if (found != 0) return 3 * Width + last_bit(found);
+    found = mask(m2);
+    if (found != 0) return 2 * Width + last_bit(found);
+    found = mask(m1);
+    if (found != 0) return Width + last_bit(found);
+    return last_bit(mask(m0));
+}
+
+/// First c in [b, e), or 0.
+inline const char* find_char(const char* b, const char* e, char c)
+{
+    const block needle = splat(c);
+    for (; e - b >= 4 * Width; b += 4 * Width)
+    {
+        const block m0 = equal(load(b), needle);
+        const block m1 = equal(load(b + Width), needle);
+        const block m2 = equal(load(b + 2 * Width), needle);
+        const block m3 = equal(load(b + 3 * Width), needle);
+        if (mask(either(either(m0, m1), either(m2, m3))) != 0)
+        {
+            return b + first_of_four(m0, m1, m2, m3);
+        }
+    }
+    for (; e - b >= Width; b += Width)
+    {
+        const unsigned int found = equal_mask(load(b), needle);
+        if (found != 0) return b + first_bit(found);
+    }
+    for (; b != e; ++b)
+    {
+        if (*b == c) return b;
+    }
+    return 0;
+}
+
+/// Last c in [b, e), or 0.
+inline const char* rfind_char(const char* b, const char* e, char c)
+{
+    const block needle = splat(c);
+    for (; e - b >= 4 * Width; e -= 4 * Width)
+    {
+        const char* const q = e - 4 * Width;
+        const block m0 = equal(load(q), needle);
+        const block m1 = equal(load(q + Width), needle);
+        const block m2 = equal(load(q + 2 * Width), needle);
+        const block m3 = equal(load(q + 3 * Width), needle);
+        if (mask(either(either(m0, m1), either(m2, m3))) != 0)
+        {
+            return q + last_of_four(m0, m1, m2, m3);
+        }
+    }
+    for (; e - b >= Width; e -= Width)
+    {
+        const unsigned int found = equal_mask(load(e - Width), needle);
+        if (found != 0) return e - Width + last_bit(found);
+    }
+    while (e != b)
+    {
+        if (*--e == c) return e;
+    }
+    return 0;
+}
+
+/// First [s, s + n) in [b, e), or 0, for 2 <= n <= e - b.  Looks at Width
+/// starting points at a time, and compares the whole of s only where both
+/// its first and its last character match.
+inline const char* find_substring(const char* b, const char* e,
+    const char* s, std::size_t n)
+{
+    const block first = splat(s[0]), last = splat(s[n - 1]);
+    const std::ptrdiff_t span = static_cast<std::ptrdiff_t>(n) - 1;
+    for (; e - b >= 4 * Width + span; b += 4 * Width)
+    {
+        const block m0 = both(equal(load(b), first), equal(load(b + span), last));
+        const block m1 = both(equal(load(b + Width), first),
+            equal(load(b + Width + span), last));
+        const block m2 = both(equal(load(b + 2 * Width), first),
+            equal(load(b + 2 * Width + span), last));
+        const block m3 = both(equal(load(b + 3 * Width), first),
+            equal(load(b + 3 * Width + span), last));
+        if (mask(either(either(m0, m1), either(m2, m3))) != 0) break;
+    }
+    for (; e - b >= Width + span; b += Width)
+    {
+        unsigned int found = equal_mask(load(b), first) & equal_mask(load(b + span), last);
+        while (found != 0)
+        {
+            const unsigned int bit = first_bit(found);
+            if (std::memcmp(b + bit + 1, s + 1, n - 2) == 0) return b + bit;
+            found &= found - 1;
+        }
+    }
+    for (; e - b > span; ++b)
+    {
+        if (*b == *s && std::memcmp(b + 1, s + 1, n - 1) == 0) return b;
+    }
+    return 0;
+}
+
+/// Last [s, s + n) in [b, e), or 0, for 2 <= n <= e - b.
+inline const char* rfind_substring(const char* b, const char* e,
+    const char* s, std::size_t n)
+{
+    const block first = splat(s[0]), last = splat(s[n - 1]);
+    const std::ptrdiff_t span = static_cast<std::ptrdiff_t>(n) - 1;
+    // one past the last starting point
+    const char* p = e - span;
+    for (; p - b >= 4 * Width; p -= 4 * Width)
+    {
+        const char* const q = p - 4 * Width;
+        const block m0 = both(equal(load(q), first), equal(load(q + span), last));
+        const block m1 = both(equal(load(q + Width), first),
+            equal(load(q + Width + span), last));
+        const block m2 = both(equal(load(q + 2 * Width), first),
+            equal(load(q + 2 * Width + span), last));
+        const block m3 = both(equal(load(q + 3 * Width), first),
+            equal(load(q + 3 * Width + span), last));
+        if (mask(either(either(m0, m1), either(m2, m3))) != 0) break;
+    }
+    for (; p - b >= Width; p -= Width)
+    {
+        const char* const q = p - Width;
+        unsigned int found = equal_mask(load(q), first) & equal_mask(load(q + span), last);
+        while (found != 0)
+        {
+            const unsigned int bit = last_bit(found);
+            if (std::memcmp(q + bit + 1, s + 1, n - 2) == 0) return q + bit;
+            found &= ~(1u << bit);
+        }
+    }
+    while (p != b)
+    {
+        --p;
+        if (*p == *s && std::memcmp(p + 1, s + 1, n - 1) == 0) return p;
+    }
+    return 0;
+}
+
+/// Bits set for the positions of chunk that hold one of the characters of
+/// set[0, n).
+inline unsigned int set_mask(block chunk, const block* set, std::size_t n)
+{
+    block found = equal(chunk, set[0]);
+    for (std::size_t i = 1; i < n; ++i)
+    {
+        found = either(found, equal(chunk, set[i]));
+    }
+    return mask(found);
+}
+
+/// First character in [b, e) which is in [s, s + n) if member is true, or
+/// which is not if member is false.  Returns 0 if there is none.  For
+/// 1 <= n <= MaxSetSize.
+inline const char* find_of(const char* b, const char* e,
+    const char* s, std::size_t n, bool member)
+{
+    block set[MaxSetSize];
+    for (std::size_t i = 0; i < n; ++i) set[i] = splat(s[i]);
+    const unsigned int flip = member ? 0 : FullMask;
+    for (; e - b >= Width; b += Width)
+    {
+        const unsigned int found = set_mask(load(b), set, n) ^ flip;
+        if (found != 0) return b + first_bit(found);
+    }
+    for (; b != e; ++b)
+    {
+        if ((std::memchr(s, *b, n) != 0) == member) return b;
+    }
+    return 0;
+}
+
+/// Like find_of, but the last such character.
+inline const char* rfind_of(const char* b, const char* e,
+    const char* s, std::size_t n, bool member)
+{
+    block set[MaxSetSize];
+    for (std::size_t i = 0; i < n; ++i) set[i] = splat(s[i]);
+    const unsigned int flip = member ? 0 : FullMask;
+    for (; e - b >= Width; e -= Width)
+    {
+        const unsigned int found = set_mask(load(e - Width), set, n) ^ flip;
+        if (found != 0) return e - Width + last_bit(found);
+    }
+    while (e != b)
+    {
+        --e;
+        if ((std::memchr(s, *e, n) != 0) == member) return e;
+    }
+    return 0;
+}
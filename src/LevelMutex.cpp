@@ -40,6 +40,10 @@
 #endif
 #include <algorithm>
 #include <cerrno>
+#if defined( __linux__ ) && defined( __GNUC__ )
+    #include <linux/futex.h> // needed by ParkingLevelMutex.
+    #include <sys/syscall.h>
+#endif
 #if defined( DEBUG ) || defined( _DEBUG )
     #define DEBUG_LOKI_LEVEL_MUTEX 1
     #include <iostream>
@@ -136,6 +140,38 @@ unsigned int GetLevel( const ::Loki::LevelMutexInfo::MutexContainer & mutexes )
 
 // ----------------------------------------------------------------------------
 
+/// Tells the processor this thread is spinning on a lock.  Never throws.
+inline void PauseCpu( void )
+{
+#if defined( _MSC_VER )
+    YieldProcessor();
+#elif defined( __GNUC__ ) && ( defined( __i386__ ) || defined( __x86_64__ ) )
+    __builtin_ia32_pause();
+#endif
+}
+
+#if defined( __linux__ ) && defined( __GNUC__ )
+
+// ----------------------------------------------------------------------------
+
+/** Parks the thread while *address equals value, until woken or timeout passes.
+ A nullptr timeout waits forever.  Spurious wakeups are allowed.
+ */
+inline void FutexWait( int * address, int value, const struct timespec * timeout )
+{
+    ::syscall( SYS_futex, address, FUTEX_WAIT_PRIVATE, value, timeout, nullptr, 0 );
+}
+
+/// Wakes one thread parked on address.
+inline void FutexWakeOne( int * address )
+{
+    ::syscall( SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+
 } // end anonymous namespace
 
 namespace Loki
@@ -1139,6 +1175,276 @@ MutexErrors::Type SleepLevelMutex::Lock( void ) volatile
 
 // ----------------------------------------------------------------------------
 
+unsigned long long GetSteadyClockTime( void )
+{
+#if defined( _MSC_VER )
+    return ::GetTickCount64();
+#else
+    struct timespec now;
+    ::clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast< unsigned long long >( now.tv_sec ) * 1000
+        + static_cast< unsigned long long >( now.tv_nsec ) / 1000000;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+ParkingLevelMutex::ParkingLevelMutex( unsigned int level ) :
+#if defined( __linux__ ) && defined( __GNUC__ )
+    m_state( 0 ),
+#else
+    m_guard(),
+    m_parked(),
+    m_locked( false ),
+#endif
+    m_spins( 0 ),
+    m_spinLimit( DefaultSpinLimit ),
+    m_level( level )
+{
+#if defined( _MSC_VER )
+    ::InitializeCriticalSection( &m_guard );
+    ::InitializeConditionVariable( &m_parked );
+#elif !defined( __linux__ ) || !defined( __GNUC__ )
+    if ( 0 != ::pthread_mutex_init( &m_guard, 0 ) )
+        throw MutexException( "Could not initialize pthread mutex for ParkingLevelMutex.",
+            level, MutexErrors::NotEnoughResources );
+    if ( 0 != ::pthread_cond_init( &m_parked, 0 ) )
+    {
+        ::pthread_mutex_destroy( &m_guard );
+        throw MutexException( "Could not initialize pthread condition for ParkingLevelMutex.",
+            level, MutexErrors::NotEnoughResources );
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+ParkingLevelMutex::ParkingLevelMutex( unsigned int level, unsigned int spinLimit ) :
+#if defined( __linux__ ) && defined( __GNUC__ )
+    m_state( 0 ),
+#else
+    m_guard(),
+    m_parked(),
+    m_locked( false ),
+#endif
+    m_spins( 0 ),
+    m_spinLimit( spinLimit ),
+    m_level( level )
+{
+#if defined( _MSC_VER )
+    ::InitializeCriticalSection( &m_guard );
+    ::InitializeConditionVariable( &m_parked );
+#elif !defined( __linux__ ) || !defined( __GNUC__ )
+    if ( 0 != ::pthread_mutex_init( &m_guard, 0 ) )
+        throw MutexException( "Could not initialize pthread mutex for ParkingLevelMutex.",
+            level, MutexErrors::NotEnoughResources );
+    if ( 0 != ::pthread_cond_init( &m_parked, 0 ) )
+    {
+        ::pthread_mutex_destroy( &m_guard );
+        throw MutexException( "Could not initialize pthread condition for ParkingLevelMutex.",
+            level, MutexErrors::NotEnoughResources );
+    }
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+ParkingLevelMutex::~ParkingLevelMutex( void )
+{
+#if defined( _MSC_VER )
+    ::DeleteCriticalSection( &m_guard );
+#elif !defined( __linux__ ) || !defined( __GNUC__ )
+    ::pthread_cond_destroy( &m_parked );
+    ::pthread_mutex_destroy( &m_guard );
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ParkingLevelMutex::Lock( void ) volatile
+{
+    return DoLock( false, 0 );
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ParkingLevelMutex::TryLock( void ) volatile
+{
+    return DoTryLock() ? MutexErrors::Success : MutexErrors::TryFailed;
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ParkingLevelMutex::TimedLock( unsigned int milliSeconds ) volatile
+{
+    return DoLock( true, GetSteadyClockTime() + milliSeconds );
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ParkingLevelMutex::Unlock( void ) volatile
+{
+    ParkingLevelMutex * pThis = const_cast< ParkingLevelMutex * >( this );
+#if defined( __linux__ ) && defined( __GNUC__ )
+    const int state = __atomic_exchange_n( &pThis->m_state, 0, __ATOMIC_RELEASE );
+    if ( 0 == state )
+        return MutexErrors::WasntLocked;
+    if ( 2 == state )
+        FutexWakeOne( &pThis->m_state );
+#elif defined( _MSC_VER )
+    ::EnterCriticalSection( &pThis->m_guard );
+    const bool wasLocked = pThis->m_locked;
+    pThis->m_locked = false;
+    ::LeaveCriticalSection( &pThis->m_guard );
+    if ( !wasLocked )
+        return MutexErrors::WasntLocked;
+    ::WakeConditionVariable( &pThis->m_parked );
+#else
+    ::pthread_mutex_lock( &pThis->m_guard );
+    const bool wasLocked = pThis->m_locked;
+    pThis->m_locked = false;
+    ::pthread_mutex_unlock( &pThis->m_guard );
+    if ( !wasLocked )
+        return MutexErrors::WasntLocked;
+    ::pthread_cond_signal( &pThis->m_parked );
+#endif
+    return MutexErrors::Success;
+}
+
+// ----------------------------------------------------------------------------
+
+bool ParkingLevelMutex::DoTryLock( void ) volatile
+{
+    ParkingLevelMutex * pThis = const_cast< ParkingLevelMutex * >( this );
+#if defined( __linux__ ) && defined( __GNUC__ )
+    int expected = 0;
+    return __atomic_compare_exchange_n( &pThis->m_state, &expected, 1, false,
+        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED );
+#elif defined( _MSC_VER )
+    ::EnterCriticalSection( &pThis->m_guard );
+    const bool locked = !pThis->m_locked;
+    pThis->m_locked = true;
+    ::LeaveCriticalSection( &pThis->m_guard );
+    return locked;
+#else
+    ::pthread_mutex_lock( &pThis->m_guard );
+    const bool locked = !pThis->m_locked;
+    pThis->m_locked = true;
+    ::pthread_mutex_unlock( &pThis->m_guard );
+    return locked;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+MutexErrors::Type ParkingLevelMutex::DoLock( bool timed,
+    unsigned long long deadline ) volatile
+{
+    if ( DoTryLock() )
+        return MutexErrors::Success;
+
+    // Spin a while in case the owner unlocks soon.  The spin count adapts to
+    // how many spins recent locks needed, so a mutex which is usually held
+    // for a long time soon stops wasting processor time.
+    ParkingLevelMutex * pThis = const_cast< ParkingLevelMutex * >( this );
+    const unsigned int limit = ::std::min( 2 * pThis->m_spins + 10, pThis->m_spinLimit );
+    unsigned int spins = 0;
+    bool locked = false;
+    while ( spins < limit )
+    {
+        ++spins;
+        PauseCpu();
+        if ( DoTryLock() )
+        {
+            locked = true;
+            break;
+        }
+    }
+    // m_spins is only a hint, so races while updating it do not matter.
+    if ( spins < pThis->m_spins )
+        pThis->m_spins -= ( pThis->m_spins - spins + 7 ) / 8;
+    else
+        pThis->m_spins += ( spins - pThis->m_spins ) / 8;
+    if ( locked )
+        return MutexErrors::Success;
+
+#if defined( __linux__ ) && defined( __GNUC__ )
+    // Mark the mutex as having parked threads so Unlock knows to wake one.
+    while ( 0 != __atomic_exchange_n( &pThis->m_state, 2, __ATOMIC_ACQUIRE ) )
+    {
+        if ( !Park( timed, deadline ) )
+            return MutexErrors::TimedOut;
+    }
+    return MutexErrors::Success;
+#else
+    #if defined( _MSC_VER )
+        ::EnterCriticalSection( &pThis->m_guard );
+    #else
+        ::pthread_mutex_lock( &pThis->m_guard );
+    #endif
+    bool timedOut = false;
+    while ( pThis->m_locked && !timedOut )
+        timedOut = !Park( timed, deadline );
+    if ( !timedOut )
+        pThis->m_locked = true;
+    #if defined( _MSC_VER )
+        ::LeaveCriticalSection( &pThis->m_guard );
+    #else
+        ::pthread_mutex_unlock( &pThis->m_guard );
+    #endif
+    return ( timedOut ) ? MutexErrors::TimedOut : MutexErrors::Success;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+bool ParkingLevelMutex::Park( bool timed, unsigned long long deadline ) volatile
+{
+    ParkingLevelMutex * pThis = const_cast< ParkingLevelMutex * >( this );
+    unsigned long long remaining = 0;
+    if ( timed )
+    {
+        const unsigned long long now = GetSteadyClockTime();
+        if ( deadline <= now )
+            return false;
+        remaining = deadline - now;
+    }
+
+#if defined( __linux__ ) && defined( __GNUC__ )
+    // The futex only parks this thread if m_state is still 2, so an Unlock
+    // between the caller's exchange and this call can not be missed.
+    struct timespec timeout;
+    timeout.tv_sec = static_cast< time_t >( remaining / 1000 );
+    timeout.tv_nsec = static_cast< long >( remaining % 1000 ) * 1000000;
+    FutexWait( &pThis->m_state, 2, ( timed ) ? &timeout : nullptr );
+#elif defined( _MSC_VER )
+    // Caller holds m_guard.
+    const DWORD wait = ( timed ) ? static_cast< DWORD >( remaining ) : INFINITE;
+    ::SleepConditionVariableCS( &pThis->m_parked, &pThis->m_guard, wait );
+#else
+    // Caller holds m_guard.  pthread_cond_timedwait wants an absolute time on
+    // the system clock, so the steady deadline gets converted to one.
+    if ( timed )
+    {
+        struct timespec when;
+        ::clock_gettime( CLOCK_REALTIME, &when );
+        when.tv_sec += static_cast< time_t >( remaining / 1000 );
+        when.tv_nsec += static_cast< long >( remaining % 1000 ) * 1000000;
+        if ( 1000000000 <= when.tv_nsec )
+        {
+            ++when.tv_sec;
+            when.tv_nsec -= 1000000000;
+        }
+        ::pthread_cond_timedwait( &pThis->m_parked, &pThis->m_guard, &when );
+    }
+    else
+        ::pthread_cond_wait( &pThis->m_parked, &pThis->m_guard );
+#endif
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
 MutexException::MutexException( const char * message,
     unsigned int level, MutexErrors::Type reason ) :
     m_message( message ),
@@ -27,10 +27,435 @@
 
 #include <loki/SafeFormat.h>
 
+#include <algorithm>
+
+#if defined(_WIN32) || defined(_WIN64)
+#  include <windows.h> // for the thread buffers and the flusher thread
+#else
+#  include <pthread.h> // for the thread buffers and the flusher thread
+#endif
+
+
+namespace
+{
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Grisu2, after Florian Loitsch: Printing Floating-Point Numbers Quickly and
+    //   Accurately with Integers, PLDI 2010.
+    ////////////////////////////////////////////////////////////////////////////////
+
+    typedef unsigned long long Bits;
+
+    const Bits SignificandMask = 0x000FFFFFFFFFFFFFULL;
+    const Bits ExponentMask = 0x7FF0000000000000ULL;
+    const Bits HiddenBit = 0x0010000000000000ULL;
+    const int SignificandSize = 52;
+    const int ExponentBias = 0x3FF + SignificandSize;
+
+    /// A floating point number f * 2^e with a 64 bit significand.
+    struct DiyFp
+    {
+        DiyFp() : f(0), e(0) {}
+
+        DiyFp(Bits fp, int exp) : f(fp), e(exp) {}
+
+        explicit DiyFp(Bits bits) {
+            const int biased = static_cast<int>((bits & ExponentMask) >> SignificandSize);
+            f = bits & SignificandMask;
+            if (biased != 0) {
+                f += HiddenBit;
+                e = biased - ExponentBias;
+            } else {
+                // denormal
+                e = 1 - ExponentBias;
+            }
+        }
+
+        DiyFp operator-(const DiyFp& rhs) const {
+            assert(e == rhs.e && f >= rhs.f);
+            return DiyFp(f - rhs.f, e);
+        }
+
+        /// Product rounded to the upper 64 bits.
+        DiyFp operator*(const DiyFp& rhs) const {
+            const Bits mask = 0xFFFFFFFFULL;
+            const Bits a = f >> 32, b = f & mask, c = rhs.f >> 32, d = rhs.f & mask;
+            const Bits ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+            Bits tmp = (bd >> 32) + (ad & mask) + (bc & mask);
+            tmp += 1ULL << 31; // round
+            return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+        }
+
+        DiyFp Normalize() const {
+            DiyFp res = *this;
+            while ((res.f & (1ULL << 63)) == 0) {
+                res.f <<= 1;
+                --res.e;
+            }
+            return res;
+        }
+
+        /// The boundaries halfway to the neighbouring doubles, with the
+        /// exponent of the normalized upper one.
+        void NormalizedBoundaries(DiyFp& minus, DiyFp& plus) const {
+            DiyFp pl((f << 1) + 1, e - 1);
+            while ((pl.f & (HiddenBit << 1)) == 0) {
+                pl.f <<= 1;
+                --pl.e;
+            }
+            pl.f <<= 64 - SignificandSize - 2;
+            pl.e -= 64 - SignificandSize - 2;
+            // the lower neighbour is closer at a power of two
+            DiyFp mi = f == HiddenBit ? DiyFp((f << 2) - 1, e - 2) : DiyFp((f << 1) - 1, e - 1);
+            mi.f <<= mi.e - pl.e;
+            mi.e = pl.e;
+            minus = mi;
+            plus = pl;
+        }
+
+        Bits f;
+        int e;
+    };
+
+    /// Normalized 10^-348, 10^-340, ..., 10^340.
+    const Bits CachedPowerSignificands[] =
+    {
+        0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+        0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+        0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+        0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+        0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+        0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+        0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+        0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+        0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+        0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+        0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+        0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+        0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+        0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+        0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+        0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+        0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+        0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+        0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+        0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+        0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+        0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+        0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+        0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+        0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+        0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+        0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+        0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+        0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+    };
+
+    const short CachedPowerExponents[] =
+    {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+        -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+        -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+        -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+        -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+        109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+        375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+        641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+        907, 933, 960, 986, 1013, 1039, 1066
+    };
+
+    /// A cached power of ten c = 10^-K such that the binary exponent of
+    /// c times a number with binary exponent e lands in [-60, -32].
+    DiyFp CachedPower(int e, int& K) {
+        // 0.30102999566398114 is log10(2)
+        const double dk = (-61 - e) * 0.30102999566398114 + 347;
+        int k = static_cast<int>(dk);
+        if (dk - k > 0.0) ++k;
+        const unsigned int index = static_cast<unsigned int>((k >> 3) + 1);
+        K = -(-348 + static_cast<int>(index << 3));
+        return DiyFp(CachedPowerSignificands[index], CachedPowerExponents[index]);
+    }
+
+    const unsigned int PowersOfTen[] =
+    {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+
+    /// Moves the last digit down while that brings it closer to the exact value
+    /// and stays inside the rounding interval.
+    void GrisuRound(char* buffer, int length, Bits delta, Bits rest, Bits tenKappa,
+        Bits distance) {
+        while (rest < distance && delta - rest >= tenKappa &&
+            (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+            --buffer[length - 1];
+            rest += tenKappa;
+        }
+    }
+
+    /// Generates the digits of Mp until they are inside the interval
+    /// (Mp - delta, Mp].
+    void DigitGen(const DiyFp& W, const DiyFp& Mp, Bits delta, char* buffer, int& length,
+        int& K) {
+        const DiyFp one(1ULL << -Mp.e, Mp.e);
+        const DiyFp distance = Mp - W;
+        unsigned int p1 = static_cast<unsigned int>(Mp.f >> -one.e);
+        Bits p2 = Mp.f & (one.f - 1);
+        int kappa = 1;
+        while (kappa < 10 && p1 >= PowersOfTen[kappa]) ++kappa;
+        length = 0;
+        while (kappa > 0) {
+            const unsigned int d = p1 / PowersOfTen[kappa - 1];
+            p1 %= PowersOfTen[kappa - 1];
+            if (d != 0 || length != 0) buffer[length++] = static_cast<char>('0' + d);
+            --kappa;
+            const Bits rest = (static_cast<Bits>(p1) << -one.e) + p2;
+            if (rest <= delta) {
+                K += kappa;
+                GrisuRound(buffer, length, delta, rest,
+                    static_cast<Bits>(PowersOfTen[kappa]) << -one.e, distance.f);
+                return;
+            }
+        }
+        // the integer part is done, continue with the fraction
+        for (;;) {
+            p2 *= 10;
+            delta *= 10;
+            const unsigned int d = static_cast<unsigned int>(p2 >> -one.e);
+            if (d != 0 || length != 0) buffer[length++] = static_cast<char>('0' + d);
+            p2 &= one.f - 1;
+            --kappa;
+            if (p2 < delta) {
+                K += kappa;
+                Bits scale = 0;
+                if (-kappa < 20) {
+                    scale = 1;
+                    for (int ii = 0; ii < -kappa; ++ii) scale *= 10;
+                }
+                GrisuRound(buffer, length, delta, p2, one.f, distance.f * scale);
+                return;
+            }
+        }
+    }
+
+    /// Writes the shortest digits of a positive double, and K such that the
+    /// value is digits * 10^K.
+    void Grisu2(Bits bits, char* buffer, int& length, int& K) {
+        const DiyFp v(bits);
+        DiyFp minus, plus;
+        v.NormalizedBoundaries(minus, plus);
+        const DiyFp cached = CachedPower(plus.e, K);
+        const DiyFp W = v.Normalize() * cached;
+        DiyFp Wp = plus * cached;
+        DiyFp Wm = minus * cached;
+        ++Wm.f;
+        --Wp.f;
+        DigitGen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+    }
+
+    char* WriteExponent(int exponent, char* p) {
+        *p++ = 'e';
+        if (exponent < 0) {
+            *p++ = '-';
+            exponent = -exponent;
+        } else {
+            *p++ = '+';
+        }
+        // at least two digits, as printf does
+        if (exponent >= 100) {
+            *p++ = static_cast<char>('0' + exponent / 100);
+            exponent %= 100;
+        }
+        *p++ = static_cast<char>('0' + exponent / 10);
+        *p++ = static_cast<char>('0' + exponent % 10);
+        return p;
+    }
+
+    const char* ParseDecimal(const char* p, size_t& dest) {
+        if (*p < '0' || *p > '9') return p;
+        size_t r = 0;
+        do {
+            r = r * 10 + static_cast<size_t>(*p - '0');
+            ++p;
+        } while (*p >= '0' && *p <= '9');
+        dest = r;
+        return p;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Buffers in which each thread gathers its BufferedFile expressions
+    ////////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    DWORD ThreadBufferKey = FLS_OUT_OF_INDEXES;
+
+    INIT_ONCE ThreadBufferKeyOnce = INIT_ONCE_STATIC_INIT;
+
+    VOID WINAPI DeleteThreadBuffer(PVOID buffer) {
+        delete static_cast<std::string*>(buffer);
+    }
+
+    BOOL CALLBACK MakeThreadBufferKey(PINIT_ONCE, PVOID, PVOID*) {
+        ThreadBufferKey = ::FlsAlloc(&DeleteThreadBuffer);
+        return TRUE;
+    }
+
+    std::string* GetThreadBuffer() {
+        ::InitOnceExecuteOnce(&ThreadBufferKeyOnce, &MakeThreadBufferKey, 0, 0);
+        std::string* buffer = static_cast<std::string*>(::FlsGetValue(ThreadBufferKey));
+        if (buffer == 0) {
+            buffer = new std::string;
+            buffer->reserve(256);
+            ::FlsSetValue(ThreadBufferKey, buffer);
+        }
+        return buffer;
+    }
+
+#else
+
+    pthread_key_t ThreadBufferKey;
+
+    pthread_once_t ThreadBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+    extern "C" void DeleteThreadBuffer(void* buffer) {
+        delete static_cast<std::string*>(buffer);
+    }
+
+    void MakeThreadBufferKey() {
+        ::pthread_key_create(&ThreadBufferKey, &DeleteThreadBuffer);
+    }
+
+    std::string* GetThreadBuffer() {
+        ::pthread_once(&ThreadBufferKeyOnce, &MakeThreadBufferKey);
+        std::string* buffer = static_cast<std::string*>(::pthread_getspecific(ThreadBufferKey));
+        if (buffer == 0) {
+            buffer = new std::string;
+            buffer->reserve(256);
+            ::pthread_setspecific(ThreadBufferKey, buffer);
+        }
+        return buffer;
+    }
+
+#endif
+
+    ////////////////////////////////////////////////////////////////////////////////
+    // Thread, mutex and condition of the BufferedFile flusher, per platform
+    ////////////////////////////////////////////////////////////////////////////////
+
+#if defined(_WIN32) || defined(_WIN64)
+
+    typedef CRITICAL_SECTION FlusherMutex;
+    typedef CONDITION_VARIABLE FlusherCondition;
+    typedef HANDLE FlusherThread;
+    typedef LPTHREAD_START_ROUTINE FlusherEntry;
+
+    void InitMutex(FlusherMutex& m) { ::InitializeCriticalSection(&m); }
+    void DestroyMutex(FlusherMutex& m) { ::DeleteCriticalSection(&m); }
+    void Lock(FlusherMutex& m) { ::EnterCriticalSection(&m); }
+    void Unlock(FlusherMutex& m) { ::LeaveCriticalSection(&m); }
+
+    void InitCondition(FlusherCondition& c) { ::InitializeConditionVariable(&c); }
+    void DestroyCondition(FlusherCondition&) {}
+    void Signal(FlusherCondition& c) { ::WakeConditionVariable(&c); }
+    void Wait(FlusherCondition& c, FlusherMutex& m) {
+        ::SleepConditionVariableCS(&c, &m, INFINITE);
+    }
+
+    bool StartThread(FlusherThread& thread, FlusherEntry entry, void* arg) {
+        thread = ::CreateThread(0, 0, entry, arg, 0, 0);
+        return thread != 0;
+    }
+
+    void JoinThread(FlusherThread& thread) {
+        ::WaitForSingleObject(thread, INFINITE);
+        ::CloseHandle(thread);
+    }
+
+#else
+
+    typedef pthread_mutex_t FlusherMutex;
+    typedef pthread_cond_t FlusherCondition;
+    typedef pthread_t FlusherThread;
+    typedef void* (*FlusherEntry)(void*);
+
+    void InitMutex(FlusherMutex& m) { ::pthread_mutex_init(&m, 0); }
+    void DestroyMutex(FlusherMutex& m) { ::pthread_mutex_destroy(&m); }
+    void Lock(FlusherMutex& m) { ::pthread_mutex_lock(&m); }
+    void Unlock(FlusherMutex& m) { ::pthread_mutex_unlock(&m); }
+
+    void InitCondition(FlusherCondition& c) { ::pthread_cond_init(&c, 0); }
+    void DestroyCondition(FlusherCondition& c) { ::pthread_cond_destroy(&c); }
+    void Signal(FlusherCondition& c) { ::pthread_cond_signal(&c); }
+    void Wait(FlusherCondition& c, FlusherMutex& m) { ::pthread_cond_wait(&c, &m); }
+
+    bool StartThread(FlusherThread& thread, FlusherEntry entry, void* arg) {
+        return ::pthread_create(&thread, 0, entry, arg) == 0;
+    }
+
+    void JoinThread(FlusherThread& thread) {
+        ::pthread_join(thread, 0);
+    }
+
+#endif
+
+} // anonymous namespace
+
 
 namespace Loki
 {
 
+    namespace Private
+    {
+
+        char* FormatShortest(double value, char* buffer) {
+            Bits bits;
+            ::std::memcpy(&bits, &value, sizeof(bits));
+            char* p = buffer;
+            if ((bits >> 63) != 0) *p++ = '-';
+            if ((bits & ExponentMask) == ExponentMask) {
+                const char* const special = (bits & SignificandMask) == 0 ? "inf" : "nan";
+                return ::std::copy(special, special + 3, p);
+            }
+            if ((bits & ~(1ULL << 63)) == 0) {
+                *p++ = '0';
+                return p;
+            }
+
+            char digits[20];
+            int length = 0, K = 0;
+            Grisu2(bits, digits, length, K);
+            // the value is 0.digits * 10^point
+            const int point = length + K;
+            if (point <= -4 || point > 17) {
+                // d.ddde+xx
+                *p++ = digits[0];
+                if (length > 1) {
+                    *p++ = '.';
+                    p = ::std::copy(digits + 1, digits + length, p);
+                }
+                return WriteExponent(point - 1, p);
+            }
+            if (point <= 0) {
+                // 0.000ddd
+                *p++ = '0';
+                *p++ = '.';
+                p = ::std::fill_n(p, -point, '0');
+                return ::std::copy(digits, digits + length, p);
+            }
+            if (point >= length) {
+                // ddd000
+                p = ::std::copy(digits, digits + length, p);
+                return ::std::fill_n(p, point - length, '0');
+            }
+            // dd.ddd
+            p = ::std::copy(digits, digits + point, p);
+            *p++ = '.';
+            return ::std::copy(digits + point, digits + length, p);
+        }
+
+    } // namespace Private
+
+
     // Crude writing method: writes straight to the file, unbuffered
     // Must be combined with a buffer to work properly (and efficiently)
 
@@ -58,6 +483,154 @@ namespace Loki
         f.write(from, std::streamsize(to - from));
     }
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // BufferedFile class
+    ////////////////////////////////////////////////////////////////////////////////
+
+    /// Thread which writes what the printing threads leave in pending_.
+    struct BufferedFile::Flusher {
+
+        explicit Flusher(std::FILE* file)
+                : file_(file)
+                , stop_(false) {
+            InitMutex(pendingMutex_);
+            InitMutex(fileMutex_);
+            InitCondition(wake_);
+            pending_.reserve(4096);
+            writing_.reserve(4096);
+            if (!StartThread(thread_, &Start, this)) {
+                Destroy();
+                throw std::runtime_error("Loki::BufferedFile could not start its flusher thread");
+            }
+        }
+
+        ~Flusher() {
+            Lock(pendingMutex_);
+            stop_ = true;
+            Signal(wake_);
+            Unlock(pendingMutex_);
+            JoinThread(thread_);
+            WritePending();
+            Destroy();
+        }
+
+        void Append(const char* from, const char* to) {
+            Lock(pendingMutex_);
+            const bool wasEmpty = pending_.empty();
+            pending_.append(from, to);
+            if (wasEmpty) Signal(wake_);
+            Unlock(pendingMutex_);
+        }
+
+        // Writes what is pending now.  The file lock is taken before pending_
+        // is swapped out, so batches reach the file in the order they came.
+        void WritePending() {
+            Lock(fileMutex_);
+            Lock(pendingMutex_);
+            writing_.swap(pending_);
+            Unlock(pendingMutex_);
+            if (!writing_.empty()) {
+                ::std::fwrite(writing_.data(), 1, writing_.size(), file_);
+                ::std::fflush(file_);
+                writing_.clear();
+            }
+            Unlock(fileMutex_);
+        }
+
+#if defined(_WIN32) || defined(_WIN64)
+        static DWORD WINAPI Start(LPVOID p) {
+            static_cast<Flusher*>(p)->Run();
+            return 0;
+        }
+#else
+        static void* Start(void* p) {
+            static_cast<Flusher*>(p)->Run();
+            return 0;
+        }
+#endif
+
+        void Run() {
+            Lock(pendingMutex_);
+            for (;;) {
+                while (pending_.empty() && !stop_) {
+                    Wait(wake_, pendingMutex_);
+                }
+                if (stop_) break;
+                Unlock(pendingMutex_);
+                WritePending();
+                Lock(pendingMutex_);
+            }
+            Unlock(pendingMutex_);
+        }
+
+        void Destroy() {
+            DestroyCondition(wake_);
+            DestroyMutex(fileMutex_);
+            DestroyMutex(pendingMutex_);
+        }
+
+        std::FILE* file_;
+        bool stop_;
+        std::string pending_;
+        std::string writing_;
+        FlusherMutex pendingMutex_; // guards pending_ and stop_
+        FlusherMutex fileMutex_; // held while writing_ goes to the file
+        FlusherCondition wake_;
+        FlusherThread thread_;
+    };
+
+    BufferedFile::BufferedFile(std::FILE* file, bool backgroundFlusher)
+            : file_(file)
+            , flusher_(backgroundFlusher ? new Flusher(file) : 0) {
+        assert(file != 0);
+    }
+
+    BufferedFile::~BufferedFile() {
+        delete flusher_;
+        ::std::fflush(file_);
+    }
+
+    void BufferedFile::Flush() {
+        if (flusher_ != 0) flusher_->WritePending();
+        ::std::fflush(file_);
+    }
+
+    void BufferedFile::Write(const char* from, const char* to) {
+        if (from == to) return;
+        if (flusher_ != 0) {
+            flusher_->Append(from, to);
+            return;
+        }
+        ::std::fwrite(from, 1, to - from, file_);
+    }
+
+    BufferedFile::Expression::Expression(BufferedFile& file)
+            : file_(&file)
+            , buffer_(GetThreadBuffer())
+            , mark_(buffer_->size())
+            , owner_(true) {
+    }
+
+    BufferedFile::Expression::Expression(const Expression& other)
+            : file_(other.file_)
+            , buffer_(other.buffer_)
+            , mark_(other.mark_)
+            , owner_(other.owner_) {
+        other.owner_ = false;
+    }
+
+    BufferedFile::Expression::~Expression() {
+        if (!owner_) return;
+        // expressions on one thread nest, so this one is at the end of the buffer
+        file_->Write(buffer_->data() + mark_, buffer_->data() + buffer_->size());
+        buffer_->resize(mark_);
+    }
+
+    void write(BufferedFile::Expression& e, const char* from, const char* to) {
+        assert(from <= to);
+        e.Append(from, to);
+    }
+
     ////////////////////////////////////////////////////////////////////////////////
     // PrintfState class template
     // Holds the formatting state, and implements operator() to format stuff
@@ -99,6 +672,14 @@ namespace Loki
         return printState2;
     }
 
+    PrintfState<BufferedFile::Expression, char> FPrintf(BufferedFile& f, const char* format) {
+        return PrintfState<BufferedFile::Expression, char>(BufferedFile::Expression(f), format);
+    }
+
+    PrintfState<BufferedFile::Expression, char> FPrintf(BufferedFile& f, const std::string& format) {
+        return PrintfState<BufferedFile::Expression, char>(BufferedFile::Expression(f), format.c_str());
+    }
+
     PrintfState< std::ostream &, char > FPrintf( const char * format ) {
         ::std::string buffer;
         const PrintfState< ::std::string &, char > state1( buffer, format );
@@ -143,6 +724,112 @@ namespace Loki
         return PrintfState<std::string&, char>(s, format.c_str());
     }
 
+    ////////////////////////////////////////////////////////////////////////////////
+    // PrintfFormat class
+    ////////////////////////////////////////////////////////////////////////////////
+
+    PrintfFormat::PrintfFormat(const char* format)
+            : text_()
+            , specs_()
+            , argumentCount_(0) {
+        Parse(format);
+    }
+
+    PrintfFormat::PrintfFormat(const std::string& format)
+            : text_()
+            , specs_()
+            , argumentCount_(0) {
+        Parse(format.c_str());
+    }
+
+    void PrintfFormat::Parse(const char* format) {
+        assert(format != 0);
+        text_.reserve(::std::strlen(format));
+        for (;;) {
+            Spec spec;
+            spec.literalBegin_ = text_.size();
+            for (; *format != 0; ++format) {
+                if (*format == '%') {
+                    if (format[1] != '%') break; // It's a format specifier
+                    ++format; // It's a "%%"
+                }
+                text_ += *format;
+            }
+            spec.literalEnd_ = text_.size();
+            spec.width_ = 0;
+            spec.prec_ = size_t(-1);
+            spec.flags_ = 0;
+            spec.type_ = 0;
+            if (*format == 0) {
+                specs_.push_back(spec);
+                break;
+            }
+            ++format;
+            // % [flags] [width] [.prec] [modifier] type_char
+            for (bool isFlag = true; isFlag; ) {
+                switch (*format) {
+                    case '-': spec.flags_ |= leftJustify; break;
+                    case '+': spec.flags_ |= showSignAlways; break;
+                    case ' ': spec.flags_ |= blank; break;
+                    case '#': spec.flags_ |= alternateForm; break;
+                    case '0': spec.flags_ |= fillZeros; break;
+                    default: isFlag = false; continue;
+                }
+                ++format;
+            }
+            if (*format == '*') {
+                spec.flags_ |= widthFromArgument;
+                ++argumentCount_;
+                ++format;
+            } else {
+                format = ParseDecimal(format, spec.width_);
+            }
+            if (*format == '.') {
+                ++format;
+                if (*format == '*') {
+                    spec.flags_ |= precisionFromArgument;
+                    ++argumentCount_;
+                    ++format;
+                } else {
+                    spec.prec_ = 0;
+                    format = ParseDecimal(format, spec.prec_);
+                }
+            }
+            switch (*format) {
+                case 'h': spec.flags_ |= forceShort; ++format; break;
+                case 'l': ++format; if (*format == 'l') ++format; break;
+                case 'L': ++format; break;
+            }
+            if (*format == 0 || ::std::strchr("cdiuoxXeEfgGpsnr", *format) == 0) {
+                ::std::logic_error ex( "invalid format specifier for Loki::SafeFormat!" );
+                throw ex;
+            }
+            spec.type_ = *format++;
+            ++argumentCount_;
+            specs_.push_back(spec);
+        }
+    }
+
+    PrintfFormatState<std::FILE*> Printf(const PrintfFormat& format) {
+        return PrintfFormatState<std::FILE*>(stdout, format);
+    }
+
+    PrintfFormatState<std::FILE*> FPrintf(std::FILE* f, const PrintfFormat& format) {
+        return PrintfFormatState<std::FILE*>(f, format);
+    }
+
+    PrintfFormatState<BufferedFile::Expression> FPrintf(BufferedFile& f, const PrintfFormat& format) {
+        return PrintfFormatState<BufferedFile::Expression>(BufferedFile::Expression(f), format);
+    }
+
+    PrintfFormatState<std::ostream&> FPrintf(std::ostream& f, const PrintfFormat& format) {
+        return PrintfFormatState<std::ostream&>(f, format);
+    }
+
+    PrintfFormatState<std::string&> SPrintf(std::string& s, const PrintfFormat& format) {
+        return PrintfFormatState<std::string&>(s, format);
+    }
+
 
 } // end namespace Loki
 
@@ -30,11 +30,31 @@
 // ----------------------------------------------------------------------------
 
 #include <loki/SmallObj.h>
+#include <loki/static_check.h>
 
 #include <cassert>
 #include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
-#include <bitset>
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+    #include <malloc.h> // needed for _aligned_malloc.
+    #include <windows.h> // needed for VirtualAlloc and FlsAlloc.
+#else
+    #include <stdlib.h> // needed for posix_memalign.
+    #include <sys/mman.h> // needed for mmap and madvise.
+    #if !defined( MAP_ANONYMOUS )
+        #define MAP_ANONYMOUS MAP_ANON
+    #endif
+    #if !defined( MAP_NORESERVE )
+        #define MAP_NORESERVE 0
+    #endif
+#endif
+
+#if !defined( _WIN32 ) && !defined( _WIN64 )
+    #include <pthread.h> // needed to flush thread caches when threads exit.
+#endif
 
 //#define DO_EXTRA_LOKI_TESTS
 //#define USE_NEW_TO_ALLOCATE
@@ -83,23 +103,98 @@ namespace Private
      Algorithm.
 
      @par Stealth Indexes
-     The first char of each empty block contains the index of the next empty
+     The first bytes of each empty block contain the index of the next empty
      block.  These stealth indexes form a singly-linked list within the blocks.
      A Chunk is corrupt if this singly-linked list has a loop or is shorter
      than blocksAvailable_.  Much of the allocator's time and space efficiency
      comes from how these stealth indexes are implemented.
+
+     @par Index Size
+     A stealth index is as wide as the block allows, up to 4 bytes, so the
+     size of an index is decided by the block size of each FixedAllocator.
+     Blocks of 1 byte use a 1 byte index, and so hold at most UCHAR_MAX blocks
+     per Chunk, blocks of 2 or 3 bytes use a 2 byte index, and larger blocks
+     use a 4 byte index.  This lets a large page size give fewer but bigger
+     Chunks instead of many Chunks of at most 255 blocks.
      */
     class Chunk
     {
     private:
         friend class FixedAllocator;
 
-        /** Initializes a just-constructed Chunk.
+        /// Type used for block counts and for stealth indexes of any size.
+        typedef unsigned int Index;
+
+        /// Returns # of bytes used by a stealth index in blocks of blockSize.
+        static inline ::std::size_t IndexSize( ::std::size_t blockSize )
+        {
+            return ( blockSize < 2 ) ? 1 :
+                ( ( blockSize < sizeof(Index) ) ? 2 : sizeof(Index) );
+        }
+
+        /// Returns most # of blocks a Chunk can hold for blocks of blockSize.
+        static inline Index MaxBlocks( ::std::size_t blockSize )
+        {
+            const ::std::size_t indexSize = IndexSize( blockSize );
+            return ( 1 == indexSize ) ? UCHAR_MAX :
+                ( ( 2 == indexSize ) ? USHRT_MAX : UINT_MAX );
+        }
+
+        /// Reads the stealth index stored at the start of an empty block.
+        static inline Index ReadIndex( const unsigned char * block,
+            ::std::size_t blockSize )
+        {
+            switch ( IndexSize( blockSize ) )
+            {
+                case 1:
+                    return *block;
+                case 2:
+                {
+                    unsigned short index;
+                    ::std::memcpy( &index, block, sizeof(index) );
+                    return index;
+                }
+                default:
+                {
+                    Index index;
+                    ::std::memcpy( &index, block, sizeof(index) );
+                    return index;
+                }
+            }
+        }
+
+        /// Writes a stealth index at the start of an empty block.
+        static inline void WriteIndex( unsigned char * block, Index index,
+            ::std::size_t blockSize )
+        {
+            switch ( IndexSize( blockSize ) )
+            {
+                case 1:
+                    *block = static_cast< unsigned char >( index );
+                    break;
+                case 2:
+                {
+                    const unsigned short shortIndex =
+                        static_cast< unsigned short >( index );
+                    ::std::memcpy( block, &shortIndex, sizeof(shortIndex) );
+                    break;
+                }
+                default:
+                    ::std::memcpy( block, &index, sizeof(index) );
+                    break;
+            }
+        }
+
+        /** Initializes a just-constructed Chunk.  The blocks are carved from
+         memory aligned on a ChunkMap page boundary, and whose size is rounded
+         up to a whole number of ChunkMap pages, so that no ChunkMap page is
+         shared by two Chunks.
+         @param source Page source which gives the memory.
          @param blockSize Number of bytes per block.
          @param blocks Number of blocks per Chunk.
          @return True for success, false for failure.
          */
-        bool Init( ::std::size_t blockSize, unsigned char blocks );
+        bool Init( PageSource & source, ::std::size_t blockSize, Index blocks );
 
         /** Allocate a block within the Chunk.  Complexity is always O(1), and
          this will never throw.  Does not actually "allocate" by calling
@@ -112,8 +207,8 @@ namespace Private
         /** Deallocate a block within the Chunk. Complexity is always O(1), and
          this will never throw.  For efficiency, this assumes the address is
          within the block and aligned along the correct byte boundary.  An
-         assertion checks the alignment, and a call to HasBlock is done from
-         within VicinityFind.  Does not actually "deallocate" by calling free,
+         assertion checks the alignment, and FixedAllocator finds the Chunk
+         through the ChunkMap.  Does not actually "deallocate" by calling free,
          delete, or other function, but merely adjusts some internal indexes to
          indicate a block is now available.
          */
@@ -124,10 +219,10 @@ namespace Private
          block.  The stealth indexes inside each block are set to point to the
          next block. This assumes the Chunk's data was already using Init.
          */
-        void Reset( ::std::size_t blockSize, unsigned char blocks );
+        void Reset( ::std::size_t blockSize, Index blocks );
 
-        /// Releases the allocated block of memory.
-        void Release();
+        /// Gives the memory back to the page source which Init got it from.
+        void Release( PageSource & source, ::std::size_t blockSize, Index blocks );
 
         /** Determines if the Chunk has been corrupted.
          @param numBlocks Total # of blocks in the Chunk.
@@ -138,7 +233,7 @@ namespace Private
           release version runs faster.)
          @return True if Chunk is corrupt.
          */
-        bool IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
+        bool IsCorrupt( Index numBlocks, ::std::size_t blockSize,
             bool checkIndexes ) const;
 
         /** Determines if block is available.
@@ -147,7 +242,7 @@ namespace Private
          @param blockSize # of bytes in each block.
          @return True if block is available, else false if allocated.
          */
-        bool IsBlockAvailable( void * p, unsigned char numBlocks,
+        bool IsBlockAvailable( void * p, Index numBlocks,
             ::std::size_t blockSize ) const;
 
         /// Returns true if block at address P is inside this Chunk.
@@ -157,7 +252,7 @@ namespace Private
             return ( pData_ <= pc ) && ( pc < pData_ + chunkLength );
         }
 
-        inline bool HasAvailable( unsigned char numBlocks ) const
+        inline bool HasAvailable( Index numBlocks ) const
         { return ( blocksAvailable_ == numBlocks ); }
 
         inline bool IsFilled( void ) const
@@ -166,9 +261,180 @@ namespace Private
         /// Pointer to array of allocated blocks.
         unsigned char * pData_;
         /// Index of first empty block.
-        unsigned char firstAvailableBlock_;
+        Index firstAvailableBlock_;
         /// Count of empty blocks.
-        unsigned char blocksAvailable_;
+        Index blocksAvailable_;
+    };
+
+    /** @class ChunkMap
+        @ingroup SmallObjectGroupInternal
+     Radix tree which maps each page of memory owned by a Chunk to that Chunk
+     and to the FixedAllocator which owns the Chunk.  Finding the owner of any
+     address takes three array lookups regardless of how many Chunks exist.
+     Addresses never given to the map, such as those from the default
+     allocator, are simply not found, so any pointer may be looked up.
+
+     @par Pages
+     A page here is PageSize bytes, which is independent of the pageSize used
+     to decide how many blocks go into a Chunk.  Chunks start on page
+     boundaries and never share a page, so every page has at most one owner.
+
+     @par Storage
+     The root array is allocated when the map is made.  Nodes and leaves are
+     allocated the first time a page in their range is set, and are only
+     released when the map is destroyed.  Each leaf covers LeafSize pages.
+     */
+    class ChunkMap
+    {
+    public:
+
+        enum
+        {
+            /// log2 of # of bytes in a page.
+            PageShift = 12,
+            /// # of bytes in a page.
+            PageSize = 1 << PageShift
+        };
+
+        LOKI_STATIC_CHECK( ( static_cast< int >( PageSize ) ==
+            static_cast< int >( PageSource::PageSize ) ), PageSizesDiffer );
+
+        /// What the map stores for each page.
+        struct Owner
+        {
+            Chunk * chunk_;
+            FixedAllocator * allocator_;
+        };
+
+        ChunkMap( void );
+
+        ~ChunkMap( void );
+
+        /// Rounds numBytes up to a whole number of pages.
+        static inline ::std::size_t RoundUp( ::std::size_t numBytes )
+        {
+            return ( numBytes + PageSize - 1 ) & ~static_cast< ::std::size_t >( PageSize - 1 );
+        }
+
+        /** Returns owner of the page which contains p, or nullptr if that page
+         is not owned by any Chunk.  Complexity is O(1).  This never throws.
+         */
+        inline const Owner * Find( const void * p ) const
+        {
+            const ::std::size_t page = reinterpret_cast< ::std::size_t >( p ) >> PageShift;
+            const ::std::size_t rootIndex = page >> ( NodeShift + LeafShift );
+            if ( RootSize <= rootIndex )
+                return nullptr;
+            const Node * node = root_[ rootIndex ];
+            if ( nullptr == node )
+                return nullptr;
+            const Leaf * leaf = node->leaves_[ ( page >> LeafShift ) & ( NodeSize - 1 ) ];
+            if ( nullptr == leaf )
+                return nullptr;
+            const Owner * owner = &leaf->owners_[ page & ( LeafSize - 1 ) ];
+            return ( nullptr == owner->chunk_ ) ? nullptr : owner;
+        }
+
+        /** Records chunk and allocator as owner of every page from begin up to
+         begin + length.  Complexity is O(P) where P is the number of pages.
+         This never throws.
+         @return False if memory for a node or leaf could not be allocated,
+          or if the pages are beyond the address range covered by the map.
+         */
+        bool Set( void * begin, ::std::size_t length, Chunk * chunk,
+            FixedAllocator * allocator );
+
+        /** Forgets owners of every page from begin up to begin + length.
+         Complexity is O(P) where P is the number of pages.  Never throws.
+         */
+        void Clear( void * begin, ::std::size_t length );
+
+    private:
+        /// Copy-constructor is not implemented.
+        ChunkMap( const ChunkMap & );
+        /// Copy-assignment operator is not implemented.
+        ChunkMap & operator = ( const ChunkMap & );
+
+        enum
+        {
+            /// # of address bits covered by the map.
+            AddressBits = ( sizeof( void * ) > 4 ) ? 48 : 32,
+            LeafShift = 12,
+            LeafSize = 1 << LeafShift,
+            NodeShift = 12,
+            NodeSize = 1 << NodeShift,
+            RootShift = ( AddressBits > PageShift + NodeShift + LeafShift ) ?
+                AddressBits - PageShift - NodeShift - LeafShift : 0,
+            RootSize = 1 << RootShift
+        };
+
+        struct Leaf
+        {
+            Owner owners_[ LeafSize ];
+        };
+
+        struct Node
+        {
+            Leaf * leaves_[ NodeSize ];
+        };
+
+        /// Returns owner for page, or nullptr if leaf could not be made.
+        Owner * MakeOwner( ::std::size_t page );
+
+        /// Array of RootSize pointers to nodes.
+        Node ** root_;
+    };
+
+    /** @class StatCounter
+        @ingroup SmallObjectGroupInternal
+     Counter behind SmallObjStats.  Only the thread which holds the lock of
+     the allocator changes it, so Add needs no read-modify-write, just an
+     atomic load and a release store, which on x86 cost no more than a plain
+     increment.  Get may be called from any thread at any time, and acquires,
+     so a reader which sees a deallocation also sees the allocation before
+     it.  The library is built without a threading policy, so these use the
+     compiler's atomics directly rather than Loki::AtomicOps.  If the library
+     is built with LOKI_SMALL_OBJECT_NO_STATS, Add does nothing.
+     */
+    class StatCounter
+    {
+    public:
+
+        StatCounter( void ) : value_( 0 ) {}
+
+        inline void Add( ::std::size_t count = 1 )
+        {
+#if defined( LOKI_SMALL_OBJECT_NO_STATS )
+            (void)count;
+#elif defined( _MSC_VER ) && defined( _WIN64 )
+            ::InterlockedExchangeAdd64( reinterpret_cast< volatile LONG64 * >( &value_ ),
+                static_cast< LONG64 >( count ) );
+#elif defined( _MSC_VER )
+            ::InterlockedExchangeAdd( reinterpret_cast< volatile LONG * >( &value_ ),
+                static_cast< LONG >( count ) );
+#else
+            __atomic_store_n( &value_,
+                __atomic_load_n( &value_, __ATOMIC_RELAXED ) + count, __ATOMIC_RELEASE );
+#endif
+        }
+
+        inline ::std::size_t Get( void ) const
+        {
+#if defined( _MSC_VER ) && defined( _WIN64 )
+            return static_cast< ::std::size_t >( ::InterlockedCompareExchange64(
+                reinterpret_cast< volatile LONG64 * >( &value_ ), 0, 0 ) );
+#elif defined( _MSC_VER )
+            return static_cast< ::std::size_t >( ::InterlockedCompareExchange(
+                reinterpret_cast< volatile LONG * >( &value_ ), 0, 0 ) );
+#else
+            return __atomic_load_n( &value_, __ATOMIC_ACQUIRE );
+#endif
+        }
+
+    private:
+
+        /// Mutable since the Interlocked calls which read it take no const.
+        mutable ::std::size_t value_;
     };
 
     /** @class FixedAllocator
@@ -206,19 +472,24 @@ namespace Private
          */
         bool MakeNewChunk( void );
 
-        /** Finds the Chunk which owns the block at address p.  It starts at
-         deallocChunk_ and searches in both forwards and backwards directions
-         from there until it finds the Chunk which owns p.  This algorithm
-         should find the Chunk quickly if it is deallocChunk_ or is close to it
-         in the Chunks container.  This goes both forwards and backwards since
-         that works well for both same-order and opposite-order deallocations.
-         (Same-order = objects are deallocated in the same order in which they
-         were allocated.  Opposite order = objects are deallocated in a last to
-         first order.  Complexity is O(C) where C is count of all Chunks.  This
-         never throws.
-         @return Pointer to Chunk that owns p, or nullptr if no owner found.
+        /** Records this FixedAllocator and chunk as the owner of all pages
+         used by chunk.  This never throws.
+         @return False if the ChunkMap could not record the pages.
+         */
+        bool MapChunk( Chunk * chunk );
+
+        /** Updates the ChunkMap after Chunks moved within the container, such
+         as after a reallocation.  Since the pages are already in the ChunkMap,
+         this can not fail.  Complexity is O(C).
          */
-        Chunk * VicinityFind( void * p ) const;
+        void RemapChunks( void );
+
+        /// Removes pages used by chunk from the ChunkMap.
+        void UnmapChunk( Chunk * chunk );
+
+        /// Returns # of bytes of memory used by each Chunk.
+        inline ::std::size_t ChunkMemorySize( void ) const
+        { return ChunkMap::RoundUp( numBlocks_ * blockSize_ ); }
 
         /// Not implemented.
         FixedAllocator(const FixedAllocator&);
@@ -235,13 +506,11 @@ namespace Private
         /// Fewest # of objects managed by a Chunk.
         static unsigned char MinObjectsPerChunk_;
 
-        /// Most # of objects managed by a Chunk - never exceeds UCHAR_MAX.
-        static unsigned char MaxObjectsPerChunk_;
 
         /// Number of bytes in a single block within a Chunk.
         ::std::size_t blockSize_;
         /// Number of blocks managed by each Chunk.
-        unsigned char numBlocks_;
+        Chunk::Index numBlocks_;
 
         /// Container of Chunks.
         Chunks chunks_;
@@ -251,6 +520,19 @@ namespace Private
         Chunk * deallocChunk_;
         /// Pointer to the only empty Chunk if there is one, else nullptr.
         Chunk * emptyChunk_;
+        /// Map of pages to Chunks, shared by all FixedAllocator's in a pool.
+        ChunkMap * chunkMap_;
+        /// Where Chunks get their memory, shared by all FixedAllocator's in a pool.
+        PageSource * pageSource_;
+
+        /// Counters for SmallObjStats.
+        StatCounter allocations_;
+        StatCounter deallocations_;
+        StatCounter allocSlowPaths_;
+        StatCounter chunksSearched_;
+        StatCounter deallocSlowPaths_;
+        StatCounter chunksMade_;
+        StatCounter chunksReleased_;
 
     public:
         /// Create a FixedAllocator which manages blocks of 'blockSize' size.
@@ -259,8 +541,12 @@ namespace Private
         /// Destroy the FixedAllocator and release all its Chunks.
         ~FixedAllocator();
 
-        /// Initializes a FixedAllocator by calculating # of blocks per Chunk.
-        void Initialize( ::std::size_t blockSize, ::std::size_t pageSize );
+        /** Initializes a FixedAllocator by calculating # of blocks per Chunk.
+         The pageSize is rounded up to a whole number of ChunkMap pages, since
+         that is how much memory each Chunk uses anyway.
+         */
+        void Initialize( ::std::size_t blockSize, ::std::size_t pageSize,
+            ChunkMap & chunkMap, PageSource & pageSource );
 
         /** Returns pointer to allocated memory block of fixed size - or nullptr
          if it failed to allocate.
@@ -303,9 +589,9 @@ namespace Private
          */
         bool IsCorrupt( void ) const;
 
-        /** Returns true if the block at address p is within a Chunk owned by
-         this FixedAllocator.  Complexity is O(C) where C is the total number
-         of Chunks - empty or used.
+        /** Returns the Chunk which owns the block at address p if that Chunk
+         is owned by this FixedAllocator, or nullptr if not.  Complexity is
+         O(1) since it uses the ChunkMap.
          */
         const Chunk * HasBlock( void * p ) const;
         inline Chunk * HasBlock( void * p )
@@ -314,10 +600,17 @@ namespace Private
                 const_cast< const FixedAllocator * >( this )->HasBlock( p ) );
         }
 
+        /** Returns the counters of this FixedAllocator.  This may be called
+         by any thread without the lock.  It reads each counter which takes
+         from a gauge before the counter which adds to it.  Since the counters
+         are stored with release and read with acquire, the adding counter is
+         then at least as far along, so no gauge is negative.
+         */
+        SmallObjStats GetStats( void ) const;
+
     };
 
     unsigned char FixedAllocator::MinObjectsPerChunk_ = 8;
-    unsigned char FixedAllocator::MaxObjectsPerChunk_ = UCHAR_MAX;
 
 /** @ingroup SmallObjectGroupInternal
  Calls the default allocator when SmallObjAllocator decides not to handle a
@@ -341,7 +634,7 @@ void DefaultDeallocator( void * p );
 
 // Chunk::Init ----------------------------------------------------------------
 
-bool Chunk::Init( ::std::size_t blockSize, unsigned char blocks )
+bool Chunk::Init( PageSource & source, ::std::size_t blockSize, Index blocks )
 {
     assert(blockSize > 0);
     assert(blocks > 0);
@@ -349,17 +642,13 @@ bool Chunk::Init( ::std::size_t blockSize, unsigned char blocks )
     const ::std::size_t allocSize = blockSize * blocks;
     assert( allocSize / blockSize == blocks);
 
-#ifdef USE_NEW_TO_ALLOCATE
-    // If this new operator fails, it will throw, and the exception will get
-    // caught one layer up.
-    pData_ = static_cast< unsigned char * >( ::operator new ( allocSize ) );
-#else
-    // malloc can't throw, so its only way to indicate an error is to return
-    // a nullptr pointer, so we have to check for that.
-    pData_ = static_cast< unsigned char * >( ::std::malloc( allocSize ) );
+    // The ChunkMap requires page aligned Chunks which do not share pages.
+    // Page sources can not throw, so the only way to indicate an error is to
+    // return a nullptr pointer, so we have to check for that.
+    const ::std::size_t memorySize = ChunkMap::RoundUp( allocSize );
+    pData_ = static_cast< unsigned char * >( source.AllocatePages( memorySize ) );
     if ( nullptr == pData_ )
         return false;
-#endif
 
     Reset( blockSize, blocks );
     return true;
@@ -367,33 +656,30 @@ bool Chunk::Init( ::std::size_t blockSize, unsigned char blocks )
 
 // Chunk::Reset ---------------------------------------------------------------
 
-void Chunk::Reset(::std::size_t blockSize, unsigned char blocks)
+void Chunk::Reset(::std::size_t blockSize, Index blocks)
 {
     assert(blockSize > 0);
     assert(blocks > 0);
+    assert(blocks <= MaxBlocks(blockSize));
     // Overflow check
     assert((blockSize * blocks) / blockSize == blocks);
 
     firstAvailableBlock_ = 0;
     blocksAvailable_ = blocks;
 
-    unsigned char i = 0;
+    Index i = 0;
     for ( unsigned char * p = pData_; i != blocks; p += blockSize )
     {
-        *p = ++i;
+        WriteIndex( p, ++i, blockSize );
     }
 }
 
 // Chunk::Release -------------------------------------------------------------
 
-void Chunk::Release()
+void Chunk::Release( PageSource & source, ::std::size_t blockSize, Index blocks )
 {
     assert( nullptr != pData_ );
-#ifdef USE_NEW_TO_ALLOCATE
-    ::operator delete ( pData_ );
-#else
-    ::std::free( static_cast< void * >( pData_ ) );
-#endif
+    source.ReleasePages( pData_, ChunkMap::RoundUp( blockSize * blocks ) );
 }
 
 // Chunk::Allocate ------------------------------------------------------------
@@ -406,7 +692,7 @@ void* Chunk::Allocate(::std::size_t blockSize)
     assert((firstAvailableBlock_ * blockSize) / blockSize ==
         firstAvailableBlock_);
     unsigned char * pResult = pData_ + (firstAvailableBlock_ * blockSize);
-    firstAvailableBlock_ = *pResult;
+    firstAvailableBlock_ = ReadIndex( pResult, blockSize );
     --blocksAvailable_;
 
     return pResult;
@@ -421,7 +707,7 @@ void Chunk::Deallocate(void* p, ::std::size_t blockSize)
     unsigned char* toRelease = static_cast<unsigned char*>(p);
     // Alignment check
     assert((toRelease - pData_) % blockSize == 0);
-    unsigned char index = static_cast< unsigned char >(
+    Index index = static_cast< Index >(
         ( toRelease - pData_ ) / blockSize);
 
 #if defined(DEBUG) || defined(_DEBUG)
@@ -432,17 +718,18 @@ void Chunk::Deallocate(void* p, ::std::size_t blockSize)
         assert( firstAvailableBlock_ != index );
 #endif
 
-    *toRelease = firstAvailableBlock_;
+    WriteIndex( toRelease, firstAvailableBlock_, blockSize );
     firstAvailableBlock_ = index;
     // Truncation check
-    assert(firstAvailableBlock_ == (toRelease - pData_) / blockSize);
+    assert(firstAvailableBlock_ == static_cast< ::std::size_t >(
+        (toRelease - pData_) / blockSize));
 
     ++blocksAvailable_;
 }
 
 // Chunk::IsCorrupt -----------------------------------------------------------
 
-bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
+bool Chunk::IsCorrupt( Index numBlocks, ::std::size_t blockSize,
     bool checkIndexes ) const
 {
 
@@ -456,7 +743,7 @@ bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
     if ( IsFilled() )
         // Useless to do further corruption checks if all blocks allocated.
         return false;
-    unsigned char index = firstAvailableBlock_;
+    Index index = firstAvailableBlock_;
     if ( numBlocks <= index )
     {
         // Contents at this Chunk corrupted.  This might mean something has
@@ -471,7 +758,8 @@ bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
     /* If the bit at index was set in foundBlocks, then the stealth index was
      found on the linked-list.
      */
-    ::std::bitset< UCHAR_MAX > foundBlocks;
+    ::std::vector< bool > foundBlocks( numBlocks, false );
+    ::std::size_t foundCount = 0;
     unsigned char * nextBlock = nullptr;
 
     /* The loop goes along singly linked-list of stealth indexes and makes sure
@@ -500,15 +788,16 @@ bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
       No index should be repeated within the linked-list since that would
       indicate the presence of a loop in the linked-list.
      */
-    for ( unsigned char cc = 0; ; )
+    for ( Index cc = 0; ; )
     {
         nextBlock = pData_ + ( index * blockSize );
-        foundBlocks.set( index, true );
+        foundBlocks[ index ] = true;
+        ++foundCount;
         ++cc;
         if ( cc >= blocksAvailable_ )
             // Successfully counted off number of nodes in linked-list.
             break;
-        index = *nextBlock;
+        index = ReadIndex( nextBlock, blockSize );
         if ( numBlocks <= index )
         {
             /* This catches Type 1 corruptions as shown in above comments.
@@ -518,7 +807,7 @@ bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
             assert( false );
             return true;
         }
-        if ( foundBlocks.test( index ) )
+        if ( foundBlocks[ index ] )
         {
             /* This catches Type 2 corruptions as shown in above comments.
              This implies that a block was corrupted due to a stray pointer
@@ -529,7 +818,7 @@ bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
             return true;
         }
     }
-    if ( foundBlocks.count() != blocksAvailable_ )
+    if ( foundCount != blocksAvailable_ )
     {
         /* This implies that the singly-linked-list of stealth indexes was
          corrupted.  Ideally, this should have been detected within the loop.
@@ -543,7 +832,7 @@ bool Chunk::IsCorrupt( unsigned char numBlocks, ::std::size_t blockSize,
 
 // Chunk::IsBlockAvailable ----------------------------------------------------
 
-bool Chunk::IsBlockAvailable( void * p, unsigned char numBlocks,
+bool Chunk::IsBlockAvailable( void * p, Index numBlocks,
     ::std::size_t blockSize ) const
 {
     (void) numBlocks;
@@ -554,10 +843,10 @@ bool Chunk::IsBlockAvailable( void * p, unsigned char numBlocks,
     unsigned char * place = static_cast< unsigned char * >( p );
     // Alignment check
     assert( ( place - pData_ ) % blockSize == 0 );
-    unsigned char blockIndex = static_cast< unsigned char >(
+    Index blockIndex = static_cast< Index >(
         ( place - pData_ ) / blockSize );
 
-    unsigned char index = firstAvailableBlock_;
+    Index index = firstAvailableBlock_;
     assert( numBlocks > index );
     if ( index == blockIndex )
         return true;
@@ -565,26 +854,122 @@ bool Chunk::IsBlockAvailable( void * p, unsigned char numBlocks,
     /* If the bit at index was set in foundBlocks, then the stealth index was
      found on the linked-list.
      */
-    ::std::bitset< UCHAR_MAX > foundBlocks;
+    ::std::vector< bool > foundBlocks( numBlocks, false );
     unsigned char * nextBlock = nullptr;
-    for ( unsigned char cc = 0; ; )
+    for ( Index cc = 0; ; )
     {
         nextBlock = pData_ + ( index * blockSize );
-        foundBlocks.set( index, true );
+        foundBlocks[ index ] = true;
         ++cc;
         if ( cc >= blocksAvailable_ )
             // Successfully counted off number of nodes in linked-list.
             break;
-        index = *nextBlock;
+        index = ReadIndex( nextBlock, blockSize );
         if ( index == blockIndex )
             return true;
         assert( numBlocks > index );
-        assert( !foundBlocks.test( index ) );
+        assert( !foundBlocks[ index ] );
     }
 
     return false;
 }
 
+// ChunkMap::ChunkMap ---------------------------------------------------------
+
+ChunkMap::ChunkMap( void ) : root_( nullptr )
+{
+    root_ = new Node * [ RootSize ];
+    for ( ::std::size_t ii = 0; ii < RootSize; ++ii )
+        root_[ ii ] = nullptr;
+}
+
+// ChunkMap::~ChunkMap --------------------------------------------------------
+
+ChunkMap::~ChunkMap( void )
+{
+    for ( ::std::size_t ii = 0; ii < RootSize; ++ii )
+    {
+        Node * node = root_[ ii ];
+        if ( nullptr == node )
+            continue;
+        for ( ::std::size_t jj = 0; jj < NodeSize; ++jj )
+            delete node->leaves_[ jj ];
+        delete node;
+    }
+    delete [] root_;
+}
+
+// ChunkMap::MakeOwner --------------------------------------------------------
+
+ChunkMap::Owner * ChunkMap::MakeOwner( ::std::size_t page )
+{
+    const ::std::size_t rootIndex = page >> ( NodeShift + LeafShift );
+    if ( RootSize <= rootIndex )
+        return nullptr;
+    Node * node = root_[ rootIndex ];
+    if ( nullptr == node )
+    {
+        node = new ( ::std::nothrow ) Node;
+        if ( nullptr == node )
+            return nullptr;
+        for ( ::std::size_t ii = 0; ii < NodeSize; ++ii )
+            node->leaves_[ ii ] = nullptr;
+        root_[ rootIndex ] = node;
+    }
+    Leaf * & leaf = node->leaves_[ ( page >> LeafShift ) & ( NodeSize - 1 ) ];
+    if ( nullptr == leaf )
+    {
+        leaf = new ( ::std::nothrow ) Leaf;
+        if ( nullptr == leaf )
+            return nullptr;
+        for ( ::std::size_t ii = 0; ii < LeafSize; ++ii )
+        {
+            leaf->owners_[ ii ].chunk_ = nullptr;
+            leaf->owners_[ ii ].allocator_ = nullptr;
+        }
+    }
+    return &leaf->owners_[ page & ( LeafSize - 1 ) ];
+}
+
+// ChunkMap::Set --------------------------------------------------------------
+
+bool ChunkMap::Set( void * begin, ::std::size_t length, Chunk * chunk,
+    FixedAllocator * allocator )
+{
+    assert( 0 == ( reinterpret_cast< ::std::size_t >( begin ) & ( PageSize - 1 ) ) );
+    const ::std::size_t first = reinterpret_cast< ::std::size_t >( begin ) >> PageShift;
+    const ::std::size_t last = first + ( RoundUp( length ) >> PageShift );
+    for ( ::std::size_t page = first; page < last; ++page )
+    {
+        Owner * owner = MakeOwner( page );
+        if ( nullptr == owner )
+        {
+            Clear( begin, ( page - first ) << PageShift );
+            return false;
+        }
+        owner->chunk_ = chunk;
+        owner->allocator_ = allocator;
+    }
+    return true;
+}
+
+// ChunkMap::Clear ------------------------------------------------------------
+
+void ChunkMap::Clear( void * begin, ::std::size_t length )
+{
+    const ::std::size_t first = reinterpret_cast< ::std::size_t >( begin ) >> PageShift;
+    const ::std::size_t last = first + ( RoundUp( length ) >> PageShift );
+    for ( ::std::size_t page = first; page < last; ++page )
+    {
+        Owner * owner = const_cast< Owner * >( Find(
+            reinterpret_cast< void * >( page << PageShift ) ) );
+        if ( nullptr == owner )
+            continue;
+        owner->chunk_ = nullptr;
+        owner->allocator_ = nullptr;
+    }
+}
+
 // FixedAllocator::FixedAllocator ---------------------------------------------
 
 FixedAllocator::FixedAllocator()
@@ -594,6 +979,15 @@ FixedAllocator::FixedAllocator()
     , allocChunk_( nullptr )
     , deallocChunk_( nullptr )
     , emptyChunk_( nullptr )
+    , chunkMap_( nullptr )
+    , pageSource_( nullptr )
+    , allocations_()
+    , deallocations_()
+    , allocSlowPaths_()
+    , chunksSearched_()
+    , deallocSlowPaths_()
+    , chunksMade_()
+    , chunksReleased_()
 {
 }
 
@@ -606,22 +1000,28 @@ FixedAllocator::~FixedAllocator()
     assert( chunks_.empty() && "Memory leak detected!" );
 #endif
     for ( ChunkIter i( chunks_.begin() ); i != chunks_.end(); ++i )
-       i->Release();
+       i->Release( *pageSource_, blockSize_, numBlocks_ );
 }
 
 // FixedAllocator::Initialize -------------------------------------------------
 
-void FixedAllocator::Initialize( ::std::size_t blockSize, ::std::size_t pageSize )
+void FixedAllocator::Initialize( ::std::size_t blockSize, ::std::size_t pageSize,
+    ChunkMap & chunkMap, PageSource & pageSource )
 {
     assert( blockSize > 0 );
     assert( pageSize >= blockSize );
     blockSize_ = blockSize;
-
-    ::std::size_t numBlocks = pageSize / blockSize;
-    if ( numBlocks > MaxObjectsPerChunk_ ) numBlocks = MaxObjectsPerChunk_;
+    chunkMap_ = &chunkMap;
+    pageSource_ = &pageSource;
+
+    // The most blocks per Chunk depends on how wide a stealth index fits in
+    // a block, so small blocks get fewer blocks per Chunk than large ones.
+    const ::std::size_t maxBlocks = Chunk::MaxBlocks( blockSize );
+    ::std::size_t numBlocks = ChunkMap::RoundUp( pageSize ) / blockSize;
+    if ( numBlocks > maxBlocks ) numBlocks = maxBlocks;
     else if ( numBlocks < MinObjectsPerChunk_ ) numBlocks = MinObjectsPerChunk_;
 
-    numBlocks_ = static_cast<unsigned char>(numBlocks);
+    numBlocks_ = static_cast< Chunk::Index >( numBlocks );
     assert(numBlocks_ == numBlocks);
 }
 
@@ -755,6 +1155,14 @@ bool FixedAllocator::IsCorrupt( void ) const
             const Chunk & chunk = *it;
             if ( chunk.IsCorrupt( numBlocks_, blockSize_, true ) )
                 return true;
+            const ChunkMap::Owner * owner = chunkMap_->Find( chunk.pData_ );
+            if ( ( nullptr == owner ) || ( owner->chunk_ != &chunk )
+              || ( owner->allocator_ != this ) )
+            {
+                // The ChunkMap does not know where this Chunk is.
+                assert( false );
+                return true;
+            }
         }
     }
 
@@ -765,14 +1173,58 @@ bool FixedAllocator::IsCorrupt( void ) const
 
 const Chunk * FixedAllocator::HasBlock( void * p ) const
 {
-    const ::std::size_t chunkLength = numBlocks_ * blockSize_;
-    for ( ChunkCIter it( chunks_.begin() ); it != chunks_.end(); ++it )
+    const ChunkMap::Owner * owner = chunkMap_->Find( p );
+    if ( ( nullptr == owner ) || ( owner->allocator_ != this ) )
+        return nullptr;
+    if ( !owner->chunk_->HasBlock( p, numBlocks_ * blockSize_ ) )
+        return nullptr;
+    return owner->chunk_;
+}
+
+// FixedAllocator::GetStats ---------------------------------------------------
+
+SmallObjStats FixedAllocator::GetStats( void ) const
+{
+    SmallObjStats stats;
+    stats.blockSize_ = blockSize_;
+    stats.chunkSize_ = ChunkMemorySize();
+    // Keep this order: each counter which takes from a gauge comes first.
+    stats.deallocations_ = deallocations_.Get();
+    stats.allocations_ = allocations_.Get();
+    stats.allocSlowPaths_ = allocSlowPaths_.Get();
+    stats.chunksSearched_ = chunksSearched_.Get();
+    stats.deallocSlowPaths_ = deallocSlowPaths_.Get();
+    stats.chunksReleased_ = chunksReleased_.Get();
+    stats.chunksMade_ = chunksMade_.Get();
+    stats.bytesReserved_ = stats.GetChunkCount() * stats.chunkSize_;
+    stats.bytesInUse_ = stats.GetBlocksInUse() * blockSize_;
+    return stats;
+}
+
+// FixedAllocator::MapChunk ---------------------------------------------------
+
+bool FixedAllocator::MapChunk( Chunk * chunk )
+{
+    return chunkMap_->Set( chunk->pData_, ChunkMemorySize(), chunk, this );
+}
+
+// FixedAllocator::RemapChunks ------------------------------------------------
+
+void FixedAllocator::RemapChunks( void )
+{
+    for ( ChunkIter it( chunks_.begin() ); it != chunks_.end(); ++it )
     {
-        const Chunk & chunk = *it;
-        if ( chunk.HasBlock( p, chunkLength ) )
-            return &chunk;
+        const bool mapped = MapChunk( &*it );
+        (void) mapped;
+        assert( mapped );
     }
-    return nullptr;
+}
+
+// FixedAllocator::UnmapChunk -------------------------------------------------
+
+void FixedAllocator::UnmapChunk( Chunk * chunk )
+{
+    chunkMap_->Clear( chunk->pData_, ChunkMemorySize() );
 }
 
 // FixedAllocator::TrimEmptyChunk ---------------------------------------------
@@ -791,10 +1243,15 @@ bool FixedAllocator::TrimEmptyChunk( void )
 
     Chunk * lastChunk = &chunks_.back();
     if ( lastChunk != emptyChunk_ )
+    {
         ::std::swap( *emptyChunk_, *lastChunk );
+        MapChunk( emptyChunk_ );
+    }
+    UnmapChunk( lastChunk );
     assert( lastChunk->HasAvailable( numBlocks_ ) );
-    lastChunk->Release();
+    lastChunk->Release( *pageSource_, blockSize_, numBlocks_ );
     chunks_.pop_back();
+    chunksReleased_.Add();
 
     if ( chunks_.empty() )
     {
@@ -839,6 +1296,7 @@ bool FixedAllocator::TrimChunkList( void )
         Chunks temp( chunks_ );
         temp.swap( chunks_ );
     }
+    RemapChunks();
 
     if ( chunks_.empty() )
     {
@@ -869,21 +1327,38 @@ bool FixedAllocator::MakeNewChunk( void )
         {
             if ( 0 == size ) size = 4;
             chunks_.reserve( size * 2 );
+            // The Chunks moved, so the ChunkMap must learn where they are.
+            RemapChunks();
         }
         Chunk newChunk;
-        allocated = newChunk.Init( blockSize_, numBlocks_ );
+        allocated = newChunk.Init( *pageSource_, blockSize_, numBlocks_ );
         if ( allocated )
+        {
             chunks_.push_back( newChunk );
+            if ( !MapChunk( &chunks_.back() ) )
+            {
+                chunks_.back().Release( *pageSource_, blockSize_, numBlocks_ );
+                chunks_.pop_back();
+                allocated = false;
+            }
+        }
     }
     catch ( ... )
     {
         allocated = false;
     }
-    if ( !allocated ) return false;
-
+    // Reserve may have moved the Chunks even if no new Chunk was made.
+    if ( chunks_.empty() )
+    {
+        allocChunk_ = nullptr;
+        deallocChunk_ = nullptr;
+        return false;
+    }
     allocChunk_ = &chunks_.back();
     deallocChunk_ = &chunks_.front();
-    return true;
+    if ( allocated )
+        chunksMade_.Add();
+    return allocated;
 }
 
 // FixedAllocator::Allocate ---------------------------------------------------
@@ -896,6 +1371,7 @@ void * FixedAllocator::Allocate( void )
 
     if ( ( nullptr == allocChunk_ ) || allocChunk_->IsFilled() )
     {
+        allocSlowPaths_.Add();
         if ( nullptr != emptyChunk_ )
         {
             allocChunk_ = emptyChunk_;
@@ -903,10 +1379,12 @@ void * FixedAllocator::Allocate( void )
         }
         else
         {
-            for ( ChunkIter i( chunks_.begin() ); ; ++i )
+            ChunkIter i( chunks_.begin() );
+            for ( ; ; ++i )
             {
                 if ( chunks_.end() == i )
                 {
+                    chunksSearched_.Add( chunks_.size() );
                     if ( !MakeNewChunk() )
                         return nullptr;
                     break;
@@ -914,6 +1392,7 @@ void * FixedAllocator::Allocate( void )
                 if ( !i->IsFilled() )
                 {
                     allocChunk_ = &*i;
+                    chunksSearched_.Add( static_cast< ::std::size_t >( i - chunks_.begin() ) + 1 );
                     break;
                 }
             }
@@ -928,6 +1407,7 @@ void * FixedAllocator::Allocate( void )
     assert( allocChunk_ != nullptr );
     assert( !allocChunk_->IsFilled() );
     void * place = allocChunk_->Allocate( blockSize_ );
+    allocations_.Add();
 
     // prove either emptyChunk_ points nowhere, or points to a truly empty Chunk.
     assert( ( nullptr == emptyChunk_ ) || ( emptyChunk_->HasAvailable( numBlocks_ ) ) );
@@ -960,10 +1440,11 @@ bool FixedAllocator::Deallocate( void * p, Chunk * hint )
         foundChunk = hint;
     else if ( deallocChunk_->HasBlock( p, chunkLength ) )
         foundChunk = deallocChunk_;
-    else if ( allocChunk_->HasBlock( p, chunkLength ) )
-        foundChunk = allocChunk_;
     else
-        foundChunk = VicinityFind( p );
+    {
+        deallocSlowPaths_.Add();
+        foundChunk = HasBlock( p );
+    }
     if ( nullptr == foundChunk )
         return false;
 
@@ -981,61 +1462,13 @@ bool FixedAllocator::Deallocate( void * p, Chunk * hint )
     }
 #endif
     deallocChunk_ = foundChunk;
+    deallocations_.Add();
     DoDeallocate(p);
     assert( CountEmptyChunks() < 2 );
 
     return true;
 }
 
-// FixedAllocator::VicinityFind -----------------------------------------------
-
-Chunk * FixedAllocator::VicinityFind( void * p ) const
-{
-    if ( chunks_.empty() )
-        return nullptr;
-    assert(deallocChunk_);
-
-    const ::std::size_t chunkLength = numBlocks_ * blockSize_;
-    Chunk * lo = deallocChunk_;
-    Chunk * hi = deallocChunk_ + 1;
-    const Chunk * loBound = &chunks_.front();
-    const Chunk * hiBound = &chunks_.back() + 1;
-
-    // Special case: deallocChunk_ is the last in the array
-    if ( hi == hiBound )
-        hi = nullptr;
-
-    for (;;)
-    {
-        if (lo)
-        {
-            if ( lo->HasBlock( p, chunkLength ) )
-                return lo;
-            if ( lo == loBound )
-            {
-                lo = nullptr;
-                if ( nullptr == hi )
-                    break;
-            }
-            else --lo;
-        }
-
-        if (hi)
-        {
-            if ( hi->HasBlock( p, chunkLength ) )
-                return hi;
-            if ( ++hi == hiBound )
-            {
-                hi = nullptr;
-                if ( nullptr == lo )
-                    break;
-            }
-        }
-    }
-
-    return nullptr;
-}
-
 // FixedAllocator::DoDeallocate -----------------------------------------------
 
 void FixedAllocator::DoDeallocate(void* p)
@@ -1068,10 +1501,15 @@ void FixedAllocator::DoDeallocate(void* p)
             if ( lastChunk == deallocChunk_ )
                 deallocChunk_ = emptyChunk_;
             else if ( lastChunk != emptyChunk_ )
+            {
                 ::std::swap( *emptyChunk_, *lastChunk );
+                MapChunk( emptyChunk_ );
+            }
+            UnmapChunk( lastChunk );
             assert( lastChunk->HasAvailable( numBlocks_ ) );
-            lastChunk->Release();
+            lastChunk->Release( *pageSource_, blockSize_, numBlocks_ );
             chunks_.pop_back();
+            chunksReleased_.Add();
             if ( ( allocChunk_ == lastChunk ) || allocChunk_->IsFilled() )
                 allocChunk_ = deallocChunk_;
         }
@@ -1117,58 +1555,470 @@ void DefaultDeallocator( void * p )
 #endif
 }
 
-// ----------------------------------------------------------------------------
+// PageRegions ----------------------------------------------------------------
 
-} // end namespace Private
+    /** @class PageRegions
+        @ingroup SmallObjectGroupInternal
+     Implements MappedPageSource.  Maps regions of address space from the
+     operating system and hands out page ranges from the current region one
+     after another.  Released ranges are kept on a free list for each page
+     count, since a FixedAllocator always asks for the same number of pages.
+     Each free list keeps the trimmed ranges before the untrimmed ones, so
+     Trim only visits ranges released since the last Trim, and never needs
+     to allocate.  When a region is too small for a range, the rest of it is
+     abandoned, which costs address space but no memory since those pages
+     were never touched.
+     */
+    class PageRegions
+    {
+    public:
 
-using namespace ::Loki::Private;
+        explicit PageRegions( ::std::size_t regionSize );
 
+        ~PageRegions( void );
 
-// SmallObjAllocator::SmallObjAllocator ---------------------------------------
+        void * Allocate( ::std::size_t numBytes );
 
-SmallObjAllocator::SmallObjAllocator( ::std::size_t pageSize,
-    ::std::size_t maxObjectSize, ::std::size_t objectAlignSize ) :
-    pool_( nullptr ),
-    maxSmallObjectSize_( maxObjectSize ),
-    objectAlignSize_( objectAlignSize )
-{
-#ifdef DO_EXTRA_LOKI_TESTS
-    std::cout << "SmallObjAllocator " << this << std::endl;
-#endif
-    assert( 0 != objectAlignSize );
-    const ::std::size_t allocCount = GetOffset( maxObjectSize, objectAlignSize );
-    pool_ = new FixedAllocator[ allocCount ];
-    for ( ::std::size_t i = 0; i < allocCount; ++i )
-        pool_[ i ].Initialize( ( i+1 ) * objectAlignSize, pageSize );
-}
+        void Release( void * place, ::std::size_t numBytes );
 
-// SmallObjAllocator::~SmallObjAllocator --------------------------------------
+        bool Trim( void );
 
-SmallObjAllocator::~SmallObjAllocator( void )
-{
-#ifdef DO_EXTRA_LOKI_TESTS
-    std::cout << "~SmallObjAllocator " << this << std::endl;
+        inline ::std::size_t GetMappedSize( void ) const { return mappedSize_; }
+
+        inline ::std::size_t GetUntrimmedSize( void ) const { return untrimmedSize_; }
+
+    private:
+
+        /// A mapped region.
+        struct Region
+        {
+            void * place_;
+            ::std::size_t size_;
+        };
+
+        /// Released ranges of one page count.  Ranges before firstUntrimmed_
+        /// were given back to the system.
+        struct FreeList
+        {
+            FreeList( void ) : places_(), firstUntrimmed_( 0 ) {}
+            ::std::vector< void * > places_;
+            ::std::size_t firstUntrimmed_;
+        };
+
+        /// Copy-constructor is not implemented.
+        PageRegions( const PageRegions & );
+        /// Copy-assignment operator is not implemented.
+        PageRegions & operator = ( const PageRegions & );
+
+        /// Maps a region of size bytes, or returns nullptr.
+        static void * MapRegion( ::std::size_t size );
+        static void UnmapRegion( void * place, ::std::size_t size );
+        /// Backs pages with memory before their first use or after Decommit.
+        static bool Commit( void * place, ::std::size_t size );
+        /// Gives the memory behind pages back, but keeps their addresses.
+        static void Decommit( void * place, ::std::size_t size );
+
+        ::std::vector< Region > regions_;
+        ::std::vector< FreeList > freeLists_;
+        ::std::size_t regionSize_;
+        /// Next unused page and end of current region.
+        unsigned char * next_;
+        unsigned char * end_;
+        ::std::size_t mappedSize_;
+        ::std::size_t untrimmedSize_;
+    };
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+    enum { RegionAlignment = PageSource::PageSize };
+#elif defined( MADV_HUGEPAGE )
+    /// Regions start on a huge page boundary so huge pages can back them.
+    enum { RegionAlignment = 2 * 1024 * 1024 };
+#else
+    enum { RegionAlignment = PageSource::PageSize };
 #endif
-    delete [] pool_;
+
+inline ::std::size_t RoundUpToRegion( ::std::size_t numBytes )
+{
+    return ( numBytes + RegionAlignment - 1 ) &
+        ~static_cast< ::std::size_t >( RegionAlignment - 1 );
 }
 
-// SmallObjAllocator::TrimExcessMemory ----------------------------------------
+PageRegions::PageRegions( ::std::size_t regionSize ) :
+    regions_(),
+    freeLists_(),
+    regionSize_( RoundUpToRegion( regionSize ) ),
+    next_( nullptr ),
+    end_( nullptr ),
+    mappedSize_( 0 ),
+    untrimmedSize_( 0 )
+{
+    if ( 0 == regionSize_ )
+        regionSize_ = RegionAlignment;
+}
 
-bool SmallObjAllocator::TrimExcessMemory( void )
+PageRegions::~PageRegions( void )
 {
-    bool found = false;
-    const ::std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
-    ::std::size_t i = 0;
-    for ( ; i < allocCount; ++i )
+    for ( ::std::vector< Region >::iterator it( regions_.begin() );
+        it != regions_.end(); ++it )
     {
-        if ( pool_[ i ].TrimEmptyChunk() )
-            found = true;
-    }
-    for ( i = 0; i < allocCount; ++i )
-    {
-        if ( pool_[ i ].TrimChunkList() )
-            found = true;
+        UnmapRegion( it->place_, it->size_ );
     }
+}
+
+void * PageRegions::Allocate( ::std::size_t numBytes )
+{
+    assert( 0 < numBytes );
+    assert( 0 == ( numBytes & ( PageSource::PageSize - 1 ) ) );
+    const ::std::size_t pageCount = numBytes / PageSource::PageSize;
+    if ( pageCount < freeLists_.size() )
+    {
+        FreeList & freeList = freeLists_[ pageCount ];
+        const ::std::size_t count = freeList.places_.size();
+        if ( 0 < count )
+        {
+            void * place = freeList.places_.back();
+            if ( freeList.firstUntrimmed_ < count )
+                untrimmedSize_ -= numBytes;
+            else if ( !Commit( place, numBytes ) )
+                return nullptr;
+            freeList.places_.pop_back();
+            if ( count <= freeList.firstUntrimmed_ )
+                freeList.firstUntrimmed_ = count - 1;
+            return place;
+        }
+    }
+
+    if ( static_cast< ::std::size_t >( end_ - next_ ) < numBytes )
+    {
+        const ::std::size_t size = ( numBytes <= regionSize_ ) ?
+            regionSize_ : RoundUpToRegion( numBytes );
+        void * place = MapRegion( size );
+        if ( nullptr == place )
+            return nullptr;
+        try
+        {
+            Region region = { place, size };
+            regions_.push_back( region );
+        }
+        catch ( ... )
+        {
+            UnmapRegion( place, size );
+            return nullptr;
+        }
+        mappedSize_ += size;
+        next_ = static_cast< unsigned char * >( place );
+        end_ = next_ + size;
+    }
+
+    if ( !Commit( next_, numBytes ) )
+        return nullptr;
+    void * place = next_;
+    next_ += numBytes;
+    return place;
+}
+
+void PageRegions::Release( void * place, ::std::size_t numBytes )
+{
+    assert( nullptr != place );
+    assert( 0 == ( numBytes & ( PageSource::PageSize - 1 ) ) );
+    const ::std::size_t pageCount = numBytes / PageSource::PageSize;
+    try
+    {
+        if ( freeLists_.size() <= pageCount )
+            freeLists_.resize( pageCount + 1 );
+        freeLists_[ pageCount ].places_.push_back( place );
+        untrimmedSize_ += numBytes;
+    }
+    catch ( ... )
+    {
+        // Can't remember the range, so at least give its memory back.
+        Decommit( place, numBytes );
+    }
+}
+
+bool PageRegions::Trim( void )
+{
+    if ( 0 == untrimmedSize_ )
+        return false;
+    for ( ::std::size_t pageCount = 0; pageCount < freeLists_.size(); ++pageCount )
+    {
+        FreeList & freeList = freeLists_[ pageCount ];
+        const ::std::size_t numBytes = pageCount * PageSource::PageSize;
+        for ( ; freeList.firstUntrimmed_ < freeList.places_.size();
+            ++freeList.firstUntrimmed_ )
+        {
+            Decommit( freeList.places_[ freeList.firstUntrimmed_ ], numBytes );
+        }
+    }
+    untrimmedSize_ = 0;
+    return true;
+}
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+
+void * PageRegions::MapRegion( ::std::size_t size )
+{
+    return ::VirtualAlloc( nullptr, size, MEM_RESERVE, PAGE_NOACCESS );
+}
+
+void PageRegions::UnmapRegion( void * place, ::std::size_t )
+{
+    ::VirtualFree( place, 0, MEM_RELEASE );
+}
+
+bool PageRegions::Commit( void * place, ::std::size_t size )
+{
+    return ( nullptr != ::VirtualAlloc( place, size, MEM_COMMIT, PAGE_READWRITE ) );
+}
+
+void PageRegions::Decommit( void * place, ::std::size_t size )
+{
+    ::VirtualFree( place, size, MEM_DECOMMIT );
+}
+
+#else
+
+void * PageRegions::MapRegion( ::std::size_t size )
+{
+    // Map more than asked for, so the region can be moved up to the next
+    // RegionAlignment boundary, and then unmap what sticks out on either side.
+    const ::std::size_t extra = RegionAlignment - PageSource::PageSize;
+    void * place = ::mmap( nullptr, size + extra, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if ( MAP_FAILED == place )
+        return nullptr;
+    unsigned char * begin = static_cast< unsigned char * >( place );
+    const ::std::size_t address = reinterpret_cast< ::std::size_t >( begin );
+    const ::std::size_t head = RoundUpToRegion( address ) - address;
+    if ( 0 < head )
+        ::munmap( begin, head );
+    if ( head < extra )
+        ::munmap( begin + head + size, extra - head );
+    begin += head;
+#if defined( MADV_HUGEPAGE )
+    // Only a hint, so failure does not matter.
+    ::madvise( begin, size, MADV_HUGEPAGE );
+#endif
+    return begin;
+}
+
+void PageRegions::UnmapRegion( void * place, ::std::size_t size )
+{
+    ::munmap( place, size );
+}
+
+bool PageRegions::Commit( void *, ::std::size_t )
+{
+    // Anonymous pages get memory when they are first touched.
+    return true;
+}
+
+void PageRegions::Decommit( void * place, ::std::size_t size )
+{
+    ::madvise( place, size, MADV_DONTNEED );
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+} // end namespace Private
+
+using namespace ::Loki::Private;
+
+
+// SmallObjStats::SmallObjStats -----------------------------------------------
+
+SmallObjStats::SmallObjStats( void ) :
+    blockSize_( 0 ),
+    chunkSize_( 0 ),
+    allocations_( 0 ),
+    deallocations_( 0 ),
+    allocSlowPaths_( 0 ),
+    chunksSearched_( 0 ),
+    deallocSlowPaths_( 0 ),
+    chunksMade_( 0 ),
+    chunksReleased_( 0 ),
+    bytesReserved_( 0 ),
+    bytesInUse_( 0 )
+{
+}
+
+// SmallObjStats::GetFragmentation --------------------------------------------
+
+double SmallObjStats::GetFragmentation( void ) const
+{
+    if ( 0 == bytesReserved_ )
+        return 0.0;
+    // The counters are not read at one instant, so in use may look bigger.
+    if ( bytesReserved_ <= bytesInUse_ )
+        return 0.0;
+    return static_cast< double >( bytesReserved_ - bytesInUse_ )
+        / static_cast< double >( bytesReserved_ );
+}
+
+// SmallObjStats::operator += -------------------------------------------------
+
+SmallObjStats & SmallObjStats::operator += ( const SmallObjStats & stats )
+{
+    allocations_ += stats.allocations_;
+    deallocations_ += stats.deallocations_;
+    allocSlowPaths_ += stats.allocSlowPaths_;
+    chunksSearched_ += stats.chunksSearched_;
+    deallocSlowPaths_ += stats.deallocSlowPaths_;
+    chunksMade_ += stats.chunksMade_;
+    chunksReleased_ += stats.chunksReleased_;
+    bytesReserved_ += stats.bytesReserved_;
+    bytesInUse_ += stats.bytesInUse_;
+    return *this;
+}
+
+
+// HeapPageSource::AllocatePages ----------------------------------------------
+
+void * HeapPageSource::AllocatePages( ::std::size_t numBytes )
+{
+#if defined( _WIN32 ) || defined( _WIN64 )
+    return ::_aligned_malloc( numBytes, PageSize );
+#else
+    void * place = nullptr;
+    if ( 0 != ::posix_memalign( &place, PageSize, numBytes ) )
+        place = nullptr;
+    return place;
+#endif
+}
+
+// HeapPageSource::ReleasePages -----------------------------------------------
+
+void HeapPageSource::ReleasePages( void * place, ::std::size_t )
+{
+#if defined( _WIN32 ) || defined( _WIN64 )
+    ::_aligned_free( place );
+#else
+    ::std::free( place );
+#endif
+}
+
+// MappedPageSource::MappedPageSource -----------------------------------------
+
+MappedPageSource::MappedPageSource( ::std::size_t regionSize ) :
+    PageSource(),
+    regions_( new PageRegions( regionSize ) )
+{
+}
+
+// MappedPageSource::~MappedPageSource ----------------------------------------
+
+MappedPageSource::~MappedPageSource( void )
+{
+    delete regions_;
+}
+
+// MappedPageSource::AllocatePages --------------------------------------------
+
+void * MappedPageSource::AllocatePages( ::std::size_t numBytes )
+{
+    return regions_->Allocate( numBytes );
+}
+
+// MappedPageSource::ReleasePages ---------------------------------------------
+
+void MappedPageSource::ReleasePages( void * place, ::std::size_t numBytes )
+{
+    regions_->Release( place, numBytes );
+}
+
+// MappedPageSource::Trim -----------------------------------------------------
+
+bool MappedPageSource::Trim( void )
+{
+    return regions_->Trim();
+}
+
+// MappedPageSource::GetMappedSize --------------------------------------------
+
+::std::size_t MappedPageSource::GetMappedSize( void ) const
+{
+    return regions_->GetMappedSize();
+}
+
+// MappedPageSource::GetUntrimmedSize -----------------------------------------
+
+::std::size_t MappedPageSource::GetUntrimmedSize( void ) const
+{
+    return regions_->GetUntrimmedSize();
+}
+
+/// Page source of SmallObjAllocator's made without one.
+static HeapPageSource & GetHeapPageSource( void )
+{
+    static HeapPageSource source;
+    return source;
+}
+
+
+// SmallObjAllocator::SmallObjAllocator ---------------------------------------
+
+SmallObjAllocator::SmallObjAllocator( ::std::size_t pageSize,
+    ::std::size_t maxObjectSize, ::std::size_t objectAlignSize,
+    PageSource * pageSource ) :
+    pool_( nullptr ),
+    chunkMap_( nullptr ),
+    pageSource_( ( nullptr == pageSource ) ? &GetHeapPageSource() : pageSource ),
+    maxSmallObjectSize_( maxObjectSize ),
+    objectAlignSize_( objectAlignSize )
+{
+#ifdef DO_EXTRA_LOKI_TESTS
+    std::cout << "SmallObjAllocator " << this << std::endl;
+#endif
+    assert( 0 != objectAlignSize );
+    const ::std::size_t allocCount = GetOffset( maxObjectSize, objectAlignSize );
+    chunkMap_ = new ChunkMap;
+    try
+    {
+        pool_ = new FixedAllocator[ allocCount ];
+    }
+    catch ( ... )
+    {
+        delete chunkMap_;
+        throw;
+    }
+    for ( ::std::size_t i = 0; i < allocCount; ++i )
+        pool_[ i ].Initialize( ( i+1 ) * objectAlignSize, pageSize, *chunkMap_,
+            *pageSource_ );
+}
+
+// SmallObjAllocator::~SmallObjAllocator --------------------------------------
+
+SmallObjAllocator::~SmallObjAllocator( void )
+{
+#ifdef DO_EXTRA_LOKI_TESTS
+    std::cout << "~SmallObjAllocator " << this << std::endl;
+#endif
+    SmallObjThreadCache::ForgetAllocator( *this );
+    delete [] pool_;
+    delete chunkMap_;
+}
+
+// SmallObjAllocator::TrimExcessMemory ----------------------------------------
+
+bool SmallObjAllocator::TrimExcessMemory( void )
+{
+    bool found = false;
+    const ::std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
+    ::std::size_t i = 0;
+    for ( ; i < allocCount; ++i )
+    {
+        if ( pool_[ i ].TrimEmptyChunk() )
+            found = true;
+    }
+    for ( i = 0; i < allocCount; ++i )
+    {
+        if ( pool_[ i ].TrimChunkList() )
+            found = true;
+    }
+    if ( pageSource_->Trim() )
+        found = true;
 
     return found;
 }
@@ -1240,31 +2090,101 @@ void SmallObjAllocator::Deallocate( void * p )
     if ( nullptr == p )
         return;
     assert( nullptr != pool_ );
-    FixedAllocator * pAllocator = nullptr;
-    const ::std::size_t allocCount = GetOffset( GetMaxObjectSize(), GetAlignment() );
-    Chunk * chunk = nullptr;
-
-    for ( ::std::size_t ii = 0; ii < allocCount; ++ii )
-    {
-        chunk = pool_[ ii ].HasBlock( p );
-        if ( nullptr != chunk )
-        {
-            pAllocator = &pool_[ ii ];
-            break;
-        }
-    }
-    if ( nullptr == pAllocator )
+    const ChunkMap::Owner * owner = chunkMap_->Find( p );
+    if ( nullptr == owner )
     {
         DefaultDeallocator( p );
         return;
     }
 
-    assert( nullptr != chunk );
-    const bool found = pAllocator->Deallocate( p, chunk );
+    assert( nullptr != owner->chunk_ );
+    assert( nullptr != owner->allocator_ );
+    const bool found = owner->allocator_->Deallocate( p, owner->chunk_ );
     (void) found;
     assert( found );
 }
 
+// SmallObjAllocator::AllocateBatch -------------------------------------------
+
+::std::size_t SmallObjAllocator::AllocateBatch( ::std::size_t numBytes,
+    void ** blocks, ::std::size_t count )
+{
+    assert( nullptr != pool_ );
+    assert( nullptr != blocks );
+    assert( numBytes <= GetMaxObjectSize() );
+    if ( 0 == numBytes ) numBytes = 1;
+    const ::std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    FixedAllocator & allocator = pool_[ index ];
+
+    ::std::size_t ii = 0;
+    for ( ; ii < count; ++ii )
+    {
+        void * place = allocator.Allocate();
+        if ( nullptr == place )
+            break;
+        blocks[ ii ] = place;
+    }
+    if ( ( 0 == ii ) && ( 0 < count ) && TrimExcessMemory() )
+    {
+        void * place = allocator.Allocate();
+        if ( nullptr != place )
+            blocks[ ii++ ] = place;
+    }
+
+    return ii;
+}
+
+// SmallObjAllocator::DeallocateBatch -----------------------------------------
+
+void SmallObjAllocator::DeallocateBatch( ::std::size_t numBytes,
+    void ** blocks, ::std::size_t count )
+{
+    assert( nullptr != pool_ );
+    assert( numBytes <= GetMaxObjectSize() );
+    if ( 0 == numBytes ) numBytes = 1;
+    const ::std::size_t index = GetOffset( numBytes, GetAlignment() ) - 1;
+    FixedAllocator & allocator = pool_[ index ];
+
+    for ( ::std::size_t ii = 0; ii < count; ++ii )
+    {
+        const bool found = allocator.Deallocate( blocks[ ii ], nullptr );
+        (void) found;
+        assert( found );
+    }
+}
+
+// SmallObjAllocator::HasStats ------------------------------------------------
+
+bool SmallObjAllocator::HasStats( void )
+{
+#if defined( LOKI_SMALL_OBJECT_NO_STATS )
+    return false;
+#else
+    return true;
+#endif
+}
+
+// SmallObjAllocator::GetSizeClassStats ---------------------------------------
+
+SmallObjStats SmallObjAllocator::GetSizeClassStats( ::std::size_t index ) const
+{
+    assert( nullptr != pool_ );
+    assert( index < GetSizeClassCount() );
+    return pool_[ index ].GetStats();
+}
+
+// SmallObjAllocator::GetTotalStats -------------------------------------------
+
+SmallObjStats SmallObjAllocator::GetTotalStats( void ) const
+{
+    assert( nullptr != pool_ );
+    const ::std::size_t allocCount = GetSizeClassCount();
+    SmallObjStats stats;
+    for ( ::std::size_t ii = 0; ii < allocCount; ++ii )
+        stats += pool_[ ii ].GetStats();
+    return stats;
+}
+
 // SmallObjAllocator::IsCorrupt -----------------------------------------------
 
 bool SmallObjAllocator::IsCorrupt( void ) const
@@ -1293,4 +2213,263 @@ bool SmallObjAllocator::IsCorrupt( void ) const
     return false;
 }
 
+/// @ingroup SmallObjectGroupInternal
+/// Head of list of all caches in the process.  ThreadCacheMutex guards it, and
+/// the allocator pointer of each cache.
+static SmallObjThreadCache * AllThreadCaches = nullptr;
+
+#if defined( _WIN32 ) || defined( _WIN64 )
+
+static SRWLOCK ThreadCacheMutex = SRWLOCK_INIT;
+
+/// Fiber local index whose per-thread value is the list of caches owned by
+/// that thread.
+static DWORD ThreadCacheKey = FLS_OUT_OF_INDEXES;
+
+static INIT_ONCE ThreadCacheKeyOnce = INIT_ONCE_STATIC_INIT;
+
+/// Calls OnThreadExit with the calling convention which FlsAlloc wants.
+static VOID WINAPI OnThreadCacheExit( PVOID caches )
+{
+    SmallObjThreadCache::OnThreadExit( caches );
+}
+
+/// Makes the index only once for the whole process.
+static BOOL CALLBACK MakeThreadCacheKey( PINIT_ONCE, PVOID, PVOID * )
+{
+    ThreadCacheKey = ::FlsAlloc( &OnThreadCacheExit );
+    return TRUE;
+}
+
+/// Makes the key if needed, and returns false if it could not be made.
+static bool MakeThreadCacheKeyOnce( void )
+{
+    ::InitOnceExecuteOnce( &ThreadCacheKeyOnce, &MakeThreadCacheKey,
+        nullptr, nullptr );
+    return ( FLS_OUT_OF_INDEXES != ThreadCacheKey );
+}
+
+static inline void LockThreadCaches( void )
+{
+    ::AcquireSRWLockExclusive( &ThreadCacheMutex );
+}
+
+static inline void UnlockThreadCaches( void )
+{
+    ::ReleaseSRWLockExclusive( &ThreadCacheMutex );
+}
+
+/// Returns the calling thread's list of caches.  The key must exist.
+static inline SmallObjThreadCache * GetThreadCaches( void )
+{
+    return static_cast< SmallObjThreadCache * >(
+        ::FlsGetValue( ThreadCacheKey ) );
+}
+
+/// Makes caches the calling thread's list, or returns false if it can not.
+static inline bool SetThreadCaches( SmallObjThreadCache * caches )
+{
+    return ( FALSE != ::FlsSetValue( ThreadCacheKey, caches ) );
+}
+
+#else
+
+static ::pthread_mutex_t ThreadCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/// Key whose per-thread value is the list of caches owned by that thread.
+static ::pthread_key_t ThreadCacheKey;
+
+static ::pthread_once_t ThreadCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+static bool ThreadCacheKeyMade = false;
+
+/// Makes the key only once for the whole process.
+static void MakeThreadCacheKey( void )
+{
+    ThreadCacheKeyMade = ( 0 == ::pthread_key_create( &ThreadCacheKey,
+        &SmallObjThreadCache::OnThreadExit ) );
+}
+
+/// Makes the key if needed, and returns false if it could not be made.
+static bool MakeThreadCacheKeyOnce( void )
+{
+    ::pthread_once( &ThreadCacheKeyOnce, &MakeThreadCacheKey );
+    return ThreadCacheKeyMade;
+}
+
+static inline void LockThreadCaches( void )
+{
+    ::pthread_mutex_lock( &ThreadCacheMutex );
+}
+
+static inline void UnlockThreadCaches( void )
+{
+    ::pthread_mutex_unlock( &ThreadCacheMutex );
+}
+
+/// Returns the calling thread's list of caches.  The key must exist.
+static inline SmallObjThreadCache * GetThreadCaches( void )
+{
+    return static_cast< SmallObjThreadCache * >(
+        ::pthread_getspecific( ThreadCacheKey ) );
+}
+
+/// Makes caches the calling thread's list, or returns false if it can not.
+static inline bool SetThreadCaches( SmallObjThreadCache * caches )
+{
+    return ( 0 == ::pthread_setspecific( ThreadCacheKey, caches ) );
+}
+
+#endif
+
+// SmallObjThreadCache::SmallObjThreadCache -----------------------------------
+
+SmallObjThreadCache::SmallObjThreadCache( SmallObjAllocator & allocator,
+    ExitFunction exitFunction ) :
+    allocator_( &allocator ),
+    alignment_( allocator.GetAlignment() ),
+    magazines_( nullptr ),
+    exitFunction_( exitFunction ),
+    next_( nullptr ),
+    prevAll_( nullptr ),
+    nextAll_( nullptr )
+{
+    const ::std::size_t magazineCount = GetOffset(
+        allocator.GetMaxObjectSize(), allocator.GetAlignment() );
+    magazines_ = new Magazine[ magazineCount ];
+    for ( ::std::size_t ii = 0; ii < magazineCount; ++ii )
+        magazines_[ ii ].count_ = 0;
+}
+
+// SmallObjThreadCache::~SmallObjThreadCache ----------------------------------
+
+SmallObjThreadCache::~SmallObjThreadCache( void )
+{
+    delete [] magazines_;
+}
+
+// SmallObjThreadCache::Create ------------------------------------------------
+
+SmallObjThreadCache * SmallObjThreadCache::Create(
+    SmallObjAllocator & allocator, ExitFunction exitFunction )
+{
+    if ( !MakeThreadCacheKeyOnce() )
+        return nullptr;
+    SmallObjThreadCache * cache = nullptr;
+    try
+    {
+        cache = new SmallObjThreadCache( allocator, exitFunction );
+    }
+    catch ( ... )
+    {
+        return nullptr;
+    }
+
+    cache->next_ = GetThreadCaches();
+    if ( !SetThreadCaches( cache ) )
+    {
+        delete cache;
+        return nullptr;
+    }
+    LockThreadCaches();
+    cache->nextAll_ = AllThreadCaches;
+    if ( nullptr != AllThreadCaches )
+        AllThreadCaches->prevAll_ = cache;
+    AllThreadCaches = cache;
+    UnlockThreadCaches();
+
+    return cache;
+}
+
+// SmallObjThreadCache::OnThreadExit ------------------------------------------
+
+void SmallObjThreadCache::OnThreadExit( void * caches )
+{
+    // Hold the mutex while flushing so no allocator dies in the meantime.
+    LockThreadCaches();
+    SmallObjThreadCache * cache = static_cast< SmallObjThreadCache * >( caches );
+    while ( nullptr != cache )
+    {
+        SmallObjThreadCache * next = cache->next_;
+        if ( nullptr != cache->prevAll_ )
+            cache->prevAll_->nextAll_ = cache->nextAll_;
+        else
+            AllThreadCaches = cache->nextAll_;
+        if ( nullptr != cache->nextAll_ )
+            cache->nextAll_->prevAll_ = cache->prevAll_;
+        if ( cache->IsAlive() && ( nullptr != cache->exitFunction_ ) )
+            cache->exitFunction_( *cache );
+        delete cache;
+        cache = next;
+    }
+    UnlockThreadCaches();
+}
+
+// SmallObjThreadCache::ForgetAllocator ---------------------------------------
+
+void SmallObjThreadCache::ForgetAllocator( SmallObjAllocator & allocator )
+{
+    LockThreadCaches();
+    if ( nullptr != AllThreadCaches )
+    {
+        // No other thread may use an allocator being destroyed, so the
+        // calling thread's caches can be flushed without the allocator's lock.
+        for ( SmallObjThreadCache * cache = GetThreadCaches();
+            nullptr != cache; cache = cache->next_ )
+        {
+            if ( &allocator == cache->allocator_ )
+                cache->FlushAll();
+        }
+        for ( SmallObjThreadCache * cache = AllThreadCaches;
+            nullptr != cache; cache = cache->nextAll_ )
+        {
+            if ( &allocator == cache->allocator_ )
+                cache->allocator_ = nullptr;
+        }
+    }
+    UnlockThreadCaches();
+}
+
+// SmallObjThreadCache::Refill ------------------------------------------------
+
+bool SmallObjThreadCache::Refill( ::std::size_t numBytes )
+{
+    Magazine & magazine = GetMagazine( numBytes );
+    ::std::size_t wanted = LOKI_SMALL_OBJECT_CACHE_SIZE / 2 + 1;
+    if ( wanted > LOKI_SMALL_OBJECT_CACHE_SIZE - magazine.count_ )
+        wanted = LOKI_SMALL_OBJECT_CACHE_SIZE - magazine.count_;
+    const ::std::size_t got = allocator_->AllocateBatch( numBytes,
+        magazine.blocks_ + magazine.count_, wanted );
+    magazine.count_ += got;
+    return ( 0 < got );
+}
+
+// SmallObjThreadCache::Flush -------------------------------------------------
+
+void SmallObjThreadCache::Flush( ::std::size_t numBytes )
+{
+    Magazine & magazine = GetMagazine( numBytes );
+    ::std::size_t count = magazine.count_ / 2 + 1;
+    if ( count > magazine.count_ )
+        count = magazine.count_;
+    magazine.count_ -= count;
+    allocator_->DeallocateBatch( numBytes,
+        magazine.blocks_ + magazine.count_, count );
+}
+
+// SmallObjThreadCache::FlushAll ----------------------------------------------
+
+void SmallObjThreadCache::FlushAll( void )
+{
+    const ::std::size_t magazineCount = GetOffset(
+        allocator_->GetMaxObjectSize(), alignment_ );
+    for ( ::std::size_t ii = 0; ii < magazineCount; ++ii )
+    {
+        Magazine & magazine = magazines_[ ii ];
+        allocator_->DeallocateBatch( ( ii + 1 ) * alignment_,
+            magazine.blocks_, magazine.count_ );
+        magazine.count_ = 0;
+    }
+}
+
 } // end namespace Loki
@@ -183,6 +183,71 @@ void TwoRefCounts::ZapPointer( void )
 
 // ----------------------------------------------------------------------------
 
+void * MadeTwoRefCounts::s_nullPointer = NULL;
+
+// ----------------------------------------------------------------------------
+
+MadeTwoRefCounts::MadeTwoRefCounts( const void * p, bool strong )
+    : m_info( NULL )
+{
+    (void)strong;
+    if ( NULL != p )
+    {
+        throw ::std::logic_error(
+            "MadeTwoRefCounts only accepts pointers made by MakeStrong!" );
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+bool MadeTwoRefCounts::Release( bool strong )
+{
+    if ( NULL == m_info )
+    {
+        return false;
+    }
+    if ( strong )
+    {
+        if ( m_info->DecStrongCount() )
+        {
+            // The pointee may hold weak copointers to itself, so borrow a weak
+            // count to keep the block alive while the pointee dies.
+            m_info->IncWeakCount();
+            m_info->DestroyPointee();
+            m_info->DecWeakCount();
+        }
+    }
+    else
+    {
+        m_info->DecWeakCount();
+    }
+    if ( !m_info->HasStrongPointer() && !m_info->HasWeakPointer() )
+    {
+        m_info->DestroyPointee();
+        m_info->~MadeTwoRefCountInfo();
+        ::Loki::Private::MadeBlock< MadeHeader >::Deallocate( m_info );
+    }
+    m_info = NULL;
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+void MadeTwoRefCounts::SetPointer( void * p )
+{
+    if ( NULL != p )
+    {
+        throw ::std::logic_error(
+            "MadeTwoRefCounts only accepts pointers made by MakeStrong!" );
+    }
+    if ( NULL != m_info )
+    {
+        m_info->ZapPointer();
+    }
+}
+
+// ----------------------------------------------------------------------------
+
 SingleOwnerRefCount::SingleOwnerRefCount( bool strong )
     : m_info( NULL )
 {
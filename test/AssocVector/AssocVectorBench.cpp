@@ -0,0 +1,245 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+
+/// @note This benchmark measures how long it takes to build a lookup table of
+/// a million random keys, as programs do at startup, with std::map and with
+/// the ways AssocVector offers: the range constructor, inserting the keys in
+/// batches, and the assume_sorted constructor for keys which are already
+/// sorted.  Inserting the keys one by one into an AssocVector costs O(N*N),
+/// so that is only measured for a tenth of the keys.  It then measures
+/// finding every key once in random order, and searching for its lower bound
+/// alone, in tables with small values and in tables with values of 64 bytes,
+/// for std::map and every layout of AssocVector.
+
+
+#include <loki/AssocVector.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <utility>
+#include <algorithm>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int EntryCount = 1000 * 1000;
+
+static const unsigned int BatchCount = 10;
+
+typedef pair< unsigned int, unsigned int > Entry;
+
+typedef vector< Entry > Entries;
+
+typedef map< unsigned int, unsigned int > Map;
+
+typedef ::Loki::AssocVector< unsigned int, unsigned int > Vector;
+
+/// A value as big as a cache line.
+struct BigValue
+{
+    BigValue( void ) : m_value( 0 ) {}
+    BigValue( unsigned int value ) : m_value( value ) {}
+    unsigned int m_value;
+    unsigned int m_padding[ 15 ];
+};
+
+typedef pair< unsigned int, BigValue > BigEntry;
+
+typedef vector< BigEntry > BigEntries;
+
+// ----------------------------------------------------------------------------
+
+void PrintTime( const char * what, double start, size_t size )
+{
+    const double stop = GetMilliSeconds();
+    cout << setw( 40 ) << left << what << right
+         << setw( 12 ) << size
+         << setw( 12 ) << ( stop - start ) << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+unsigned int ValueOf( unsigned int value ) { return value; }
+
+unsigned int ValueOf( const BigValue & value ) { return value.m_value; }
+
+/// Returns the sum of the values of all keys, to keep the lookups alive.
+template < class Table >
+unsigned int LookUp( const Table & table, const Entries & entries )
+{
+    unsigned int sum = 0;
+    for ( Entries::const_iterator it = entries.begin(); it != entries.end(); ++it )
+        sum += ValueOf( table.find( it->first )->second );
+    return sum;
+}
+
+/// Returns the sum of the distances of the lower bounds of all keys from the
+/// beginning, which is the cost of the search alone.
+template < class Table >
+size_t Search( const Table & table, const Entries & entries )
+{
+    size_t sum = 0;
+    for ( Entries::const_iterator it = entries.begin(); it != entries.end(); ++it )
+        sum += static_cast< size_t >( distance( table.begin(), table.lower_bound( it->first ) ) );
+    return sum;
+}
+
+/// Prints how long finding every key and, for random access tables,
+/// searching every key take, and returns the sum of the values found.
+template < class Table >
+unsigned int TimeTable( const char * what, const Table & table, const Entries & entries,
+    bool search )
+{
+    const double start = GetMilliSeconds();
+    const unsigned int sum = LookUp( table, entries );
+    const double found = GetMilliSeconds();
+
+    cout << setw( 40 ) << left << what << right
+         << setw( 12 ) << table.size()
+         << setw( 12 ) << ( found - start );
+    if ( search )
+    {
+        const size_t distances = Search( table, entries );
+        cout << setw( 12 ) << ( GetMilliSeconds() - found );
+        if ( distances != table.size() * ( table.size() - 1 ) / 2 )
+            cout << " wrong lower bounds";
+    }
+    cout << endl;
+    return sum;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Builds a table of every layout from sorted, and prints how long it takes
+/// to look up every key of entries.
+template < class Value >
+void TimeLookUps( const char * title, const vector< pair< unsigned int, Value > > & sorted,
+    const Entries & entries )
+{
+    typedef map< unsigned int, Value > ValueMap;
+    typedef ::Loki::AssocVector< unsigned int, Value > PairsVector;
+    typedef ::Loki::AssocVector< unsigned int, Value, less< unsigned int >,
+        allocator< pair< unsigned int, Value > >, ::Loki::SortedKeysLayout > KeysVector;
+    typedef ::Loki::AssocVector< unsigned int, Value, less< unsigned int >,
+        allocator< pair< unsigned int, Value > >, ::Loki::BTreeKeysLayout > BTreeVector;
+
+    const ValueMap valueMap( sorted.begin(), sorted.end() );
+    const PairsVector pairs( ::Loki::assume_sorted, sorted.begin(), sorted.end() );
+    const KeysVector keys( ::Loki::assume_sorted, sorted.begin(), sorted.end() );
+    const BTreeVector btree( ::Loki::assume_sorted, sorted.begin(), sorted.end() );
+
+    cout << endl << setw( 40 ) << left << title << right
+         << setw( 12 ) << "Entries"
+         << setw( 12 ) << "find"
+         << setw( 12 ) << "lower_bound" << endl;
+
+    const unsigned int sum = TimeTable( "std::map", valueMap, entries, false );
+    bool same = ( sum == TimeTable( "AssocVector SortedPairsLayout", pairs, entries, true ) );
+    same = ( sum == TimeTable( "AssocVector SortedKeysLayout", keys, entries, true ) ) && same;
+    same = ( sum == TimeTable( "AssocVector BTreeKeysLayout", btree, entries, true ) ) && same;
+    if ( !same )
+        cout << "lookups differ" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    // Multiplying by an odd number scrambles the keys without repeating any.
+    Entries entries;
+    entries.reserve( EntryCount );
+    for ( unsigned int ii = 0; ii < EntryCount; ++ii )
+        entries.push_back( make_pair( ii * 2654435761u, ii ) );
+    Entries sorted( entries );
+    sort( sorted.begin(), sorted.end() );
+
+    cout << "Times in milliseconds." << endl << endl;
+    cout << setw( 40 ) << left << "Building" << right
+         << setw( 12 ) << "Entries"
+         << setw( 12 ) << "Time" << endl;
+
+    double start = GetMilliSeconds();
+    Map map1;
+    for ( Entries::const_iterator it = entries.begin(); it != entries.end(); ++it )
+        map1.insert( *it );
+    PrintTime( "std::map insert one by one", start, map1.size() );
+
+    start = GetMilliSeconds();
+    const Map map2( entries.begin(), entries.end() );
+    PrintTime( "std::map range constructor", start, map2.size() );
+
+    start = GetMilliSeconds();
+    Vector vector1;
+    for ( unsigned int ii = 0; ii < EntryCount / 10; ++ii )
+        vector1.insert( entries[ ii ] );
+    PrintTime( "AssocVector insert one by one", start, vector1.size() );
+
+    start = GetMilliSeconds();
+    const Vector vector2( entries.begin(), entries.end() );
+    PrintTime( "AssocVector range constructor", start, vector2.size() );
+
+    start = GetMilliSeconds();
+    Vector vector3;
+    vector3.reserve( EntryCount );
+    for ( unsigned int batch = 0; batch < BatchCount; ++batch )
+    {
+        const Entries::const_iterator first = entries.begin()
+            + static_cast< ptrdiff_t >( batch * ( EntryCount / BatchCount ) );
+        vector3.insert( first, first + static_cast< ptrdiff_t >( EntryCount / BatchCount ) );
+    }
+    PrintTime( "AssocVector insert ten batches", start, vector3.size() );
+
+    start = GetMilliSeconds();
+    const Vector vector4( ::Loki::assume_sorted, sorted.begin(), sorted.end() );
+    PrintTime( "AssocVector assume_sorted constructor", start, vector4.size() );
+
+    const Entries fromMap( map2.begin(), map2.end() );
+    if ( vector2 != vector3 || vector2 != vector4 || vector2.size() != fromMap.size()
+        || !equal( vector2.begin(), vector2.end(), fromMap.begin() ) )
+        cout << "tables differ" << endl;
+
+    TimeLookUps( "Looking up every key", sorted, entries );
+
+    BigEntries bigSorted;
+    bigSorted.reserve( EntryCount );
+    for ( Entries::const_iterator it = sorted.begin(); it != sorted.end(); ++it )
+        bigSorted.push_back( make_pair( it->first, BigValue( it->second ) ) );
+    TimeLookUps( "Looking up every key of big values", bigSorted, entries );
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
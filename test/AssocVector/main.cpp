@@ -31,8 +31,10 @@
 #include <cassert>
 
 #include <string>
-#include <iostream>
-
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
 using namespace std;
 
 typedef ::std::map< ::std::string, unsigned int > StudentGradeMap;
@@ -43,7 +45,7 @@ typedef ::Loki::AssocVector< ::std::string, unsigned int > StudentGrades;
 typedef StudentGrades::iterator StudentGradeIter;
 typedef StudentGrades::const_iterator StudentGradeCIter;
 
-typedef ::std::pair< ::std::string, unsigned int > GradeInfo;
+typedef ::std::pair< ::std::string, unsigned int > GradeInfo;
 
 
 GradeInfo oneStudent = ::std::make_pair( "Anne", 100 );
@@ -172,7 +174,162 @@ void TestAssocVectorCtor( void )
 }
 
 // ----------------------------------------------------------------------------
-
+
+void TestAssocVectorBulk( void )
+{
+    cout << "Starting TestAssocVectorBulk" << endl;
+
+    static const unsigned int  noDuplicateCount = ( sizeof(noDuplicates)  / sizeof(noDuplicates[0])  );
+    static const unsigned int hasDuplicateCount = ( sizeof(hasDuplicates) / sizeof(hasDuplicates[0]) );
+
+    {
+        // This test demonstrates the sorted constructor takes the elements as they are.
+        const StudentGrades grades1( noDuplicates, noDuplicates + noDuplicateCount );
+        const StudentGrades grades2( ::Loki::assume_sorted, noDuplicates, noDuplicates + noDuplicateCount );
+        assert( grades2.size() == noDuplicateCount );
+        assert( grades1 == grades2 );
+    }
+
+    {
+        // This test demonstrates the iterator constructor keeps the first of duplicate elements.
+        const StudentGrades grades( hasDuplicates, hasDuplicates + hasDuplicateCount );
+        assert( grades.find( "Anne" )->second == 100 );
+        assert( grades.find( "Fran" )->second == 74 );
+    }
+
+    {
+        // This test demonstrates inserting a range does not replace elements.
+        StudentGrades grades;
+        grades.insert( oneStudent );
+        grades[ "Fran" ] = 50;
+        grades.insert( hasDuplicates, hasDuplicates + hasDuplicateCount );
+        assert( grades.size() == noDuplicateCount );
+        assert( grades.find( "Anne" )->second == 100 );
+        assert( grades.find( "Fran" )->second == 50 );
+        assert( grades.find( "Greg" )->second == 95 );
+        grades.insert( hasDuplicates, hasDuplicates );
+        assert( grades.size() == noDuplicateCount );
+    }
+
+    {
+        // This test demonstrates inserting random ranges gives what std::map gives.
+        ::srand( 7 );
+        StudentGradeMap map;
+        StudentGrades grades;
+        for ( unsigned int batch = 0; batch < 20; ++batch )
+        {
+            ::std::vector< GradeInfo > infos;
+            for ( unsigned int ii = 0; ii < batch * 10; ++ii )
+            {
+                const char name[] = { char( 'A' + ::rand() % 26 ), char( 'a' + ::rand() % 26 ), 0 };
+                infos.push_back( ::std::make_pair( ::std::string( name ), batch ) );
+            }
+            map.insert( infos.begin(), infos.end() );
+            grades.insert( infos.begin(), infos.end() );
+            const ::std::vector< GradeInfo > fromMap( map.begin(), map.end() );
+            assert( grades.size() == fromMap.size() );
+            assert( ::std::equal( grades.begin(), grades.end(), fromMap.begin() ) );
+        }
+    }
+
+    {
+        // This test demonstrates reserve and shrink_to_fit.
+        StudentGrades grades;
+        grades.reserve( 100 );
+        assert( grades.capacity() >= 100 );
+        grades.insert( noDuplicates, noDuplicates + noDuplicateCount );
+        assert( grades.capacity() >= 100 );
+        grades.shrink_to_fit();
+        assert( grades.capacity() == noDuplicateCount );
+        assert( grades == StudentGrades( noDuplicates, noDuplicates + noDuplicateCount ) );
+    }
+
+    cout << "Finished TestAssocVectorBulk" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Does the same random changes and lookups to an AssocVector with the given
+/// layout and to a std::map, and checks they agree.
+template < template < class, class > class Layout >
+void TestAssocVectorLayout( const char * name )
+{
+    cout << "Starting TestAssocVectorLayout " << name << endl;
+
+    typedef ::Loki::AssocVector< int, int, ::std::less< int >,
+        ::std::allocator< ::std::pair< int, int > >, Layout > Table;
+    typedef ::std::map< int, int > Map;
+
+    ::srand( 11 );
+    Table table;
+    Map map;
+    assert( table.find( 3 ) == table.end() );
+    assert( table.lower_bound( 3 ) == table.end() );
+    for ( int ii = 0; ii < 2000; ++ii )
+    {
+        const int key = ::rand() % 300;
+        switch ( ::rand() % 6 )
+        {
+            case 0:
+                assert( table.insert( ::std::make_pair( key, ii ) ).second
+                    == map.insert( ::std::make_pair( key, ii ) ).second );
+                break;
+            case 1:
+                table[ key ] = ii;
+                map[ key ] = ii;
+                break;
+            case 2:
+                assert( table.erase( key ) == map.erase( key ) );
+                break;
+            case 3:
+            {
+                ::std::vector< ::std::pair< int, int > > batch;
+                for ( int jj = 0; jj < ii % 17; ++jj )
+                    batch.push_back( ::std::make_pair( ::rand() % 300, jj ) );
+                table.insert( batch.begin(), batch.end() );
+                map.insert( batch.begin(), batch.end() );
+                break;
+            }
+            case 4:
+            {
+                Table copy( table );
+                Table other;
+                other.swap( copy );
+                table.swap( other );
+                break;
+            }
+            default:
+                if ( ii % 500 == 0 )
+                {
+                    table.clear();
+                    map.clear();
+                }
+                break;
+        }
+        assert( table.size() == map.size() );
+        for ( int probe = -1; probe <= 300; probe += 7 )
+        {
+            const Table & cTable = table;
+            const typename Table::const_iterator it = cTable.find( probe );
+            const Map::const_iterator mit = map.find( probe );
+            (void)it;
+            (void)mit;
+            assert( ( it == cTable.end() ) == ( mit == map.end() ) );
+            assert( it == cTable.end() || it->second == mit->second );
+            assert( table.lower_bound( probe ) - table.begin()
+                == ::std::distance( map.begin(), map.lower_bound( probe ) ) );
+            assert( table.upper_bound( probe ) - table.begin()
+                == ::std::distance( map.begin(), map.upper_bound( probe ) ) );
+            assert( table.equal_range( probe ).second - table.equal_range( probe ).first
+                == ::std::distance( map.equal_range( probe ).first, map.equal_range( probe ).second ) );
+        }
+    }
+
+    cout << "Finished TestAssocVectorLayout " << name << endl;
+}
+
+// ----------------------------------------------------------------------------
+
 int main( int argc, const char * const argv[] )
 {
     (void)argc;
@@ -181,7 +338,11 @@ int main( int argc, const char * const argv[] )
 
     TestEmptyAssocVector();
     TestAssocVectorCtor();
-
+    TestAssocVectorBulk();
+    TestAssocVectorLayout< ::Loki::SortedPairsLayout >( "SortedPairsLayout" );
+    TestAssocVectorLayout< ::Loki::SortedKeysLayout >( "SortedKeysLayout" );
+    TestAssocVectorLayout< ::Loki::BTreeKeysLayout >( "BTreeKeysLayout" );
+
     cout << "Press <Enter> key to finish. " << endl;
     cin.get( ender );
 
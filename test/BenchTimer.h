@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The author makes no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+#ifndef LOKI_TEST_BENCH_TIMER_H
+#define LOKI_TEST_BENCH_TIMER_H
+
+// $Id$
+
+/// @file BenchTimer.h Wall clock timer shared by the benchmark programs.
+
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <sys/time.h>
+#endif
+
+
+/// Returns wall clock time in milliseconds.
+inline double GetMilliSeconds( void )
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    ::QueryPerformanceFrequency( &frequency );
+    ::QueryPerformanceCounter( &counter );
+    return 1000.0 * static_cast< double >( counter.QuadPart )
+        / static_cast< double >( frequency.QuadPart );
+#else
+    struct timeval now;
+    ::gettimeofday( &now, NULL );
+    return 1000.0 * static_cast< double >( now.tv_sec )
+        + static_cast< double >( now.tv_usec ) / 1000.0;
+#endif
+}
+
+#endif
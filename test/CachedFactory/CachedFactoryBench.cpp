@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark fetches and releases products of many distinct keys
+/// from a CachedFactory, and from a cache built like CachedFactory used to be,
+/// with one std::map from each Key to its pool and one from each provided
+/// product back to its Key.  Every key is fetched once before timing starts,
+/// so the timed loop only measures cache hits.  It then fills caches limited
+/// by AmountLimitedCreation, and times fetching new keys which each make the
+/// eviction policy throw out one object.
+
+
+#include <loki/Factory.h>
+#include <loki/Sequence.h>
+#include <loki/CachedFactory.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <cassert>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int FetchCount = 1000 * 1000;
+
+static const unsigned int EvictionCount = 100 * 1000;
+
+// ----------------------------------------------------------------------------
+
+class AbstractProduct
+{
+public:
+    virtual ~AbstractProduct( void ) {}
+};
+
+class Product : public AbstractProduct
+{
+public:
+    explicit Product( int value ) : m_value( value ) {}
+private:
+    int m_value;
+};
+
+AbstractProduct * CreateProduct( int value )
+{
+    return new Product( value );
+}
+
+static const int ProductId = 1;
+
+typedef ::Loki::CachedFactory< AbstractProduct, int, ::Loki::Seq< int > >
+    HashedCache;
+
+typedef ::Loki::CachedFactory< AbstractProduct, int, ::Loki::Seq< int >,
+    ::Loki::SimplePointer, ::Loki::AmountLimitedCreation, ::Loki::EvictLRU >
+    LRUCache;
+
+typedef ::Loki::CachedFactory< AbstractProduct, int, ::Loki::Seq< int >,
+    ::Loki::SimplePointer, ::Loki::AmountLimitedCreation, ::Loki::EvictAging >
+    AgingCache;
+
+typedef ::Loki::CachedFactory< AbstractProduct, int, ::Loki::Seq< int >,
+    ::Loki::SimplePointer, ::Loki::AmountLimitedCreation, ::Loki::EvictRandom >
+    RandomCache;
+
+// ----------------------------------------------------------------------------
+
+/// Cache with the std::map lookups CachedFactory had before it used hashing.
+class MapCache
+{
+public:
+    typedef ::Loki::FactoryImpl< AbstractProduct, int, ::Loki::Seq< int > > Impl;
+    typedef ::Loki::Key< Impl, int > MyKey;
+
+    ~MapCache( void )
+    {
+        for ( PoolMap::iterator it( m_pools.begin() ); it != m_pools.end(); ++it )
+            for ( size_t ii = 0; ii < it->second.size(); ++ii )
+                delete it->second[ ii ];
+    }
+
+    AbstractProduct * CreateObject( int id, int value )
+    {
+        MyKey key( id, value );
+        vector< AbstractProduct * > & pool = m_pools[ key ];
+        AbstractProduct * product = NULL;
+        if ( pool.empty() )
+            product = CreateProduct( value );
+        else
+        {
+            product = pool.back();
+            pool.pop_back();
+        }
+        m_provided[ product ] = key;
+        return product;
+    }
+
+    void ReleaseObject( AbstractProduct * & product )
+    {
+        ProvidedMap::iterator it( m_provided.find( product ) );
+        assert( it != m_provided.end() );
+        m_pools[ it->second ].push_back( product );
+        m_provided.erase( it );
+        product = NULL;
+    }
+
+private:
+    typedef map< MyKey, vector< AbstractProduct * > > PoolMap;
+    typedef map< AbstractProduct *, MyKey > ProvidedMap;
+    PoolMap m_pools;
+    ProvidedMap m_provided;
+};
+
+// ----------------------------------------------------------------------------
+
+/// Picks keys in a fixed pseudo random order, the same for every cache.
+class KeyPicker
+{
+public:
+    explicit KeyPicker( unsigned int keyCount ) : m_seed( 12345 ), m_keyCount( keyCount ) {}
+    int Next( void )
+    {
+        m_seed = m_seed * 1103515245U + 12345U;
+        return static_cast< int >( ( m_seed >> 8 ) % m_keyCount );
+    }
+private:
+    unsigned int m_seed;
+    unsigned int m_keyCount;
+};
+
+// ----------------------------------------------------------------------------
+
+/// Returns nanoseconds per fetch and release pair.
+template < class Cache >
+double TimeFetches( Cache & cache, unsigned int keyCount )
+{
+    for ( unsigned int ii = 0; ii < keyCount; ++ii )
+    {
+        AbstractProduct * product = cache.CreateObject( ProductId, static_cast< int >( ii ) );
+        cache.ReleaseObject( product );
+    }
+
+    KeyPicker picker( keyCount );
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < FetchCount; ++ii )
+    {
+        AbstractProduct * product = cache.CreateObject( ProductId, picker.Next() );
+        cache.ReleaseObject( product );
+    }
+    const double stop = GetMilliSeconds();
+    return ( stop - start ) * 1000.0 * 1000.0 / FetchCount;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Returns nanoseconds per fetch and release pair which evicts an object.
+template < class Cache >
+double TimeEvictions( unsigned int objectCount )
+{
+    Cache cache;
+    cache.Register( ProductId, &CreateProduct );
+    cache.setMaxCreation( objectCount );
+    for ( unsigned int ii = 0; ii < objectCount; ++ii )
+    {
+        AbstractProduct * product = cache.CreateObject( ProductId, static_cast< int >( ii ) );
+        cache.ReleaseObject( product );
+    }
+
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < EvictionCount; ++ii )
+    {
+        const int key = static_cast< int >( objectCount + ii );
+        AbstractProduct * product = cache.CreateObject( ProductId, key );
+        cache.ReleaseObject( product );
+    }
+    const double stop = GetMilliSeconds();
+    return ( stop - start ) * 1000.0 * 1000.0 / EvictionCount;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "CachedFactory fetch + release pairs, " << FetchCount
+         << " pairs on randomly picked keys." << endl;
+    cout << "Times in nanoseconds per pair." << endl << endl;
+
+    cout << setw( 10 ) << "keys"
+         << setw( 12 ) << "std::map"
+         << setw( 12 ) << "hashed" << endl;
+
+    for ( unsigned int keyCount = 100; keyCount <= 100 * 1000; keyCount *= 10 )
+    {
+        MapCache mapCache;
+        HashedCache hashedCache;
+        hashedCache.Register( ProductId, &CreateProduct );
+        cout << setw( 10 ) << keyCount;
+        cout << setw( 12 ) << TimeFetches( mapCache, keyCount );
+        cout << setw( 12 ) << TimeFetches( hashedCache, keyCount );
+        cout << endl;
+    }
+
+    cout << endl << "Fetch + release pairs of " << EvictionCount
+         << " new keys, each evicting one object from a full cache." << endl;
+    cout << "Times in nanoseconds per pair." << endl << endl;
+
+    cout << setw( 10 ) << "objects"
+         << setw( 12 ) << "LRU"
+         << setw( 12 ) << "Aging"
+         << setw( 12 ) << "Random" << endl;
+
+    for ( unsigned int objectCount = 1000; objectCount <= 100 * 1000; objectCount *= 10 )
+    {
+        cout << setw( 10 ) << objectCount;
+        cout << setw( 12 ) << TimeEvictions< LRUCache >( objectCount );
+        cout << setw( 12 ) << TimeEvictions< AgingCache >( objectCount );
+        cout << setw( 12 ) << TimeEvictions< RandomCache >( objectCount );
+        cout << endl;
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
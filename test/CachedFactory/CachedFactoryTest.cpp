@@ -46,8 +46,35 @@ typedef long milliSec;
     {
     	return clock()*1000/CLOCKS_PER_SEC;
     }
+    #include <process.h>
+    typedef unsigned int ( WINAPI * ThreadFunction_ )( void * );
+    #define LOKI_pthread_t HANDLE
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+        (int)((*handle=(HANDLE) _beginthreadex (NULL,0,(ThreadFunction_)func,arg,0,NULL))==NULL)
+    #define LOKI_pthread_join(thread) \
+        ((::WaitForSingleObject((thread),INFINITE)!=WAIT_OBJECT_0) || !CloseHandle(thread))
+    long AtomicExchange(volatile long * p, long value)
+    {
+        return ::InterlockedExchange(p, value);
+    }
+    void AtomicAdd(volatile long * p, long value)
+    {
+        ::InterlockedExchangeAdd(p, value);
+    }
 #else
 	#include <unistd.h>
+	#include <pthread.h>
+    #define LOKI_pthread_t pthread_t
+    #define LOKI_pthread_create(handle,attr,func,arg) pthread_create(handle,attr,func,arg)
+    #define LOKI_pthread_join(thread) pthread_join(thread, NULL)
+    long AtomicExchange(volatile long * p, long value)
+    {
+        return __atomic_exchange_n(p, value, __ATOMIC_ACQ_REL);
+    }
+    void AtomicAdd(volatile long * p, long value)
+    {
+        __atomic_add_fetch(p, value, __ATOMIC_SEQ_CST);
+    }
 	void Sleep(unsigned int t) { usleep( 1000 * static_cast<unsigned long>(t));}
     /**
      * Returns the number of milliseconds elapsed from the epoch.
@@ -390,6 +417,255 @@ bool testCache()
     }
 }
 
+class SharedProduct : public AbstractProduct
+{
+public:
+    SharedProduct() : inUse(0), owner(NULL) {}
+    volatile long inUse;
+    const void * owner;
+    unsigned int work[16];
+};
+
+SharedProduct* createSharedProduct(int)
+{
+    return new SharedProduct;
+}
+
+bool testShardedCache()
+{
+    typedef ShardedCachedFactory< AbstractProduct, int, Seq< int, int > > CCache;
+    CCache CC;
+    CC.Register(intID, createProductInt);
+    // the same key must come back from the same shard
+    AbstractProduct * pProduct = CC.CreateObject(intID,5,3);
+    AbstractProduct * pSave(pProduct);
+    CC.ReleaseObject(pProduct);
+    pProduct = CC.CreateObject(intID,5,3);
+    bool cacheOk = (pSave == pProduct);
+    // another key must not get the cached object
+    AbstractProduct * pOther = CC.CreateObject(intID,3,5);
+    bool otherOk = (pOther != pSave);
+    CC.ReleaseObject(pOther);
+    CC.ReleaseObject(pProduct);
+    // releasing twice must throw
+    bool throwOk = false;
+    pProduct = pSave;
+    try{
+        CC.ReleaseObject(pProduct);
+    } catch(CacheException &){
+        throwOk = true;
+    }
+    return cacheOk && otherOk && throwOk;
+}
+
+bool testShardedEviction()
+{
+    typedef ShardedCachedFactory< AbstractProduct, int, Seq< int >, SimplePointer,
+        AmountLimitedCreation, EvictLRU, SimpleStatisticPolicy, DefaultFactoryError,
+        std::vector< AbstractProduct* >, 4 > CCache;
+    CCache CC;
+    CC.Register(intID, createSharedProduct);
+    for(unsigned int i = 0; i < CC.GetShardCount(); ++i)
+        CC.GetShard(i).setMaxCreation(1);
+    // each key may only keep one object in its shard, so each new key
+    // evicts the object of an older key of the same shard
+    const int keyCount(40);
+    for(int i = 0; i < keyCount; ++i)
+    {
+        AbstractProduct * pProduct = CC.CreateObject(intID, i);
+        CC.ReleaseObject(pProduct);
+    }
+    unsigned int created = 0, destroyed = 0, allocated = 0;
+    for(unsigned int i = 0; i < CC.GetShardCount(); ++i)
+    {
+        created += CC.GetShard(i).getCreated();
+        destroyed += CC.GetShard(i).getDestroyed();
+        allocated += CC.GetShard(i).getAllocated();
+        if(CC.GetShard(i).getAllocated() > 1)
+            return false;
+    }
+    return (created == keyCount) && (destroyed + allocated == created);
+}
+
+/**
+ * Mutex for the sharded thread test.  The other tests keep the default
+ * threading model, so Loki::Mutex may be a dummy here.
+ */
+class ShardMutex
+{
+public:
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    ShardMutex() { ::InitializeCriticalSection(&mtx_); }
+    ~ShardMutex() { ::DeleteCriticalSection(&mtx_); }
+    void Lock() { ::EnterCriticalSection(&mtx_); }
+    void Unlock() { ::LeaveCriticalSection(&mtx_); }
+private:
+    CRITICAL_SECTION mtx_;
+#else
+    ShardMutex() { pthread_mutex_init(&mtx_, NULL); }
+    ~ShardMutex() { pthread_mutex_destroy(&mtx_); }
+    void Lock() { pthread_mutex_lock(&mtx_); }
+    void Unlock() { pthread_mutex_unlock(&mtx_); }
+private:
+    pthread_mutex_t mtx_;
+#endif
+    ShardMutex(const ShardMutex &);
+    ShardMutex & operator = (const ShardMutex &);
+};
+
+/**
+ * Threading model which locks each object with its own MutexPolicy, like
+ * ObjectLevelLockable, but which does not need LOKI_OBJECT_LEVEL_THREADING.
+ */
+template < class Host, class MutexPolicy >
+class ShardLockable
+{
+    mutable MutexPolicy mtx_;
+public:
+    class Lock
+    {
+    public:
+        explicit Lock(const ShardLockable & host) : host_(host)
+        {
+            host_.mtx_.Lock();
+        }
+        ~Lock()
+        {
+            host_.mtx_.Unlock();
+        }
+    private:
+        Lock(const Lock &);
+        Lock & operator = (const Lock &);
+        const ShardLockable & host_;
+    };
+};
+
+typedef ShardedCachedFactory< AbstractProduct, int, Seq< int >, SimplePointer,
+    AlwaysCreate, EvictRandom, NoStatisticPolicy, DefaultFactoryError,
+    std::vector< AbstractProduct* >, 16, ShardLockable, ShardMutex > CSharedCache;
+
+static const int sharedKeyCount(64);
+static const int sharedLoopCount(20000);
+static volatile long sharedErrors(0);
+
+void * runShardedThread(void * p)
+{
+    CSharedCache &CC(*static_cast< CSharedCache * >(p));
+    long errors = 0;
+    // each thread starts from its own seed
+    unsigned int seed = static_cast< unsigned int >(reinterpret_cast< size_t >(&errors));
+    for(int i = 0; i < sharedLoopCount; ++i)
+    {
+        seed = seed * 1103515245U + 12345U;
+        const int key = static_cast< int >((seed >> 16) % sharedKeyCount);
+        AbstractProduct * pProduct = CC.CreateObject(intID, key);
+        SharedProduct * pShared = static_cast< SharedProduct * >(pProduct);
+        // no other thread may hold the same object while this one works on it
+        if(AtomicExchange(&pShared->inUse, 1) != 0)
+            ++errors;
+        pShared->owner = &errors;
+        for(unsigned int j = 0; j < 16; ++j)
+            pShared->work[j] = seed + j;
+        if(pShared->owner != &errors)
+            ++errors;
+        AtomicExchange(&pShared->inUse, 0);
+        CC.ReleaseObject(pProduct);
+    }
+    AtomicAdd(&sharedErrors, errors);
+    return NULL;
+}
+
+bool testShardedThreads()
+{
+    const unsigned int threadCount(8);
+    CSharedCache CC;
+    CC.Register(intID, createSharedProduct);
+    LOKI_pthread_t threads[threadCount];
+    for(unsigned int i = 0; i < threadCount; ++i)
+        LOKI_pthread_create(&threads[i], NULL, runShardedThread, &CC);
+    for(unsigned int i = 0; i < threadCount; ++i)
+        LOKI_pthread_join(threads[i]);
+    return sharedErrors == 0;
+}
+
+template< class Cache >
+void fetchAndRelease(Cache &CC, int key)
+{
+    AbstractProduct *pProduct = CC.CreateObject(intID, key);
+    CC.ReleaseObject(pProduct);
+}
+
+// Fills a cache of 3 objects, uses key 0 often, then brings in 3 new keys.
+// Returns true if key 0 was still cached afterwards.
+template< class Cache >
+bool frequentKeySurvives()
+{
+    Cache CC;
+    CC.Register(intID, createSharedProduct);
+    CC.setMaxCreation(3);
+    for(int key = 0; key < 3; ++key)
+        fetchAndRelease(CC, key);
+    for(int i = 0; i < 3; ++i)
+        fetchAndRelease(CC, 0);
+    for(int key = 3; key < 6; ++key)
+        fetchAndRelease(CC, key);
+    const unsigned created = CC.getCreated();
+    fetchAndRelease(CC, 0);
+    return CC.getCreated() == created;
+}
+
+bool testEvictionOrder()
+{
+    typedef CachedFactory< AbstractProduct, int, Seq< int >, SimplePointer, AmountLimitedCreation, EvictLRU, SimpleStatisticPolicy > CLRUEvict;
+    typedef CachedFactory< AbstractProduct, int, Seq< int >, SimplePointer, AmountLimitedCreation, EvictAging, SimpleStatisticPolicy > CAgingEvict;
+    // LRU evicts key 0 once 3 keys were released after it, aging keeps it
+    bool test1 = dispResult("LRU policy", !frequentKeySurvives< CLRUEvict >());
+    bool test2 = dispResult("Aging policy", frequentKeySurvives< CAgingEvict >());
+    return test1 && test2;
+}
+
+bool testRandomEvictionSkipsOutObjects()
+{
+    typedef CachedFactory< AbstractProduct, int, Seq< int >, SimplePointer, AmountLimitedCreation, EvictRandom, SimpleStatisticPolicy > CRandomEvict;
+    CRandomEvict CC;
+    CC.Register(intID, createSharedProduct);
+    CC.setMaxCreation(2);
+    bool testPassed = true;
+    AbstractProduct *pOut = CC.CreateObject(intID, 0);
+    fetchAndRelease(CC, 0);
+    fetchAndRelease(CC, 1);
+    // the only object which may go is the one of key 0 which was released
+    for(int key = 2; key < 10; ++key)
+    {
+        try{
+            fetchAndRelease(CC, key);
+        } catch(std::exception &){
+            testPassed = false;
+        }
+    }
+    CC.ReleaseObject(pOut);
+    return testPassed;
+}
+
+bool testBatchEviction()
+{
+    typedef CachedFactory< AbstractProduct, int, Seq< int >, SimplePointer, AmountLimitedCreation, EvictLRU, SimpleStatisticPolicy > CCache;
+    CCache CC;
+    CC.Register(intID, createSharedProduct);
+    CC.setMaxCreation(4);
+    CC.setEvictionBatchSize(3);
+    for(int key = 0; key < 4; ++key)
+        fetchAndRelease(CC, key);
+    // the fifth key evicts three objects at once ...
+    fetchAndRelease(CC, 4);
+    bool batchOk = (CC.getDestroyed() == 3);
+    // ... so the next two keys need no eviction
+    fetchAndRelease(CC, 5);
+    fetchAndRelease(CC, 6);
+    bool roomOk = (CC.getDestroyed() == 3);
+    return batchOk && roomOk;
+}
+
 #include <loki/SPCachedFactory.h>
 
 template<class T>
@@ -477,8 +753,28 @@ void reliabilityTests()
     dispText("Smart pointer", "The factory provides smart pointers, when pointers go out of scope, the object returns to Cache");
     bool spTest = dispResult("Smart Pointer test result", testSmartPointer());
     separator();
+    dispText("Eviction order", "A key used often must outlive newer keys with the aging policy, not with LRU");
+    bool evictionOrderTest = dispResult("eviction order test result", testEvictionOrder());
+    separator();
+    dispText("Random eviction", "Random eviction must only pick objects which are not in use");
+    bool randomEvictionTest = dispResult("random eviction test result", testRandomEvictionSkipsOutObjects());
+    separator();
+    dispText("Batch eviction", "Evicting 3 objects at once leaves room for the next creations");
+    bool batchEvictionTest = dispResult("batch eviction test result", testBatchEviction());
+    separator();
+    dispText("Sharded cache", "Same tests as caching, with each key cached in its own shard");
+    bool shardedTest = dispResult("Sharded cache test result", testShardedCache());
+    separator();
+    dispText("Sharded eviction", "Each shard evicts its own objects when it reaches its creation limit");
+    bool shardedEvictionTest = dispResult("Sharded eviction test result", testShardedEviction());
+    separator();
+    dispText("Sharded threads", "Threads fetch and release objects of 64 keys, no object may be given out twice");
+    bool shardedThreadTest = dispResult("Sharded threads test result", testShardedThreads());
+    separator();
     
-    if(cacheResult&&rateLimitedResult&&amountLimitedResult&&evictionTest&&spTest)
+    if(cacheResult&&rateLimitedResult&&amountLimitedResult&&evictionTest&&spTest
+        &&evictionOrderTest&&randomEvictionTest&&batchEvictionTest
+        &&shardedTest&&shardedEvictionTest&&shardedThreadTest)
         dispText("All tests passed successfully");
     else
         dispText("One or more test have failed");
@@ -75,6 +75,40 @@ Factory< AbstractProduct, std::string, Seq< int, int > >,
 >
 PFactory;
  
+/////////////////////////////////////////////////////////////
+// Factory which looks up ids through a B-tree over the keys
+/////////////////////////////////////////////////////////////
+ 
+typedef SingletonHolder
+<
+    Factory< AbstractProduct, int, NullType, DefaultFactoryError,
+        BTreeKeysLayout >,
+    CreateUsingNew,
+    Loki::LongevityLifetime::DieAsSmallObjectChild
+>
+PFactoryLayout;
+
+/// Enough ids for the B-tree to have more than one level.
+static const int LayoutIdCount = 200;
+ 
+/////////////////////////////////////////////////////////////
+// Factory which threads may use while others register
+/////////////////////////////////////////////////////////////
+ 
+typedef SingletonHolder
+<
+#ifndef USE_SEQUENCE
+ConcurrentFactory< AbstractProduct, std::string, LOKI_TYPELIST_2( int, int ),
+    DefaultFactoryError, SortedKeysLayout >,
+#else
+ConcurrentFactory< AbstractProduct, std::string, Seq< int, int >,
+    DefaultFactoryError, SortedKeysLayout >,
+#endif
+    CreateUsingNew,
+    Loki::LongevityLifetime::DieAsSmallObjectChild
+>
+PConcurrentFactory;
+ 
 ////////////////////////////////////////////////////
 // Creator functions with different names
 ////////////////////////////////////////////////////
@@ -205,8 +239,18 @@ bool reg()
     bool const ok8 = PFactory::Instance().Register( "Four", &cT, &CreatorT<Product>::createParm );
 
     bool const ok9 = PFactoryFunctorParm::Instance().Register( 1, createProductRuntime );
+
+    bool const ok10 = PConcurrentFactory::Instance().Register( "One", createProductParm );
+    bool const ok11 = PConcurrentFactory::Instance().Register( "Three", c, &AbstractCreator::createParm );
+    bool const ok12 = !PConcurrentFactory::Instance().Register( "One", createProductParm );
+
+    // Register in descending order, so every id goes to the front.
+    bool ok13 = true;
+    for ( int id = LayoutIdCount; id > 0; --id )
+        ok13 = PFactoryLayout::Instance().Register( id * 3, createProductNull ) && ok13;
     
-    return ok1 && ok2 && ok3 && ok4 && ok5 && ok6 && ok7 && ok8 && ok9;
+    return ok1 && ok2 && ok3 && ok4 && ok5 && ok6 && ok7 && ok8 && ok9
+        && ok10 && ok11 && ok12 && ok13;
 }
 
 
@@ -246,7 +290,8 @@ int main()
 {
     heap_debug();
 
-    reg();
+    if ( !reg() )
+        cout << "registration failed" << endl;
     
     AbstractProduct* p;
  
@@ -282,6 +327,30 @@ int main()
     p= PFactoryFunctorParm::Instance().CreateObject( 1, func2, 64,64 );
     delete p;
 
+    cout << endl << "creator function of a concurrent factory:" << endl;
+    p= PConcurrentFactory::Instance().CreateObject( "One", 64,64 );
+    delete p;
+    p= PConcurrentFactory::Instance().CreateObject( "Three", 64,64 );
+    delete p;
+    if ( !PConcurrentFactory::Instance().Unregister( "One" ) ||
+        PConcurrentFactory::Instance().IsRegistered( "One" ) )
+        cout << "unregister from concurrent factory failed" << endl;
+
+    cout << endl << "creator function of a factory with a key layout:" << endl;
+    p= PFactoryLayout::Instance().CreateObject( 3 );
+    delete p;
+    p= PFactoryLayout::Instance().CreateObject( LayoutIdCount * 3 );
+    delete p;
+    for ( int id = 0; id <= LayoutIdCount * 3 + 1; ++id )
+    {
+        if ( PFactoryLayout::Instance().IsRegistered( id ) != ( 0 < id && 0 == id % 3 ) )
+            cout << "key layout finds wrong id " << id << endl;
+    }
+    if ( !PFactoryLayout::Instance().Unregister( 300 ) ||
+        PFactoryLayout::Instance().IsRegistered( 300 ) ||
+        !PFactoryLayout::Instance().IsRegistered( 303 ) )
+        cout << "unregister from factory with key layout failed" << endl;
+
     
     cout << endl;
     cout << "Registered ids: \n";
@@ -0,0 +1,262 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark measures how many objects per microsecond 1, 2, 4
+/// and 8 threads create through one factory with 64 registered creators,
+/// while another thread registers and unregisters one more creator every
+/// millisecond, as a program which loads plugins might do.  It compares a
+/// Factory whose every call is guarded by a Mutex with a ConcurrentFactory,
+/// whose CreateObject takes no lock.  The creators return a static product
+/// instead of allocating one, so the times show the cost of finding the
+/// creator.  Only a machine with at least as many cores as threads shows
+/// how well each one scales.
+
+
+#define LOKI_OBJECT_LEVEL_THREADING
+
+#include <loki/Factory.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include "../BenchTimer.h"
+
+#if defined(_WIN32)
+
+    #include <process.h>
+
+    typedef unsigned int ( WINAPI * ThreadFunction_ )( void * );
+
+    #define LOKI_pthread_t HANDLE
+
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+        (int)((*handle=(HANDLE) _beginthreadex (NULL,0,(ThreadFunction_)func,arg,0,NULL))==NULL)
+
+    #define LOKI_pthread_join(thread) \
+        ((::WaitForSingleObject((thread),INFINITE)!=WAIT_OBJECT_0) || !CloseHandle(thread))
+
+    void SleepOneMilliSecond( void ) { ::Sleep( 1 ); }
+
+#else
+
+    #include <unistd.h>
+
+    #define LOKI_pthread_t \
+                 pthread_t
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+                 pthread_create(handle,attr,func,arg)
+    #define LOKI_pthread_join(thread) \
+                 pthread_join(thread, NULL)
+
+    void SleepOneMilliSecond( void ) { ::usleep( 1000 ); }
+
+#endif
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int MaxThreadCount = 8;
+
+static const unsigned int CreatesPerThread = 500 * 1000;
+
+static const int CreatorCount = 64;
+
+// ----------------------------------------------------------------------------
+
+class Product
+{
+};
+
+static Product TheProduct;
+
+/// Returns the same product every time, so that creating does not allocate.
+Product * CreateProduct( void )
+{
+    return &TheProduct;
+}
+
+// ----------------------------------------------------------------------------
+
+/// How threads shared a Factory before ConcurrentFactory.
+class MutexFactory
+{
+public:
+    bool Register( int id, Product * ( * creator )( void ) )
+    {
+        mutex_.Lock();
+        const bool result = factory_.Register( id, creator );
+        mutex_.Unlock();
+        return result;
+    }
+
+    bool Unregister( int id )
+    {
+        mutex_.Lock();
+        const bool result = factory_.Unregister( id );
+        mutex_.Unlock();
+        return result;
+    }
+
+    Product * CreateObject( int id )
+    {
+        mutex_.Lock();
+        Product * product = factory_.CreateObject( id );
+        mutex_.Unlock();
+        return product;
+    }
+
+private:
+    ::Loki::Mutex mutex_;
+    ::Loki::Factory< Product, int > factory_;
+};
+
+typedef ::Loki::ConcurrentFactory< Product, int > LockFreeFactory;
+
+// ----------------------------------------------------------------------------
+
+/// Tells the registering thread when the creating threads are done.
+class StopFlag
+{
+public:
+    StopFlag( void ) : stop_( false ) {}
+
+    void Set( bool stop )
+    {
+        mutex_.Lock();
+        stop_ = stop;
+        mutex_.Unlock();
+    }
+
+    bool Get( void )
+    {
+        mutex_.Lock();
+        const bool stop = stop_;
+        mutex_.Unlock();
+        return stop;
+    }
+
+private:
+    ::Loki::Mutex mutex_;
+    bool stop_;
+};
+
+static StopFlag Stop;
+
+static unsigned int WrongProducts = 0;
+
+static ::Loki::Mutex WrongProductsMutex;
+
+// ----------------------------------------------------------------------------
+
+template < class AnyFactory >
+void * RunCreates( void * parm )
+{
+    AnyFactory & factory = *static_cast< AnyFactory * >( parm );
+    unsigned int wrong = 0;
+    for ( unsigned int ii = 0; ii < CreatesPerThread; ++ii )
+    {
+        if ( factory.CreateObject( static_cast< int >( ii % CreatorCount ) ) != &TheProduct )
+            ++wrong;
+    }
+    WrongProductsMutex.Lock();
+    WrongProducts += wrong;
+    WrongProductsMutex.Unlock();
+    return NULL;
+}
+
+template < class AnyFactory >
+void * RunRegisters( void * parm )
+{
+    AnyFactory & factory = *static_cast< AnyFactory * >( parm );
+    while ( !Stop.Get() )
+    {
+        factory.Register( CreatorCount, &CreateProduct );
+        SleepOneMilliSecond();
+        factory.Unregister( CreatorCount );
+        SleepOneMilliSecond();
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Returns objects created per microsecond by all creating threads together.
+template < class AnyFactory >
+double TimeCreates( unsigned int threadCount )
+{
+    AnyFactory factory;
+    for ( int id = 0; id < CreatorCount; ++id )
+        factory.Register( id, &CreateProduct );
+
+    Stop.Set( false );
+    LOKI_pthread_t registerer;
+    LOKI_pthread_create( &registerer, NULL, RunRegisters< AnyFactory >, &factory );
+
+    LOKI_pthread_t threads[ MaxThreadCount ];
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_create( &threads[ ii ], NULL, RunCreates< AnyFactory >, &factory );
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_join( threads[ ii ] );
+    const double stop = GetMilliSeconds();
+
+    Stop.Set( true );
+    LOKI_pthread_join( registerer );
+    return static_cast< double >( threadCount * CreatesPerThread ) / ( ( stop - start ) * 1000.0 );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "Each thread creates " << CreatesPerThread << " objects from "
+         << CreatorCount << " creators." << endl;
+    cout << "Objects created per microsecond by all threads together." << endl << endl;
+
+    cout << setw( 8 ) << "threads"
+         << setw( 16 ) << "Mutex"
+         << setw( 20 ) << "ConcurrentFactory" << endl;
+
+    for ( unsigned int threadCount = 1; threadCount <= MaxThreadCount; threadCount *= 2 )
+    {
+        cout << setw( 8 ) << threadCount
+             << setw( 16 ) << TimeCreates< MutexFactory >( threadCount )
+             << setw( 20 ) << TimeCreates< LockFreeFactory >( threadCount )
+             << endl;
+    }
+
+    if ( WrongProducts != 0 )
+        cout << WrongProducts << " objects were not created right." << endl;
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
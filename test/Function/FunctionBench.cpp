@@ -0,0 +1,253 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark counts the calls to operator new, and times making,
+/// copying, moving and calling Functions which hold different kinds of
+/// callables.  Function pointers, member function pointers and small function
+/// objects fit inside the Function, while big function objects and BindFirst
+/// results are kept on the heap, as every callable was before Functor had a
+/// buffer.  Moving a Function from the heap only passes its pointer.
+/// Functor implementations are not SmallObjects here, so that every heap
+/// implementation shows up as a call to operator new.
+
+
+#define LOKI_FUNCTOR_IS_NOT_A_SMALLOBJECT
+
+#include <loki/Function.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <new>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int LoopCount = 1000 * 1000;
+
+static const unsigned int QueueSize = 1000;
+
+static unsigned long AllocationCount = 0;
+
+// ----------------------------------------------------------------------------
+
+void * operator new( size_t size )
+{
+    ++AllocationCount;
+    void * p = ::malloc( size ? size : 1 );
+    if ( NULL == p )
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete( void * p ) throw ()
+{
+    ::free( p );
+}
+
+// ----------------------------------------------------------------------------
+
+typedef ::Loki::Function< unsigned int ( unsigned int ) > Callback;
+
+typedef ::Loki::Functor< unsigned int, LOKI_TYPELIST_2( unsigned int, unsigned int ) >
+    Callback2;
+
+unsigned int AddOne( unsigned int value )
+{
+    return value + 1;
+}
+
+unsigned int Add( unsigned int left, unsigned int right )
+{
+    return left + right;
+}
+
+class Counter
+{
+public:
+    Counter( void ) : m_step( 1 ) {}
+    unsigned int Step( unsigned int value ) { return value + m_step; }
+private:
+    unsigned int m_step;
+};
+
+class SmallAdder
+{
+public:
+    SmallAdder( void ) : m_step( 1 ) {}
+    unsigned int operator()( unsigned int value ) const { return value + m_step; }
+private:
+    unsigned int m_step;
+};
+
+class BigAdder
+{
+public:
+    BigAdder( void ) : m_step( 1 ) { m_padding[ 0 ] = 0; }
+    unsigned int operator()( unsigned int value ) const { return value + m_step; }
+private:
+    unsigned int m_step;
+    char m_padding[ 60 ];
+};
+
+// ----------------------------------------------------------------------------
+
+template < class Maker >
+void RunTests( const char * name, const Maker & maker )
+{
+    unsigned int sum = 0;
+
+    unsigned long allocations = AllocationCount;
+    double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LoopCount; ++ii )
+    {
+        Callback callback( maker() );
+        sum += callback( ii );
+    }
+    double stop = GetMilliSeconds();
+    const double makeAllocations = static_cast< double >( AllocationCount - allocations ) / LoopCount;
+    const double makeTime = ( stop - start ) * 1000.0 * 1000.0 / LoopCount;
+
+    // Copies go into a queue, as event dispatch code would do.
+    const Callback original( maker() );
+    vector< Callback > queue( QueueSize );
+    allocations = AllocationCount;
+    start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LoopCount; ++ii )
+        queue[ ii % QueueSize ] = original;
+    stop = GetMilliSeconds();
+    const double copyAllocations = static_cast< double >( AllocationCount - allocations ) / LoopCount;
+    const double copyTime = ( stop - start ) * 1000.0 * 1000.0 / LoopCount;
+
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+    // Each loop moves a Function out of the queue and back.
+    allocations = AllocationCount;
+    start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LoopCount; ++ii )
+    {
+        Callback moved( std::move( queue[ ii % QueueSize ] ) );
+        queue[ ii % QueueSize ] = std::move( moved );
+    }
+    stop = GetMilliSeconds();
+    const double moveAllocations = static_cast< double >( AllocationCount - allocations ) / ( 2 * LoopCount );
+    const double moveTime = ( stop - start ) * 1000.0 * 1000.0 / ( 2 * LoopCount );
+#endif
+
+    allocations = AllocationCount;
+    start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LoopCount; ++ii )
+        sum += queue[ ii % QueueSize ]( ii );
+    stop = GetMilliSeconds();
+    const double callAllocations = static_cast< double >( AllocationCount - allocations ) / LoopCount;
+    const double callTime = ( stop - start ) * 1000.0 * 1000.0 / LoopCount;
+
+    cout << setw( 16 ) << name
+         << setw( 8 ) << makeAllocations
+         << setw( 8 ) << copyAllocations
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+         << setw( 8 ) << moveAllocations
+#endif
+         << setw( 8 ) << callAllocations
+         << setw( 10 ) << makeTime
+         << setw( 10 ) << copyTime
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+         << setw( 10 ) << moveTime
+#endif
+         << setw( 10 ) << callTime;
+    // Printing the sum keeps the compiler from dropping the calls.
+    cout << "    (" << ( sum & 0xff ) << ")" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+struct FunctionPointerMaker
+{
+    Callback operator()( void ) const { return Callback( &AddOne ); }
+};
+
+struct MemberFunctionMaker
+{
+    explicit MemberFunctionMaker( Counter & counter ) : m_counter( &counter ) {}
+    Callback operator()( void ) const { return Callback( m_counter, &Counter::Step ); }
+    Counter * m_counter;
+};
+
+struct SmallObjectMaker
+{
+    Callback operator()( void ) const { return Callback( SmallAdder() ); }
+};
+
+struct BigObjectMaker
+{
+    Callback operator()( void ) const { return Callback( BigAdder() ); }
+};
+
+struct BindFirstMaker
+{
+    Callback operator()( void ) const { return ::Loki::BindFirst( Callback2( &Add ), 1U ); }
+};
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "Making, copying, moving and calling " << LoopCount << " Functions." << endl;
+    cout << "Calls to operator new per operation, and nanoseconds per operation."
+         << endl << endl;
+
+    cout << setw( 16 ) << "callable"
+         << setw( 8 ) << "make"
+         << setw( 8 ) << "copy"
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+         << setw( 8 ) << "move"
+#endif
+         << setw( 8 ) << "call"
+         << setw( 10 ) << "make ns"
+         << setw( 10 ) << "copy ns"
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+         << setw( 10 ) << "move ns"
+#endif
+         << setw( 10 ) << "call ns" << endl;
+
+    Counter counter;
+    RunTests( "function", FunctionPointerMaker() );
+    RunTests( "member", MemberFunctionMaker( counter ) );
+    RunTests( "small object", SmallObjectMaker() );
+    RunTests( "big object", BigObjectMaker() );
+    RunTests( "BindFirst", BindFirstMaker() );
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
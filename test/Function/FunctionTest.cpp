@@ -14,6 +14,8 @@
 #include <cassert>
 #include <string>
 #include <utility>
+#include <vector>
+#include <memory>
 
 //***********************************************************
 //#include <boost/test/minimal.hpp>
@@ -754,7 +756,7 @@ static void test_exception()
         f(5, 4);
         BOOST_CHECK(false);
     }
-    catch(bad_function_call)
+    catch(Loki::bad_function_call)
     {
         // okay
     }
@@ -786,6 +788,83 @@ static void test_call()
     test_call_cref(std::plus<int>());
 }
 
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+
+struct counting_obj
+{
+    static int copies;
+
+    counting_obj() {}
+    counting_obj(const counting_obj&) { ++copies; }
+    counting_obj(counting_obj&&) {}
+    int operator()(int x) const { return x + 1; }
+};
+
+int counting_obj::copies = 0;
+
+struct big_counting_obj : counting_obj
+{
+    char padding[64];
+};
+
+struct move_only_obj
+{
+    explicit move_only_obj(int v) : value(new int(v)) {}
+    move_only_obj(move_only_obj&& rhs) : value(std::move(rhs.value)) {}
+    int operator()(int x) const { return *value + x; }
+    std::unique_ptr<int> value;
+};
+
+static void test_move()
+{
+    function<int (int)> small = counting_obj();
+    function<int (int)> big = big_counting_obj();
+    counting_obj::copies = 0;
+
+    function<int (int)> moved_small(std::move(small));
+    function<int (int)> moved_big(std::move(big));
+    BOOST_CHECK(small.empty());
+    BOOST_CHECK(big.empty());
+    BOOST_CHECK(moved_small(1) == 2);
+    BOOST_CHECK(moved_big(2) == 3);
+
+    small = std::move(moved_big);
+    big = std::move(moved_small);
+    BOOST_CHECK(moved_small.empty());
+    BOOST_CHECK(moved_big.empty());
+    BOOST_CHECK(small(3) == 4);
+    BOOST_CHECK(big(4) == 5);
+    BOOST_CHECK(counting_obj::copies == 0);
+
+    small = small;
+    BOOST_CHECK(small(5) == 6);
+}
+
+static void test_unique_function()
+{
+    UniqueFunction<int (int)> f = move_only_obj(5);
+    BOOST_CHECK(f);
+    BOOST_CHECK(f(1) == 6);
+
+    add_to_obj adder(2);
+    std::vector< UniqueFunction<int (int)> > queue;
+    queue.push_back(std::move(f));
+    queue.push_back(UniqueFunction<int (int)>(&adder, &add_to_obj::operator()));
+    BOOST_CHECK(f.empty());
+    BOOST_CHECK(queue[0](2) == 7);
+    BOOST_CHECK(queue[1](3) == 5);
+
+    UniqueFunction<int (int)> g;
+    BOOST_CHECK(!g);
+    g = std::move(queue[0]);
+    BOOST_CHECK(queue[0].empty());
+    BOOST_CHECK(g(3) == 8);
+    g.clear();
+    BOOST_CHECK(g.empty());
+}
+
+#endif
+
 int main()
 {
     test_static_function();
@@ -798,6 +877,10 @@ int main()
     test_exception();
     test_implicit();
     test_call();
+#ifdef LOKI_HAS_MOVE_SEMANTICS
+    test_move();
+    test_unique_function();
+#endif
 
 #if defined(__BORLANDC__) || defined(_MSC_VER)
     system("PAUSE");
@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Part of LevelMutex test program for The Loki Library
+// The copyright on this file is protected under the terms of the MIT license.
+//
+// Permission to use, copy, modify, distribute and sell this software for any
+// purpose is hereby granted without fee, provided that the above copyright
+// notice appear in all copies and that both that copyright notice and this
+// permission notice appear in supporting documentation.
+//
+// The author makes no representations about the suitability of this software
+// for any purpose. It is provided "as is" without express or implied warranty.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+/// @note This benchmark has several threads lock one mutex many times, and
+/// compares how long it takes when waiting threads sleep at intervals, when
+/// they park until woken, and when they block inside a pthread mutex.  It also
+/// checks timed locks wait for about as long as they were asked to.
+
+
+#include "loki/LevelMutex.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+#include "../BenchTimer.h"
+
+
+using namespace ::std;
+
+
+typedef ::Loki::LevelMutex< ::Loki::SpinLevelMutex, 1,
+    ::Loki::JustReturnMutexError, ::Loki::NoMutexWait > SpinMutex;
+
+typedef ::Loki::LevelMutex< ::Loki::SleepLevelMutex, 1,
+    ::Loki::JustReturnMutexError, ::Loki::MutexSleepWaits > SleepMutex;
+
+typedef ::Loki::LevelMutex< ::Loki::ParkingLevelMutex, 1,
+    ::Loki::JustReturnMutexError, ::Loki::NoMutexWait > ParkingMutex;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int MaxThreadCount = 8;
+
+static const unsigned int TotalLoops = 200 * 1000;
+
+static unsigned int LoopsPerThread = 0;
+
+static volatile unsigned int SharedCount = 0;
+
+// ----------------------------------------------------------------------------
+
+template < class Mutex >
+void * RunLockTest( void * p )
+{
+    volatile Mutex & mutex = *static_cast< volatile Mutex * >( p );
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+    {
+        ::Loki::MutexLocker locker( mutex );
+        SharedCount = SharedCount + 1;
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+template < class Mutex >
+double RunThreads( unsigned int threadCount )
+{
+    assert( threadCount <= MaxThreadCount );
+    volatile Mutex mutex( 1 );
+    pthread_t threads[ MaxThreadCount ];
+    LoopsPerThread = TotalLoops / threadCount;
+    SharedCount = 0;
+
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        ::pthread_create( &threads[ ii ], NULL, &RunLockTest< Mutex >,
+            const_cast< Mutex * >( &mutex ) );
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        ::pthread_join( threads[ ii ], NULL );
+    const double stop = GetMilliSeconds();
+
+    assert( SharedCount == LoopsPerThread * threadCount );
+    return stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+template < class Mutex >
+void * RunTimedLockTest( void * p )
+{
+    volatile Mutex & mutex = *static_cast< volatile Mutex * >( p );
+    const ::Loki::MutexErrors::Type result = mutex.Lock( 50 );
+    if ( ::Loki::MutexErrors::Success == result )
+        mutex.Unlock();
+    return reinterpret_cast< void * >(
+        ( ::Loki::MutexErrors::TimedOut == result ) ? 1 : 0 );
+}
+
+/** Locks a mutex so another thread's timed lock has to wait it out.
+ @return Milliseconds the other thread waited, or a negative number if its
+  lock did not time out.
+ */
+template < class Mutex >
+double RunTimedThreads( void )
+{
+    volatile Mutex mutex( 1 );
+    mutex.Lock();
+    pthread_t thread;
+    void * timedOut = NULL;
+    const double start = GetMilliSeconds();
+    ::pthread_create( &thread, NULL, &RunTimedLockTest< Mutex >,
+        const_cast< Mutex * >( &mutex ) );
+    ::pthread_join( thread, &timedOut );
+    const double stop = GetMilliSeconds();
+    mutex.Unlock();
+    return ( NULL == timedOut ) ? -1.0 : stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "LevelMutex lock + unlock pairs on one shared mutex, "
+         << TotalLoops << " pairs split across all threads." << endl;
+    cout << "Times in milliseconds." << endl << endl;
+
+    cout << setw( 8 ) << "threads"
+         << setw( 12 ) << "Spin"
+         << setw( 12 ) << "Sleep"
+         << setw( 12 ) << "Parking" << endl;
+
+    for ( unsigned int count = 1; count <= MaxThreadCount; count *= 2 )
+    {
+        cout << setw( 8 ) << count;
+        cout << setw( 12 ) << RunThreads< SpinMutex >( count );
+        cout << setw( 12 ) << RunThreads< SleepMutex >( count );
+        cout << setw( 12 ) << RunThreads< ParkingMutex >( count );
+        cout << endl;
+    }
+
+    const double sleepWait = RunTimedThreads< SleepMutex >();
+    const double parkingWait = RunTimedThreads< ParkingMutex >();
+    cout << endl << "Milliseconds spent waiting for a 50 millisecond timed lock." << endl;
+    cout << setw( 8 ) << "Sleep" << setw( 12 ) << sleepWait << endl;
+    cout << setw( 8 ) << "Parking" << setw( 12 ) << parkingWait << endl;
+
+    // Timed locks must wait at least 50 milliseconds, and not much longer.
+    const bool okay = ( 49.0 <= sleepWait ) && ( sleepWait < 500.0 )
+        && ( 49.0 <= parkingWait ) && ( parkingWait < 500.0 );
+    cout << endl << ( okay ? "Timed locks waited for the right time." :
+        "Timed locks waited for the wrong time!" ) << endl;
+
+    return okay ? 0 : 1;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,220 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark compares the atomic functions of the threading models
+/// against the mutex based implementation Loki used before the lock-free
+/// atomic functions were added.  Each thread increments and decrements one
+/// shared counter, which is what RefCountedMT does when SmartPtr's get copied.
+
+
+#define LOKI_OBJECT_LEVEL_THREADING
+#include <loki/Threads.h>
+#include <loki/SmartPtr.h>
+
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+#include "../BenchTimer.h"
+
+#if defined(_WIN32)
+
+    #include <process.h>
+
+    typedef unsigned int ( WINAPI * ThreadFunction_ )( void * );
+
+    #define LOKI_pthread_t HANDLE
+
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+        (int)((*handle=(HANDLE) _beginthreadex (NULL,0,(ThreadFunction_)func,arg,0,NULL))==NULL)
+
+    #define LOKI_pthread_join(thread) \
+        ((::WaitForSingleObject((thread),INFINITE)!=WAIT_OBJECT_0) || !CloseHandle(thread))
+
+#else
+
+    #define LOKI_pthread_t \
+                 pthread_t
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+                 pthread_create(handle,attr,func,arg)
+    #define LOKI_pthread_join(thread) \
+                 pthread_join(thread, NULL)
+
+#endif
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int MaxThreadCount = 64;
+
+static const unsigned int TotalLoops = 4 * 1000 * 1000;
+
+static unsigned int LoopsPerThread = 0;
+
+// ----------------------------------------------------------------------------
+
+class Host : public ::Loki::ObjectLevelLockable< Host >
+{
+};
+
+typedef Host::IntType IntType;
+
+static volatile IntType SharedCount = 0;
+
+// ----------------------------------------------------------------------------
+
+/// The old implementation: one mutex guards every atomic function.
+static ::Loki::Mutex AtomicMutex;
+
+void * RunMutexTest( void * )
+{
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+    {
+        AtomicMutex.Lock();
+        ++SharedCount;
+        AtomicMutex.Unlock();
+        AtomicMutex.Lock();
+        --SharedCount;
+        AtomicMutex.Unlock();
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+void * RunThreadingModelTest( void * )
+{
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+    {
+        bool isZero = false;
+        Host::AtomicIncrement( SharedCount );
+        Host::AtomicDecrement( SharedCount, 0, isZero );
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+void * RunRelaxedTest( void * )
+{
+    typedef ::Loki::AtomicOps< IntType, ::Loki::AtomicRelaxed > IncrementOps;
+    typedef ::Loki::AtomicOps< IntType, ::Loki::AtomicAcqRel > DecrementOps;
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+    {
+        IncrementOps::Add( SharedCount, 1 );
+        DecrementOps::Add( SharedCount, -1 );
+    }
+    return NULL;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+typedef ::Loki::SmartPtr< int,
+    ::Loki::RefCountedMTAdj< ::Loki::ObjectLevelLockable >::RefCountedMT >
+    SharedInt;
+
+static SharedInt * SharedPointer = NULL;
+
+void * RunSmartPtrTest( void * )
+{
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+    {
+        SharedInt copy( *SharedPointer );
+        (void)copy;
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+double RunThreads( unsigned int threadCount, void * ( * function )( void * ) )
+{
+    assert( threadCount <= MaxThreadCount );
+    LOKI_pthread_t threads[ MaxThreadCount ];
+    LoopsPerThread = TotalLoops / threadCount;
+    SharedCount = 0;
+
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_create( &threads[ ii ], NULL, function, NULL );
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_join( threads[ ii ] );
+    const double stop = GetMilliSeconds();
+
+    assert( 0 == SharedCount );
+    return stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    SharedPointer = new SharedInt( new int( 0 ) );
+
+    cout << "Atomic increment + decrement pairs on one shared counter, "
+         << TotalLoops << " pairs split across all threads." << endl;
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+    cout << "Threading model atomic functions are lock-free." << endl;
+#else
+    cout << "Threading model atomic functions use a mutex." << endl;
+#endif
+    cout << "Times in milliseconds." << endl << endl;
+
+    cout << setw( 8 ) << "threads"
+         << setw( 12 ) << "mutex"
+         << setw( 12 ) << "model"
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+         << setw( 12 ) << "relaxed"
+#endif
+         << setw( 12 ) << "SmartPtr" << endl;
+
+    for ( unsigned int count = 1; count <= MaxThreadCount; count *= 2 )
+    {
+        cout << setw( 8 ) << count;
+        cout << setw( 12 ) << RunThreads( count, &RunMutexTest );
+        cout << setw( 12 ) << RunThreads( count, &RunThreadingModelTest );
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+        cout << setw( 12 ) << RunThreads( count, &RunRelaxedTest );
+#endif
+        cout << setw( 12 ) << RunThreads( count, &RunSmartPtrTest );
+        cout << endl;
+    }
+
+    delete SharedPointer;
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
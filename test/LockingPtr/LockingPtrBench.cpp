@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark measures how many reads per microsecond 1, 2, 4 and 8
+/// threads get from a small shared record.  Each thread also replaces the
+/// record once every 1024 reads, so the record is read-mostly but not
+/// read-only.  It compares a LockingPtr with a Mutex, a const LockingPtr with
+/// a RWMutex, which readers hold together, and a SeqLocked record, which
+/// readers copy without any lock.  Only a machine with at least as many
+/// cores as threads shows how well each one scales.
+
+
+#define LOKI_CLASS_LEVEL_THREADING
+
+#include "Thread.h"
+
+#include <loki/LockingPtr.h>
+
+#include <iostream>
+#include <iomanip>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int ReadsPerThread = 1000 * 1000;
+
+static const unsigned int ReadsPerWrite = 1024;
+
+static const unsigned int MaxThreads = 8;
+
+// ----------------------------------------------------------------------------
+
+struct Record
+{
+    Record( void ) : a( 1 ), b( 2 ), c( 3 ), d( 4 ) {}
+    long Sum( void ) const { return a + b + c + d; }
+    long a;
+    long b;
+    long c;
+    long d;
+};
+
+volatile Record SharedRecord;
+
+::Loki::Mutex RecordMutex;
+
+::Loki::RWMutex RecordRWMutex;
+
+::Loki::SeqLocked< Record > SeqRecord;
+
+/// Each thread adds up its reads here so the compiler can not drop them.
+long Sums[ MaxThreads ];
+
+// ----------------------------------------------------------------------------
+
+void * ReadMutex( void * parm )
+{
+    typedef ::Loki::LockingPtr< Record, ::Loki::Mutex > RecordPtr;
+    long & sum = *static_cast< long * >( parm );
+    for ( unsigned int ii = 1; ii <= ReadsPerThread; ++ii )
+    {
+        RecordPtr record( SharedRecord, RecordMutex );
+        sum += record->Sum();
+        if ( ii % ReadsPerWrite == 0 )
+            ++record->a;
+    }
+    return 0;
+}
+
+void * ReadRWMutex( void * parm )
+{
+    typedef ::Loki::LockingPtr< const Record, ::Loki::RWMutex > ReadPtr;
+    typedef ::Loki::LockingPtr< Record, ::Loki::RWMutex > WritePtr;
+    long & sum = *static_cast< long * >( parm );
+    for ( unsigned int ii = 1; ii <= ReadsPerThread; ++ii )
+    {
+        if ( ii % ReadsPerWrite == 0 )
+        {
+            WritePtr record( SharedRecord, RecordRWMutex );
+            ++record->a;
+        }
+        ReadPtr record( SharedRecord, RecordRWMutex );
+        sum += record->Sum();
+    }
+    return 0;
+}
+
+void * ReadSeqLocked( void * parm )
+{
+    long & sum = *static_cast< long * >( parm );
+    for ( unsigned int ii = 1; ii <= ReadsPerThread; ++ii )
+    {
+        Record record = SeqRecord.Read();
+        sum += record.Sum();
+        if ( ii % ReadsPerWrite == 0 )
+        {
+            ++record.a;
+            SeqRecord.Write( record );
+        }
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Returns reads per microsecond of all threads together.
+double TimeReads( ::Loki::Thread::ThreadFunction reader, unsigned int threadCount )
+{
+    vector< ::Loki::Thread * > threads;
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        threads.push_back( new ::Loki::Thread( reader, &Sums[ ii ] ) );
+
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        threads[ ii ]->start();
+    ::Loki::Thread::JoinThreads( threads );
+    const double stop = GetMilliSeconds();
+
+    ::Loki::Thread::DeleteThreads( threads );
+    return static_cast< double >( threadCount * ReadsPerThread ) / ( ( stop - start ) * 1000.0 );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "Each thread reads a record " << ReadsPerThread << " times and"
+         << " writes it once every " << ReadsPerWrite << " reads." << endl;
+    cout << "Reads per microsecond of all threads together." << endl << endl;
+
+    cout << setw( 8 ) << "threads"
+         << setw( 16 ) << "Mutex"
+         << setw( 16 ) << "RWMutex"
+         << setw( 16 ) << "SeqLocked" << endl;
+
+    for ( unsigned int threadCount = 1; threadCount <= MaxThreads; threadCount *= 2 )
+    {
+        cout << setw( 8 ) << threadCount
+             << setw( 16 ) << TimeReads( ReadMutex, threadCount )
+             << setw( 16 ) << TimeReads( ReadRWMutex, threadCount )
+             << setw( 16 ) << TimeReads( ReadSeqLocked, threadCount )
+             << endl;
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 
 #include <loki/LockingPtr.h>
 #include <loki/SafeFormat.h>
+#include <loki/SmartPtr.h>
 
 using namespace Loki;
 
@@ -95,6 +96,115 @@ void* Run(void *id)
     return 0;
 }
 
+/// Two values which writers always keep equal.
+struct Twins
+{
+    Twins() : first(0), second(0) {}
+    long first;
+    long second;
+};
+
+typedef Loki::LockingPtr<Twins,Loki::RWMutex> WriteTwinsPtr;
+typedef Loki::LockingPtr<const Twins,Loki::RWMutex> ReadTwinsPtr;
+
+volatile Twins sharedTwins;
+Loki::RWMutex twinsMutex;
+Loki::SeqLocked<Twins> seqTwins;
+
+void* RunTwinsWriter(void *)
+{
+    for(long i=1; i<=10000; i++)
+    {
+        WriteTwinsPtr l(sharedTwins,twinsMutex);
+        l->first = i;
+        l->second = i;
+    }
+    return 0;
+}
+
+/// Counts the torn values it reads in the int at p.
+void* RunTwinsReader(void * p)
+{
+    int& torn = *static_cast<int*>(p);
+    for(int i=0; i<10000; i++)
+    {
+        ReadTwinsPtr l(sharedTwins,twinsMutex);
+        if(l->first != l->second)
+            torn++;
+    }
+    return 0;
+}
+
+void* RunSeqWriter(void *)
+{
+    Twins twins;
+    for(long i=1; i<=100000; i++)
+    {
+        twins.first = i;
+        twins.second = i;
+        seqTwins.Write(twins);
+    }
+    return 0;
+}
+
+/// Counts the torn values it reads in the int at p.
+void* RunSeqReader(void * p)
+{
+    int& torn = *static_cast<int*>(p);
+    for(int i=0; i<100000; i++)
+    {
+        const Twins twins = seqTwins.Read();
+        if(twins.first != twins.second)
+            torn++;
+    }
+    return 0;
+}
+
+int RunReadersAndWriter(Thread::ThreadFunction writer, Thread::ThreadFunction reader)
+{
+    std::vector<Thread*> threads;
+    int torn[4] = { 0, 0, 0, 0 };
+    threads.push_back(new Thread(writer,0));
+    for(int i=0; i<4; i++)
+        threads.push_back(new Thread(reader,&torn[i]));
+    for(size_t i=0; i<threads.size(); i++)
+        threads.at(i)->start();
+    Thread::JoinThreads(threads);
+    Thread::DeleteThreads(threads);
+    return torn[0] + torn[1] + torn[2] + torn[3];
+}
+
+/// Records how it is locked while its functions run.
+class Tracked
+{
+public:
+    Tracked() : locked_(0), shared_(0) {}
+    void Lock() { locked_++; }
+    void Unlock() { locked_--; }
+    void LockShared() { shared_++; }
+    void UnlockShared() { shared_--; }
+    bool IsShared() const { return locked_ == 0 && shared_ == 1; }
+    bool IsLocked() { return locked_ == 1 && shared_ == 0; }
+    bool IsFree() const { return locked_ == 0 && shared_ == 0; }
+private:
+    int locked_;
+    int shared_;
+};
+
+typedef Loki::SmartPtr<Tracked, Loki::RefCounted, Loki::DisallowConversion,
+    Loki::AssertCheck, Loki::SharedLockedStorage> SharedLockedPtr;
+
+bool TestSharedLockedStorage()
+{
+    Tracked * tracked = new Tracked;
+    SharedLockedPtr p(tracked);
+    const SharedLockedPtr & cp = p;
+    // Each call on its own line, since the lockers live to the end of it.
+    const bool locked = p->IsLocked();
+    const bool shared = cp->IsShared();
+    return locked && shared && tracked->IsFree();
+}
+
 int main ()
 {
     std::vector<Thread*> threads;
@@ -138,6 +248,12 @@ int main ()
     Thread::JoinThreads(threads);
     Thread::DeleteThreads(threads);
 
+    Printf("--------------------------------------------------------------------------------------\n");
+
+    Printf("shared LockingPtr read %d torn values\n")(RunReadersAndWriter(RunTwinsWriter,RunTwinsReader));
+    Printf("SeqLocked read %d torn values\n")(RunReadersAndWriter(RunSeqWriter,RunSeqReader));
+    Printf("SharedLockedStorage locks %s\n")(TestSharedLockedStorage() ? "right" : "wrong");
+
     Printf("--------------------------------------------------------------------------------------\n");
     
     // test pair ctor
@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+
+/// @note This benchmark calls Go on randomly chosen pairs of objects from a
+/// square matrix of classes where every pair has a callback.  It compares
+/// BasicDispatcher, which finds the callback in a table indexed by the
+/// classes of both arguments, with a dispatcher which keeps the callbacks in
+/// an AssocVector sorted by the pair of TypeInfos, as BasicDispatcher did
+/// before.  It also compares StaticDispatcher, which tries a dynamic_cast
+/// to every class of its typelists, with IndexedStaticDispatcher, which asks
+/// both objects for their index, on a hierarchy of ten classes.  Each
+/// callback only adds one to a counter.
+
+
+#include <loki/MultiMethods.h>
+#include <loki/AssocVector.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <cstdlib>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int PairCount = 1000;
+
+static const unsigned int DispatchCount = 10 * 1000 * 1000;
+
+// ----------------------------------------------------------------------------
+
+class Node
+{
+public:
+    virtual ~Node( void ) {}
+};
+
+template < int I > class Leaf : public Node {};
+
+static unsigned int HitCount = 0;
+
+void Hit( Node &, Node & )
+{
+    ++HitCount;
+}
+
+// ----------------------------------------------------------------------------
+
+/// The dispatcher BasicDispatcher used to be: a binary search through the
+/// callbacks sorted by the TypeInfos of both classes.
+class SortedDispatcher
+{
+public:
+    typedef void ( * CallbackType )( Node &, Node & );
+
+    template < class SomeLhs, class SomeRhs >
+    void Add( CallbackType fun )
+    {
+        m_callbacks[ KeyType( typeid( SomeLhs ), typeid( SomeRhs ) ) ] = fun;
+    }
+
+    void Go( Node & lhs, Node & rhs )
+    {
+        MapType::iterator it = m_callbacks.find(
+            KeyType( typeid( lhs ), typeid( rhs ) ) );
+        if ( it == m_callbacks.end() )
+            throw runtime_error( "Function not found" );
+        ( it->second )( lhs, rhs );
+    }
+
+private:
+    typedef pair< ::Loki::TypeInfo, ::Loki::TypeInfo > KeyType;
+    typedef ::Loki::AssocVector< KeyType, CallbackType > MapType;
+    MapType m_callbacks;
+};
+
+// ----------------------------------------------------------------------------
+
+/// Adds Hit for Leaf< I > with every Leaf< J > for J below Count.
+template < int I, int J > struct InnerAdder
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher & dispatcher )
+    {
+        dispatcher.template Add< Leaf< I >, Leaf< J - 1 > >( &Hit );
+        InnerAdder< I, J - 1 >::Add( dispatcher );
+    }
+};
+
+template < int I > struct InnerAdder< I, 0 >
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher & ) {}
+};
+
+/// Adds Hit for every pair of Leaf classes below Count, and makes one
+/// object of each class.
+template < int I, int Count, class Base = Node > struct OuterAdder
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher & dispatcher, vector< Node * > & leaves )
+    {
+        OuterAdder< I - 1, Count, Base >::Add( dispatcher, leaves );
+        InnerAdder< I - 1, Count >::Add( dispatcher );
+        leaves.push_back( new Leaf< I - 1 > );
+    }
+};
+
+template < int Count > struct OuterAdder< 0, Count, Node >
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher &, vector< Node * > & ) {}
+};
+
+// ----------------------------------------------------------------------------
+
+/// Returns nanoseconds per dispatch between random pairs of Count classes.
+template < class Dispatcher, int Count, class Base >
+double TimeDispatch( void )
+{
+    Dispatcher dispatcher;
+    vector< Base * > leaves;
+    OuterAdder< Count, Count, Base >::Add( dispatcher, leaves );
+
+    ::srand( 42 );
+    vector< pair< Base *, Base * > > pairs;
+    pairs.reserve( PairCount );
+    for ( unsigned int ii = 0; ii < PairCount; ++ii )
+    {
+        const unsigned int lhs = static_cast< unsigned int >( ::rand() ) % Count;
+        const unsigned int rhs = static_cast< unsigned int >( ::rand() ) % Count;
+        pairs.push_back( make_pair( leaves[ lhs ], leaves[ rhs ] ) );
+    }
+
+    HitCount = 0;
+    const double start = GetMilliSeconds();
+    for ( unsigned int loop = 0; loop < DispatchCount / PairCount; ++loop )
+        for ( unsigned int ii = 0; ii < PairCount; ++ii )
+            dispatcher.Go( *pairs[ ii ].first, *pairs[ ii ].second );
+    const double stop = GetMilliSeconds();
+
+    if ( HitCount != DispatchCount )
+        cout << "wrong count " << HitCount << endl;
+    for ( unsigned int ii = 0; ii < leaves.size(); ++ii )
+        delete leaves[ ii ];
+    return ( stop - start ) * 1000.0 * 1000.0 / DispatchCount;
+}
+
+/// A hierarchy of ten classes for the static dispatchers.
+template < int I > class StaticLeaf;
+
+#define STATIC_LEAF_TYPES LOKI_TYPELIST_10( StaticLeaf< 0 >, StaticLeaf< 1 >, \
+    StaticLeaf< 2 >, StaticLeaf< 3 >, StaticLeaf< 4 >, StaticLeaf< 5 >, \
+    StaticLeaf< 6 >, StaticLeaf< 7 >, StaticLeaf< 8 >, StaticLeaf< 9 > )
+
+class StaticNode
+{
+public:
+    virtual ~StaticNode( void ) {}
+    LOKI_DEFINE_STATIC_DISPATCH_TYPES( STATIC_LEAF_TYPES )
+};
+
+template < int I > class StaticLeaf : public StaticNode
+{
+public:
+    LOKI_DEFINE_STATIC_DISPATCH_INDEX()
+};
+
+struct StaticExecutor
+{
+    template < class SomeLhs, class SomeRhs >
+    void Fire( SomeLhs &, SomeRhs & ) { ++HitCount; }
+    void OnError( StaticNode &, StaticNode & ) {}
+};
+
+template < class Dispatcher > struct StaticAdapter
+{
+    void Go( StaticNode & lhs, StaticNode & rhs )
+    {
+        Dispatcher::Go( lhs, rhs, m_executor );
+    }
+    StaticExecutor m_executor;
+};
+
+/// Makes one object of each StaticLeaf class.
+template < int I, int Count > struct OuterAdder< I, Count, StaticNode >
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher & dispatcher, vector< StaticNode * > & leaves )
+    {
+        OuterAdder< I - 1, Count, StaticNode >::Add( dispatcher, leaves );
+        leaves.push_back( new StaticLeaf< I - 1 > );
+    }
+};
+
+template < int Count > struct OuterAdder< 0, Count, StaticNode >
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher &, vector< StaticNode * > & ) {}
+};
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    typedef ::Loki::BasicDispatcher< Node > TableDispatcher;
+
+    cout << "Dispatching " << DispatchCount << " times between random pairs."
+         << endl;
+    cout << "Times in nanoseconds per dispatch." << endl << endl;
+
+    cout << setw( 12 ) << "Classes"
+         << setw( 16 ) << "AssocVector"
+         << setw( 16 ) << "Table" << endl;
+
+    cout << setw( 12 ) << "10 x 10"
+         << setw( 16 ) << TimeDispatch< SortedDispatcher, 10, Node >()
+         << setw( 16 ) << TimeDispatch< TableDispatcher, 10, Node >() << endl;
+
+    cout << setw( 12 ) << "100 x 100"
+         << setw( 16 ) << TimeDispatch< SortedDispatcher, 100, Node >()
+         << setw( 16 ) << TimeDispatch< TableDispatcher, 100, Node >() << endl;
+
+    typedef StaticAdapter< ::Loki::StaticDispatcher< StaticExecutor,
+        StaticNode, STATIC_LEAF_TYPES > > CastDispatcher;
+    typedef StaticAdapter< ::Loki::IndexedStaticDispatcher< StaticExecutor,
+        StaticNode, STATIC_LEAF_TYPES > > IndexDispatcher;
+
+    cout << endl << setw( 12 ) << "Classes"
+         << setw( 16 ) << "Static"
+         << setw( 16 ) << "IndexedStatic" << endl;
+
+    cout << setw( 12 ) << "10 x 10"
+         << setw( 16 ) << TimeDispatch< CastDispatcher, 10, StaticNode >()
+         << setw( 16 ) << TimeDispatch< IndexDispatcher, 10, StaticNode >() << endl;
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
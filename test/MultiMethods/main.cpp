@@ -0,0 +1,317 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+#include <loki/MultiMethods.h>
+
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+class Shape
+{
+public:
+    virtual ~Shape( void ) {}
+};
+
+class Circle : public Shape {};
+
+class Square : public Shape {};
+
+class Triangle : public Shape {};
+
+template < int I > class Polygon : public Shape {};
+
+// ----------------------------------------------------------------------------
+
+static unsigned int FailCount = 0;
+
+void Check( bool passed, const char * message )
+{
+    if ( !passed )
+    {
+        ++FailCount;
+        cout << "Failed: " << message << endl;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+int HitShapes( Shape &, Shape & ) { return 0; }
+
+int HitCircleSquare( Shape &, Shape & ) { return 1; }
+
+int HitSquareCircle( Shape &, Shape & ) { return 2; }
+
+int HitCircles( Shape &, Shape & ) { return 3; }
+
+template < int I > int HitPolygon( Shape &, Shape & ) { return 100 + I; }
+
+int HitCircleTriangle( Circle &, Triangle & ) { return 4; }
+
+int HitSquares( Square &, Square & ) { return 5; }
+
+// ----------------------------------------------------------------------------
+
+/// Calls Go and returns what it returns, or -1 if it throws.
+template < class Dispatcher >
+int TryGo( Dispatcher & dispatcher, Shape & lhs, Shape & rhs )
+{
+    try
+    {
+        return dispatcher.Go( lhs, rhs );
+    }
+    catch ( const runtime_error & )
+    {
+        return -1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/// Adds HitPolygon< I > for every pair of Polygons up to I.
+template < int I > struct PolygonAdder
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher & dispatcher )
+    {
+        dispatcher.template Add< Polygon< I >, Polygon< I > >( &HitPolygon< I > );
+        dispatcher.template Add< Polygon< I >, Circle >( &HitPolygon< I > );
+        PolygonAdder< I - 1 >::Add( dispatcher );
+    }
+};
+
+template <> struct PolygonAdder< 0 >
+{
+    template < class Dispatcher >
+    static void Add( Dispatcher & ) {}
+};
+
+// ----------------------------------------------------------------------------
+
+void TestBasicDispatcher( void )
+{
+    typedef ::Loki::BasicDispatcher< Shape, Shape, int > Dispatcher;
+    Dispatcher dispatcher;
+    Circle circle;
+    Square square;
+    Triangle triangle;
+
+    Check( TryGo( dispatcher, circle, square ) == -1, "empty dispatcher throws" );
+
+    dispatcher.Add< Circle, Square >( &HitCircleSquare );
+    dispatcher.Add< Square, Circle >( &HitSquareCircle );
+    dispatcher.Add< Circle, Circle >( &HitCircles );
+    Check( TryGo( dispatcher, circle, square ) == 1, "circle square" );
+    Check( TryGo( dispatcher, square, circle ) == 2, "square circle" );
+    Check( TryGo( dispatcher, circle, circle ) == 3, "circle circle" );
+    Check( TryGo( dispatcher, square, square ) == -1, "square square is not added" );
+    Check( TryGo( dispatcher, circle, triangle ) == -1, "triangle is unknown" );
+
+    dispatcher.Add< Circle, Square >( &HitShapes );
+    Check( TryGo( dispatcher, circle, square ) == 0, "adding again replaces" );
+
+    Check( dispatcher.Remove< Circle, Square >(), "remove circle square" );
+    Check( !dispatcher.Remove< Circle, Square >(), "remove circle square twice" );
+    Check( !dispatcher.Remove< Circle, Triangle >(), "remove unknown pair" );
+    Check( TryGo( dispatcher, circle, square ) == -1, "removed pair throws" );
+    Check( TryGo( dispatcher, square, circle ) == 2, "other pairs stay" );
+
+    dispatcher.Add< Circle, Square >( &HitCircleSquare );
+    Check( TryGo( dispatcher, circle, square ) == 1, "add after remove" );
+
+    // More classes than the first table has room for.
+    PolygonAdder< 40 >::Add( dispatcher );
+    Polygon< 1 > polygon1;
+    Polygon< 17 > polygon17;
+    Polygon< 40 > polygon40;
+    Check( TryGo( dispatcher, polygon1, polygon1 ) == 101, "polygon 1" );
+    Check( TryGo( dispatcher, polygon17, polygon17 ) == 117, "polygon 17" );
+    Check( TryGo( dispatcher, polygon40, circle ) == 140, "polygon 40 circle" );
+    Check( TryGo( dispatcher, polygon40, polygon17 ) == -1, "polygon 40 polygon 17" );
+    Check( TryGo( dispatcher, square, circle ) == 2, "old pairs survive growth" );
+    Check( TryGo( dispatcher, circle, circle ) == 3, "old pairs survive growth" );
+
+    const Dispatcher copy( dispatcher );
+    dispatcher.Remove< Circle, Circle >();
+    Check( TryGo( const_cast< Dispatcher & >( copy ), circle, circle ) == 3, "copies are independent" );
+}
+
+// ----------------------------------------------------------------------------
+
+void TestAddTypes( void )
+{
+    ::Loki::BasicDispatcher< Shape, Shape, int > dispatcher;
+    dispatcher.AddTypes< LOKI_TYPELIST_3( Circle, Square, Triangle ) >();
+    Circle circle;
+    Square square;
+    Check( TryGo( dispatcher, circle, square ) == -1, "classes without callbacks throw" );
+    dispatcher.Add< Circle, Square >( &HitCircleSquare );
+    Check( TryGo( dispatcher, circle, square ) == 1, "add after AddTypes" );
+}
+
+// ----------------------------------------------------------------------------
+
+void TestFnDispatcher( void )
+{
+    ::Loki::FnDispatcher< Shape, Shape, int > dispatcher;
+    dispatcher.AddTypes< LOKI_TYPELIST_3( Circle, Square, Triangle ) >();
+    dispatcher.Add< Circle, Triangle, &HitCircleTriangle, true >();
+    dispatcher.Add< Square, Square, &HitSquares >();
+    Circle circle;
+    Square square;
+    Triangle triangle;
+    Check( TryGo( dispatcher, circle, triangle ) == 4, "circle triangle" );
+    Check( TryGo( dispatcher, triangle, circle ) == 4, "symmetric triangle circle" );
+    Check( TryGo( dispatcher, square, square ) == 5, "square square" );
+    Check( TryGo( dispatcher, circle, square ) == -1, "circle square is not added" );
+}
+
+// ----------------------------------------------------------------------------
+
+struct HitFunctor
+{
+    int operator()( Circle &, Square & ) { return 6; }
+};
+
+void TestFunctorDispatcher( void )
+{
+    ::Loki::FunctorDispatcher< Shape, Shape, int > dispatcher;
+    dispatcher.Add< Circle, Square, true >( HitFunctor() );
+    Circle circle;
+    Square square;
+    Check( TryGo( dispatcher, circle, square ) == 6, "functor circle square" );
+    Check( TryGo( dispatcher, square, circle ) == 6, "functor square circle" );
+    dispatcher.Remove< Square, Circle >();
+    Check( TryGo( dispatcher, square, circle ) == -1, "removed functor" );
+}
+
+// ----------------------------------------------------------------------------
+
+class Disc;
+class Box;
+class Cube;
+
+class Figure
+{
+public:
+    virtual ~Figure( void ) {}
+    LOKI_DEFINE_STATIC_DISPATCH_TYPES( LOKI_TYPELIST_3( Disc, Box, Cube ) )
+};
+
+class Disc : public Figure
+{
+public:
+    LOKI_DEFINE_STATIC_DISPATCH_INDEX()
+};
+
+class Box : public Figure
+{
+public:
+    LOKI_DEFINE_STATIC_DISPATCH_INDEX()
+};
+
+class Cube : public Box
+{
+public:
+    LOKI_DEFINE_STATIC_DISPATCH_INDEX()
+};
+
+/// Not in StaticDispatchTypes, so it is dispatched as a Disc.
+class Ring : public Disc {};
+
+struct FigureExecutor
+{
+    int Fire( Disc &, Disc & ) { return 1; }
+    int Fire( Disc &, Box & ) { return 2; }
+    int Fire( Box &, Box & ) { return 3; }
+    int Fire( Box &, Disc & ) { return 4; }
+    int OnError( Figure &, Figure & ) { return -1; }
+    template < class SomeLhs > int OnError( SomeLhs &, Figure & ) { return -2; }
+};
+
+/// Checks that IndexedStaticDispatcher calls what StaticDispatcher calls for
+/// every pair of figures.
+template < bool symmetric >
+void TestIndexedStaticDispatcher( void )
+{
+    typedef LOKI_TYPELIST_2( Disc, Box ) Types;
+    typedef ::Loki::StaticDispatcher< FigureExecutor, Figure, Types, symmetric,
+        Figure, Types, int > CastDispatcher;
+    typedef ::Loki::IndexedStaticDispatcher< FigureExecutor, Figure, Types,
+        symmetric, Figure, Types, int > IndexDispatcher;
+
+    Figure figure;
+    Disc disc;
+    Box box;
+    Cube cube;
+    Ring ring;
+    Figure * figures[] = { &figure, &disc, &box, &cube, &ring };
+    FigureExecutor executor;
+    for ( unsigned int ii = 0; ii < 5; ++ii )
+    {
+        for ( unsigned int jj = 0; jj < 5; ++jj )
+        {
+            Check( CastDispatcher::Go( *figures[ ii ], *figures[ jj ], executor )
+                == IndexDispatcher::Go( *figures[ ii ], *figures[ jj ], executor ),
+                "IndexedStaticDispatcher calls what StaticDispatcher calls" );
+        }
+    }
+    Check( IndexDispatcher::Go( box, disc, executor ) == ( symmetric ? 2 : 4 ),
+        "box disc" );
+    Check( IndexDispatcher::Go( cube, ring, executor ) == ( symmetric ? 2 : 4 ),
+        "cube ring" );
+    Check( IndexDispatcher::Go( disc, figure, executor ) == -2, "disc figure" );
+    Check( IndexDispatcher::Go( figure, disc, executor ) == -1, "figure disc" );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    TestBasicDispatcher();
+    TestAddTypes();
+    TestFnDispatcher();
+    TestFunctorDispatcher();
+    TestIndexedStaticDispatcher< true >();
+    TestIndexedStaticDispatcher< false >();
+
+    if ( FailCount != 0 )
+    {
+        cout << FailCount << " tests failed." << endl;
+        return 1;
+    }
+    cout << "All MultiMethods tests passed." << endl;
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,228 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+
+/// @note This benchmark formats the same lines with snprintf, with an
+/// ostringstream, with a format string handed to BufPrintf, and with a
+/// PrintfFormat parsed once and handed to BufPrintf.  The round-trip row
+/// prints doubles with enough digits to read them back: %.17g for snprintf,
+/// precision 17 for the stream and %r for PrintfFormat, which prints the
+/// fewest digits that do.  Nothing is written to a file.
+
+
+#include <loki/SafeFormat.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../BenchTimer.h"
+
+#if defined(_WIN32)
+    #define snprintf _snprintf
+#endif
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int LineCount = 1000 * 1000;
+
+static char Buffer[ 256 ];
+
+// ----------------------------------------------------------------------------
+
+/// The value printed on line ii.
+double Value( unsigned int ii )
+{
+    return ( static_cast< double >( ii ) - LineCount / 2 ) / 64.0 + 0.1;
+}
+
+// ----------------------------------------------------------------------------
+
+struct IntegerLine
+{
+    static const char * Format( void ) { return "id=%d count=%u\n"; }
+
+    static int Snprintf( unsigned int ii )
+    {
+        return ::snprintf( Buffer, sizeof(Buffer), Format(),
+            static_cast< int >( ii ) - 1000, ii * 37 );
+    }
+
+    static int Stream( ostringstream & out, unsigned int ii )
+    {
+        out << "id=" << static_cast< int >( ii ) - 1000 << " count=" << ii * 37 << '\n';
+        return 0;
+    }
+
+    template < class Format >
+    static int Loki( const Format & format, unsigned int ii )
+    {
+        return ::Loki::BufPrintf( Buffer, format )( static_cast< int >( ii ) - 1000 )( ii * 37 );
+    }
+};
+
+struct DoubleLine
+{
+    static const char * Format( void ) { return "x=%g y=%g\n"; }
+
+    static int Snprintf( unsigned int ii )
+    {
+        return ::snprintf( Buffer, sizeof(Buffer), Format(), Value( ii ), -Value( ii ) );
+    }
+
+    static int Stream( ostringstream & out, unsigned int ii )
+    {
+        out << "x=" << Value( ii ) << " y=" << -Value( ii ) << '\n';
+        return 0;
+    }
+
+    template < class Format >
+    static int Loki( const Format & format, unsigned int ii )
+    {
+        return ::Loki::BufPrintf( Buffer, format )( Value( ii ) )( -Value( ii ) );
+    }
+};
+
+struct RoundTripLine
+{
+    static const char * Format( void ) { return "x=%.17g y=%.17g\n"; }
+
+    static const char * CachedFormat( void ) { return "x=%r y=%r\n"; }
+
+    static int Snprintf( unsigned int ii )
+    {
+        return ::snprintf( Buffer, sizeof(Buffer), Format(), Value( ii ), -Value( ii ) );
+    }
+
+    static int Stream( ostringstream & out, unsigned int ii )
+    {
+        out << setprecision( 17 ) << "x=" << Value( ii ) << " y=" << -Value( ii ) << '\n';
+        return 0;
+    }
+
+    template < class Format >
+    static int Loki( const Format & format, unsigned int ii )
+    {
+        return ::Loki::BufPrintf( Buffer, format )( Value( ii ) )( -Value( ii ) );
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+/// Returns nanoseconds per line for snprintf.
+template < class Line >
+double TimeSnprintf( void )
+{
+    unsigned int total = 0;
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LineCount; ++ii )
+        total += static_cast< unsigned int >( Line::Snprintf( ii ) );
+    const double stop = GetMilliSeconds();
+    if ( total == 0 )
+        cout << "nothing printed" << endl;
+    return ( stop - start ) * 1000.0 * 1000.0 / LineCount;
+}
+
+/// Returns nanoseconds per line for an ostringstream that is emptied
+/// after each line.
+template < class Line >
+double TimeStream( void )
+{
+    ostringstream out;
+    const string empty;
+    size_t total = 0;
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LineCount; ++ii )
+    {
+        Line::Stream( out, ii );
+        total += static_cast< size_t >( out.tellp() );
+        out.str( empty );
+    }
+    const double stop = GetMilliSeconds();
+    if ( total == 0 )
+        cout << "nothing printed" << endl;
+    return ( stop - start ) * 1000.0 * 1000.0 / LineCount;
+}
+
+/// Returns nanoseconds per line for BufPrintf with format, which is either
+/// a format string or a PrintfFormat.
+template < class Line, class Format >
+double TimeLoki( const Format & format )
+{
+    unsigned int total = 0;
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < LineCount; ++ii )
+        total += static_cast< unsigned int >( Line::Loki( format, ii ) );
+    const double stop = GetMilliSeconds();
+    if ( total == 0 )
+        cout << "nothing printed" << endl;
+    return ( stop - start ) * 1000.0 * 1000.0 / LineCount;
+}
+
+// ----------------------------------------------------------------------------
+
+template < class Line >
+void TimeLine( const char * name, const char * cachedFormat )
+{
+    const ::Loki::PrintfFormat format( cachedFormat );
+    cout << setw( 12 ) << name
+         << setw( 12 ) << TimeSnprintf< Line >()
+         << setw( 12 ) << TimeStream< Line >()
+         << setw( 12 ) << TimeLoki< Line >( Line::Format() )
+         << setw( 14 ) << TimeLoki< Line >( format ) << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "Formatting " << LineCount << " lines of two numbers." << endl;
+    cout << "Times in nanoseconds per line." << endl << endl;
+
+    cout << setw( 12 ) << "line"
+         << setw( 12 ) << "snprintf"
+         << setw( 12 ) << "iostream"
+         << setw( 12 ) << "BufPrintf"
+         << setw( 14 ) << "PrintfFormat" << endl;
+
+    cout << fixed << setprecision( 1 );
+    TimeLine< IntegerLine >( "integer", IntegerLine::Format() );
+    TimeLine< DoubleLine >( "double", DoubleLine::Format() );
+    TimeLine< RoundTripLine >( "round-trip", RoundTripLine::CachedFormat() );
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -18,6 +18,9 @@
 #include <utility>
 #include <cctype>
 #include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <vector>
 
 #include "../SmallObj/timer.h"
 #include "ThreadPool.hpp"
@@ -106,6 +109,17 @@ void TestCase(const string& fmt, T value)
         << "A: [" << s.c_str() << "]" << endl;
         assert(false);
     }
+    std::string s2;
+    const int i3 = SPrintf(s2, PrintfFormat(fmt))(value);
+    if (i1 != i3 || s != s2)
+    {
+        cout << endl
+        << "Reference: " << i1 << "; PrintfFormat: " << i3 << endl
+        << "F: [" << fmt << "]" << endl
+        << "R: [" << s.c_str() << "]" << endl
+        << "A: [" << s2.c_str() << "]" << endl;
+        assert(false);
+    }
 }
 
 template <class T, class U>
@@ -117,6 +131,10 @@ void TestCase2(const string& fmt, T value, U value2)
     const int i2 = snprintf(buf, sizeof(buf), fmt.c_str(), value, value2);
     assert(i1 == i2);
     assert(s == buf);
+    std::string s2;
+    const int i3 = SPrintf(s2, PrintfFormat(fmt))(value)(value2);
+    assert(i1 == i3);
+    assert(s == s2);
 }
 
 // ----------------------------------------------------------------------------
@@ -273,6 +291,119 @@ void FormatTest( void )
 
 // ----------------------------------------------------------------------------
 
+void CachedFormatTest( void )
+{
+    cout << "Starting CachedFormatTest" << endl;
+
+    const PrintfFormat hey( "Hey, %u frobnicators and %u%% %s\n" );
+    assert( hey.ArgumentCount() == 3 );
+    for ( unsigned int i = 0; i < 1000; i += 7 )
+    {
+        char reference[ 128 ];
+        snprintf( reference, sizeof(reference), "Hey, %u frobnicators and %u%% %s\n",
+            i, i * 1000, "twiddlicators" );
+        string result;
+        SPrintf( result, hey )( i )( i * 1000 )( "twiddlicators" );
+        assert( result == reference );
+
+        // straight into a buffer: no terminator, the result is the length
+        char buffer[ 128 ];
+        const int length = BufPrintf( buffer, hey )( i )( i * 1000 )( "twiddlicators" );
+        assert( string( buffer, length ) == reference );
+        (void)length;
+    }
+
+    // '*' width and precision are taken from the arguments
+    {
+        const PrintfFormat stars( "[%*.*d|%-*s|%.*f]" );
+        assert( stars.ArgumentCount() == 7 );
+        string result;
+        SPrintf( result, stars )( 8 )( 5 )( 42 )( -6 )( "ab" )( 2 )( 3.14159 );
+        char reference[ 64 ];
+        snprintf( reference, sizeof(reference), "[%*.*d|%-*s|%.*f]", 8, 5, 42, -6, "ab", 2, 3.14159 );
+        assert( result == reference );
+    }
+
+    // extreme integers
+    {
+        const PrintfFormat extremes( "%ld %lu %lx %lo %+ld" );
+        string result;
+        SPrintf( result, extremes )( LONG_MIN )( ULONG_MAX )( ULONG_MAX )( ULONG_MAX )( LONG_MAX );
+        char reference[ 128 ];
+        snprintf( reference, sizeof(reference), "%ld %lu %lx %lo %+ld",
+            LONG_MIN, ULONG_MAX, ULONG_MAX, ULONG_MAX, LONG_MAX );
+        assert( result == reference );
+    }
+
+    // %r prints the shortest form that reads back as the same double
+    {
+        const PrintfFormat shortest( "%r" );
+        const double values[] = { 0.0, 1.0, -2.5, 0.1, 1.0 / 3.0, 100.0, 1e21, 1e-7,
+            123456789.125, 5e-324, 1.7976931348623157e308, 2.2250738585072014e-308 };
+        const char * expected[] = { "0", "1", "-2.5", "0.1", "0.3333333333333333", "100",
+            "1e+21", "1e-07", "123456789.125", "5e-324", "1.7976931348623157e+308",
+            "2.2250738585072014e-308" };
+        (void)expected;
+        for ( unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); ++i )
+        {
+            string result;
+            SPrintf( result, shortest )( values[ i ] );
+            assert( result == expected[ i ] );
+        }
+        string result;
+        SPrintf( result, PrintfFormat( "[%+8r|%-6r|%08r]" ) )( 0.5 )( 0.25 )( -1.5 );
+        assert( result == "[    +0.5|0.25  |-00001.5]" );
+
+        srand( 0 );
+        for ( unsigned int i = 0; i < 100000; ++i )
+        {
+            const double value = ( rand() - RAND_MAX / 2 ) * ::std::pow( 10.0, rand() % 40 - 20 )
+                / ( rand() + 1 );
+            result.clear();
+            SPrintf( result, shortest )( value );
+            assert( ::strtod( result.c_str(), 0 ) == value );
+        }
+    }
+
+    // malformed formats are rejected when they are parsed
+    const char * malformed[] = { "%", "abc%", "%5", "%k", "%.3" };
+    for ( unsigned int i = 0; i < sizeof(malformed) / sizeof(malformed[0]); ++i )
+    {
+        try
+        {
+            PrintfFormat format( malformed[ i ] );
+            assert( false );
+        }
+        catch ( const ::std::logic_error & ex )
+        {
+            (void)ex;
+        }
+    }
+
+    // too many arguments throw, wrong ones are an error
+    {
+        const PrintfFormat one( "%d" );
+        string result;
+        try
+        {
+            SPrintf( result, one )( 1 )( 2 );
+            assert( false );
+        }
+        catch ( const ::std::logic_error & ex )
+        {
+            (void)ex;
+        }
+        result.clear();
+        const int count = SPrintf( result, one )( "text" );
+        assert( count == -1 );
+        (void)count;
+    }
+
+    cout << "Finished CachedFormatTest" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
 void RandomTest( unsigned int loopCount )
 {
     cout << "Starting RandomTest" << endl;
@@ -491,6 +622,109 @@ void AtomicTest( void )
 
 // ----------------------------------------------------------------------------
 
+static const unsigned int BufferedThreadCount = 8;
+
+static const unsigned int BufferedLineCount = 2000;
+
+static ::Loki::BufferedFile * BufferedTarget = 0;
+
+void * DoBufferedFileLoop( void * p )
+{
+    const uintptr_t threadIndex = reinterpret_cast< uintptr_t >( p );
+    static const ::Loki::PrintfFormat format( "Thread %2u, line %5u, %s.\n" );
+
+    for ( unsigned int line = 0; line < BufferedLineCount; ++line )
+    {
+        // every fragment of a line must land next to the others
+        if ( line % 2 == 0 )
+            ::Loki::FPrintf( *BufferedTarget, "Thread %2u, line %5u, %s.\n" )
+                ( threadIndex )( line )( "frobnicators and twiddlicators" );
+        else
+            ::Loki::FPrintf( *BufferedTarget, format )
+                ( threadIndex )( line )( "frobnicators and twiddlicators" );
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+/// Returns what a printing function writes into a BufferedFile.
+string ReadBack( ::std::FILE * file )
+{
+    ::std::rewind( file );
+    string result;
+    char buffer[ 4096 ];
+    size_t count = 0;
+    while ( ( count = ::std::fread( buffer, 1, sizeof(buffer), file ) ) > 0 )
+        result.append( buffer, count );
+    return result;
+}
+
+string Nested( ::Loki::BufferedFile & file )
+{
+    ::Loki::FPrintf( file, "inner %d\n" )( 2 );
+    return "outer";
+}
+
+void BufferedFileTest( bool backgroundFlusher )
+{
+    cout << "Starting BufferedFileTest" << ( backgroundFlusher ? " with flusher" : "" ) << endl;
+
+    ::std::FILE * file = ::std::tmpfile();
+    assert( file != 0 );
+    {
+        ::Loki::BufferedFile buffered( file, backgroundFlusher );
+        BufferedTarget = &buffered;
+        ThreadPool pool;
+        pool.Create( BufferedThreadCount, &DoBufferedFileLoop );
+        pool.Start();
+        pool.Join();
+        BufferedTarget = 0;
+    }
+
+    // Each line must be whole, and each thread's lines in order.
+    const string text = ReadBack( file );
+    vector< unsigned int > nextLine( BufferedThreadCount + 1, 0 );
+    unsigned int lineCount = 0;
+    for ( size_t begin = 0; begin < text.size(); ++lineCount )
+    {
+        const size_t end = text.find( '\n', begin );
+        assert( end != string::npos );
+        unsigned int thread = 0, line = 0;
+        char tail[ 64 ] = "";
+        const int fields = ::sscanf( text.c_str() + begin, "Thread %2u, line %5u, %63[^.\n]",
+            &thread, &line, tail );
+        assert( fields == 3 );
+        assert( 0 < thread && thread <= BufferedThreadCount );
+        assert( line == nextLine[ thread ] );
+        assert( string( tail ) == "frobnicators and twiddlicators" );
+        assert( text.compare( end - 1, 1, "." ) == 0 );
+        (void)fields;
+        ++nextLine[ thread ];
+        begin = end + 1;
+    }
+    assert( lineCount == BufferedThreadCount * BufferedLineCount );
+    ::std::fclose( file );
+
+    // An expression evaluated inside another one goes out first, whole.
+    file = ::std::tmpfile();
+    assert( file != 0 );
+    {
+        ::Loki::BufferedFile buffered( file, backgroundFlusher );
+        const int count = ::Loki::FPrintf( buffered, "%s %d\n" )( Nested( buffered ) )( 1 );
+        assert( count == 8 );
+        (void)count;
+        buffered.Flush();
+        assert( ReadBack( file ) == "inner 2\nouter 1\n" );
+    }
+    ::std::fclose( file );
+
+    cout << "Finished BufferedFileTest" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
 class CommandLineArgs
 {
 public:
@@ -503,6 +737,8 @@ public:
     inline bool DoSpeedTest( void ) const { return ( 0 < m_speedLoopCount ); }
     inline bool DoRandomTest( void ) const { return ( 0 < m_randomLoopCount ); }
     inline bool DoFormatTest( void ) const { return m_doFormatTest; }
+    inline bool DoCachedFormatTest( void ) const { return m_doCachedFormatTest; }
+    inline bool DoBufferedFileTest( void ) const { return m_doBufferedFileTest; }
 	inline bool DoAtomicTest( void ) const { return m_doAtomicTest; }
     inline bool DoShowHelp( void ) const { return m_showHelp; }
 
@@ -513,6 +749,8 @@ private:
     unsigned int m_speedLoopCount;
     unsigned int m_randomLoopCount;
     bool m_doFormatTest;
+    bool m_doCachedFormatTest;
+    bool m_doBufferedFileTest;
 	bool m_doAtomicTest;
     bool m_showHelp;
     const char * m_exeName;
@@ -524,6 +762,8 @@ CommandLineArgs::CommandLineArgs( unsigned int argc, const char * argv[] ) :
     m_speedLoopCount( 0 ),
     m_randomLoopCount( 0 ),
     m_doFormatTest( false ),
+    m_doCachedFormatTest( false ),
+    m_doBufferedFileTest( false ),
 	m_doAtomicTest( false ),
     m_showHelp( false ),
     m_exeName( argv[0] )
@@ -551,6 +791,8 @@ CommandLineArgs::CommandLineArgs( unsigned int argc, const char * argv[] ) :
             default: isValid = false; break;
             case 'h': m_showHelp = true; break;
             case 'f': m_doFormatTest = true; break;
+            case 'c': m_doCachedFormatTest = true; break;
+            case 'b': m_doBufferedFileTest = true; break;
 			case 'a': m_doAtomicTest = true; break;
 
             case 'r':
@@ -584,6 +826,8 @@ CommandLineArgs::CommandLineArgs( unsigned int argc, const char * argv[] ) :
         m_speedLoopCount = 0;
         m_randomLoopCount = 0;
         m_doFormatTest = false;
+        m_doCachedFormatTest = false;
+        m_doBufferedFileTest = false;
     }
 }
 
@@ -591,9 +835,11 @@ CommandLineArgs::CommandLineArgs( unsigned int argc, const char * argv[] ) :
 
 void CommandLineArgs::ShowHelp( void ) const
 {
-    cout << "Usage: " << m_exeName << " [-h] [-f] [-r:#] [-s:#]" << endl;
+    cout << "Usage: " << m_exeName << " [-h] [-f] [-c] [-b] [-r:#] [-s:#]" << endl;
     cout << " -h    Show this help info and exit. Overrides all other options." << endl;
     cout << " -f    Run formatting tests." << endl;
+    cout << " -c    Run tests of formats parsed once by PrintfFormat." << endl;
+    cout << " -b    Run tests of BufferedFile with several threads." << endl;
 	cout << " -a    Run atomic tests." << endl;
     cout << " -r:#  Run random tests for # of loops. # is a positive decimal value greater than 100." << endl;
     cout << " -s:#  Run speed tests for # of loops. # is a positive decimal value greater than 100." << endl;
@@ -623,6 +869,15 @@ int main( int argc, const char * argv[] )
     if ( args.DoFormatTest() )
     {
         FormatTest();
+    }
+    if ( args.DoCachedFormatTest() )
+    {
+        CachedFormatTest();
+    }
+    if ( args.DoBufferedFileTest() )
+    {
+        BufferedFileTest( false );
+        BufferedFileTest( true );
     }
 	if ( args.DoAtomicTest() )
 	{
@@ -0,0 +1,199 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark calls SingletonHolder::Instance from many threads.
+/// ClassLevelLockable reads the instance pointer without any ordering, which
+/// is fast but only safe by luck.  DoubleCheckedLockable does an acquire load
+/// instead.  Locked takes the class lock on every call, which is what a
+/// correct Instance would cost without double-checked locking.
+
+
+#define LOKI_CLASS_LEVEL_THREADING
+#include <loki/Singleton.h>
+
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+#include "../BenchTimer.h"
+
+#if defined(_WIN32)
+
+    #include <process.h>
+
+    typedef unsigned int ( WINAPI * ThreadFunction_ )( void * );
+
+    #define LOKI_pthread_t HANDLE
+
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+        (int)((*handle=(HANDLE) _beginthreadex (NULL,0,(ThreadFunction_)func,arg,0,NULL))==NULL)
+
+    #define LOKI_pthread_join(thread) \
+        ((::WaitForSingleObject((thread),INFINITE)!=WAIT_OBJECT_0) || !CloseHandle(thread))
+
+#else
+
+    #define LOKI_pthread_t \
+                 pthread_t
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+                 pthread_create(handle,attr,func,arg)
+    #define LOKI_pthread_join(thread) \
+                 pthread_join(thread, NULL)
+
+#endif
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int MaxThreadCount = 64;
+
+static const unsigned int TotalLoops = 16 * 1000 * 1000;
+
+static unsigned int LoopsPerThread = 0;
+
+// ----------------------------------------------------------------------------
+
+/// Counts how often each kind of Thing gets constructed.
+static volatile long ConstructionCount[ 3 ] = { 0, 0, 0 };
+
+template < unsigned int Id >
+class Thing
+{
+public:
+    Thing( void ) : value_( Id + 1 )
+    {
+        ++ConstructionCount[ Id ];
+    }
+
+    unsigned int GetValue( void ) const { return value_; }
+
+private:
+    unsigned int value_;
+};
+
+typedef ::Loki::SingletonHolder< Thing< 0 >, ::Loki::CreateUsingNew,
+    ::Loki::DefaultLifetime, ::Loki::ClassLevelLockable > ClassLevelThing;
+
+typedef ::Loki::SingletonHolder< Thing< 1 >, ::Loki::CreateUsingNew,
+    ::Loki::DefaultLifetime, ::Loki::DoubleCheckedLockable > DoubleCheckedThing;
+
+/// Host class for the lock used by RunLockedTest.
+class LockedHost : public ::Loki::ClassLevelLockable< LockedHost >
+{
+};
+
+// ----------------------------------------------------------------------------
+
+template < class Holder >
+void * RunInstanceTest( void * )
+{
+    unsigned int sum = 0;
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+        sum += Holder::Instance().GetValue();
+    assert( sum == LoopsPerThread * Holder::Instance().GetValue() );
+    (void)sum;
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+void * RunLockedTest( void * )
+{
+    unsigned int sum = 0;
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ++ii )
+    {
+        LockedHost::Lock guard;
+        (void)guard;
+        sum += ClassLevelThing::Instance().GetValue();
+    }
+    assert( sum == LoopsPerThread * ClassLevelThing::Instance().GetValue() );
+    (void)sum;
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+double RunThreads( unsigned int threadCount, void * ( * function )( void * ) )
+{
+    assert( threadCount <= MaxThreadCount );
+    LOKI_pthread_t threads[ MaxThreadCount ];
+    LoopsPerThread = TotalLoops / threadCount;
+
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_create( &threads[ ii ], NULL, function, NULL );
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_join( threads[ ii ] );
+    const double stop = GetMilliSeconds();
+
+    return stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    // All threads race to make the singleton, but only one may construct it.
+    RunThreads( MaxThreadCount, &RunInstanceTest< DoubleCheckedThing > );
+    RunThreads( MaxThreadCount, &RunInstanceTest< ClassLevelThing > );
+    const bool once = ( 1 == ConstructionCount[ 0 ] )
+        && ( 1 == ConstructionCount[ 1 ] );
+
+    cout << "SingletonHolder::Instance calls, "
+         << TotalLoops << " calls split across all threads." << endl;
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+    cout << "DoubleCheckedLockable uses lock-free acquire loads." << endl;
+#else
+    cout << "DoubleCheckedLockable uses a mutex." << endl;
+#endif
+    cout << "Times in milliseconds." << endl << endl;
+
+    cout << setw( 8 ) << "threads"
+         << setw( 14 ) << "ClassLevel"
+         << setw( 14 ) << "DoubleChecked"
+         << setw( 14 ) << "Locked" << endl;
+
+    for ( unsigned int count = 1; count <= MaxThreadCount; count *= 2 )
+    {
+        cout << setw( 8 ) << count;
+        cout << setw( 14 ) << RunThreads( count, &RunInstanceTest< ClassLevelThing > );
+        cout << setw( 14 ) << RunThreads( count, &RunInstanceTest< DoubleCheckedThing > );
+        cout << setw( 14 ) << RunThreads( count, &RunLockedTest );
+        cout << endl;
+    }
+
+    cout << endl << ( once ? "Each singleton was made once." :
+        "A singleton was made more than once!" ) << endl;
+
+    return once ? 0 : 1;
+}
+
+// ----------------------------------------------------------------------------
@@ -333,6 +333,171 @@ void testSize()
 
 // ----------------------------------------------------------------------------
 
+/// Prints the counters of one size class of the allocator.
+void printStats( const Loki::SmallObjStats & stats )
+{
+    cout << "  chunks: " << stats.GetChunkCount()
+         << "  in use: " << stats.bytesInUse_
+         << "  reserved: " << stats.bytesReserved_
+         << "  fragmentation: " << stats.GetFragmentation() << endl;
+    cout << "  allocations: " << stats.allocations_
+         << "  slow: " << stats.allocSlowPaths_
+         << "  chunks searched: " << stats.chunksSearched_
+         << "  deallocations: " << stats.deallocations_
+         << "  slow: " << stats.deallocSlowPaths_ << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+/** Shows how the chunk size changes the cost of filling the allocator, and
+ the cost of TrimExcessMemory when every Chunk is half full.  Bigger chunks
+ mean fewer Chunks for the same number of objects, so the trim, which walks
+ all Chunks, gets cheaper.
+ */
+template< unsigned int Size, std::size_t chunkSize >
+void testChunkSize( void )
+{
+    typedef Base< Size, Loki::SmallValueObject< ::Loki::SingleThreaded, chunkSize,
+        128, 4, ::Loki::NoDestroy, ::Loki::Mutex > > C;
+    typedef Loki::AllocatorSingleton< ::Loki::SingleThreaded, chunkSize,
+        128, 4, ::Loki::NoDestroy, ::Loki::Mutex > AllocatorSingleton;
+
+    const int Narr = 1000*1000;
+    C ** arr = new C*[Narr];
+    Timer t;
+    t.t100 = 0;
+
+    cout << Size << " bytes big objects, chunk size " << chunkSize << endl;
+
+    // Untimed pass so first-touch page faults do not hide the chunk size.
+    for (int i=0; i<Narr; ++i)
+        arr[i] = new C;
+    for (int i=0; i<Narr; ++i)
+        delete arr[i];
+    AllocatorSingleton::ClearExtraMemory();
+
+    t.start();
+    for (int i=0; i<Narr; ++i)
+        arr[i] = new C;
+    t.stop();
+    t.print(t.t(),"'arr[i] = new T'      :");
+
+    t.start();
+    for (int i=0; i<Narr; i+=2)
+        delete arr[i];
+    t.stop();
+    t.print(t.t(),"'delete arr[2*i]'     :");
+
+    if ( Loki::SmallObjAllocator::HasStats() )
+        printStats( AllocatorSingleton::GetSizeClassStats( ( sizeof(C) + 3 ) / 4 - 1 ) );
+
+    t.start();
+    AllocatorSingleton::ClearExtraMemory();
+    t.stop();
+    t.print(t.t(),"'TrimExcessMemory'    :");
+
+    for (int i=1; i<Narr; i+=2)
+        delete arr[i];
+    delete [] arr;
+
+    assert( (!AllocatorSingleton::IsCorrupted()) );
+    AllocatorSingleton::ClearExtraMemory();
+    cout << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+void DoChunkSizeTest (void)
+{
+    cout << endl;
+    cout << "Allocator Benchmark Tests with different chunk sizes" << endl;
+    cout << endl;
+    testChunkSize<  8,  4096 >();
+    testChunkSize<  8, 16384 >();
+    testChunkSize<  8, 65536 >();
+    testChunkSize< 32,  4096 >();
+    testChunkSize< 32, 65536 >();
+    cout << "_________________________________________________________________" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+/** Compares the page sources.  HeapPageSource takes each Chunk from the heap
+ with an aligned malloc, while MappedPageSource carves Chunks out of big
+ mapped regions, and keeps released Chunks for reuse until TrimExcessMemory
+ gives their pages back with MADV_DONTNEED.  An untimed pass first touches
+ all the memory, so the timed pass reuses it.  The refill after the trim
+ shows what faulting the trimmed pages back in costs.
+ */
+template< unsigned int Size, std::size_t chunkSize, class PageSourcePolicy >
+void testPageSource( const char * name )
+{
+    typedef Base< Size, Loki::SmallValueObject< ::Loki::SingleThreaded, chunkSize,
+        128, 4, ::Loki::NoDestroy, ::Loki::Mutex, PageSourcePolicy > > C;
+    typedef Loki::AllocatorSingleton< ::Loki::SingleThreaded, chunkSize,
+        128, 4, ::Loki::NoDestroy, ::Loki::Mutex, PageSourcePolicy > AllocatorSingleton;
+
+    const int Narr = 1000*1000;
+    C ** arr = new C*[Narr];
+    Timer t;
+    t.t100 = 0;
+
+    cout << Size << " bytes big objects, chunk size " << chunkSize
+         << ", " << name << endl;
+
+    for (int i=0; i<Narr; ++i)
+        arr[i] = new C;
+    for (int i=0; i<Narr; ++i)
+        delete arr[i];
+
+    t.start();
+    for (int i=0; i<Narr; ++i)
+        arr[i] = new C;
+    t.stop();
+    t.print(t.t(),"'arr[i] = new T'      :");
+
+    t.start();
+    for (int i=0; i<Narr; ++i)
+        delete arr[i];
+    t.stop();
+    t.print(t.t(),"'delete arr[i]'       :");
+
+    t.start();
+    AllocatorSingleton::ClearExtraMemory();
+    t.stop();
+    t.print(t.t(),"'TrimExcessMemory'    :");
+
+    t.start();
+    for (int i=0; i<Narr; ++i)
+        arr[i] = new C;
+    t.stop();
+    t.print(t.t(),"'new T' after trim    :");
+
+    for (int i=0; i<Narr; ++i)
+        delete arr[i];
+    delete [] arr;
+
+    assert( (!AllocatorSingleton::IsCorrupted()) );
+    AllocatorSingleton::ClearExtraMemory();
+    cout << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+void DoPageSourceTest (void)
+{
+    cout << endl;
+    cout << "Allocator Benchmark Tests with different page sources" << endl;
+    cout << endl;
+    testPageSource<  8,  4096, ::Loki::HeapPageSource >( "HeapPageSource" );
+    testPageSource<  8,  4096, ::Loki::MappedPageSource >( "MappedPageSource" );
+    testPageSource< 32, 65536, ::Loki::HeapPageSource >( "HeapPageSource" );
+    testPageSource< 32, 65536, ::Loki::MappedPageSource >( "MappedPageSource" );
+    cout << "_________________________________________________________________" << endl;
+}
+
+// ----------------------------------------------------------------------------
+
 void DoSingleThreadTest (void)
 {
     const int loop = 1000*1000;
@@ -375,6 +540,10 @@ void DoClassLockTest (void)
 
 int main()
 {
+    DoChunkSizeTest();
+
+    DoPageSourceTest();
+
     DoSingleThreadTest();
 
 #if defined(LOKI_CLASS_LEVEL_THREADING)
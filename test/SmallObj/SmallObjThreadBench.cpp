@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Permission to use, copy, modify, distribute and sell this software for any
+//     purpose is hereby granted without fee, provided that the above copyright
+//     notice appear in all copies and that both that copyright notice and this
+//     permission notice appear in supporting documentation.
+// The authors make no representations about the
+//     suitability of this software for any purpose. It is provided "as is"
+//     without express or implied warranty.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+// ----------------------------------------------------------------------------
+
+#ifndef LOKI_CLASS_LEVEL_THREADING
+#define LOKI_CLASS_LEVEL_THREADING
+#endif
+
+#include <loki/SmallObj.h>
+
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+#include "../BenchTimer.h"
+
+#if defined(_WIN32)
+
+    #include <process.h>
+
+    typedef unsigned int ( WINAPI * ThreadFunction_ )( void * );
+
+    #define LOKI_pthread_t HANDLE
+
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+        (int)((*handle=(HANDLE) _beginthreadex (NULL,0,(ThreadFunction_)func,arg,0,NULL))==NULL)
+
+    #define LOKI_pthread_join(thread) \
+        ((::WaitForSingleObject((thread),INFINITE)!=WAIT_OBJECT_0) || !CloseHandle(thread))
+
+#else
+
+    #define LOKI_pthread_t \
+                 pthread_t
+    #define LOKI_pthread_create(handle,attr,func,arg) \
+                 pthread_create(handle,attr,func,arg)
+    #define LOKI_pthread_join(thread) \
+                 pthread_join(thread, NULL)
+
+#endif
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int MaxThreadCount = 16;
+
+static const unsigned int TotalLoops = 2 * 1000 * 1000;
+
+static const unsigned int BatchSize = 100;
+
+static unsigned int LoopsPerThread = 0;
+
+// ----------------------------------------------------------------------------
+
+template < template < class, class > class ThreadingModel, unsigned int Size >
+class Thing : public ::Loki::SmallValueObject< ThreadingModel >
+{
+    char data_[ Size ];
+};
+
+/// Blocks handed from one thread to the next, so they get freed by a thread
+/// other than the one which allocated them.
+static void * Handoff[ MaxThreadCount ][ BatchSize ];
+
+// ----------------------------------------------------------------------------
+
+template < template < class, class > class ThreadingModel >
+void * RunLocalTest( void * )
+{
+    typedef Thing< ThreadingModel, 16 > Small;
+    typedef Thing< ThreadingModel, 48 > Medium;
+    Small * smalls[ BatchSize ];
+    Medium * mediums[ BatchSize ];
+    for ( unsigned int ii = 0; ii < LoopsPerThread; ii += BatchSize )
+    {
+        for ( unsigned int jj = 0; jj < BatchSize; ++jj )
+        {
+            smalls[ jj ] = new Small;
+            mediums[ jj ] = new Medium;
+        }
+        for ( unsigned int jj = 0; jj < BatchSize; ++jj )
+        {
+            delete smalls[ jj ];
+            delete mediums[ jj ];
+        }
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+template < template < class, class > class ThreadingModel >
+void * RunCrossThreadTest( void * p )
+{
+    typedef Thing< ThreadingModel, 24 > Object;
+    const unsigned int threadIndex = static_cast< unsigned int >(
+        reinterpret_cast< size_t >( p ) );
+    for ( unsigned int jj = 0; jj < BatchSize; ++jj )
+        Handoff[ threadIndex ][ jj ] = new Object;
+    return NULL;
+}
+
+template < template < class, class > class ThreadingModel >
+void * FreeCrossThreadTest( void * p )
+{
+    typedef Thing< ThreadingModel, 24 > Object;
+    const unsigned int threadIndex = static_cast< unsigned int >(
+        reinterpret_cast< size_t >( p ) );
+    for ( unsigned int jj = 0; jj < BatchSize; ++jj )
+        delete static_cast< Object * >( Handoff[ threadIndex ][ jj ] );
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+
+double RunThreads( unsigned int threadCount, void * ( * function )( void * ) )
+{
+    assert( threadCount <= MaxThreadCount );
+    LOKI_pthread_t threads[ MaxThreadCount ];
+    LoopsPerThread = TotalLoops / threadCount;
+
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_create( &threads[ ii ], NULL, function,
+            reinterpret_cast< void * >( ii ) );
+    for ( unsigned int ii = 0; ii < threadCount; ++ii )
+        LOKI_pthread_join( threads[ ii ] );
+    const double stop = GetMilliSeconds();
+
+    return stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+template < template < class, class > class ThreadingModel >
+bool IsCorrupted( void )
+{
+    typedef ::Loki::AllocatorSingleton< ThreadingModel > AllocatorSingleton;
+    return AllocatorSingleton::IsCorrupted();
+}
+
+// ----------------------------------------------------------------------------
+
+int main( void )
+{
+    cout << "Allocation + deallocation of " << TotalLoops
+         << " pairs of 16 and 48 byte objects split across all threads." << endl;
+    cout << "Times in milliseconds." << endl << endl;
+
+    cout << setw( 8 ) << "threads"
+         << setw( 16 ) << "ClassLevel"
+         << setw( 16 ) << "ThreadCached" << endl;
+
+    for ( unsigned int count = 1; count <= MaxThreadCount; count *= 2 )
+    {
+        cout << setw( 8 ) << count;
+        cout << setw( 16 ) << RunThreads( count, &RunLocalTest< ::Loki::ClassLevelLockable > );
+        cout << setw( 16 ) << RunThreads( count, &RunLocalTest< ::Loki::ThreadCachedLockable > );
+        cout << endl;
+    }
+
+    // Each thread allocates a batch, and a later thread frees it.
+    RunThreads( MaxThreadCount, &RunCrossThreadTest< ::Loki::ThreadCachedLockable > );
+    RunThreads( MaxThreadCount, &FreeCrossThreadTest< ::Loki::ThreadCachedLockable > );
+
+    const bool corrupt = IsCorrupted< ::Loki::ClassLevelLockable >()
+        || IsCorrupted< ::Loki::ThreadCachedLockable >();
+    cout << endl << ( corrupt ? "Allocator is corrupt!" : "Allocator is not corrupt." ) << endl;
+
+    return corrupt ? 1 : 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -44,25 +44,25 @@ public:
         return t1-t0;
     }
 
-    double sec(int t)
+    double sec(clock_t t)
     { 
         return floor(100.0*double(t)/1000.0 )/100.0; 
     }
     
-    int rel(int t)
+    int rel(clock_t t)
     {
-        return ( t100==0 ? 100 : static_cast<int>(floor(100.0*t/t100+0.5)) ); 
+        return ( t100==0 ? 100 : static_cast<int>(floor(100.0*double(t)/t100+0.5)) ); 
     }
     
-    double speedup(int t)
+    double speedup(clock_t t)
     {
-        double tup=t;
+        double tup=double(t);
         return (tup!=0 ? floor(100.0*(t100!=0?t100:tup)/tup+0.5)/100 : 1);
     }
 
     double  t100;
 
-    void print(int t, const char* s)
+    void print(clock_t t, const char* s)
     {
         std::cout << s << "\tseconds: " << sec(t) << "\trelative time: " << rel(t) << "%\tspeed-up factor: " << speedup(t) << "" << std::endl;
     }
@@ -474,6 +474,99 @@ void DoLockedStorageTest( void )
 
 // ----------------------------------------------------------------------------
 
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+/// Pointee which knows how many of its kind are alive, and which spoils its
+/// value when destroyed, so a reader of a dead pointee would notice.
+class Survivor
+{
+public:
+    typedef ::Loki::AtomicOps< int > Ops;
+
+    Survivor( void ) : m_value( 42 ) { Ops::Add( s_alive, 1 ); }
+
+    ~Survivor( void )
+    {
+        m_value = 0;
+        Ops::Add( s_alive, -1 );
+    }
+
+    int GetValue( void ) const { return m_value; }
+
+    static int GetAliveCount( void ) { return Ops::Load( s_alive ); }
+
+private:
+    volatile int m_value;
+    static volatile int s_alive;
+};
+
+volatile int Survivor::s_alive = 0;
+
+typedef ::Loki::StrongPtr< Survivor, true, LockFreeTwoRefCounts, DisallowConversion,
+    NoCheck, NeverReset, DeleteSingle, DontPropagateConst >
+    Survivor_LockFree_ptr;
+
+typedef ::Loki::StrongPtr< Survivor, false, LockFreeTwoRefCounts, DisallowConversion,
+    NoCheck, NeverReset, DeleteSingle, DontPropagateConst >
+    Survivor_LockFree_weak_ptr;
+
+static Survivor_LockFree_weak_ptr * s_survivorWatcher = NULL;
+
+static const unsigned int UpgradeLoops = 20000;
+
+// ----------------------------------------------------------------------------
+
+/// Makes strong and weak copies of the shared weak pointer while the main
+/// thread destroys the last strong pointer.
+void * RunLockFree( void * id )
+{
+    (void)id;
+    for ( unsigned int ii = 0; ii < UpgradeLoops; ++ii )
+    {
+        Survivor_LockFree_ptr strong( *s_survivorWatcher );
+        if ( strong )
+        {
+            assert( 42 == strong->GetValue() );
+            Survivor_LockFree_weak_ptr weak( strong );
+            Survivor_LockFree_ptr again( weak );
+            assert( again );
+        }
+        Survivor_LockFree_weak_ptr weak( *s_survivorWatcher );
+        Survivor_LockFree_ptr other( weak );
+        assert( !other || ( 42 == other->GetValue() ) );
+    }
+    return 0;
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+
+void DoLockFreeCountsTest( void )
+{
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+    cout << "Starting DoLockFreeCountsTest." << endl;
+    for ( unsigned int round = 0; round < 10; ++round )
+    {
+        Survivor_LockFree_ptr * owner = new Survivor_LockFree_ptr( new Survivor );
+        s_survivorWatcher = new Survivor_LockFree_weak_ptr( *owner );
+        ThreadPool pool;
+        pool.Create( 4, RunLockFree );
+        pool.Start();
+        delete owner;
+        pool.Join();
+        assert( 0 == Survivor::GetAliveCount() );
+        assert( !Survivor_LockFree_ptr( *s_survivorWatcher ) );
+        delete s_survivorWatcher;
+        s_survivorWatcher = NULL;
+    }
+    assert( 0 == Survivor::GetAliveCount() );
+    cout << "Finished DoLockFreeCountsTest." << endl;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
 #endif //#ifdef using multi-threaded model
 
 // ----------------------------------------------------------------------------
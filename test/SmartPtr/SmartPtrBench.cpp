@@ -0,0 +1,225 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark compares pointees whose counts are allocated apart
+/// from them (RefCounted and TwoRefCounts) with pointees made together with
+/// their counts by MakeSmart and MakeStrong.  It times making and destroying
+/// the pointees, and copying pointers to pointees scattered across the heap,
+/// which touches both the count and the pointee.  It also compares the two
+/// thread-safe StrongPtr policies, LockableTwoRefCounts, which locks a mutex
+/// in the counts, and LockFreeTwoRefCounts, which uses atomic operations.
+/// Class-level threading is on, so that those policies exist, and so the
+/// other policies lock their allocators as in a multi-threaded program.
+
+
+#define LOKI_CLASS_LEVEL_THREADING
+
+#include <loki/SmartPtr.h>
+#include <loki/StrongPtr.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int ObjectCount = 200 * 1000;
+
+static const unsigned int CopyLoops = 20;
+
+// ----------------------------------------------------------------------------
+
+class Thing
+{
+public:
+    Thing( void ) : m_value( 1 ) {}
+    explicit Thing( unsigned int value ) : m_value( value ) {}
+    unsigned int GetValue( void ) const { return m_value; }
+private:
+    unsigned int m_value;
+    char m_padding[ 28 ];
+};
+
+typedef ::Loki::SmartPtr< Thing, ::Loki::RefCounted > RefCountedPtr;
+
+typedef ::Loki::SmartPtr< Thing, ::Loki::MadeRefCounted > MadeRefCountedPtr;
+
+typedef ::Loki::StrongPtr< Thing, true, ::Loki::TwoRefCounts > TwoRefCountsPtr;
+
+typedef ::Loki::StrongPtr< Thing, true, ::Loki::MadeTwoRefCounts,
+    ::Loki::DisallowConversion, ::Loki::AssertCheck, ::Loki::NeverReset >
+    MadeTwoRefCountsPtr;
+
+typedef ::Loki::StrongPtr< Thing, true, ::Loki::LockableTwoRefCounts >
+    LockableTwoRefCountsPtr;
+
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+typedef ::Loki::StrongPtr< Thing, true, ::Loki::LockFreeTwoRefCounts >
+    LockFreeTwoRefCountsPtr;
+#endif
+
+// ----------------------------------------------------------------------------
+
+template < class Ptr > struct Maker
+{
+    static Ptr Make( unsigned int value ) { return Ptr( new Thing( value ) ); }
+};
+
+template <> struct Maker< MadeRefCountedPtr >
+{
+    static MadeRefCountedPtr Make( unsigned int value )
+    {
+        return ::Loki::MakeSmart< MadeRefCountedPtr >( value );
+    }
+};
+
+template <> struct Maker< MadeTwoRefCountsPtr >
+{
+    static MadeTwoRefCountsPtr Make( unsigned int value )
+    {
+        return ::Loki::MakeStrong< MadeTwoRefCountsPtr >( value );
+    }
+};
+
+// ----------------------------------------------------------------------------
+
+/// Times making and then destroying ObjectCount pointees.
+template < class Ptr >
+double TimeCreation( void )
+{
+    vector< Ptr > pointers;
+    pointers.reserve( ObjectCount );
+    const double start = GetMilliSeconds();
+    for ( unsigned int ii = 0; ii < ObjectCount; ++ii )
+        pointers.push_back( Maker< Ptr >::Make( ii ) );
+    pointers.clear();
+    const double stop = GetMilliSeconds();
+    return stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+/** Makes pointees in between other allocations, and times how long it takes
+ to copy each pointer and read its pointee.
+ @param shuffle True to visit the pointees in random order, false to visit
+  them in the order they were made.
+ */
+template < class Ptr >
+double TimeCopies( bool shuffle )
+{
+    vector< Ptr > pointers;
+    vector< char * > clutter;
+    pointers.reserve( ObjectCount );
+    clutter.reserve( ObjectCount );
+    for ( unsigned int ii = 0; ii < ObjectCount; ++ii )
+    {
+        pointers.push_back( Maker< Ptr >::Make( ii ) );
+        clutter.push_back( new char[ 48 + ( ii % 7 ) * 16 ] );
+    }
+    if ( shuffle )
+    {
+        ::srand( 42 );
+        random_shuffle( pointers.begin(), pointers.end() );
+    }
+
+    // Copies go into another vector so the compiler can not fold away the
+    // count changes, and each copy releases the one made in the last loop.
+    vector< Ptr > copies( ObjectCount );
+    unsigned int sum = 0;
+    const double start = GetMilliSeconds();
+    for ( unsigned int loop = 0; loop < CopyLoops; ++loop )
+    {
+        for ( unsigned int ii = 0; ii < ObjectCount; ++ii )
+        {
+            copies[ ii ] = pointers[ ii ];
+            sum += copies[ ii ]->GetValue();
+        }
+    }
+    const double stop = GetMilliSeconds();
+
+    assert( sum == CopyLoops * ( ObjectCount * ( ObjectCount - 1 ) / 2 ) );
+    (void)sum;
+    for ( unsigned int ii = 0; ii < ObjectCount; ++ii )
+        delete [] clutter[ ii ];
+    return stop - start;
+}
+
+// ----------------------------------------------------------------------------
+
+template < class Ptr >
+void RunTests( const char * name )
+{
+    cout << setw( 20 ) << name
+         << setw( 12 ) << TimeCreation< Ptr >()
+         << setw( 12 ) << TimeCopies< Ptr >( false )
+         << setw( 12 ) << TimeCopies< Ptr >( true ) << endl;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "Making and destroying " << ObjectCount << " pointees, and copying "
+         << ObjectCount << " pointers " << CopyLoops << " times." << endl;
+    cout << "Times in milliseconds." << endl << endl;
+
+    cout << setw( 20 ) << "policy"
+         << setw( 12 ) << "create"
+         << setw( 12 ) << "in order"
+         << setw( 12 ) << "shuffled" << endl;
+
+    RunTests< RefCountedPtr >( "RefCounted" );
+    RunTests< MadeRefCountedPtr >( "MadeRefCounted" );
+    RunTests< TwoRefCountsPtr >( "TwoRefCounts" );
+    RunTests< MadeTwoRefCountsPtr >( "MadeTwoRefCounts" );
+    RunTests< LockableTwoRefCountsPtr >( "LockableTwoRefCounts" );
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+    RunTests< LockFreeTwoRefCountsPtr >( "LockFreeTwoRefCounts" );
+#endif
+
+    cout << endl << "Counts of LockableTwoRefCounts take "
+         << sizeof( ::Loki::Private::LockableTwoRefCountInfo ) << " bytes";
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+    cout << ", counts of LockFreeTwoRefCounts take "
+         << sizeof( ::Loki::Private::LockFreeTwoRefCountInfo ) << " bytes";
+#endif
+    cout << "." << endl;
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
@@ -38,9 +38,12 @@ extern void DoStrongCompareTests( void );
 extern void DoStrongPtrDynamicCastTests( void );
 extern void DoSingleOwnerTests( void );
 extern void DoStrongArrayTests( void );
+extern void DoMadeStrongTests( void );
+extern void DoLockFreeRefCountTests( void );
 
 extern void DoLockedPtrTest( void );
 extern void DoLockedStorageTest( void );
+extern void DoLockFreeCountsTest( void );
 
 extern void TryColvinGibbonsTrick( void );
 
@@ -1624,6 +1627,119 @@ void DoSmartArrayTests( void )
 
 // ----------------------------------------------------------------------------
 
+/// @note These are used for testing MakeSmart.
+
+typedef Loki::SmartPtr< BaseClass, MadeRefCounted, DisallowConversion,
+    NoCheck, DefaultSPStorage, DontPropagateConst >
+    NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr;
+
+typedef Loki::SmartPtr< PublicSubClass, MadeRefCounted, DisallowConversion,
+    NoCheck, DefaultSPStorage, DontPropagateConst >
+    PublicSub_MadeCount_NoConvert_NoCheck_DontPropagate_ptr;
+
+typedef Loki::SmartPtr< BaseClass, MadeRefCountedMTAdj< SingleThreaded >::RefCountedMT,
+    DisallowConversion, NoCheck, DefaultSPStorage, DontPropagateConst >
+    NonConstBase_MadeCountMT_NoConvert_NoCheck_DontPropagate_ptr;
+
+/// Pointee whose constructor takes parameters, and may throw.
+class Made
+{
+public:
+    Made( int value, const char * name ) : m_value( value ), m_name( name )
+    {
+        if ( value < 0 )
+            throw ::std::invalid_argument( name );
+    }
+    int GetValue( void ) const { return m_value; }
+    const char * GetName( void ) const { return m_name; }
+private:
+    int m_value;
+    const char * m_name;
+};
+
+typedef Loki::SmartPtr< Made, MadeRefCounted > Made_ptr;
+
+// ----------------------------------------------------------------------------
+
+void DoMadeRefCountTests( void )
+{
+    cout << "Starting DoMadeRefCountTests." << endl;
+
+    BaseClass * pNull = NULL; (void) pNull;
+    const unsigned int ctorCount = BaseClass::GetCtorCount(); (void) ctorCount;
+    const unsigned int dtorCount = BaseClass::GetDtorCount(); (void) dtorCount;
+    assert( BaseClass::GetCtorCount() == BaseClass::GetDtorCount() );
+
+    {
+        NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr p0;
+        assert( !p0 );
+        assert( p0 == pNull );
+        NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr p1( p0 );
+        assert( !p1 );
+
+        p1 = MakeSmart< NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr >();
+        assert( p1 );
+        assert( ctorCount + 1 == BaseClass::GetCtorCount() );
+        {
+            NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr p2( p1 );
+            p0 = p2;
+            assert( p0 == p1 );
+            assert( p2 == p1 );
+        }
+        p1 = p0;
+        p0 = NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr();
+        assert( dtorCount == BaseClass::GetDtorCount() );
+        p1->DoThat();
+        p1 = p0;
+        // The last copointer destroyed the pointee.
+        assert( dtorCount + 1 == BaseClass::GetDtorCount() );
+    }
+    assert( BaseClass::AllDestroyed() );
+
+    {
+        // The count stays with the block even after converting to a base type.
+        PublicSub_MadeCount_NoConvert_NoCheck_DontPropagate_ptr sub =
+            MakeSmart< PublicSub_MadeCount_NoConvert_NoCheck_DontPropagate_ptr >();
+        NonConstBase_MadeCount_NoConvert_NoCheck_DontPropagate_ptr base( sub );
+        sub = PublicSub_MadeCount_NoConvert_NoCheck_DontPropagate_ptr();
+        assert( BaseClass::ExtraConstructions() );
+        base->DoThat();
+    }
+    assert( BaseClass::AllDestroyed() );
+
+    {
+        NonConstBase_MadeCountMT_NoConvert_NoCheck_DontPropagate_ptr p0 =
+            MakeSmart< NonConstBase_MadeCountMT_NoConvert_NoCheck_DontPropagate_ptr >();
+        NonConstBase_MadeCountMT_NoConvert_NoCheck_DontPropagate_ptr p1( p0 );
+        assert( p0 == p1 );
+        assert( BaseClass::ExtraConstructions() );
+    }
+    assert( BaseClass::AllDestroyed() );
+
+    {
+        Made_ptr p = MakeSmart< Made_ptr >( 3, "three" );
+        assert( 3 == p->GetValue() );
+        assert( 0 == ::strcmp( "three", p->GetName() ) );
+        try
+        {
+            p = MakeSmart< Made_ptr >( -1, "negative" );
+            assert( false );
+        }
+        catch ( const ::std::invalid_argument & )
+        {
+            // The pointee's constructor threw, so p still refers to the old one.
+            assert( 3 == p->GetValue() );
+        }
+    }
+
+    assert( BaseClass::AllDestroyed() );
+    assert( !BaseClass::ExtraConstructions() );
+    assert( !BaseClass::ExtraDestructions() );
+    cout << "Finished DoMadeRefCountTests." << endl;
+}
+
+// ----------------------------------------------------------------------------
+
 int main( int argc, const char * argv[] )
 {
     bool doThreadTest = false;
@@ -1641,6 +1757,8 @@ int main( int argc, const char * argv[] )
     DoStrongReleaseTests();
     DoStrongReleaseTests();
     DoWeakCycleTests();
+    DoLockFreeRefCountTests();
+    DoLockFreeCountsTest();
     DoStrongCompareTests();
     DoSingleOwnerTests();
 
@@ -1664,6 +1782,8 @@ int main( int argc, const char * argv[] )
     DoStrongPtrDynamicCastTests();
     DoStrongArrayTests();
     DoSmartArrayTests();
+    DoMadeRefCountTests();
+    DoMadeStrongTests();
 
 #if defined (LOKI_OBJECT_LEVEL_THREADING) || defined (LOKI_CLASS_LEVEL_THREADING)
     if ( doThreadTest )
@@ -663,6 +663,84 @@ void DoStrongConstTests( void )
 
 // ----------------------------------------------------------------------------
 
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+
+typedef ::Loki::StrongPtr< Counted, false, ::Loki::LockFreeTwoRefCounts >
+    LockFree_WeakPtr;
+typedef ::Loki::StrongPtr< Counted, true,  ::Loki::LockFreeTwoRefCounts >
+    LockFree_StrongPtr;
+
+#endif
+
+void DoLockFreeRefCountTests( void )
+{
+#if defined( LOKI_THREADS_ATOMIC_LOCKFREE )
+    cout << "Starting DoLockFreeRefCountTests." << endl;
+    assert( Counted::AllDestroyed() );
+    const unsigned int dtorCount = Counted::GetDtorCount();
+    (void)dtorCount;
+
+    {
+        LockFree_WeakPtr pWeak;
+        {
+            LockFree_StrongPtr pStrong( new Counted );
+            pWeak = pStrong;
+            LockFree_StrongPtr pStrong2( pWeak );
+            assert( pStrong2 );
+            assert( pStrong2 == pStrong );
+        }
+        // The last strong pointer died, so no strong pointer can be made from
+        // the weak one, and a strong copy is null.
+        assert( Counted::AllDestroyed() );
+        assert( !pWeak );
+        LockFree_StrongPtr pStrong3( pWeak );
+        assert( !pStrong3 );
+        LockFree_WeakPtr pWeak2( pWeak );
+        assert( !pWeak2 );
+    }
+    assert( Counted::AllDestroyed() );
+
+    {
+        // A pointee which only weak pointers ever had may still get a strong
+        // pointer, and the last strong pointer deletes it.
+        LockFree_WeakPtr pWeak( new Counted );
+        {
+            LockFree_StrongPtr pStrong( pWeak );
+            assert( pStrong );
+            assert( Counted::ExtraConstructions() );
+        }
+        assert( Counted::AllDestroyed() );
+        assert( !pWeak );
+    }
+
+    {
+        // With no strong pointer at all, the last weak pointer deletes it.
+        LockFree_WeakPtr pWeak( new Counted );
+        {
+            LockFree_WeakPtr pWeak2( pWeak );
+        }
+        assert( Counted::ExtraConstructions() );
+    }
+    assert( Counted::AllDestroyed() );
+    assert( Counted::GetDtorCount() == dtorCount + 3 );
+
+    {
+        LockFree_StrongPtr pStrong1( new Counted );
+        LockFree_StrongPtr pStrong2( new Counted );
+        LockFree_WeakPtr pWeak( pStrong1 );
+        pStrong1.Swap( pStrong2 );
+        assert( pWeak == pStrong2 );
+        pStrong2 = pStrong1;
+        assert( Counted::GetDtorCount() == dtorCount + 4 );
+        assert( !pWeak );
+    }
+    assert( Counted::AllDestroyed() );
+    cout << "Finished DoLockFreeRefCountTests." << endl;
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
 void DoStrongReleaseTests( void )
 {
 
@@ -684,7 +762,7 @@ void DoStrongReleaseTests( void )
 
         // Prove that neither weak nor strong pointers can be
         // released if any co-pointer is strong.
-        bool released = ReleaseAll( w2, pNull );
+        bool released = ReleaseAll( w2, pNull ); (void)released;
         assert( !released );
 
         released = ReleaseAll( w1, pNull );
@@ -699,7 +777,7 @@ void DoStrongReleaseTests( void )
         // Prove that weak and strong pointers can be reset only
         // if stored pointer matches parameter pointer - or there
         // are no strong co-pointers.
-        bool reset = ResetAll( w2, pNull );
+        bool reset = ResetAll( w2, pNull ); (void)reset;
         assert( !reset );
 
         reset = ResetAll( w1, pNull );
@@ -738,7 +816,7 @@ void DoStrongReleaseTests( void )
         NonConstBase_StrongCount_NoConvert_NoCheck_Reset_NoPropagate_ptr s2( w2 );
 
         BaseClass * thing = NULL;
-        bool released = ReleaseAll( w2, thing );
+        bool released = ReleaseAll( w2, thing ); (void)released;
         assert( released );
         assert( NULL != thing );
         delete thing;
@@ -761,7 +839,7 @@ void DoStrongReleaseTests( void )
         // Prove that weak and strong pointers can be reset
         // only if stored pointer matches parameter pointer
         // - even if there are strong co-pointers.
-        bool reset = ResetAll( w2, pNull );
+        bool reset = ResetAll( w2, pNull ); (void)reset;
         assert( reset );
 
         reset = ResetAll( w1, pNull );
@@ -2231,3 +2309,104 @@ void DoStrongArrayTests( void )
 }
 
 // ----------------------------------------------------------------------------
+
+/// Use these typedefs to test MakeStrong.
+
+typedef Loki::StrongPtr< BaseClass, true, MadeTwoRefCounts, DisallowConversion,
+    AssertCheck, NeverReset, DeleteSingle, DontPropagateConst >
+    NonConstBase_StrongMade_NoConvert_Assert_NoPropagate_ptr;
+
+typedef Loki::StrongPtr< BaseClass, false, MadeTwoRefCounts, DisallowConversion,
+    AssertCheck, NeverReset, DeleteSingle, DontPropagateConst >
+    NonConstBase_WeakMade_NoConvert_Assert_NoPropagate_ptr;
+
+/// Holds a weak pointer to itself, so its destructor releases a weak copointer.
+class SelfWatcher : public BaseClass
+{
+public:
+    typedef Loki::StrongPtr< SelfWatcher, true, MadeTwoRefCounts, DisallowConversion,
+        AssertCheck, NeverReset, DeleteSingle, DontPropagateConst > StrongPtr;
+    typedef Loki::StrongPtr< SelfWatcher, false, MadeTwoRefCounts, DisallowConversion,
+        AssertCheck, NeverReset, DeleteSingle, DontPropagateConst > WeakPtr;
+
+    explicit SelfWatcher( int value ) : m_value( value ) {}
+
+    void Watch( const StrongPtr & self ) { m_self = self; }
+
+    int GetValue( void ) const { return m_value; }
+
+private:
+    WeakPtr m_self;
+    int m_value;
+};
+
+// ----------------------------------------------------------------------------
+
+void DoMadeStrongTests( void )
+{
+    cout << "Starting DoMadeStrongTests." << endl;
+
+    BaseClass * pNull = NULL; (void)pNull;
+    const unsigned int ctorCount = BaseClass::GetCtorCount(); (void)ctorCount;
+    const unsigned int dtorCount = BaseClass::GetDtorCount(); (void)dtorCount;
+    assert( BaseClass::GetCtorCount() == BaseClass::GetDtorCount() );
+
+    {
+        NonConstBase_WeakMade_NoConvert_Assert_NoPropagate_ptr w0;
+        NonConstBase_StrongMade_NoConvert_Assert_NoPropagate_ptr s0;
+        assert( !w0 );
+        assert( !s0 );
+        assert( s0 == pNull );
+        {
+            NonConstBase_StrongMade_NoConvert_Assert_NoPropagate_ptr s1 =
+                MakeStrong< NonConstBase_StrongMade_NoConvert_Assert_NoPropagate_ptr >();
+            assert( s1 );
+            assert( ctorCount + 1 == BaseClass::GetCtorCount() );
+            s0 = s1;
+            w0 = s1;
+            assert( s0 == s1 );
+            assert( w0 == s1 );
+        }
+        assert( dtorCount == BaseClass::GetDtorCount() );
+        s0 = NonConstBase_StrongMade_NoConvert_Assert_NoPropagate_ptr();
+        // The last strong copointer destroyed the pointee, but not the block,
+        // since a weak copointer remains.
+        assert( dtorCount + 1 == BaseClass::GetDtorCount() );
+        assert( !w0 );
+        assert( w0 == pNull );
+    }
+    assert( BaseClass::AllDestroyed() );
+
+    {
+        SelfWatcher::StrongPtr s0 = MakeStrong< SelfWatcher::StrongPtr >( 7 );
+        s0->Watch( s0 );
+        assert( 7 == s0->GetValue() );
+        SelfWatcher::WeakPtr w0( s0 );
+        s0 = SelfWatcher::StrongPtr();
+        assert( BaseClass::AllDestroyed() );
+        assert( !w0 );
+    }
+    assert( BaseClass::AllDestroyed() );
+
+    {
+        BaseClass * p = new BaseClass;
+        try
+        {
+            NonConstBase_StrongMade_NoConvert_Assert_NoPropagate_ptr s0( p );
+            assert( false );
+        }
+        catch ( const ::std::logic_error & ex )
+        {
+            (void)ex;
+            assert( true );
+        }
+        delete p;
+    }
+
+    assert( BaseClass::AllDestroyed() );
+    assert( !BaseClass::ExtraConstructions() );
+    assert( !BaseClass::ExtraDestructions() );
+    cout << "Finished DoMadeStrongTests." << endl;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark visits a mix of ten node classes with a visitor for
+/// all ten, through the dynamic_cast of BaseVisitable, through the table
+/// lookup of IndexedBaseVisitable, and through a CyclicVisitor, which knows
+/// every node class and needs no lookup at all.  Each Visit function only
+/// adds the value of its node.
+
+
+#include <loki/Visitor.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int NodeCount = 1000;
+
+static const unsigned int VisitLoops = 10 * 1000;
+
+// ----------------------------------------------------------------------------
+
+class AcyclicNode : public ::Loki::BaseVisitable<>
+{
+public:
+    LOKI_DEFINE_VISITABLE()
+    AcyclicNode( void ) : m_value( 1 ) {}
+    unsigned int GetValue( void ) const { return m_value; }
+private:
+    unsigned int m_value;
+};
+
+template < int I > class AcyclicLeaf : public AcyclicNode
+{
+public:
+    LOKI_DEFINE_VISITABLE()
+};
+
+class IndexedNode : public ::Loki::IndexedBaseVisitable<>
+{
+public:
+    LOKI_DEFINE_INDEXED_VISITABLE()
+    IndexedNode( void ) : m_value( 1 ) {}
+    unsigned int GetValue( void ) const { return m_value; }
+private:
+    unsigned int m_value;
+};
+
+template < int I > class IndexedLeaf : public IndexedNode
+{
+public:
+    LOKI_DEFINE_INDEXED_VISITABLE()
+};
+
+template < int I > class CyclicLeaf;
+
+typedef ::Loki::CyclicVisitor< void, LOKI_TYPELIST_10( CyclicLeaf< 0 >,
+    CyclicLeaf< 1 >, CyclicLeaf< 2 >, CyclicLeaf< 3 >, CyclicLeaf< 4 >,
+    CyclicLeaf< 5 >, CyclicLeaf< 6 >, CyclicLeaf< 7 >, CyclicLeaf< 8 >,
+    CyclicLeaf< 9 > ) > CyclicVisitorBase;
+
+class CyclicNode
+{
+public:
+    typedef void ReturnType;
+    CyclicNode( void ) : m_value( 1 ) {}
+    virtual ~CyclicNode( void ) {}
+    virtual void Accept( CyclicVisitorBase & guest ) = 0;
+    unsigned int GetValue( void ) const { return m_value; }
+private:
+    unsigned int m_value;
+};
+
+template < int I > class CyclicLeaf : public CyclicNode
+{
+public:
+    LOKI_DEFINE_CYCLIC_VISITABLE( CyclicVisitorBase )
+};
+
+// ----------------------------------------------------------------------------
+
+#define LEAF_TYPES( Leaf ) LOKI_TYPELIST_10( Leaf< 0 >, Leaf< 1 >, Leaf< 2 >, \
+    Leaf< 3 >, Leaf< 4 >, Leaf< 5 >, Leaf< 6 >, Leaf< 7 >, Leaf< 8 >, Leaf< 9 > )
+
+#define VISIT_LEAVES( Leaf ) \
+    void Visit( Leaf< 0 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 1 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 2 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 3 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 4 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 5 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 6 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 7 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 8 > & node ) { m_sum += node.GetValue(); } \
+    void Visit( Leaf< 9 > & node ) { m_sum += node.GetValue(); }
+
+class AcyclicSummer : public ::Loki::BaseVisitor,
+    public ::Loki::Visitor< LEAF_TYPES( AcyclicLeaf ) >
+{
+public:
+    AcyclicSummer( void ) : m_sum( 0 ) {}
+    VISIT_LEAVES( AcyclicLeaf )
+    unsigned int m_sum;
+};
+
+class IndexedSummer
+    : public ::Loki::IndexedVisitor< IndexedSummer, LEAF_TYPES( IndexedLeaf ) >
+{
+public:
+    IndexedSummer( void ) : m_sum( 0 ) {}
+    VISIT_LEAVES( IndexedLeaf )
+    unsigned int m_sum;
+};
+
+class CyclicSummer : public CyclicVisitorBase
+{
+public:
+    CyclicSummer( void ) : m_sum( 0 ) {}
+    VISIT_LEAVES( CyclicLeaf )
+    unsigned int m_sum;
+};
+
+// ----------------------------------------------------------------------------
+
+template < class Node, template < int > class Leaf >
+Node * MakeLeaf( unsigned int kind )
+{
+    switch ( kind )
+    {
+        case 0: return new Leaf< 0 >;
+        case 1: return new Leaf< 1 >;
+        case 2: return new Leaf< 2 >;
+        case 3: return new Leaf< 3 >;
+        case 4: return new Leaf< 4 >;
+        case 5: return new Leaf< 5 >;
+        case 6: return new Leaf< 6 >;
+        case 7: return new Leaf< 7 >;
+        case 8: return new Leaf< 8 >;
+        default: return new Leaf< 9 >;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/// Returns nanoseconds per visit of randomly mixed leaves.
+template < class Node, template < int > class Leaf, class Summer >
+double TimeVisits( void )
+{
+    ::srand( 42 );
+    vector< Node * > nodes;
+    nodes.reserve( NodeCount );
+    for ( unsigned int ii = 0; ii < NodeCount; ++ii )
+        nodes.push_back( MakeLeaf< Node, Leaf >( static_cast< unsigned int >( ::rand() ) % 10 ) );
+
+    Summer summer;
+    const double start = GetMilliSeconds();
+    for ( unsigned int loop = 0; loop < VisitLoops; ++loop )
+        for ( unsigned int ii = 0; ii < NodeCount; ++ii )
+            nodes[ ii ]->Accept( summer );
+    const double stop = GetMilliSeconds();
+
+    if ( summer.m_sum != NodeCount * VisitLoops )
+        cout << "wrong sum " << summer.m_sum << endl;
+    for ( unsigned int ii = 0; ii < NodeCount; ++ii )
+        delete nodes[ ii ];
+    return ( stop - start ) * 1000.0 * 1000.0 / ( NodeCount * VisitLoops );
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    cout << "Visiting " << NodeCount << " nodes of ten classes " << VisitLoops
+         << " times." << endl;
+    cout << "Times in nanoseconds per visit." << endl << endl;
+
+    cout << setw( 16 ) << "BaseVisitable"
+         << setw( 16 ) << "Indexed"
+         << setw( 16 ) << "CyclicVisitor" << endl;
+
+    cout << setw( 16 ) << TimeVisits< AcyclicNode, AcyclicLeaf, AcyclicSummer >()
+         << setw( 16 ) << TimeVisits< IndexedNode, IndexedLeaf, IndexedSummer >()
+         << setw( 16 ) << TimeVisits< CyclicNode, CyclicLeaf, CyclicSummer >()
+         << endl;
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
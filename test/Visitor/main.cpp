@@ -72,6 +72,66 @@ public:
     void Visit(const CType1&){std::cout << "void Visit(CType1&)\n";}
 }; 
 
+class IBase : public Loki::IndexedBaseVisitable<>
+{
+public:
+    LOKI_DEFINE_INDEXED_VISITABLE()
+};
+
+class IType1 : public IBase
+{
+public:
+    LOKI_DEFINE_INDEXED_VISITABLE()
+};
+
+class IType2 : public IBase
+{
+public:
+    LOKI_DEFINE_INDEXED_VISITABLE()
+};
+
+class IVariableVisitor : 
+#ifndef LOKI_DISABLE_TYPELIST_MACROS
+    public Loki::IndexedVisitor<IVariableVisitor, LOKI_TYPELIST_2(IBase,IType1)>
+#else
+    public Loki::IndexedVisitor<IVariableVisitor, Loki::Seq<IBase,IType1>::Type>
+#endif
+{ 
+public: 
+    void Visit(IBase&){std::cout << "void Visit(IBase&)\n";}
+    void Visit(IType1&){std::cout << "void Visit(IType1&)\n";}
+}; 
+
+class IType2Visitor : public Loki::IndexedVisitor<IType2Visitor, IType2>
+{ 
+public: 
+    void Visit(IType2&){std::cout << "void Visit(IType2&)\n";}
+}; 
+
+class CIBase : public Loki::IndexedBaseVisitable<void, Loki::DefaultCatchAll, true>
+{
+public:
+    LOKI_DEFINE_CONST_INDEXED_VISITABLE()
+};
+
+class CIType1 : public CIBase
+{
+public:
+    LOKI_DEFINE_CONST_INDEXED_VISITABLE()
+};
+
+class CIndexedVisitor : 
+#ifndef LOKI_DISABLE_TYPELIST_MACROS
+    public Loki::IndexedVisitor<CIndexedVisitor, LOKI_TYPELIST_2(CIBase,CIType1),void,true>
+#else
+    public Loki::IndexedVisitor<CIndexedVisitor, Loki::Seq<CIBase,CIType1>::Type,void,true>
+#endif
+{ 
+public: 
+    void Visit(const CIBase&){std::cout << "void Visit(CIBase&)\n";}
+    void Visit(const CIType1&){std::cout << "void Visit(CIType1&)\n";}
+}; 
+
 int main()
 {
     VariableVisitor visitor;
@@ -84,6 +144,24 @@ int main()
     CBase* cdyn = &ctype1;
     cdyn->Accept(cvisitor);
 
+    // IType2 is unknown to IVariableVisitor and is caught by DefaultCatchAll
+    IVariableVisitor ivisitor;
+    IType2Visitor itype2Visitor;
+    IBase ibase;
+    IType1 itype1;
+    IType2 itype2;
+    IBase* idyn[] = { &ibase, &itype1, &itype2 };
+    for (int i = 0; i < 3; ++i)
+    {
+        idyn[i]->Accept(ivisitor);
+        idyn[i]->Accept(itype2Visitor);
+    }
+
+    CIndexedVisitor civisitor;
+    CIType1 citype1;
+    const CIBase* cidyn = &citype1;
+    cidyn->Accept(civisitor);
+
 #if defined(__BORLANDC__) || defined(_MSC_VER)
     system("PAUSE");
 #endif
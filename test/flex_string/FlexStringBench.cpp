@@ -0,0 +1,183 @@
+////////////////////////////////////////////////////////////////////////////////
+// The Loki Library
+// Code covered by the MIT License
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+////////////////////////////////////////////////////////////////////////////////
+
+// $Id$
+
+
+/// @note This benchmark runs the search functions of flex_string on a log
+/// like text of 64 KB and compares them with std::string.  The flex_string
+/// with PlainCharTraits uses the general searchers, which skip to candidates
+/// with traits::find, and the flex_string with std::char_traits< char > uses
+/// the SSE2 or AVX2 searchers.  Every search looks for something near the end
+/// of the text or for something which is not there at all.
+
+
+#include <loki/flex/flex_string.h>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include "../BenchTimer.h"
+
+using namespace std;
+
+
+// ----------------------------------------------------------------------------
+
+static const unsigned int TextSize = 64 * 1024;
+
+static const unsigned int SearchLoops = 2000;
+
+// ----------------------------------------------------------------------------
+
+/// Traits which keep flex_string on its general searchers.
+struct PlainCharTraits : public char_traits< char > {};
+
+typedef flex_string< char, PlainCharTraits > PlainString;
+
+typedef flex_string< char > SimdString;
+
+// ----------------------------------------------------------------------------
+
+/// Returns lines of a made up server log, a line with the needles, and blank
+/// lines for the last quarter.
+string MakeText( void )
+{
+    static const char * const lines[] =
+    {
+        "2024-01-17 12:00:01 INFO  server: accepted connection from 10.0.0.17\n",
+        "2024-01-17 12:00:01 DEBUG server: request GET /index.html took 3 ms\n",
+        "2024-01-17 12:00:02 INFO  cache: hit ratio 0.93 over 1000 lookups\n",
+        "2024-01-17 12:00:02 DEBUG server: request GET /style.css took 1 ms\n",
+    };
+    string text;
+    text.reserve( TextSize );
+    for ( unsigned int ii = 0; text.size() < TextSize / 4 * 3; ++ii )
+        text += lines[ ii % 4 ];
+    text += "2024-01-17 12:00:03 WARN  server: slow request took 1200 ms @@\n";
+    while ( text.size() < TextSize )
+        text += "               \n";
+    return text;
+}
+
+// ----------------------------------------------------------------------------
+
+enum Search
+{
+    FindChar,
+    FindSubstring,
+    FindAbsentSubstring,
+    RfindChar,
+    RfindSubstring,
+    FindFirstOf,
+    FindFirstOfBigSet,
+    FindLastNotOf,
+    SearchCount
+};
+
+static const char * const SearchNames[ SearchCount ] =
+{
+    "find( '@' )",
+    "find( \"WARN\" )",
+    "find( \"FATAL\" )",
+    "rfind( 'Q' )",
+    "rfind( \"2023\" )",
+    "find_first_of( \"@#$\" )",
+    "find_first_of( 20 chars )",
+    "find_last_not_of( \" \\n\" )",
+};
+
+/// Runs one search from pos, or from the end when pos is zero and the search
+/// goes backwards, and returns what it found.
+template < class String >
+typename String::size_type Run( const String & text, Search search, size_t pos )
+{
+    const size_t last = text.size() - 1 - pos;
+    switch ( search )
+    {
+        case FindChar: return text.find( '@', pos );
+        case FindSubstring: return text.find( "WARN", pos );
+        case FindAbsentSubstring: return text.find( "FATAL", pos );
+        case RfindChar: return text.rfind( 'Q', last );
+        case RfindSubstring: return text.rfind( "2023", last );
+        case FindFirstOf: return text.find_first_of( "@#$", pos );
+        case FindFirstOfBigSet: return text.find_first_of( "@#$%^&*!?|~<>[]{}\\`Z", pos );
+        default: return text.find_last_not_of( " \n", last );
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+/// Returns microseconds per search through the whole text.
+template < class String >
+double TimeSearch( const string & source, Search search, size_t & found )
+{
+    const String text( source.data(), source.size() );
+    // Read on every loop, so that the compiler cannot hoist the search.
+    volatile size_t pos = 0;
+    size_t sum = 0;
+    const double start = GetMilliSeconds();
+    for ( unsigned int loop = 0; loop < SearchLoops; ++loop )
+        sum += Run( text, search, pos );
+    const double stop = GetMilliSeconds();
+    found = sum / SearchLoops;
+    return ( stop - start ) * 1000.0 / SearchLoops;
+}
+
+// ----------------------------------------------------------------------------
+
+int main( int argc, const char * const argv[] )
+{
+    (void)argc;
+    (void)argv;
+
+    const string text = MakeText();
+    cout << "Searching " << text.size() << " characters " << SearchLoops
+         << " times." << endl;
+    cout << "Times in microseconds per search." << endl << endl;
+
+    cout << setw( 28 ) << "search"
+         << setw( 14 ) << "std::string"
+         << setw( 14 ) << "flex plain"
+         << setw( 14 ) << "flex simd" << endl;
+
+    for ( unsigned int ii = 0; ii < SearchCount; ++ii )
+    {
+        const Search search = static_cast< Search >( ii );
+        size_t expected = 0;
+        size_t plainFound = 0;
+        size_t simdFound = 0;
+        cout << setw( 28 ) << SearchNames[ ii ] << fixed << setprecision( 2 )
+             << setw( 14 ) << TimeSearch< string >( text, search, expected )
+             << setw( 14 ) << TimeSearch< PlainString >( text, search, plainFound )
+             << setw( 14 ) << TimeSearch< SimdString >( text, search, simdFound )
+             << endl;
+        if ( plainFound != expected || simdFound != expected )
+            cout << "wrong result for " << SearchNames[ ii ] << endl;
+    }
+
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
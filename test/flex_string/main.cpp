@@ -243,7 +243,7 @@ std::list<typename String::value_type> RandomList(typename String::size_type max
 {
   const typename String::size_type size = random(0, maxSize);
   std::list<typename String::value_type> list(size);
-  std::list<typename String::value_type>::iterator i = list.begin();
+  typename std::list<typename String::value_type>::iterator i = list.begin();
   for (; i != list.end(); ++i)
   {
     *i = random('a', 'z');
@@ -3046,6 +3046,75 @@ void checkResults(const std::string & reference, const String & tested,
   }
 }
 
+/// Traits which keep flex_string on its general searcher.
+struct PlainCharTraits : public std::char_traits<char> {};
+
+typedef flex_string<
+  char,
+  PlainCharTraits,
+  std::allocator<char>,
+  AllocatorStringStorage<char, std::allocator<char> >
+> my_string_PlainTraits;
+
+template<class String>
+unsigned int CheckSearch(const std::string& text, const std::string& needle,
+  typename String::size_type pos)
+{
+  const String tested(text.data(), text.size());
+  const char* const s = needle.data();
+  const size_t n = needle.size();
+  unsigned int failures = 0;
+#define LOKI_CHECK_SEARCH(call) \
+  if (tested.call != text.call) \
+  { \
+    std::cout << "search failed: " #call " for " << typeid(String).name() \
+      << "\ntext   = {" << text << "}\nneedle = {" << needle << "}\npos    = " << pos \
+      << "\nexpected " << text.call << ", got " << tested.call << "\n\n"; \
+    ++failures; \
+  }
+  LOKI_CHECK_SEARCH(find(s, pos, n))
+  LOKI_CHECK_SEARCH(rfind(s, pos, n))
+  LOKI_CHECK_SEARCH(find_first_of(s, pos, n))
+  LOKI_CHECK_SEARCH(find_last_of(s, pos, n))
+  LOKI_CHECK_SEARCH(find_first_not_of(s, pos, n))
+  LOKI_CHECK_SEARCH(find_last_not_of(s, pos, n))
+  if (n > 0)
+  {
+    LOKI_CHECK_SEARCH(find(s[0], pos))
+    LOKI_CHECK_SEARCH(rfind(s[0], pos))
+    LOKI_CHECK_SEARCH(find_first_not_of(s[0], pos))
+    LOKI_CHECK_SEARCH(find_last_not_of(s[0], pos))
+  }
+#undef LOKI_CHECK_SEARCH
+  return failures;
+}
+
+/// Compares the search functions with std::string's on strings long enough
+/// for the SIMD searchers, and over few letters so that there are matches.
+unsigned int TestSearch()
+{
+  unsigned int failures = 0;
+  for (size_t i = 0; i < 20000 && failures < 10; ++i)
+  {
+    const char alphabet[] = "ab\xe9 ,;\t";
+    const size_t letters = random(1u, sizeof(alphabet) - 1);
+    std::string text(random(0u, 300u), 'x');
+    for (size_t j = 0; j < text.size(); ++j)
+      text[j] = alphabet[random(0u, letters - 1)];
+    std::string needle(random(0u, size_t(i % 2 == 0 ? 4 : 20)), 'x');
+    for (size_t j = 0; j < needle.size(); ++j)
+      needle[j] = alphabet[random(0u, letters - 1)];
+    // sometimes take the needle out of the text, so that it is there
+    if (rand() % 2 == 0 && needle.size() <= text.size())
+      needle = text.substr(random(0u, text.size() - needle.size()), needle.size());
+    const size_t pos = rand() % 4 == 0 ? std::string::npos : random(0u, text.size() + 2);
+    failures += CheckSearch<StringsToTest::my_string_AllocatorStorage>(text, needle, pos);
+    failures += CheckSearch<StringsToTest::my_string_SmallStringSimple>(text, needle, pos);
+    failures += CheckSearch<my_string_PlainTraits>(text, needle, pos);
+  }
+  return failures;
+}
+
 void Compare()
 {
     size_t count = 0;
@@ -3066,7 +3135,8 @@ void Compare()
     {
       std::cout << ++count << '\r';
 
-      const unsigned int seedForThisIteration = count + rand();
+      const unsigned int seedForThisIteration =
+        static_cast<unsigned int>(count) + static_cast<unsigned int>(rand());
       srand(seedForThisIteration);
 
       const std::string reference(Test<std::string>(count, testFunctions_std));
@@ -3134,6 +3204,10 @@ int main()
 
   std::cout << "initial seed = " << initialSeed << "\n\n";
 
+  if (TestSearch() != 0)
+    return 1;
+  std::cout << "search functions passed" << std::endl;
+
   Compare();
 
   return 0;